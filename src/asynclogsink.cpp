@@ -0,0 +1,147 @@
+#include "asynclogsink.h"
+#include <utility>
+#include <vector>
+#ifndef _WIN32
+#include <syslog.h>
+#endif
+
+using namespace jed_utils;
+
+namespace {
+    const size_t BATCH_LENGTH = 256;
+    // Bounds the latency of a wakeup missed by the parked writer
+    const std::chrono::milliseconds IDLE_WAIT_DURATION(50);
+}  // namespace
+
+const size_t AsyncLogSink::DEFAULT_QUEUE_CAPACITY;
+
+std::shared_ptr<AsyncLogSink> AsyncLogSink::createFileSink(const char *pFilename,
+        CommunicationLogLevel pLevel,
+        size_t pQueueCapacity) {
+    if (pFilename == nullptr) {
+        return nullptr;
+    }
+    std::shared_ptr<AsyncLogSink> sink(new AsyncLogSink(pLevel, pQueueCapacity, pFilename));
+    if (!sink->mFile.is_open()) {
+        return nullptr;
+    }
+    return sink;
+}
+
+std::shared_ptr<AsyncLogSink> AsyncLogSink::createSyslogSink(const char *pIdentity,
+        CommunicationLogLevel pLevel,
+        size_t pQueueCapacity) {
+#ifdef _WIN32
+    (void)pIdentity;
+    (void)pLevel;
+    (void)pQueueCapacity;
+    return nullptr;
+#else
+    openlog(pIdentity, LOG_PID, LOG_MAIL);
+    return std::shared_ptr<AsyncLogSink>(new AsyncLogSink(pLevel, pQueueCapacity, nullptr));
+#endif
+}
+
+AsyncLogSink::AsyncLogSink(CommunicationLogLevel pLevel, size_t pQueueCapacity, const char *pFilename)
+    : LogSink(pLevel),
+      mQueue(pQueueCapacity),
+      mSyslog(pFilename == nullptr),
+      mQueuedCount(0),
+      mWrittenCount(0),
+      mDroppedCount(0),
+      mStopping(false),
+      mWriterIdle(false) {
+    if (pFilename != nullptr) {
+        mFile.open(pFilename, std::ios::out | std::ios::app | std::ios::binary);
+        if (!mFile.is_open()) {
+            return;
+        }
+    }
+    mThread = std::thread(&AsyncLogSink::run, this);
+}
+
+AsyncLogSink::~AsyncLogSink() {
+    mStopping = true;
+    {
+        std::lock_guard<std::mutex> lock(mIdleMutex);
+        mIdleCondition.notify_all();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+void AsyncLogSink::write(LogEvent &pEvent) {
+    if (mStopping || !mQueue.tryEnqueue(std::move(pEvent))) {
+        mDroppedCount++;
+        return;
+    }
+    mQueuedCount++;
+    wakeUpWriter();
+}
+
+void AsyncLogSink::flush() {
+    if (!mThread.joinable()) {
+        return;
+    }
+    const std::uint64_t target = mQueuedCount;
+    std::unique_lock<std::mutex> lock(mIdleMutex);
+    mIdleCondition.notify_all();
+    mFlushCondition.wait(lock, [this, target]() { return mWrittenCount >= target; });
+}
+
+std::uint64_t AsyncLogSink::getDroppedCount() const {
+    return mDroppedCount;
+}
+
+void AsyncLogSink::wakeUpWriter() {
+    // Pairs with the fence of the parking writer: either the writer sees the
+    // new event or this thread sees the idle writer.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mWriterIdle) {
+        std::lock_guard<std::mutex> lock(mIdleMutex);
+        mIdleCondition.notify_one();
+    }
+}
+
+void AsyncLogSink::run() {
+    std::vector<LogEvent> batch;
+    batch.reserve(BATCH_LENGTH);
+    for (;;) {
+        batch.clear();
+        if (mQueue.dequeueBatch(batch, BATCH_LENGTH) == 0) {
+            if (mStopping && mQueue.size() == 0) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(mIdleMutex);
+            mWriterIdle = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!mStopping && mQueue.size() == 0) {
+                mIdleCondition.wait_for(lock, IDLE_WAIT_DURATION);
+            }
+            mWriterIdle = false;
+            continue;
+        }
+        for (const auto &event : batch) {
+            writeLine(format(event));
+        }
+        if (!mSyslog) {
+            mFile.flush();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mIdleMutex);
+            mWrittenCount += batch.size();
+        }
+        mFlushCondition.notify_all();
+    }
+}
+
+void AsyncLogSink::writeLine(const std::string &pLine) {
+#ifndef _WIN32
+    if (mSyslog) {
+        syslog(LOG_MAIL | LOG_INFO, "%s", pLine.c_str());
+        return;
+    }
+#endif
+    mFile << pLine << '\n';
+}
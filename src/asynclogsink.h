@@ -0,0 +1,101 @@
+#ifndef ASYNCLOGSINK_H
+#define ASYNCLOGSINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "logsink.h"
+#include "mpscqueue.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define ASYNCLOGSINK_API __declspec(dllexport)
+    #else
+        #define ASYNCLOGSINK_API __declspec(dllimport)
+    #endif
+#else
+    #define ASYNCLOGSINK_API
+#endif
+
+namespace jed_utils {
+/** @brief The AsyncLogSink class writes the events to a file or to syslog
+ *  from a background thread.
+ *
+ *  write only moves the event into an MPSCQueue, without locks, so the
+ *  threads that send mails never wait for the disk. When the queue is full
+ *  the event is dropped and counted (see getDroppedCount). The background
+ *  thread writes the events by batches, one line each (see LogSink::format).
+ */
+class ASYNCLOGSINK_API AsyncLogSink : public LogSink {
+ public:
+    /** The default capacity of the queue of events. */
+    static const size_t DEFAULT_QUEUE_CAPACITY = 8192;
+
+    /**
+     *  @brief  Create a sink that appends the events to a file.
+     *  @param pFilename The file. It is created if it does not exist.
+     *  @param pLevel The level of the events the sink receives.
+     *  @param pQueueCapacity The capacity of the queue of events.
+     *  @return The sink or null if the file could not be opened.
+     */
+    static std::shared_ptr<AsyncLogSink> createFileSink(const char *pFilename,
+            CommunicationLogLevel pLevel = CommunicationLogLevel::Full,
+            size_t pQueueCapacity = DEFAULT_QUEUE_CAPACITY);
+
+    /**
+     *  @brief  Create a sink that sends the events to syslog (facility
+     *  LOG_MAIL, priority LOG_INFO).
+     *  @param pIdentity The identity prefixed to the messages (see openlog).
+     *  It must stay valid while the sink is used.
+     *  @param pLevel The level of the events the sink receives.
+     *  @param pQueueCapacity The capacity of the queue of events.
+     *  @return The sink, or null on Windows where syslog does not exist.
+     */
+    static std::shared_ptr<AsyncLogSink> createSyslogSink(const char *pIdentity,
+            CommunicationLogLevel pLevel = CommunicationLogLevel::Commands,
+            size_t pQueueCapacity = DEFAULT_QUEUE_CAPACITY);
+
+    /** Destructor of the AsyncLogSink. The queued events are written before
+     *  the background thread stops. */
+    ~AsyncLogSink() override;
+
+    /**
+     *  @brief  Queue an event for the background thread.
+     *  @param pEvent The event. It is moved into the queue.
+     */
+    void write(LogEvent &pEvent) override;
+
+    /** Wait until the events queued so far are written. */
+    void flush();
+
+    /** Return the number of events dropped because the queue was full. */
+    std::uint64_t getDroppedCount() const;
+
+ private:
+    AsyncLogSink(CommunicationLogLevel pLevel, size_t pQueueCapacity, const char *pFilename);
+    void run();
+    void wakeUpWriter();
+    void writeLine(const std::string &pLine);
+
+    MPSCQueue<LogEvent> mQueue;
+    const bool mSyslog;
+    std::ofstream mFile;
+    std::atomic<std::uint64_t> mQueuedCount;
+    std::atomic<std::uint64_t> mWrittenCount;
+    std::atomic<std::uint64_t> mDroppedCount;
+    std::atomic<bool> mStopping;
+    std::atomic<bool> mWriterIdle;
+    std::mutex mIdleMutex;
+    std::condition_variable mIdleCondition;
+    std::condition_variable mFlushCondition;
+    std::thread mThread;
+};
+}  // namespace jed_utils
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef ASYNCSMTPSESSION_H
+#define ASYNCSMTPSESSION_H
+
+// The coroutine API requires C++20 (see BUILD_WITH_COROUTINES in CMakeLists)
+#if defined(__has_include) && ((defined(_MSVC_LANG) && _MSVC_LANG >= 202002L) || __cplusplus >= 202002L)
+    #if __has_include(<coroutine>)
+        #define SMTPCLIENT_HAS_COROUTINES
+    #endif
+#endif
+
+#ifdef SMTPCLIENT_HAS_COROUTINES
+
+#include <coroutine>
+#include <functional>
+#include <string>
+#include <utility>
+#include "cpp/htmlmessage.hpp"
+#include "cpp/plaintextmessage.hpp"
+#include "htmlmessage.h"
+#include "message.h"
+#include "plaintextmessage.h"
+#include "smtpsession.h"
+
+namespace jed_utils {
+/** @brief The SMTPSessionAwaitable class suspends a coroutine until an
+ *  SMTPSession operation completes. The result of co_await is the value
+ *  passed to the operation completion handler.
+ *
+ *  The coroutine is resumed on the thread that drives the session (usually
+ *  the SMTPEventLoop thread). When the operation completes immediately
+ *  (for example on a failed session) the coroutine is not suspended.
+ */
+class SMTPSessionAwaitable {
+ public:
+    /** The function that starts the operation with the handler provided. */
+    using Starter = std::function<void(SMTPSession::CompletionHandler)>;
+
+    /**
+     *  @brief  Construct a new SMTPSessionAwaitable.
+     *  @param pStarter The function that starts the operation.
+     */
+    explicit SMTPSessionAwaitable(Starter pStarter)
+        : mStarter(std::move(pStarter)),
+          mResult(0),
+          mState(State::Idle) {
+    }
+
+    /** SMTPSessionAwaitable copy constructor (deleted). */
+    SMTPSessionAwaitable(const SMTPSessionAwaitable &other) = delete;
+
+    /** SMTPSessionAwaitable copy assignment operator (deleted). */
+    SMTPSessionAwaitable& operator=(const SMTPSessionAwaitable &other) = delete;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> pHandle) {
+        mHandle = pHandle;
+        mState = State::Started;
+        mStarter([this](int pCode) {
+                mResult = pCode;
+                const bool resume = mState == State::Suspended;
+                mState = State::Completed;
+                if (resume) {
+                    mHandle.resume();
+                }
+                });
+        if (mState == State::Completed) {
+            // Completed synchronously, continue without suspending
+            return false;
+        }
+        mState = State::Suspended;
+        return true;
+    }
+
+    int await_resume() const noexcept {
+        return mResult;
+    }
+
+ private:
+    enum class State { Idle, Started, Suspended, Completed };
+
+    Starter mStarter;
+    int mResult;
+    State mState;
+    std::coroutine_handle<> mHandle;
+};
+
+/** @brief The AsyncSMTPSession class exposes the operations of an
+ *  SMTPSession as co_await-able calls.
+ *
+ *  Example : int ret_code = co_await client.send(msg);
+ *
+ *  Results follow the SMTPSession conventions: connect() and send() return
+ *  0 on success, the other operations return the SMTP reply code. Failures
+ *  return the error codes of smtpclienterrors.h, socketerrors.h and
+ *  sslerrors.h. The session must outlive the pending operations.
+ */
+class AsyncSMTPSession {
+ public:
+    /**
+     *  @brief  Construct a new AsyncSMTPSession.
+     *  @param pSession The session driven by the coroutines.
+     */
+    explicit AsyncSMTPSession(SMTPSession &pSession)
+        : mSession(&pSession) {
+    }
+
+    /** Return the underlying session. */
+    SMTPSession &getSession() const {
+        return *mSession;
+    }
+
+    /** Wait until the session is ready to send mails. */
+    SMTPSessionAwaitable connect() {
+        SMTPSession *session = mSession;
+        return SMTPSessionAwaitable([session](SMTPSession::CompletionHandler pHandler) {
+                session->connect(std::move(pHandler));
+                });
+    }
+
+    /** Send a MAIL FROM command. */
+    SMTPSessionAwaitable mailFrom(std::string pAddress) {
+        SMTPSession *session = mSession;
+        return SMTPSessionAwaitable([session, pAddress](SMTPSession::CompletionHandler pHandler) {
+                session->mailFrom(pAddress, std::move(pHandler));
+                });
+    }
+
+    /** Send a RCPT TO command. */
+    SMTPSessionAwaitable rcpt(std::string pAddress) {
+        SMTPSession *session = mSession;
+        return SMTPSessionAwaitable([session, pAddress](SMTPSession::CompletionHandler pHandler) {
+                session->rcptTo(pAddress, std::move(pHandler));
+                });
+    }
+
+    /** Send the DATA command followed by the rendered content. */
+    SMTPSessionAwaitable data(std::string pContent) {
+        SMTPSession *session = mSession;
+        return SMTPSessionAwaitable([session, pContent](SMTPSession::CompletionHandler pHandler) mutable {
+                session->data(std::move(pContent), std::move(pHandler));
+                });
+    }
+
+    /**
+     *  @brief  Send the complete transaction of a message. The message is
+     *  rendered when its MAIL FROM command is sent, so it must stay valid
+     *  until the awaitable completes (always true for co_await
+     *  client.send(msg)).
+     */
+    SMTPSessionAwaitable send(const Message &pMsg) {
+        SMTPSession *session = mSession;
+        const Message *msg = &pMsg;
+        return SMTPSessionAwaitable([session, msg](SMTPSession::CompletionHandler pHandler) {
+                session->sendMail(*msg, std::move(pHandler));
+                });
+    }
+
+    /** Send the complete transaction of a cpp::PlaintextMessage. */
+    SMTPSessionAwaitable send(const cpp::PlaintextMessage &pMsg) {
+        return sendConverted(PlaintextMessage(pMsg));
+    }
+
+    /** Send the complete transaction of a cpp::HTMLMessage. */
+    SMTPSessionAwaitable send(const cpp::HTMLMessage &pMsg) {
+        return sendConverted(HTMLMessage(pMsg));
+    }
+
+    /** Send a RSET command. */
+    SMTPSessionAwaitable rset() {
+        SMTPSession *session = mSession;
+        return SMTPSessionAwaitable([session](SMTPSession::CompletionHandler pHandler) {
+                session->rset(std::move(pHandler));
+                });
+    }
+
+    /** Send a QUIT command. */
+    SMTPSessionAwaitable quit() {
+        SMTPSession *session = mSession;
+        return SMTPSessionAwaitable([session](SMTPSession::CompletionHandler pHandler) {
+                session->quit(std::move(pHandler));
+                });
+    }
+
+ private:
+    template<typename T>
+    SMTPSessionAwaitable sendConverted(T pMsg) {
+        SMTPSession *session = mSession;
+        return SMTPSessionAwaitable([session, pMsg](SMTPSession::CompletionHandler pHandler) {
+                session->sendMail(pMsg, std::move(pHandler));
+                });
+    }
+
+    SMTPSession *mSession;
+};
+}  // namespace jed_utils
+
+#endif  // SMTPCLIENT_HAS_COROUTINES
+
+#endif
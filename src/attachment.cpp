@@ -10,7 +10,7 @@
 using namespace jed_utils;
 
 Attachment::Attachment(const char *pFilename, const char *pName)
-    : mName(nullptr), mFilename(nullptr) {
+    : mName(nullptr), mFilename(nullptr), mEncodedFilename(nullptr), mContentId(nullptr) {
     size_t pFileNameLength = strlen(pFilename);
     if (pFileNameLength == 0 || StringUtils::trim(std::string(pFilename)).length() == 0) {
         throw std::invalid_argument("filename");
@@ -32,18 +32,26 @@ Attachment::~Attachment() {
     mName = nullptr;
     delete[] mFilename;
     mFilename = nullptr;
+    delete[] mEncodedFilename;
+    mEncodedFilename = nullptr;
+    delete[] mContentId;
+    mContentId = nullptr;
 }
 
 // Copy constructor
 Attachment::Attachment(const Attachment& other)
     : mName(new char[strlen(other.mName) + 1]),
-      mFilename(new char[strlen(other.mFilename) + 1]) {
+      mFilename(new char[strlen(other.mFilename) + 1]),
+      mEncodedFilename(nullptr),
+      mContentId(nullptr) {
     size_t name_len = strlen(other.mName);
     strncpy(mName, other.mName, name_len);
     mName[name_len] = '\0';
     size_t filename_len = strlen(other.mFilename);
     strncpy(mFilename, other.mFilename, filename_len);
     mFilename[filename_len] = '\0';
+    setEncodedFilename(other.mEncodedFilename);
+    setContentId(other.mContentId);
 }
 
 // Assignment operator
@@ -61,17 +69,23 @@ Attachment& Attachment::operator=(const Attachment& other) {
         mFilename = new char[filename_len + 1];
         strncpy(mFilename, other.mFilename, filename_len);
         mFilename[filename_len] = '\0';
+        // mEncodedFilename and mContentId
+        setEncodedFilename(other.mEncodedFilename);
+        setContentId(other.mContentId);
     }
     return *this;
 }
 
 // Move constructor
 Attachment::Attachment(Attachment&& other) noexcept
-: mName(other.mName), mFilename(other.mFilename) {
+: mName(other.mName), mFilename(other.mFilename), mEncodedFilename(other.mEncodedFilename),
+  mContentId(other.mContentId) {
     // Release the data pointer from the source object so that the destructor
     // does not free the memory multiple times.
     other.mName = nullptr;
     other.mFilename = nullptr;
+    other.mEncodedFilename = nullptr;
+    other.mContentId = nullptr;
 }
 
 // Move assignement operator
@@ -79,13 +93,19 @@ Attachment& Attachment::operator=(Attachment&& other) noexcept {
     if (this != &other) {
         delete[] mName;
         delete[] mFilename;
+        delete[] mEncodedFilename;
+        delete[] mContentId;
         // Copy the data pointer and its length from the source object.
         mName = other.mName;
         mFilename = other.mFilename;
+        mEncodedFilename = other.mEncodedFilename;
+        mContentId = other.mContentId;
         // Release the data pointer from the source object so that
         // the destructor does not free the memory multiple times.
         other.mName = nullptr;
         other.mFilename = nullptr;
+        other.mEncodedFilename = nullptr;
+        other.mContentId = nullptr;
     }
     return *this;
 }
@@ -98,7 +118,55 @@ const char *Attachment::getFilename() const {
     return mFilename;
 }
 
+const char *Attachment::getEncodedFilename() const {
+    return mEncodedFilename;
+}
+
+void Attachment::setEncodedFilename(const char *pEncodedFilename) {
+    if (pEncodedFilename == mEncodedFilename) {
+        return;
+    }
+    delete[] mEncodedFilename;
+    mEncodedFilename = nullptr;
+    if (pEncodedFilename != nullptr) {
+        size_t encoded_filename_len = strlen(pEncodedFilename);
+        mEncodedFilename = new char[encoded_filename_len + 1];
+        memcpy(mEncodedFilename, pEncodedFilename, encoded_filename_len + 1);
+    }
+}
+
+const char *Attachment::getContentId() const {
+    return mContentId;
+}
+
+void Attachment::setContentId(const char *pContentId) {
+    if (pContentId == mContentId) {
+        return;
+    }
+    delete[] mContentId;
+    mContentId = nullptr;
+    if (pContentId != nullptr) {
+        size_t content_id_len = strlen(pContentId);
+        mContentId = new char[content_id_len + 1];
+        memcpy(mContentId, pContentId, content_id_len + 1);
+    }
+}
+
 const char *Attachment::getBase64EncodedFile() const {
+    if (mEncodedFilename != nullptr) {
+        // The content is already encoded
+        std::ifstream encoded_in(mEncodedFilename, std::ios::in | std::ios::binary);
+        if (encoded_in) {
+            std::stringstream encoded_stream;
+            encoded_stream << encoded_in.rdbuf();
+            std::string encoded_contents { encoded_stream.str() };
+            auto *encoded_file = new char[encoded_contents.length() + 1];
+            strncpy(encoded_file, encoded_contents.c_str(), encoded_contents.length() + 1);
+            return encoded_file;
+        }
+        std::cerr << "Could not open file " << mEncodedFilename << std::endl;
+        return nullptr;
+    }
     // Open the file
     std::ifstream in(mFilename, std::ios::in | std::ios::binary);
     if (in) {
@@ -109,7 +177,7 @@ const char *Attachment::getBase64EncodedFile() const {
         if (static_cast<intmax_t>(contents.size()) <= std::numeric_limits<std::streamsize>::max()) {
             in.read(&contents[0], static_cast<std::streamsize>(contents.size()));
             in.close();
-            std::string base64_result = Base64::Encode(reinterpret_cast<const unsigned char*>(contents.c_str()), contents.length());
+            std::string base64_result = Base64::EncodeWithLineBreaks(reinterpret_cast<const unsigned char*>(contents.c_str()), contents.length(), Base64::MIME_LINE_LENGTH);
             auto *base64_file = new char[base64_result.length() + 1];
             strncpy(base64_file, base64_result.c_str(), base64_result.length() + 1);
             return base64_file;
@@ -121,6 +189,16 @@ const char *Attachment::getBase64EncodedFile() const {
     return nullptr;
 }
 
+size_t Attachment::getBase64EncodedSize() const {
+    const bool is_encoded = mEncodedFilename != nullptr;
+    std::ifstream in(is_encoded ? mEncodedFilename : mFilename, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!in) {
+        return 0;
+    }
+    const auto file_size = static_cast<size_t>(in.tellg());
+    return is_encoded ? file_size : Base64::EncodedLength(file_size, Base64::MIME_LINE_LENGTH);
+}
+
 const char *Attachment::getMimeType() const {
     std::string filename_str { mFilename };
     const std::string extension = StringUtils::toUpper(filename_str.substr(filename_str.find_last_of('.') + 1));
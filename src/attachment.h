@@ -50,9 +50,43 @@ class ATTACHMENT_API Attachment {
     /** Return the file name including the path. */
     const char *getFilename() const;
 
-    /** Return the base64 representation of the file content. */
+    /** Return the pre-encoded content file name or null if none is set. */
+    const char *getEncodedFilename() const;
+
+    /**
+     *  @brief  Set the file that already contains the base64 representation
+     *  of the attachment, for example a cache file. Its lines must be
+     *  separated by CRLF. The clients then send this file as is instead of
+     *  encoding the attachment, without copying it in user space when the
+     *  connection allows it (see SecureSMTPClientBase::setKernelTLS). The
+     *  file is read in memory when the message is signed with DKIM.
+     *  @param pEncodedFilename The full path of the encoded file. Null to
+     *  encode the attachment again.
+     */
+    void setEncodedFilename(const char *pEncodedFilename);
+
+    /** Return the Content-ID of the attachment or null if none is set. */
+    const char *getContentId() const;
+
+    /**
+     *  @brief  Set the Content-ID of an attachment that the HTML body shows
+     *  inline, for example an image referenced as <img src="cid:logo">. The
+     *  attachment is then sent next to the body in a multipart/related.
+     *  @param pContentId The Content-ID without the angle brackets ("logo").
+     *  Null to send the attachment as a regular one.
+     */
+    void setContentId(const char *pContentId);
+
+    /** Return the base64 representation of the file content with a line
+     *  break every 76 characters (the content of the encoded file when one is
+     *  set). */
     const char *getBase64EncodedFile() const;
 
+    /** Return the length of the content returned by getBase64EncodedFile,
+     *  computed from the file size without reading the file. 0 if the file
+     *  cannot be opened. */
+    size_t getBase64EncodedSize() const;
+
     /** Return the MIME type corresponding to the file extension. */
     const char *getMimeType() const;
 
@@ -62,6 +96,8 @@ class ATTACHMENT_API Attachment {
     Attachment() = default;
     char *mName;
     char *mFilename;
+    char *mEncodedFilename;
+    char *mContentId;
 };
 }  // namespace jed_utils
 
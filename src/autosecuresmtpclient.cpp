@@ -0,0 +1,185 @@
+#include "autosecuresmtpclient.h"
+#include <utility>
+#include "smtpserverstatuscodes.h"
+#include "sslerrors.h"
+
+using namespace jed_utils;
+
+AutoSecureSMTPClient::AutoSecureSMTPClient(const char *pServerName, unsigned int pPort)
+    : OpportunisticSecureSMTPClient(pServerName, pPort),
+      mCapabilityCache(nullptr),
+      mSecurityMode(ServerSecurityMode::StartTLS),
+      mCapabilityCacheHit(false) {
+}
+
+// Assignment operator
+AutoSecureSMTPClient& AutoSecureSMTPClient::operator=(const AutoSecureSMTPClient& other) {
+    if (this != &other) {
+        OpportunisticSecureSMTPClient::operator=(other);
+        mCapabilityCache = other.mCapabilityCache;
+        mSecurityMode = other.mSecurityMode;
+        mCapabilityCacheHit = other.mCapabilityCacheHit;
+    }
+    return *this;
+}
+
+// Move constructor
+AutoSecureSMTPClient::AutoSecureSMTPClient(AutoSecureSMTPClient&& other) noexcept
+    : OpportunisticSecureSMTPClient(std::move(other)),
+      mCapabilityCache(std::move(other.mCapabilityCache)),
+      mSecurityMode(other.mSecurityMode),
+      mCapabilityCacheHit(other.mCapabilityCacheHit) {
+}
+
+// Move assignement operator
+AutoSecureSMTPClient& AutoSecureSMTPClient::operator=(AutoSecureSMTPClient&& other) noexcept {
+    if (this != &other) {
+        OpportunisticSecureSMTPClient::operator=(std::move(other));
+        mCapabilityCache = std::move(other.mCapabilityCache);
+        mSecurityMode = other.mSecurityMode;
+        mCapabilityCacheHit = other.mCapabilityCacheHit;
+    }
+    return *this;
+}
+
+std::shared_ptr<ServerCapabilityCache> AutoSecureSMTPClient::getCapabilityCache() const {
+    return mCapabilityCache;
+}
+
+void AutoSecureSMTPClient::setCapabilityCache(std::shared_ptr<ServerCapabilityCache> pCapabilityCache) {
+    mCapabilityCache = std::move(pCapabilityCache);
+}
+
+ServerSecurityMode AutoSecureSMTPClient::getSecurityMode() const {
+    return mSecurityMode;
+}
+
+bool AutoSecureSMTPClient::isCapabilityCacheHit() const {
+    return mCapabilityCacheHit;
+}
+
+int AutoSecureSMTPClient::establishConnectionWithServer() {
+    std::shared_ptr<ServerCapabilityCache> cache { mCapabilityCache ? mCapabilityCache : ServerCapabilityCache::getDefault() };
+    ServerCapabilities capabilities;
+    bool tls_refused = false;
+    mCapabilityCacheHit = cache->find(getServerName(), getServerPort(), capabilities);
+    if (mCapabilityCacheHit) {
+        const ServerSecurityMode cached_security_mode = capabilities.SecurityMode;
+        int cached_return_code = connectWithCapabilities(capabilities, true, tls_refused);
+        if (cached_return_code != 0) {
+            // The server has changed, it will be probed on the next connection
+            cache->remove(getServerName(), getServerPort());
+        } else if (capabilities.SecurityMode != cached_security_mode) {
+            cache->store(getServerName(), getServerPort(), capabilities);
+        }
+        return cached_return_code;
+    }
+
+    // A server that expects STARTTLS sends its greeting in clear text, which
+    // makes the TLS handshake fail right away.
+    capabilities.SecurityMode = ServerSecurityMode::Implicit;
+    int return_code = connectWithCapabilities(capabilities, false, tls_refused);
+    if (return_code != 0 && tls_refused) {
+        cleanup();
+        capabilities = ServerCapabilities();
+        capabilities.SecurityMode = ServerSecurityMode::StartTLS;
+        return_code = connectWithCapabilities(capabilities, false, tls_refused);
+    }
+    if (return_code == 0) {
+        cache->store(getServerName(), getServerPort(), capabilities);
+    }
+    return return_code;
+}
+
+int AutoSecureSMTPClient::checkServerGreetings() {
+    if (mSecurityMode == ServerSecurityMode::Implicit) {
+        return checkSecureServerGreetings();
+    }
+    return SMTPClientBase::checkServerGreetings();
+}
+
+int AutoSecureSMTPClient::connectWithCapabilities(ServerCapabilities &pCapabilities, bool pFromCache, bool &pTLSRefused) {
+    pTLSRefused = false;
+    mSecurityMode = pCapabilities.SecurityMode;
+    setKeepUsingBaseSendCommands(false);
+    int session_init_return_code = initializeSession();
+    if (session_init_return_code != 0) {
+        return session_init_return_code;
+    }
+
+    if (mSecurityMode == ServerSecurityMode::Implicit) {
+        addCommunicationLogItem(pFromCache
+            ? "Info: The server accepts TLS from the initial connection (cached)."
+            : "Info: Trying TLS from the initial connection.");
+        int tls_start_return_code = startTLSNegotiation();
+        if (tls_start_return_code != 0) {
+            pTLSRefused = tls_start_return_code == SSL_CLIENT_STARTTLS_BIO_HANDSHAKE_ERROR
+                || tls_start_return_code == SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT;
+            return tls_start_return_code;
+        }
+        int server_greetings_return_code = checkServerGreetings();
+        if (server_greetings_return_code != STATUS_CODE_SERVICE_READY) {
+            return server_greetings_return_code;
+        }
+        return identifyOnSecureChannel(pCapabilities, pFromCache);
+    }
+
+    int server_greetings_return_code = checkServerGreetings();
+    if (server_greetings_return_code != STATUS_CODE_SERVICE_READY) {
+        return server_greetings_return_code;
+    }
+    int client_init_return_code = sendServerIdentification();
+    if (client_init_return_code != STATUS_CODE_REQUESTED_MAIL_ACTION_OK_OR_COMPLETED) {
+        return client_init_return_code;
+    }
+    // A server cached as unencrypted is checked again, it may offer STARTTLS now
+    if (!pFromCache || mSecurityMode == ServerSecurityMode::Unencrypted) {
+        const ServerAuthOptions *options = getAuthenticationOptions();
+        pCapabilities.SecurityMode = options != nullptr && options->StartTLS
+            ? ServerSecurityMode::StartTLS
+            : ServerSecurityMode::Unencrypted;
+        pCapabilities.EhloResponse = getLastServerResponse();
+        pCapabilities.Options = options != nullptr ? *options : ServerAuthOptions();
+        pFromCache = pFromCache && pCapabilities.SecurityMode == mSecurityMode;
+        mSecurityMode = pCapabilities.SecurityMode;
+    }
+    if (mSecurityMode == ServerSecurityMode::Unencrypted) {
+        addCommunicationLogItem("Info: STARTTLS is not an available option by the server, the communication will then remain unencrypted.");
+        setKeepUsingBaseSendCommands(true);
+        return 0;
+    }
+
+    addCommunicationLogItem("Info: STARTTLS is available by the server, the communication will be encrypted.");
+    int tls_init_return_code = upgradeToSecureConnection();
+    if (tls_init_return_code != STATUS_CODE_SERVICE_READY) {
+        return tls_init_return_code;
+    }
+    int tls_start_return_code = startTLSNegotiation();
+    if (tls_start_return_code != 0) {
+        return tls_start_return_code;
+    }
+    return identifyOnSecureChannel(pCapabilities, pFromCache);
+}
+
+int AutoSecureSMTPClient::identifyOnSecureChannel(ServerCapabilities &pCapabilities, bool pFromCache) {
+    int client_initSecure_return_code = sendSecureServerIdentification();
+    if (client_initSecure_return_code != STATUS_CODE_REQUESTED_MAIL_ACTION_OK_OR_COMPLETED) {
+        return client_initSecure_return_code;
+    }
+    auto *options = new ServerAuthOptions();
+    if (pFromCache) {
+        *options = pCapabilities.Options;
+    } else {
+        parseEhloResponse(getLastServerResponse(), options);
+        pCapabilities.EhloResponse = getLastServerResponse();
+        pCapabilities.Options = *options;
+    }
+    setAuthenticationOptions(options);
+    if (getCredentials() != nullptr) {
+        int client_auth_return_code = authenticateClient();
+        if (client_auth_return_code != STATUS_CODE_AUTHENTICATION_SUCCEEDED) {
+            return client_auth_return_code;
+        }
+    }
+    return 0;
+}
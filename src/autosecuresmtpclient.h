@@ -0,0 +1,88 @@
+#ifndef AUTOSECURESMTPCLIENT_H
+#define AUTOSECURESMTPCLIENT_H
+
+#include <memory>
+#include "opportunisticsecuresmtpclient.h"
+#include "servercapabilitycache.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define AUTOSECURESMTPCLIENT_API __declspec(dllexport)
+    #else
+        #define AUTOSECURESMTPCLIENT_API __declspec(dllimport)
+    #endif
+#else
+    #define AUTOSECURESMTPCLIENT_API
+#endif
+
+namespace jed_utils {
+/** @brief The AutoSecureSMTPClient finds by itself how to secure the
+ *  communication with a server: TLS from the initial connection (like the
+ *  ForcedSecureSMTPClient), STARTTLS (like the OpportunisticSecureSMTPClient)
+ *  or no encryption when the server offers neither.
+ *
+ *  The first connection to a server tries implicit TLS and falls back to
+ *  STARTTLS if the server does not answer the TLS handshake. What was found
+ *  (security mode, EHLO response and AUTH methods) is stored in a
+ *  ServerCapabilityCache, so the next connections go straight to the right
+ *  path and reuse the AUTH methods instead of parsing the EHLO response.
+ *  A connection that fails removes the server from the cache.
+ */
+class AUTOSECURESMTPCLIENT_API AutoSecureSMTPClient : public OpportunisticSecureSMTPClient {
+ public:
+    /**
+     *  @brief  Construct a new AutoSecureSMTPClient.
+     *  @param pServerName The name of the server.
+     *  Example: smtp.domainexample.com
+     *  @param pPort The server port number.
+     *  Example: 25, 465, 587
+     */
+    AutoSecureSMTPClient(const char *pServerName, unsigned int pPort);
+
+    /** Destructor of the AutoSecureSMTPClient. */
+    ~AutoSecureSMTPClient() = default;
+
+    /** AutoSecureSMTPClient copy constructor. */
+    AutoSecureSMTPClient(const AutoSecureSMTPClient& other) = default;
+
+    /** AutoSecureSMTPClient copy assignment operator. */
+    AutoSecureSMTPClient& operator=(const AutoSecureSMTPClient& other);
+
+    /** AutoSecureSMTPClient move constructor. */
+    AutoSecureSMTPClient(AutoSecureSMTPClient&& other) noexcept;
+
+    /** AutoSecureSMTPClient move assignment operator. */
+    AutoSecureSMTPClient& operator=(AutoSecureSMTPClient&& other) noexcept;
+
+    /** Return the capability cache used by the client. Null means the
+     *  default cache of the process (see ServerCapabilityCache::getDefault). */
+    std::shared_ptr<ServerCapabilityCache> getCapabilityCache() const;
+
+    /**
+     *  @brief  Set the capability cache used by the next connections.
+     *  @param pCapabilityCache The cache. Null to use the default cache of
+     *  the process.
+     */
+    void setCapabilityCache(std::shared_ptr<ServerCapabilityCache> pCapabilityCache);
+
+    /** Return the security mode of the last connection. */
+    ServerSecurityMode getSecurityMode() const;
+
+    /** Return true if the last connection used the capabilities found in
+     *  the cache instead of probing the server. */
+    bool isCapabilityCacheHit() const;
+
+ protected:
+    int establishConnectionWithServer() override;
+    int checkServerGreetings() override;
+    int connectWithCapabilities(ServerCapabilities &pCapabilities, bool pFromCache, bool &pTLSRefused);
+    int identifyOnSecureChannel(ServerCapabilities &pCapabilities, bool pFromCache);
+
+ private:
+    std::shared_ptr<ServerCapabilityCache> mCapabilityCache;
+    ServerSecurityMode mSecurityMode;
+    bool mCapabilityCacheHit;
+};
+}  // namespace jed_utils
+
+#endif
@@ -30,6 +30,8 @@
 
 using namespace jed_utils;
 
+const size_t Base64::MIME_LINE_LENGTH;
+
 static const std::string base64_chars =
 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 "abcdefghijklmnopqrstuvwxyz"
@@ -40,6 +42,10 @@ static inline bool is_base64(unsigned char c) {
     return (isalnum(c) || (c == '+') || (c == '/'));
 }
 
+static inline bool is_line_break(unsigned char c) {
+    return c == '\r' || c == '\n';
+}
+
 std::string Base64::Encode(unsigned char const *bytes_to_encode, size_t in_len) {
     std::string ret;
     int i = 0;
@@ -81,41 +87,70 @@ std::string Base64::Encode(unsigned char const *bytes_to_encode, size_t in_len)
 
 }
 
+std::string Base64::EncodeWithLineBreaks(unsigned char const *bytes_to_encode, size_t in_len, size_t line_length) {
+    const std::string encoded = Encode(bytes_to_encode, in_len);
+    if (line_length == 0 || encoded.length() <= line_length) {
+        return encoded;
+    }
+    std::string ret;
+    ret.reserve(EncodedLength(in_len, line_length));
+    for (size_t line_start = 0; line_start < encoded.length(); line_start += line_length) {
+        if (line_start != 0) {
+            ret += "\r\n";
+        }
+        ret.append(encoded, line_start, line_length);
+    }
+    return ret;
+}
+
+size_t Base64::EncodedLength(size_t in_len, size_t line_length) {
+    const size_t encoded_length = (in_len + 2) / 3 * 4;
+    if (line_length == 0 || encoded_length == 0) {
+        return encoded_length;
+    }
+    const size_t line_count = (encoded_length + line_length - 1) / line_length;
+    return encoded_length + (line_count - 1) * 2;
+}
+
 std::string Base64::Decode(std::string const &encoded_string) {
     size_t in_len = encoded_string.size();
-    int i = 0;
-    int in_ = 0;
+    size_t i = 0;
+    size_t in_ = 0;
     unsigned char char_array_4[4], char_array_3[3];
     std::string ret;
 
-    while (in_len-- && (encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-        char_array_4[i++] = encoded_string[in_]; in_++;
+    while (in_len-- && (encoded_string[in_] != '=') && (is_base64(static_cast<unsigned char>(encoded_string[in_])) || is_line_break(static_cast<unsigned char>(encoded_string[in_])))) {
+        if (is_line_break(static_cast<unsigned char>(encoded_string[in_]))) {
+            in_++;
+            continue;
+        }
+        char_array_4[i++] = static_cast<unsigned char>(encoded_string[in_]); in_++;
         if (i == 4) {
             for (i = 0; i < 4; i++)
-                char_array_4[i] = static_cast<unsigned char>(base64_chars.find(char_array_4[i]));
+                char_array_4[i] = static_cast<unsigned char>(base64_chars.find(static_cast<char>(char_array_4[i])));
 
-            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+            char_array_3[0] = static_cast<unsigned char>((char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4));
+            char_array_3[1] = static_cast<unsigned char>(((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2));
+            char_array_3[2] = static_cast<unsigned char>(((char_array_4[2] & 0x3) << 6) + char_array_4[3]);
 
             for (i = 0; (i < 3); i++)
-                ret += char_array_3[i];
+                ret += static_cast<char>(char_array_3[i]);
             i = 0;
         }
     }
 
     if (i) {
-        for (int j = i; j < 4; j++)
+        for (size_t j = i; j < 4; j++)
             char_array_4[j] = 0;
 
-        for (int j = 0; j < 4; j++)
-            char_array_4[j] = static_cast<unsigned char>(base64_chars.find(char_array_4[j]));
+        for (size_t j = 0; j < 4; j++)
+            char_array_4[j] = static_cast<unsigned char>(base64_chars.find(static_cast<char>(char_array_4[j])));
 
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+        char_array_3[0] = static_cast<unsigned char>((char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4));
+        char_array_3[1] = static_cast<unsigned char>(((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2));
+        char_array_3[2] = static_cast<unsigned char>(((char_array_4[2] & 0x3) << 6) + char_array_4[3]);
 
-        for (int j = 0; (j < i - 1); j++) ret += char_array_3[j];
+        for (size_t j = 0; (j < i - 1); j++) ret += static_cast<char>(char_array_3[j]);
     }
 
     return ret;
@@ -6,7 +6,13 @@
 namespace jed_utils {
 class Base64 {
  public:
+    // Maximum length of a base64 line in a MIME body (RFC 2045)
+    static const size_t MIME_LINE_LENGTH = 76;
     static std::string Encode(unsigned char const *bytes_to_encode, size_t in_len);
+    // Encode and break the lines with CRLF every line_length characters (MIME)
+    static std::string EncodeWithLineBreaks(unsigned char const *bytes_to_encode, size_t in_len, size_t line_length = MIME_LINE_LENGTH);
+    // Length of the encoded content, line breaks included if line_length is not 0
+    static size_t EncodedLength(size_t in_len, size_t line_length = 0);
     static std::string Decode(std::string const &encoded_string);
 };
 }  // namespace jed_utils
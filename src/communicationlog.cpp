@@ -0,0 +1,108 @@
+#include "communicationlog.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace jed_utils;
+
+const size_t CommunicationLog::DEFAULT_MAX_SIZE;
+const size_t CommunicationLog::CHUNK_SIZE;
+
+CommunicationLog::CommunicationLog()
+    : mLevel(CommunicationLogLevel::Full),
+      mMaxSize(DEFAULT_MAX_SIZE),
+      mSize(0),
+      mTruncated(false),
+      mTextValid(false) {
+}
+
+CommunicationLogLevel CommunicationLog::getLevel() const {
+    return mLevel;
+}
+
+void CommunicationLog::setLevel(CommunicationLogLevel pLevel) {
+    mLevel = pLevel;
+}
+
+size_t CommunicationLog::getMaxSize() const {
+    return mMaxSize;
+}
+
+void CommunicationLog::setMaxSize(size_t pMaxSize) {
+    mMaxSize = pMaxSize;
+    append(nullptr, 0);
+}
+
+void CommunicationLog::add(const char *pItem, const char *pPrefix, bool pEscapeLineBreaks) {
+    if (mLevel == CommunicationLogLevel::Off) {
+        return;
+    }
+    append("\n", 1);
+    append(pPrefix, strlen(pPrefix));
+    append(": ", 2);
+    const size_t length = pItem != nullptr ? strlen(pItem) : 0;
+    if (!pEscapeLineBreaks) {
+        append(pItem, length);
+        return;
+    }
+    const char *end = pItem + length;
+    const char *start = pItem;
+    for (const char *found = start; (found = static_cast<const char *>(memchr(found, '\r', static_cast<size_t>(end - found)))) != nullptr;) {
+        if (found + 1 < end && found[1] == '\n') {
+            append(start, static_cast<size_t>(found - start));
+            append("\\r\\n", 4);
+            start = found + 2;
+            found = start;
+        } else {
+            found++;
+        }
+    }
+    append(start, static_cast<size_t>(end - start));
+}
+
+void CommunicationLog::clear() {
+    mChunks.clear();
+    mSize = 0;
+    mTruncated = false;
+    mTextValid = false;
+}
+
+size_t CommunicationLog::getSize() const {
+    return mSize;
+}
+
+const std::string &CommunicationLog::getText() const {
+    if (!mTextValid) {
+        mText.clear();
+        mText.reserve(mSize);
+        for (const auto &chunk : mChunks) {
+            mText += chunk;
+        }
+        if (mTruncated) {
+            // The first item was partly dropped
+            mText.erase(0, std::min(mText.find('\n'), mText.length()));
+        }
+        mTextValid = true;
+    }
+    return mText;
+}
+
+void CommunicationLog::append(const char *pData, size_t pLength) {
+    mTextValid = false;
+    while (pLength > 0) {
+        if (mChunks.empty() || mChunks.back().length() == CHUNK_SIZE) {
+            mChunks.emplace_back();
+            mChunks.back().reserve(CHUNK_SIZE);
+        }
+        std::string &chunk = mChunks.back();
+        const size_t length = std::min(pLength, CHUNK_SIZE - chunk.length());
+        chunk.append(pData, length);
+        pData += length;
+        pLength -= length;
+        mSize += length;
+    }
+    while (mMaxSize > 0 && mSize > mMaxSize && mChunks.size() > 1) {
+        mSize -= mChunks.front().length();
+        mChunks.pop_front();
+        mTruncated = true;
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef COMMUNICATIONLOG_H
+#define COMMUNICATIONLOG_H
+
+#include <cstddef>
+#include <deque>
+#include <string>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define COMMUNICATIONLOG_API __declspec(dllexport)
+    #else
+        #define COMMUNICATIONLOG_API __declspec(dllimport)
+    #endif
+#else
+    #define COMMUNICATIONLOG_API
+#endif
+
+namespace jed_utils {
+/** @brief What the communication log of a client keeps. Each level includes
+ *  the items of the levels before it.
+ */
+enum class CommunicationLogLevel {
+    /** Nothing, the items are dropped before any work */
+    Off,
+    /** The commands, the replies of the server and the information messages */
+    Commands,
+    /** The header fields of the messages */
+    Headers,
+    /** The texts of the messages. The attachments are never logged. */
+    Full
+};
+
+/** @brief The CommunicationLog class keeps the last items exchanged with
+ *  the server.
+ *
+ *  The items are appended to chunks of CHUNK_SIZE bytes, so an append never
+ *  copies the previous items. When the log exceeds its maximum size, the
+ *  oldest chunks are dropped. The text of the log is only assembled when it
+ *  is requested.
+ */
+class COMMUNICATIONLOG_API CommunicationLog {
+ public:
+    /** The default maximum size of the log in bytes. */
+    static const size_t DEFAULT_MAX_SIZE = 1048576;
+
+    /** The length of the chunks that store the log. */
+    static const size_t CHUNK_SIZE = 4096;
+
+    /** Construct an empty log of level Full and of size DEFAULT_MAX_SIZE. */
+    CommunicationLog();
+
+    /** Return the level of the items kept. */
+    CommunicationLogLevel getLevel() const;
+
+    /**
+     *  @brief  Set the level of the items kept.
+     *  @param pLevel The level. Off drops all the items.
+     */
+    void setLevel(CommunicationLogLevel pLevel);
+
+    /** Return the maximum size of the log in bytes, 0 if unbounded. */
+    size_t getMaxSize() const;
+
+    /**
+     *  @brief  Set the maximum size of the log. The oldest items are dropped
+     *  when it is exceeded.
+     *  @param pMaxSize The maximum size in bytes, 0 for an unbounded log.
+     */
+    void setMaxSize(size_t pMaxSize);
+
+    /** Return true if the items of the level are kept. */
+    bool isEnabled(CommunicationLogLevel pLevel) const {
+        return pLevel != CommunicationLogLevel::Off && pLevel <= mLevel;
+    }
+
+    /**
+     *  @brief  Append an item on a new line: the prefix, a colon and the
+     *  item.
+     *  @param pItem The item.
+     *  @param pPrefix The prefix of the line ("c" for the client, "s" for the
+     *  server).
+     *  @param pEscapeLineBreaks True to write the CRLF of the item as \\r\\n.
+     */
+    void add(const char *pItem, const char *pPrefix, bool pEscapeLineBreaks);
+
+    /** Remove all the items. */
+    void clear();
+
+    /** Return the size of the log in bytes. */
+    size_t getSize() const;
+
+    /** Return the text of the log. It stays valid until the next change. */
+    const std::string &getText() const;
+
+ private:
+    void append(const char *pData, size_t pLength);
+
+    CommunicationLogLevel mLevel;
+    size_t mMaxSize;
+    std::deque<std::string> mChunks;
+    size_t mSize;
+    bool mTruncated;
+    mutable std::string mText;
+    mutable bool mTextValid;
+};
+}  // namespace jed_utils
+
+#endif
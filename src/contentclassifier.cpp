@@ -0,0 +1,126 @@
+#include "contentclassifier.h"
+#include <algorithm>
+#include "simdutils.h"
+#include "utf8validator.h"
+
+using namespace jed_utils;
+
+const size_t ContentClassifier::MAX_LINE_LENGTH;
+
+namespace {
+    struct ClassificationState {
+        ContentClassification Result;
+        size_t LineLength = 0;
+        // The offset that follows the last CR, to pair it with a LF
+        size_t AfterCarriageReturn = 0;
+    };
+
+    // Account for a byte that is not printable ASCII
+    inline void classifySpecialByte(ClassificationState &pState, unsigned char pByte, size_t pOffset) {
+        if (pByte == '\n') {
+            pState.Result.LongestLine = std::max(pState.Result.LongestLine, pState.LineLength);
+            pState.LineLength = 0;
+            if (pState.AfterCarriageReturn == pOffset && pOffset != 0) {
+                // The CR counted as bare is the start of a CRLF
+                pState.Result.BareLineBreakCount--;
+            } else {
+                pState.Result.BareLineBreakCount++;
+            }
+            return;
+        }
+        if (pByte == '\r') {
+            pState.Result.BareLineBreakCount++;
+            pState.AfterCarriageReturn = pOffset + 1;
+            return;
+        }
+        if (pByte == 0) {
+            pState.Result.Binary = true;
+        } else if (pByte > 127) {
+            pState.Result.EightBitCount++;
+        }
+        pState.LineLength++;
+    }
+}  // namespace
+
+ContentClassification ContentClassifier::classify(const char *pData, size_t pLength) {
+    ClassificationState state;
+    if (pData == nullptr) {
+        return state.Result;
+    }
+    const auto *data = reinterpret_cast<const unsigned char *>(pData);
+    size_t offset = 0;
+#ifdef SMTPCLIENT_SSE2
+    // The signed comparison flags the control characters and, as negative
+    // values, the bytes above 127. Blocks of printable ASCII are only counted.
+    const __m128i printable_start = _mm_set1_epi8(0x20);
+    for (; offset + 16 <= pLength; offset += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+        auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmplt_epi8(block, printable_start)));
+        if (mask == 0) {
+            state.LineLength += 16;
+            continue;
+        }
+        unsigned int previous = 0;
+        while (mask != 0) {
+            const unsigned int position = simd::countTrailingZeros(mask);
+            state.LineLength += position - previous;
+            classifySpecialByte(state, data[offset + position], offset + position);
+            previous = position + 1;
+            mask &= mask - 1;
+        }
+        state.LineLength += 16 - previous;
+    }
+#endif
+    for (; offset < pLength; offset++) {
+        const unsigned char byte = data[offset];
+        if (byte < 0x20 || byte > 127) {
+            classifySpecialByte(state, byte, offset);
+        } else {
+            state.LineLength++;
+        }
+    }
+    state.Result.LongestLine = std::max(state.Result.LongestLine, state.LineLength);
+    if (state.Result.EightBitCount > 0) {
+        state.Result.InvalidUTF8 = !UTF8Validator::isValid(pData, pLength);
+    }
+    return state.Result;
+}
+
+TransferEncoding ContentClassifier::selectEncoding(const ContentClassification &pClassification,
+        size_t pLength,
+        bool pEightBitMime) {
+    // The bytes are kept intact, a relay could reject them as 8-bit text
+    if (pClassification.Binary || pClassification.InvalidUTF8) {
+        return TransferEncoding::Base64;
+    }
+    if (pClassification.LongestLine <= MAX_LINE_LENGTH) {
+        if (pClassification.EightBitCount == 0) {
+            return TransferEncoding::SevenBit;
+        }
+        if (pEightBitMime) {
+            return TransferEncoding::EightBit;
+        }
+    }
+    // An escaped byte takes 3 characters, base64 takes 4 for 3 bytes (plus
+    // the line breaks). Quoted-printable stays smaller below 1/6 of 8-bit bytes.
+    if (pClassification.EightBitCount * 6 < pLength) {
+        return TransferEncoding::QuotedPrintable;
+    }
+    return TransferEncoding::Base64;
+}
+
+const char *ContentClassifier::getEncodingName(TransferEncoding pEncoding) {
+    switch (pEncoding) {
+        case TransferEncoding::SevenBit:
+            return "7bit";
+        case TransferEncoding::EightBit:
+            return "8bit";
+        case TransferEncoding::QuotedPrintable:
+            return "quoted-printable";
+        case TransferEncoding::Base64:
+            return "base64";
+        case TransferEncoding::Automatic:
+            break;
+    }
+    return "7bit";
+}
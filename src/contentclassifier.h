@@ -0,0 +1,83 @@
+#ifndef CONTENTCLASSIFIER_H
+#define CONTENTCLASSIFIER_H
+
+#include <cstddef>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define CONTENTCLASSIFIER_API __declspec(dllexport)
+    #else
+        #define CONTENTCLASSIFIER_API __declspec(dllimport)
+    #endif
+#else
+    #define CONTENTCLASSIFIER_API
+#endif
+
+namespace jed_utils {
+/** @brief The Content-Transfer-Encoding of a MIME part (RFC 2045). */
+enum class TransferEncoding {
+    /** ASCII lines of at most 998 characters, sent as is */
+    SevenBit,
+    /** 8-bit lines of at most 998 characters, sent as is (needs 8BITMIME) */
+    EightBit,
+    /** Mostly ASCII text, the other bytes are escaped */
+    QuotedPrintable,
+    /** Binary, mostly non-ASCII or invalid UTF-8 content */
+    Base64,
+    /** Selected from the content by the ContentClassifier */
+    Automatic
+};
+
+/** @brief What a single pass over a content found. */
+struct ContentClassification {
+    /** The number of bytes above 127. */
+    size_t EightBitCount = 0;
+    /** The content holds NUL bytes. */
+    bool Binary = false;
+    /** The length of the longest line, CRLF excluded. */
+    size_t LongestLine = 0;
+    /** The number of CR and LF that are not part of a CRLF. */
+    size_t BareLineBreakCount = 0;
+    /** The bytes above 127 are not valid UTF-8. */
+    bool InvalidUTF8 = false;
+};
+
+/** @brief The ContentClassifier class finds the cheapest transfer encoding
+ *  that carries a content unaltered.
+ *
+ *  The classification is a single pass that checks 16 bytes at a time with
+ *  SSE2 when it is available, so the common case of plain ASCII text costs
+ *  little more than reading it. A content with 8-bit bytes is then checked
+ *  by the UTF8Validator, as it is declared as UTF-8.
+ */
+class CONTENTCLASSIFIER_API ContentClassifier {
+ public:
+    /** The maximum length of a line in SMTP, CRLF excluded (RFC 5321). */
+    static const size_t MAX_LINE_LENGTH = 998;
+
+    /**
+     *  @brief  Classify a content.
+     *  @param pData The content.
+     *  @param pLength The length of the content.
+     */
+    static ContentClassification classify(const char *pData, size_t pLength);
+
+    /**
+     *  @brief  Return the cheapest transfer encoding of a classified content.
+     *  @param pClassification The classification of the content.
+     *  @param pLength The length of the content.
+     *  @param pEightBitMime True if the server accepts 8-bit data (8BITMIME).
+     */
+    static TransferEncoding selectEncoding(const ContentClassification &pClassification,
+            size_t pLength,
+            bool pEightBitMime);
+
+    /**
+     *  @brief  Return the value of the Content-Transfer-Encoding header.
+     *  @param pEncoding The transfer encoding.
+     */
+    static const char *getEncodingName(TransferEncoding pEncoding);
+};
+}  // namespace jed_utils
+
+#endif
@@ -14,6 +14,24 @@ std::string Attachment::getFilename() const {
     return jed_utils::Attachment::getFilename();
 }
 
+std::string Attachment::getEncodedFilename() const {
+    const char *retval = jed_utils::Attachment::getEncodedFilename();
+    return retval == nullptr ? "" : retval;
+}
+
+void Attachment::setEncodedFilename(const std::string &pEncodedFilename) {
+    jed_utils::Attachment::setEncodedFilename(pEncodedFilename.empty() ? nullptr : pEncodedFilename.c_str());
+}
+
+std::string Attachment::getContentId() const {
+    const char *retval = jed_utils::Attachment::getContentId();
+    return retval == nullptr ? "" : retval;
+}
+
+void Attachment::setContentId(const std::string &pContentId) {
+    jed_utils::Attachment::setContentId(pContentId.empty() ? nullptr : pContentId.c_str());
+}
+
 std::string Attachment::getBase64EncodedFile() const {
     const char *retval = jed_utils::Attachment::getBase64EncodedFile();
     return retval == nullptr ? "" : retval;
@@ -24,7 +42,10 @@ std::string Attachment::getMimeType() const {
 }
 
 jed_utils::Attachment Attachment::toStdAttachment() const {
-    return jed_utils::Attachment(jed_utils::Attachment::getFilename(),
+    jed_utils::Attachment retval(jed_utils::Attachment::getFilename(),
                                  jed_utils::Attachment::getName());
+    retval.setEncodedFilename(jed_utils::Attachment::getEncodedFilename());
+    retval.setContentId(jed_utils::Attachment::getContentId());
+    return retval;
 }
 
@@ -52,6 +52,30 @@ class CPP_ATTACHMENT_API Attachment : private jed_utils::Attachment {
     /** Return the file name including the path. */
     std::string getFilename() const;
 
+    /** Return the pre-encoded content file name or an empty string if none
+     *  is set. */
+    std::string getEncodedFilename() const;
+
+    /**
+     *  @brief  Set the file that already contains the base64 representation
+     *  of the attachment (see jed_utils::Attachment::setEncodedFilename).
+     *  @param pEncodedFilename The full path of the encoded file. Empty to
+     *  encode the attachment again.
+     */
+    void setEncodedFilename(const std::string &pEncodedFilename);
+
+    /** Return the Content-ID of the attachment or an empty string if none
+     *  is set. */
+    std::string getContentId() const;
+
+    /**
+     *  @brief  Set the Content-ID of an attachment that the HTML body shows
+     *  inline (see jed_utils::Attachment::setContentId).
+     *  @param pContentId The Content-ID without the angle brackets. Empty to
+     *  send the attachment as a regular one.
+     */
+    void setContentId(const std::string &pContentId);
+
     /** Return the base64 representation of the file content. */
     std::string getBase64EncodedFile() const;
 
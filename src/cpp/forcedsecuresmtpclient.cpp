@@ -28,6 +28,14 @@ std::string ForcedSecureSMTPClient::getCommunicationLog() const {
     return jed_utils::ForcedSecureSMTPClient::getCommunicationLog();
 }
 
+jed_utils::CommunicationLogLevel ForcedSecureSMTPClient::getCommunicationLogLevel() const {
+    return jed_utils::SMTPClientBase::getCommunicationLogLevel();
+}
+
+size_t ForcedSecureSMTPClient::getCommunicationLogMaxSize() const {
+    return jed_utils::SMTPClientBase::getCommunicationLogMaxSize();
+}
+
 const Credential *ForcedSecureSMTPClient::getCredentials() const {
     return mCredential;
 }
@@ -55,6 +63,14 @@ void ForcedSecureSMTPClient::setKeepUsingBaseSendCommands(bool pValue) {
     jed_utils::SMTPClientBase::setKeepUsingBaseSendCommands(pValue);
 }
 
+void ForcedSecureSMTPClient::setCommunicationLogLevel(jed_utils::CommunicationLogLevel pLevel) {
+    jed_utils::SMTPClientBase::setCommunicationLogLevel(pLevel);
+}
+
+void ForcedSecureSMTPClient::setCommunicationLogMaxSize(size_t pMaxSize) {
+    jed_utils::SMTPClientBase::setCommunicationLogMaxSize(pMaxSize);
+}
+
 std::string ForcedSecureSMTPClient::getErrorMessage(int errorCode) {
     return jed_utils::SMTPClientBase::getErrorMessage(errorCode);
 }
@@ -79,3 +95,7 @@ jed_utils::ServerAuthOptions *ForcedSecureSMTPClient::extractAuthenticationOptio
 int ForcedSecureSMTPClient::sendMail(const jed_utils::Message &pMsg) {
     return jed_utils::ForcedSecureSMTPClient::sendMail(pMsg);
 }
+
+int ForcedSecureSMTPClient::sendMail(const jed_utils::Message &pMsg, jed_utils::SendReport *pReport) {
+    return jed_utils::ForcedSecureSMTPClient::sendMail(pMsg, pReport);
+}
@@ -32,7 +32,7 @@ HTMLMessage::operator jed_utils::HTMLMessage() const {
     const auto cc = getStdMessageAddressVec(getCc());
     const auto bcc = getStdMessageAddressVec(getBcc());
     const auto att = getStdAttachmentVec(getAttachments());
-    const jed_utils::HTMLMessage msg (getFrom().toStdMessageAddress(),
+    jed_utils::HTMLMessage msg (getFrom().toStdMessageAddress(),
                                   to.data(),
                                   to.size(),
                                   getSubject().c_str(),
@@ -43,5 +43,9 @@ HTMLMessage::operator jed_utils::HTMLMessage() const {
                                   bcc.size(),
                                   att.data(),
                                   att.size());
+    msg.setBodyTransferEncoding(getBodyTransferEncoding());
+    if (!getAlternativeBody().empty()) {
+        msg.setAlternativeBody(getAlternativeBody().c_str());
+    }
     return msg;
 }
@@ -18,7 +18,8 @@ Message::Message(const MessageAddress &pFrom,
       mBody(pBody),
       mCc(pCc),
       mBcc(pBcc),
-      mAttachments(pAttachments) {
+      mAttachments(pAttachments),
+      mBodyTransferEncoding(TransferEncoding::Automatic) {
     if (pTo.empty()) {
         throw std::invalid_argument("To cannot be empty");
     }
@@ -68,6 +69,22 @@ size_t Message::getAttachmentsCount() const {
     return mAttachments.size();
 }
 
+jed_utils::TransferEncoding Message::getBodyTransferEncoding() const {
+    return mBodyTransferEncoding;
+}
+
+void Message::setBodyTransferEncoding(TransferEncoding pEncoding) {
+    mBodyTransferEncoding = pEncoding;
+}
+
+std::string Message::getAlternativeBody() const {
+    return mAlternativeBody;
+}
+
+void Message::setAlternativeBody(const std::string &pAlternativeBody) {
+    mAlternativeBody = pAlternativeBody;
+}
+
 std::vector<jed_utils::MessageAddress> Message::getStdMessageAddressVec(const std::vector<MessageAddress> &src) const {
     std::vector<jed_utils::MessageAddress> retval = {};
     std::transform(src.cbegin(),
@@ -80,6 +80,28 @@ class CPP_MESSAGE_API Message {
     /** Return the number of message attachments in the vector. */
     size_t getAttachmentsCount() const;
 
+    /** Return the transfer encoding of the body. Automatic by default. */
+    TransferEncoding getBodyTransferEncoding() const;
+
+    /**
+     *  @brief  Set the transfer encoding of the body. Automatic selects it
+     *  from the content. 7bit and 8bit are used only if the body and the
+     *  server allow them.
+     *  @param pEncoding The transfer encoding.
+     */
+    void setBodyTransferEncoding(TransferEncoding pEncoding);
+
+    /** Return the plain text alternative of the body or an empty string if
+     *  none is set. */
+    std::string getAlternativeBody() const;
+
+    /**
+     *  @brief  Set a plain text version of the body, sent with it in a
+     *  multipart/alternative (see jed_utils::Message::setAlternativeBody).
+     *  @param pAlternativeBody The plain text. Empty to send the body alone.
+     */
+    void setAlternativeBody(const std::string &pAlternativeBody);
+
  protected:
     std::vector<jed_utils::MessageAddress> getStdMessageAddressVec(const std::vector<MessageAddress> &src) const;
     std::vector<jed_utils::Attachment> getStdAttachmentVec(const std::vector<Attachment> &src) const;
@@ -92,6 +114,8 @@ class CPP_MESSAGE_API Message {
     std::vector<MessageAddress> mCc;
     std::vector<MessageAddress> mBcc;
     std::vector<Attachment> mAttachments;
+    TransferEncoding mBodyTransferEncoding;
+    std::string mAlternativeBody;
 };
 }  // namespace cpp
 }  // namespace jed_utils
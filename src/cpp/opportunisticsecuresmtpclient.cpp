@@ -28,6 +28,14 @@ std::string OpportunisticSecureSMTPClient::getCommunicationLog() const {
     return jed_utils::OpportunisticSecureSMTPClient::getCommunicationLog();
 }
 
+jed_utils::CommunicationLogLevel OpportunisticSecureSMTPClient::getCommunicationLogLevel() const {
+    return jed_utils::SMTPClientBase::getCommunicationLogLevel();
+}
+
+size_t OpportunisticSecureSMTPClient::getCommunicationLogMaxSize() const {
+    return jed_utils::SMTPClientBase::getCommunicationLogMaxSize();
+}
+
 const Credential *OpportunisticSecureSMTPClient::getCredentials() const {
     return mCredential;
 }
@@ -55,6 +63,14 @@ void OpportunisticSecureSMTPClient::setKeepUsingBaseSendCommands(bool pValue) {
     jed_utils::SMTPClientBase::setKeepUsingBaseSendCommands(pValue);
 }
 
+void OpportunisticSecureSMTPClient::setCommunicationLogLevel(jed_utils::CommunicationLogLevel pLevel) {
+    jed_utils::SMTPClientBase::setCommunicationLogLevel(pLevel);
+}
+
+void OpportunisticSecureSMTPClient::setCommunicationLogMaxSize(size_t pMaxSize) {
+    jed_utils::SMTPClientBase::setCommunicationLogMaxSize(pMaxSize);
+}
+
 std::string OpportunisticSecureSMTPClient::getErrorMessage(int errorCode) {
     return jed_utils::SMTPClientBase::getErrorMessage(errorCode);
 }
@@ -79,3 +95,7 @@ jed_utils::ServerAuthOptions *OpportunisticSecureSMTPClient::extractAuthenticati
 int OpportunisticSecureSMTPClient::sendMail(const jed_utils::Message &pMsg) {
     return jed_utils::OpportunisticSecureSMTPClient::sendMail(pMsg);
 }
+
+int OpportunisticSecureSMTPClient::sendMail(const jed_utils::Message &pMsg, jed_utils::SendReport *pReport) {
+    return jed_utils::OpportunisticSecureSMTPClient::sendMail(pMsg, pReport);
+}
@@ -58,6 +58,13 @@ class CPP_OPPORTUNISTICSECURESMTPCLIENT_API OpportunisticSecureSMTPClient : priv
     /** Return the communication log produced by the sendMail method. */
     std::string getCommunicationLog() const;
 
+    /** Return the level of the items kept in the communication log. */
+    jed_utils::CommunicationLogLevel getCommunicationLogLevel() const;
+
+    /** Return the maximum size of the communication log in bytes, 0 if
+     *  unbounded. */
+    size_t getCommunicationLogMaxSize() const;
+
     /** Return the credentials configured. */
     const Credential *getCredentials() const;
 
@@ -99,6 +106,20 @@ class CPP_OPPORTUNISTICSECURESMTPCLIENT_API OpportunisticSecureSMTPClient : priv
      */
     void setKeepUsingBaseSendCommands(bool pValue);
 
+    /**
+     *  @brief  Set the level of the items kept in the communication log.
+     *  @param pLevel The level, Full by default. Off disables the log.
+     */
+    void setCommunicationLogLevel(jed_utils::CommunicationLogLevel pLevel);
+
+    /**
+     *  @brief  Set the maximum size of the communication log. The oldest
+     *  items are dropped when it is exceeded.
+     *  @param pMaxSize The maximum size in bytes (1 MiB by default), 0 for
+     *  an unbounded log.
+     */
+    void setCommunicationLogMaxSize(size_t pMaxSize);
+
     /**
      *  @brief  Retreive the error message string that correspond to
      *  the error code provided.
@@ -123,6 +144,14 @@ class CPP_OPPORTUNISTICSECURESMTPCLIENT_API OpportunisticSecureSMTPClient : priv
 
     int sendMail(const jed_utils::Message &pMsg);
 
+    /**
+     *  @brief  Send a message and describe how it was sent.
+     *  @param pMsg The message.
+     *  @param pReport The report to fill, null to send without report.
+     *  @return 0 for success, otherwise the error code.
+     */
+    int sendMail(const jed_utils::Message &pMsg, jed_utils::SendReport *pReport);
+
  protected:
     static int extractReturnCode(const std::string &pOutput);
     static jed_utils::ServerAuthOptions *extractAuthenticationOptions(const std::string &pEhloOutput);
@@ -28,7 +28,7 @@ PlaintextMessage::operator jed_utils::PlaintextMessage() const {
     const auto cc = getStdMessageAddressVec(getCc());
     const auto bcc = getStdMessageAddressVec(getBcc());
     const auto att = getStdAttachmentVec(getAttachments());
-    const jed_utils::PlaintextMessage msg (getFrom().toStdMessageAddress(),
+    jed_utils::PlaintextMessage msg (getFrom().toStdMessageAddress(),
                                   to.data(),
                                   to.size(),
                                   getSubject().c_str(),
@@ -39,5 +39,9 @@ PlaintextMessage::operator jed_utils::PlaintextMessage() const {
                                   bcc.size(),
                                   att.data(),
                                   att.size());
+    msg.setBodyTransferEncoding(getBodyTransferEncoding());
+    if (!getAlternativeBody().empty()) {
+        msg.setAlternativeBody(getAlternativeBody().c_str());
+    }
     return msg;
 }
@@ -28,6 +28,14 @@ std::string SmtpClient::getCommunicationLog() const {
     return jed_utils::SmtpClient::getCommunicationLog();
 }
 
+jed_utils::CommunicationLogLevel SmtpClient::getCommunicationLogLevel() const {
+    return jed_utils::SMTPClientBase::getCommunicationLogLevel();
+}
+
+size_t SmtpClient::getCommunicationLogMaxSize() const {
+    return jed_utils::SMTPClientBase::getCommunicationLogMaxSize();
+}
+
 const Credential *SmtpClient::getCredentials() const {
     return mCredential;
 }
@@ -55,6 +63,14 @@ void SmtpClient::setKeepUsingBaseSendCommands(bool pValue) {
     jed_utils::SMTPClientBase::setKeepUsingBaseSendCommands(pValue);
 }
 
+void SmtpClient::setCommunicationLogLevel(jed_utils::CommunicationLogLevel pLevel) {
+    jed_utils::SMTPClientBase::setCommunicationLogLevel(pLevel);
+}
+
+void SmtpClient::setCommunicationLogMaxSize(size_t pMaxSize) {
+    jed_utils::SMTPClientBase::setCommunicationLogMaxSize(pMaxSize);
+}
+
 std::string SmtpClient::getErrorMessage(int errorCode) {
     return jed_utils::SMTPClientBase::getErrorMessage(errorCode);
 }
@@ -79,3 +95,7 @@ jed_utils::ServerAuthOptions *SmtpClient::extractAuthenticationOptions(const std
 int SmtpClient::sendMail(const jed_utils::Message &pMsg) {
     return jed_utils::SmtpClient::sendMail(pMsg);
 }
+
+int SmtpClient::sendMail(const jed_utils::Message &pMsg, jed_utils::SendReport *pReport) {
+    return jed_utils::SmtpClient::sendMail(pMsg, pReport);
+}
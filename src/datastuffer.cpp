@@ -0,0 +1,77 @@
+#include "datastuffer.h"
+#include "simdutils.h"
+
+using namespace jed_utils;
+
+DataStuffer::DataStuffer()
+    : mAtLineStart(true),
+      mSkipLineFeed(false) {
+}
+
+void DataStuffer::write(const char *pData, size_t pLength, std::string &pOutput) {
+    if (pData == nullptr || pLength == 0) {
+        return;
+    }
+    size_t run_start = 0;
+    auto copy_run = [&](size_t pRunEnd) {
+        if (pRunEnd > run_start) {
+            pOutput.append(pData + run_start, pRunEnd - run_start);
+            mAtLineStart = false;
+            mSkipLineFeed = false;
+        }
+    };
+    auto write_special = [&](size_t pOffset) {
+        copy_run(pOffset);
+        switch (pData[pOffset]) {
+            case '\r':
+                // A CR ends the line, the LF that may follow is part of it
+                pOutput.append("\r\n", 2);
+                mAtLineStart = true;
+                mSkipLineFeed = true;
+                break;
+            case '\n':
+                if (!mSkipLineFeed) {
+                    pOutput.append("\r\n", 2);
+                    mAtLineStart = true;
+                }
+                mSkipLineFeed = false;
+                break;
+            default:
+                pOutput.append(mAtLineStart ? ".." : ".", mAtLineStart ? 2 : 1);
+                mAtLineStart = false;
+                mSkipLineFeed = false;
+                break;
+        }
+        run_start = pOffset + 1;
+    };
+
+    size_t offset = 0;
+#ifdef SMTPCLIENT_SSE2
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    const __m128i line_feed = _mm_set1_epi8('\n');
+    const __m128i dot = _mm_set1_epi8('.');
+    for (; offset + 16 <= pLength; offset += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pData + offset));
+        const __m128i candidates = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, carriage_return),
+                    _mm_cmpeq_epi8(block, line_feed)),
+                _mm_cmpeq_epi8(block, dot));
+        auto mask = static_cast<unsigned int>(_mm_movemask_epi8(candidates));
+        while (mask != 0) {
+            write_special(offset + simd::countTrailingZeros(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; offset < pLength; offset++) {
+        const char byte = pData[offset];
+        if (byte == '\r' || byte == '\n' || byte == '.') {
+            write_special(offset);
+        }
+    }
+    copy_run(pLength);
+}
+
+void DataStuffer::reset() {
+    mAtLineStart = true;
+    mSkipLineFeed = false;
+}
@@ -0,0 +1,49 @@
+#ifndef DATASTUFFER_H
+#define DATASTUFFER_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define DATASTUFFER_API __declspec(dllexport)
+    #else
+        #define DATASTUFFER_API __declspec(dllimport)
+    #endif
+#else
+    #define DATASTUFFER_API
+#endif
+
+namespace jed_utils {
+/** @brief The DataStuffer class prepares the content sent after the DATA
+ *  command: the bare CR and LF become CRLF and a '.' at the start of a line
+ *  is doubled (RFC 5321, section 4.5.2), so the content can neither end the
+ *  transaction early nor be rejected for its line endings.
+ *
+ *  The content can be written in several chunks, the state of the current
+ *  line is kept between the calls. The line breaks and dots are found 16
+ *  bytes at a time with SSE2 and the runs between them are copied as is.
+ */
+class DATASTUFFER_API DataStuffer {
+ public:
+    DataStuffer();
+
+    /**
+     *  @brief  Append the next chunk of the content to a buffer.
+     *  @param pData The chunk.
+     *  @param pLength The length of the chunk.
+     *  @param pOutput The buffer that receives the prepared content, usually
+     *  the write buffer of the connection.
+     */
+    void write(const char *pData, size_t pLength, std::string &pOutput);
+
+    /** Prepare the stuffer for a new content, which starts a line. */
+    void reset();
+
+ private:
+    bool mAtLineStart;
+    bool mSkipLineFeed;
+};
+}  // namespace jed_utils
+
+#endif
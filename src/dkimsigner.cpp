@@ -0,0 +1,406 @@
+#include "dkimsigner.h"
+#include <openssl/pem.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "base64.h"
+
+using namespace jed_utils;
+
+namespace {
+    // The canonicalized body is hashed by blocks of this length
+    const size_t HASH_BUFFER_LENGTH = 4096;
+    // The length of a SHA-256 hash in base64
+    const size_t BODY_HASH_LENGTH = 44;
+    // The base64 signature is folded in lines of this length
+    const size_t SIGNATURE_LINE_LENGTH = 64;
+    const size_t MAX_LINE_LENGTH = 78;
+
+    struct HeaderField {
+        std::string Name;
+        const char *Text;
+        size_t Length;
+        bool Signed;
+    };
+
+    inline bool isWhitespace(char c) {
+        return c == ' ' || c == '\t';
+    }
+
+    std::string toLower(const char *pValue, size_t pLength) {
+        std::string lower(pValue, pLength);
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+                return static_cast<char>(std::tolower(c));
+                });
+        return lower;
+    }
+
+    // Split the header fields, a line that starts with a whitespace continues
+    // the previous field
+    std::vector<HeaderField> parseHeaderFields(const char *pHeaders, size_t pLength) {
+        std::vector<HeaderField> fields;
+        size_t offset = 0;
+        while (offset < pLength) {
+            const auto *line_feed = static_cast<const char *>(memchr(pHeaders + offset, '\n', pLength - offset));
+            const size_t next = line_feed != nullptr ? static_cast<size_t>(line_feed - pHeaders) + 1 : pLength;
+            if (pHeaders[offset] == '\r' || pHeaders[offset] == '\n') {
+                // The empty line that ends the header
+                break;
+            }
+            if (isWhitespace(pHeaders[offset]) && !fields.empty()) {
+                fields.back().Length = next - static_cast<size_t>(fields.back().Text - pHeaders);
+            } else {
+                const auto *colon = static_cast<const char *>(memchr(pHeaders + offset, ':', next - offset));
+                size_t name_end = colon != nullptr ? static_cast<size_t>(colon - pHeaders) : next;
+                while (name_end > offset && isWhitespace(pHeaders[name_end - 1])) {
+                    name_end--;
+                }
+                fields.push_back({ toLower(pHeaders + offset, name_end - offset), pHeaders + offset, next - offset, false });
+            }
+            offset = next;
+        }
+        return fields;
+    }
+
+    // RFC 6376, section 3.4.2: lowercase name, unfolded value and single
+    // spaces, without the whitespaces around the colon and at the end
+    void appendRelaxedField(std::string &pOutput, const char *pText, size_t pLength) {
+        const auto *colon = static_cast<const char *>(memchr(pText, ':', pLength));
+        size_t name_end = colon != nullptr ? static_cast<size_t>(colon - pText) : pLength;
+        const size_t value_start = colon != nullptr ? name_end + 1 : pLength;
+        while (name_end > 0 && isWhitespace(pText[name_end - 1])) {
+            name_end--;
+        }
+        pOutput += toLower(pText, name_end);
+        pOutput += ':';
+        bool pending_space = false;
+        bool has_value = false;
+        for (size_t index = value_start; index < pLength; index++) {
+            const char c = pText[index];
+            if (c == '\r' || c == '\n') {
+                continue;
+            }
+            if (isWhitespace(c)) {
+                pending_space = true;
+                continue;
+            }
+            if (pending_space && has_value) {
+                pOutput += ' ';
+            }
+            pending_space = false;
+            has_value = true;
+            pOutput += c;
+        }
+        pOutput += "\r\n";
+    }
+
+    void appendCanonicalField(std::string &pOutput, const char *pText, size_t pLength, DKIMCanonicalization pCanonicalization) {
+        if (pCanonicalization == DKIMCanonicalization::Relaxed) {
+            appendRelaxedField(pOutput, pText, pLength);
+        } else {
+            pOutput.append(pText, pLength);
+        }
+    }
+
+    const char *getCanonicalizationName(DKIMCanonicalization pCanonicalization) {
+        return pCanonicalization == DKIMCanonicalization::Relaxed ? "relaxed" : "simple";
+    }
+
+    bool isEd25519(const EVP_PKEY *pKey) {
+        return EVP_PKEY_base_id(pKey) == EVP_PKEY_ED25519;
+    }
+
+    // RSA signs the data with SHA-256, Ed25519 signs its SHA-256 hash
+    // (RFC 8463)
+    std::string sign(EVP_PKEY *pKey, const std::string &pData) {
+        const auto *data = reinterpret_cast<const unsigned char *>(pData.data());
+        size_t data_length = pData.length();
+        unsigned char hash[EVP_MAX_MD_SIZE];
+        if (isEd25519(pKey)) {
+            unsigned int hash_length = 0;
+            if (EVP_Digest(data, data_length, hash, &hash_length, EVP_sha256(), nullptr) != 1) {
+                return "";
+            }
+            data = hash;
+            data_length = hash_length;
+        }
+        EVP_MD_CTX *context = EVP_MD_CTX_new();
+        if (context == nullptr) {
+            return "";
+        }
+        std::vector<unsigned char> signature;
+        size_t signature_length = 0;
+        if (EVP_DigestSignInit(context, nullptr, isEd25519(pKey) ? nullptr : EVP_sha256(), nullptr, pKey) == 1
+                && EVP_DigestSign(context, nullptr, &signature_length, data, data_length) == 1) {
+            signature.resize(signature_length);
+            if (EVP_DigestSign(context, signature.data(), &signature_length, data, data_length) != 1) {
+                signature_length = 0;
+            }
+        }
+        EVP_MD_CTX_free(context);
+        return signature_length > 0 ? Base64::Encode(signature.data(), signature_length) : "";
+    }
+}  // namespace
+
+DKIMBodyHasher::DKIMBodyHasher(DKIMCanonicalization pCanonicalization)
+    : mCanonicalization(pCanonicalization),
+      mContext(EVP_MD_CTX_new()),
+      mPendingLineBreaks(0),
+      mPendingSpace(false),
+      mSkipLineFeed(false),
+      mHasContent(false) {
+    if (mContext != nullptr && EVP_DigestInit_ex(mContext, EVP_sha256(), nullptr) != 1) {
+        EVP_MD_CTX_free(mContext);
+        mContext = nullptr;
+    }
+    mBuffer.reserve(HASH_BUFFER_LENGTH + SIGNATURE_LINE_LENGTH);
+}
+
+DKIMBodyHasher::~DKIMBodyHasher() {
+    EVP_MD_CTX_free(mContext);
+}
+
+void DKIMBodyHasher::update(const char *pData, size_t pLength) {
+    const bool relaxed = mCanonicalization == DKIMCanonicalization::Relaxed;
+    size_t index = 0;
+    while (index < pLength) {
+        const char c = pData[index];
+        if (mSkipLineFeed) {
+            mSkipLineFeed = false;
+            if (c == '\n') {
+                index++;
+                continue;
+            }
+        }
+        if (c == '\r' || c == '\n') {
+            // The whitespaces at the end of a line are dropped (relaxed) and
+            // the empty lines are only hashed if content follows them
+            mSkipLineFeed = c == '\r';
+            mPendingLineBreaks++;
+            mPendingSpace = false;
+            index++;
+            continue;
+        }
+        if (relaxed && isWhitespace(c)) {
+            mPendingSpace = true;
+            index++;
+            continue;
+        }
+        size_t end = index + 1;
+        while (end < pLength && pData[end] != '\r' && pData[end] != '\n' && !(relaxed && isWhitespace(pData[end]))) {
+            end++;
+        }
+        appendPending();
+        mHasContent = true;
+        if (end - index >= HASH_BUFFER_LENGTH) {
+            flush();
+            if (mContext != nullptr) {
+                EVP_DigestUpdate(mContext, pData + index, end - index);
+            }
+        } else {
+            mBuffer.append(pData + index, end - index);
+            if (mBuffer.length() >= HASH_BUFFER_LENGTH) {
+                flush();
+            }
+        }
+        index = end;
+    }
+}
+
+std::string DKIMBodyHasher::finish() {
+    if (mContext == nullptr) {
+        return "";
+    }
+    // The body ends with a single CRLF. An empty body is CRLF (simple) or
+    // nothing (relaxed).
+    if (mHasContent || mCanonicalization == DKIMCanonicalization::Simple) {
+        mBuffer += "\r\n";
+    }
+    flush();
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_length = 0;
+    const int final_ret_code = EVP_DigestFinal_ex(mContext, hash, &hash_length);
+    EVP_MD_CTX_free(mContext);
+    mContext = nullptr;
+    return final_ret_code == 1 ? Base64::Encode(hash, hash_length) : "";
+}
+
+void DKIMBodyHasher::appendPending() {
+    for (; mPendingLineBreaks > 0; mPendingLineBreaks--) {
+        mBuffer += "\r\n";
+    }
+    if (mPendingSpace) {
+        mBuffer += ' ';
+        mPendingSpace = false;
+    }
+}
+
+void DKIMBodyHasher::flush() {
+    if (mContext != nullptr && !mBuffer.empty()) {
+        EVP_DigestUpdate(mContext, mBuffer.data(), mBuffer.length());
+    }
+    mBuffer.clear();
+}
+
+DKIMSigner::DKIMSigner()
+    : mHeaderCanonicalization(DKIMCanonicalization::Relaxed),
+      mBodyCanonicalization(DKIMCanonicalization::Simple) {
+}
+
+bool DKIMSigner::addKey(const char *pDomain, const char *pSelector, const char *pPrivateKeyPEM) {
+    if (pDomain == nullptr || pSelector == nullptr || pPrivateKeyPEM == nullptr) {
+        return false;
+    }
+    BIO *bio = BIO_new_mem_buf(pPrivateKeyPEM, -1);
+    if (bio == nullptr) {
+        return false;
+    }
+    EVP_PKEY *key = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+    if (key == nullptr) {
+        return false;
+    }
+    if (EVP_PKEY_base_id(key) != EVP_PKEY_RSA && !isEd25519(key)) {
+        EVP_PKEY_free(key);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mKeysMutex);
+    mKeys[toLower(pDomain, strlen(pDomain))] = { pSelector, std::shared_ptr<EVP_PKEY>(key, EVP_PKEY_free) };
+    return true;
+}
+
+bool DKIMSigner::hasKey(const char *pDomain) const {
+    SigningKey key;
+    return findKey(pDomain, key);
+}
+
+DKIMCanonicalization DKIMSigner::getHeaderCanonicalization() const {
+    return mHeaderCanonicalization;
+}
+
+DKIMCanonicalization DKIMSigner::getBodyCanonicalization() const {
+    return mBodyCanonicalization;
+}
+
+void DKIMSigner::setCanonicalization(DKIMCanonicalization pHeaderCanonicalization,
+        DKIMCanonicalization pBodyCanonicalization) {
+    mHeaderCanonicalization = pHeaderCanonicalization;
+    mBodyCanonicalization = pBodyCanonicalization;
+}
+
+size_t DKIMSigner::getSignatureFieldLength(const char *pDomain, const char *pHeaders, size_t pHeadersLength) const {
+    SigningKey key;
+    if (!findKey(pDomain, key)) {
+        return 0;
+    }
+    std::string header_names;
+    for (const auto &field : parseHeaderFields(pHeaders, pHeadersLength)) {
+        header_names += header_names.empty() ? "" : ":";
+        header_names += field.Name;
+    }
+    // The length of the signature only depends on the key
+    const auto signature_length = static_cast<size_t>(EVP_PKEY_size(key.Key.get()));
+    return renderField(toLower(pDomain, strlen(pDomain)), key, header_names, std::string(BODY_HASH_LENGTH, 'A'),
+            std::string(Base64::EncodedLength(signature_length), 'A')).length();
+}
+
+std::string DKIMSigner::createSignatureField(const char *pDomain,
+        const char *pHeaders,
+        size_t pHeadersLength,
+        const std::string &pBodyHash) const {
+    SigningKey key;
+    if (!findKey(pDomain, key) || pBodyHash.empty()) {
+        return "";
+    }
+    std::vector<HeaderField> fields { parseHeaderFields(pHeaders, pHeadersLength) };
+    std::string header_names;
+    for (const auto &field : fields) {
+        header_names += header_names.empty() ? "" : ":";
+        header_names += field.Name;
+    }
+
+    // The fields in the order of the h= tag. The instances of a field that
+    // appears several times are taken from the bottom up (section 5.4.2).
+    std::string signed_data;
+    signed_data.reserve(pHeadersLength + MAX_LINE_LENGTH * 4);
+    for (const auto &name : fields) {
+        auto field = std::find_if(fields.rbegin(), fields.rend(), [&name](const HeaderField &pField) {
+                return !pField.Signed && pField.Name == name.Name;
+                });
+        field->Signed = true;
+        appendCanonicalField(signed_data, field->Text, field->Length, mHeaderCanonicalization);
+    }
+    // Then the signature field with an empty b= tag, without its CRLF
+    const std::string domain { toLower(pDomain, strlen(pDomain)) };
+    const std::string unsigned_field { renderField(domain, key, header_names, pBodyHash, "") };
+    appendCanonicalField(signed_data, unsigned_field.data(), unsigned_field.length(), mHeaderCanonicalization);
+    signed_data.resize(signed_data.length() - 2);
+
+    const std::string signature { sign(key.Key.get(), signed_data) };
+    if (signature.empty()) {
+        return "";
+    }
+    return renderField(domain, key, header_names, pBodyHash, signature);
+}
+
+bool DKIMSigner::findKey(const char *pDomain, SigningKey &pKey) const {
+    if (pDomain == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mKeysMutex);
+    auto key = mKeys.find(toLower(pDomain, strlen(pDomain)));
+    if (key == mKeys.end()) {
+        return false;
+    }
+    pKey = key->second;
+    return true;
+}
+
+std::string DKIMSigner::renderField(const std::string &pDomain,
+        const SigningKey &pKey,
+        const std::string &pHeaderNames,
+        const std::string &pBodyHash,
+        const std::string &pSignature) const {
+    std::string field { "DKIM-Signature: v=1; a=" };
+    field += isEd25519(pKey.Key.get()) ? "ed25519-sha256" : "rsa-sha256";
+    field += "; c=";
+    field += getCanonicalizationName(mHeaderCanonicalization);
+    field += '/';
+    field += getCanonicalizationName(mBodyCanonicalization);
+    field += "; d=" + pDomain + "; s=" + pKey.Selector + ";\r\n h=";
+
+    // The list of fields is folded after a colon
+    size_t line_length = 3;
+    size_t name_start = 0;
+    while (name_start <= pHeaderNames.length()) {
+        size_t name_end = pHeaderNames.find(':', name_start);
+        if (name_end == std::string::npos) {
+            name_end = pHeaderNames.length();
+        }
+        if (name_start > 0) {
+            field += ':';
+            line_length++;
+            if (line_length + name_end - name_start + 1 > MAX_LINE_LENGTH) {
+                field += "\r\n ";
+                line_length = 1;
+            }
+        }
+        field.append(pHeaderNames, name_start, name_end - name_start);
+        line_length += name_end - name_start;
+        name_start = name_end + 1;
+    }
+    field += ";\r\n bh=" + pBodyHash + ";\r\n b=";
+
+    // The whitespaces in the signature are ignored by the verifiers
+    for (size_t offset = 0; offset < pSignature.length(); offset += SIGNATURE_LINE_LENGTH) {
+        if (offset > 0) {
+            field += "\r\n ";
+        }
+        field.append(pSignature, offset, SIGNATURE_LINE_LENGTH);
+    }
+    field += "\r\n";
+    return field;
+}
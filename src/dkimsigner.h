@@ -0,0 +1,174 @@
+#ifndef DKIMSIGNER_H
+#define DKIMSIGNER_H
+
+#include <openssl/evp.h>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define DKIMSIGNER_API __declspec(dllexport)
+    #else
+        #define DKIMSIGNER_API __declspec(dllimport)
+    #endif
+#else
+    #define DKIMSIGNER_API
+#endif
+
+namespace jed_utils {
+/** @brief The canonicalization algorithms of DKIM (RFC 6376, section 3.4). */
+enum class DKIMCanonicalization {
+    /** The content is signed as is */
+    Simple,
+    /** The whitespaces are reduced and the header field names lowercased */
+    Relaxed
+};
+
+/** @brief The DKIMBodyHasher class computes the body hash of a DKIM
+ *  signature (the bh= tag) while the body is produced.
+ *
+ *  The body is canonicalized and hashed chunk by chunk, the state of the
+ *  current line is kept between the calls. The bare CR and LF count as CRLF
+ *  since they are sent that way (see DataStuffer). The body must not be
+ *  dot-stuffed.
+ */
+class DKIMSIGNER_API DKIMBodyHasher {
+ public:
+    /**
+     *  @brief  Construct a new DKIMBodyHasher.
+     *  @param pCanonicalization The body canonicalization.
+     */
+    explicit DKIMBodyHasher(DKIMCanonicalization pCanonicalization);
+
+    /** Destructor of the DKIMBodyHasher. */
+    ~DKIMBodyHasher();
+
+    /** DKIMBodyHasher copy constructor (deleted). */
+    DKIMBodyHasher(const DKIMBodyHasher &other) = delete;
+
+    /** DKIMBodyHasher copy assignment operator (deleted). */
+    DKIMBodyHasher& operator=(const DKIMBodyHasher &other) = delete;
+
+    /**
+     *  @brief  Hash the next chunk of the body.
+     *  @param pData The chunk.
+     *  @param pLength The length of the chunk.
+     */
+    void update(const char *pData, size_t pLength);
+
+    /** Return the base64 SHA-256 hash of the canonicalized body. The hasher
+     *  cannot be updated anymore. */
+    std::string finish();
+
+ private:
+    void appendPending();
+    void flush();
+
+    DKIMCanonicalization mCanonicalization;
+    EVP_MD_CTX *mContext;
+    std::string mBuffer;
+    size_t mPendingLineBreaks;
+    bool mPendingSpace;
+    bool mSkipLineFeed;
+    bool mHasContent;
+};
+
+/** @brief The DKIMSigner class creates the DKIM-Signature header field of
+ *  the messages (RFC 6376) sent from the domains it has a key for.
+ *
+ *  The private keys (RSA or Ed25519, RFC 8463) are parsed once by addKey
+ *  and kept for each domain. The signature covers all the header fields
+ *  rendered for the message and the body hash computed by a DKIMBodyHasher,
+ *  so the message is rendered only once. A signer can be shared by several
+ *  clients and threads.
+ */
+class DKIMSIGNER_API DKIMSigner {
+ public:
+    /** Construct a DKIMSigner without keys. The header fields are relaxed
+     *  and the body simple (c=relaxed/simple). */
+    DKIMSigner();
+
+    /** DKIMSigner copy constructor (deleted). */
+    DKIMSigner(const DKIMSigner &other) = delete;
+
+    /** DKIMSigner copy assignment operator (deleted). */
+    DKIMSigner& operator=(const DKIMSigner &other) = delete;
+
+    /**
+     *  @brief  Parse and keep the private key of a domain. It replaces the
+     *  previous key of the domain.
+     *  @param pDomain The signing domain (d= tag), the domain of the sender
+     *  addresses.
+     *  @param pSelector The selector of the public key in the DNS (s= tag).
+     *  @param pPrivateKeyPEM The RSA or Ed25519 private key in PEM format.
+     *  @return False if the key could not be parsed or is of another type.
+     */
+    bool addKey(const char *pDomain, const char *pSelector, const char *pPrivateKeyPEM);
+
+    /** Return true if a key was added for the domain (case insensitive). */
+    bool hasKey(const char *pDomain) const;
+
+    /** Return the canonicalization of the header fields. */
+    DKIMCanonicalization getHeaderCanonicalization() const;
+
+    /** Return the canonicalization of the body. */
+    DKIMCanonicalization getBodyCanonicalization() const;
+
+    /**
+     *  @brief  Set the canonicalizations. Call it before the signer is used.
+     *  @param pHeaderCanonicalization The canonicalization of the header
+     *  fields.
+     *  @param pBodyCanonicalization The canonicalization of the body.
+     */
+    void setCanonicalization(DKIMCanonicalization pHeaderCanonicalization,
+            DKIMCanonicalization pBodyCanonicalization);
+
+    /**
+     *  @brief  Return the exact length of the signature field that
+     *  createSignatureField returns, without signing.
+     *  @param pDomain The signing domain.
+     *  @param pHeaders The header fields to sign.
+     *  @param pHeadersLength The length of the header fields.
+     *  @return The length or 0 if there is no key for the domain.
+     */
+    size_t getSignatureFieldLength(const char *pDomain, const char *pHeaders, size_t pHeadersLength) const;
+
+    /**
+     *  @brief  Sign the header fields and the body hash.
+     *  @param pDomain The signing domain.
+     *  @param pHeaders The header fields to sign, as sent. The fields after
+     *  an empty line are ignored.
+     *  @param pHeadersLength The length of the header fields.
+     *  @param pBodyHash The hash returned by DKIMBodyHasher::finish.
+     *  @return The DKIM-Signature field followed by CRLF, to send before the
+     *  other header fields, or an empty string if there is no key for the
+     *  domain or the signature failed.
+     */
+    std::string createSignatureField(const char *pDomain,
+            const char *pHeaders,
+            size_t pHeadersLength,
+            const std::string &pBodyHash) const;
+
+ private:
+    struct SigningKey {
+        std::string Selector;
+        std::shared_ptr<EVP_PKEY> Key;
+    };
+    bool findKey(const char *pDomain, SigningKey &pKey) const;
+    std::string renderField(const std::string &pDomain,
+            const SigningKey &pKey,
+            const std::string &pHeaderNames,
+            const std::string &pBodyHash,
+            const std::string &pSignature) const;
+
+    DKIMCanonicalization mHeaderCanonicalization;
+    DKIMCanonicalization mBodyCanonicalization;
+    mutable std::mutex mKeysMutex;
+    std::unordered_map<std::string, SigningKey> mKeys;
+};
+}  // namespace jed_utils
+
+#endif
@@ -78,6 +78,9 @@ ErrorResolver::ErrorResolver(int pErrorCode)
         case SSL_CLIENT_STARTTLS_VERIFY_RESULT_ERROR:
             errorMessage = "Unable to verify the result of chain verification";
             break;
+        case SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT:
+            errorMessage = "The TLS handshake timed out";
+            break;
         case SSL_CLIENT_INITSECURECLIENT_ERROR:
             errorMessage = "Unable to EHLO the server via the secure channel";
             break;
@@ -141,6 +144,24 @@ ErrorResolver::ErrorResolver(int pErrorCode)
         case CLIENT_SENDMAIL_QUIT_ERROR:
             errorMessage = "The QUIT command return an error";
             break;
+        case CLIENT_SENDMAIL_QUIT_TIMEOUT:
+            errorMessage = "The QUIT command timed out";
+            break;
+        case CLIENT_SENDMAIL_RSET_ERROR:
+            errorMessage = "The RSET command return an error";
+            break;
+        case CLIENT_SENDMAIL_RSET_TIMEOUT:
+            errorMessage = "The RSET command timed out";
+            break;
+        case CLIENT_SENDMAIL_ENCODED_FILE_ERROR:
+            errorMessage = "Unable to open the encoded attachment file";
+            break;
+        case CLIENT_SENDMAIL_MESSAGE_TOO_LARGE:
+            errorMessage = "The message exceeds the maximum size accepted by the server";
+            break;
+        case CLIENT_SENDMAIL_HEADERS_ERROR:
+            errorMessage = "The headers of the message return an error";
+            break;
         case SMTPSERVER_AUTHENTICATIONREQUIRED_ERROR:
             errorMessage = "Authentication required";
             break;
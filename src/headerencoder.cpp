@@ -0,0 +1,251 @@
+#include "headerencoder.h"
+#include <algorithm>
+#include <cstring>
+#include "base64.h"
+#include "simdutils.h"
+#include "utf8validator.h"
+
+using namespace jed_utils;
+
+const size_t HeaderEncoder::MAX_LINE_LENGTH;
+const size_t HeaderEncoder::MAX_ENCODED_WORD_LENGTH;
+
+namespace {
+    // "=?UTF-8?B?" and "?="
+    const size_t ENCODED_WORD_OVERHEAD = 12;
+    const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    inline bool isSpecialByte(unsigned char pByte) {
+        return (pByte < 0x20 && pByte != '\t') || pByte > 127;
+    }
+
+    // The characters that a Q encoded word keeps as is in any header (RFC 2047, section 5)
+    inline bool isQLiteral(unsigned char pByte) {
+        return (pByte >= 'a' && pByte <= 'z') || (pByte >= 'A' && pByte <= 'Z') || (pByte >= '0' && pByte <= '9')
+            || pByte == '!' || pByte == '*' || pByte == '+' || pByte == '-' || pByte == '/';
+    }
+
+    inline size_t qEncodedLength(unsigned char pByte) {
+        return isQLiteral(pByte) || pByte == ' ' ? 1 : 3;
+    }
+
+    inline size_t bEncodedLength(size_t pLength) {
+        return (pLength + 2) / 3 * 4;
+    }
+
+    // The length of the UTF-8 sequence that starts with a byte. An invalid
+    // lead byte is taken alone.
+    inline size_t sequenceLength(unsigned char pLeadByte) {
+        if (pLeadByte < 0xC0) {
+            return 1;
+        }
+        if (pLeadByte < 0xE0) {
+            return 2;
+        }
+        if (pLeadByte < 0xF0) {
+            return 3;
+        }
+        return pLeadByte < 0xF8 ? 4 : 1;
+    }
+
+    void appendFold(std::string &pOutput, size_t &pColumn) {
+        pOutput += "\r\n ";
+        pColumn = 1;
+    }
+
+    // Return a copy of a text where each byte that is not valid UTF-8 is
+    // replaced by U+FFFD, the encoded words are declared as UTF-8
+    std::string replaceInvalidUTF8(const char *pData, size_t pLength) {
+        std::string text;
+        text.reserve(pLength + 16);
+        size_t offset = 0;
+        while (offset < pLength) {
+            const size_t invalid_offset = offset + UTF8Validator::findFirstInvalid(pData + offset, pLength - offset);
+            text.append(pData + offset, invalid_offset - offset);
+            if (invalid_offset < pLength) {
+                text += "\xEF\xBF\xBD";
+            }
+            offset = invalid_offset + 1;
+        }
+        return text;
+    }
+
+    // Append a text as encoded words. A word never splits a UTF-8 character
+    // and the next word starts on a new line.
+    void appendEncodedWords(std::string &pOutput, const char *pData, size_t pLength, size_t &pColumn) {
+        if (!UTF8Validator::isValid(pData, pLength)) {
+            const std::string text { replaceInvalidUTF8(pData, pLength) };
+            appendEncodedWords(pOutput, text.data(), text.length(), pColumn);
+            return;
+        }
+        const auto *data = reinterpret_cast<const unsigned char *>(pData);
+        size_t q_length = 0;
+        for (size_t index = 0; index < pLength; index++) {
+            q_length += qEncodedLength(data[index]);
+        }
+        const bool q_encoding = q_length <= bEncodedLength(pLength);
+
+        size_t offset = 0;
+        while (offset < pLength) {
+            if (offset > 0) {
+                appendFold(pOutput, pColumn);
+            }
+            const size_t room = std::min(HeaderEncoder::MAX_ENCODED_WORD_LENGTH,
+                    HeaderEncoder::MAX_LINE_LENGTH - std::min(pColumn, HeaderEncoder::MAX_LINE_LENGTH));
+            size_t end = offset;
+            size_t encoded_length = 0;
+            while (end < pLength) {
+                const size_t sequence_length = std::min(sequenceLength(data[end]), pLength - end);
+                size_t next_length = 0;
+                if (q_encoding) {
+                    next_length = encoded_length;
+                    for (size_t index = end; index < end + sequence_length; index++) {
+                        next_length += qEncodedLength(data[index]);
+                    }
+                } else {
+                    next_length = bEncodedLength(end + sequence_length - offset);
+                }
+                if (ENCODED_WORD_OVERHEAD + next_length > room) {
+                    break;
+                }
+                encoded_length = next_length;
+                end += sequence_length;
+            }
+            if (end == offset) {
+                // Not even one character fits after the field name
+                appendFold(pOutput, pColumn);
+                continue;
+            }
+
+            pOutput += q_encoding ? "=?UTF-8?Q?" : "=?UTF-8?B?";
+            if (q_encoding) {
+                for (size_t index = offset; index < end; index++) {
+                    const unsigned char byte = data[index];
+                    if (isQLiteral(byte)) {
+                        pOutput += static_cast<char>(byte);
+                    } else if (byte == ' ') {
+                        pOutput += '_';
+                    } else {
+                        pOutput += '=';
+                        pOutput += HEX_DIGITS[byte >> 4];
+                        pOutput += HEX_DIGITS[byte & 0x0F];
+                    }
+                }
+            } else {
+                pOutput += Base64::Encode(data + offset, end - offset);
+            }
+            pOutput += "?=";
+            pColumn += ENCODED_WORD_OVERHEAD + encoded_length;
+            offset = end;
+        }
+    }
+
+    // Append printable ASCII, folded before a whitespace when the line
+    // would exceed the limit. A run without whitespace is kept whole.
+    void appendFolded(std::string &pOutput, const char *pData, size_t pLength, size_t &pColumn) {
+        size_t offset = 0;
+        while (pColumn + (pLength - offset) > HeaderEncoder::MAX_LINE_LENGTH) {
+            const size_t room = HeaderEncoder::MAX_LINE_LENGTH - std::min(pColumn, HeaderEncoder::MAX_LINE_LENGTH);
+            size_t fold = std::string::npos;
+            for (size_t index = std::min(offset + room, pLength - 1); index > offset; index--) {
+                if (pData[index] == ' ' || pData[index] == '\t') {
+                    fold = index;
+                    break;
+                }
+            }
+            if (fold == std::string::npos) {
+                for (size_t index = offset + room + 1; index < pLength; index++) {
+                    if (pData[index] == ' ' || pData[index] == '\t') {
+                        fold = index;
+                        break;
+                    }
+                }
+            }
+            if (fold == std::string::npos) {
+                break;
+            }
+            // The whitespace starts the continuation line
+            pOutput.append(pData + offset, fold - offset);
+            pOutput += "\r\n";
+            pColumn = 0;
+            offset = fold;
+        }
+        pOutput.append(pData + offset, pLength - offset);
+        pColumn += pLength - offset;
+    }
+}  // namespace
+
+bool HeaderEncoder::needsEncoding(const char *pData, size_t pLength) {
+    if (pData == nullptr) {
+        return false;
+    }
+    const auto *data = reinterpret_cast<const unsigned char *>(pData);
+    size_t offset = 0;
+#ifdef SMTPCLIENT_SSE2
+    // The signed comparison flags the control characters and, as negative
+    // values, the bytes above 127. The tabs are then let through.
+    const __m128i printable_start = _mm_set1_epi8(0x20);
+    const __m128i tab = _mm_set1_epi8('\t');
+    for (; offset + 16 <= pLength; offset += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+        const __m128i special = _mm_andnot_si128(_mm_cmpeq_epi8(block, tab), _mm_cmplt_epi8(block, printable_start));
+        if (_mm_movemask_epi8(special) != 0) {
+            return true;
+        }
+    }
+#endif
+    for (; offset < pLength; offset++) {
+        if (isSpecialByte(data[offset])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HeaderEncoder::appendUnstructured(std::string &pOutput, const char *pName, const char *pValue) {
+    const size_t value_length = pValue != nullptr ? strlen(pValue) : 0;
+    pOutput += pName;
+    pOutput += ": ";
+    size_t column = strlen(pName) + 2;
+    if (needsEncoding(pValue, value_length)) {
+        appendEncodedWords(pOutput, pValue, value_length, column);
+    } else if (value_length > 0) {
+        appendFolded(pOutput, pValue, value_length, column);
+    }
+    pOutput += "\r\n";
+}
+
+void HeaderEncoder::appendMailbox(std::string &pOutput,
+        const char *pName,
+        const char *pDisplayName,
+        const char *pEmailAddress) {
+    const size_t display_name_length = pDisplayName != nullptr ? strlen(pDisplayName) : 0;
+    const size_t email_address_length = pEmailAddress != nullptr ? strlen(pEmailAddress) : 0;
+    pOutput += pName;
+    pOutput += ": ";
+    size_t column = strlen(pName) + 2;
+    if (needsEncoding(pDisplayName, display_name_length)) {
+        appendEncodedWords(pOutput, pDisplayName, display_name_length, column);
+    } else {
+        // Quoted string, the quotes and backslashes are escaped
+        const size_t start = pOutput.length();
+        pOutput += '"';
+        for (size_t index = 0; index < display_name_length; index++) {
+            if (pDisplayName[index] == '"' || pDisplayName[index] == '\\') {
+                pOutput += '\\';
+            }
+            pOutput += pDisplayName[index];
+        }
+        pOutput += '"';
+        column += pOutput.length() - start;
+    }
+    if (column + email_address_length + 3 > MAX_LINE_LENGTH) {
+        pOutput += "\r\n";
+        column = 0;
+    }
+    pOutput += " <";
+    if (pEmailAddress != nullptr) {
+        pOutput += pEmailAddress;
+    }
+    pOutput += ">\r\n";
+}
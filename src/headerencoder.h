@@ -0,0 +1,68 @@
+#ifndef HEADERENCODER_H
+#define HEADERENCODER_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define HEADERENCODER_API __declspec(dllexport)
+    #else
+        #define HEADERENCODER_API __declspec(dllimport)
+    #endif
+#else
+    #define HEADERENCODER_API
+#endif
+
+namespace jed_utils {
+/** @brief The HeaderEncoder class writes the header fields of a message.
+ *
+ *  A value made of printable ASCII is written as is and folded at the
+ *  whitespaces to keep the lines within 78 characters (RFC 5322). Any other
+ *  value (UTF-8, control characters) becomes a sequence of encoded words
+ *  (RFC 2047), B or Q encoded whichever is shorter, each one on its own line.
+ *  The bytes that are not valid UTF-8 are replaced by U+FFFD in the words.
+ *  The ASCII check covers 16 bytes at a time when SSE2 is available, so the
+ *  common case costs little more than a copy.
+ */
+class HEADERENCODER_API HeaderEncoder {
+ public:
+    /** The recommended maximum length of a header line, CRLF excluded. */
+    static const size_t MAX_LINE_LENGTH = 78;
+
+    /** The maximum length of an encoded word (RFC 2047). */
+    static const size_t MAX_ENCODED_WORD_LENGTH = 75;
+
+    /**
+     *  @brief  Return true if a header value must be sent as encoded words:
+     *  it contains bytes above 127 or control characters other than tab.
+     *  @param pData The header value.
+     *  @param pLength The length of the value.
+     */
+    static bool needsEncoding(const char *pData, size_t pLength);
+
+    /**
+     *  @brief  Append an unstructured header field (like Subject) followed
+     *  by CRLF.
+     *  @param pOutput The buffer that receives the header field.
+     *  @param pName The name of the field.
+     *  @param pValue The value of the field.
+     */
+    static void appendUnstructured(std::string &pOutput, const char *pName, const char *pValue);
+
+    /**
+     *  @brief  Append a header field holding a single mailbox (like From)
+     *  followed by CRLF. The display name is quoted, or encoded if needed.
+     *  @param pOutput The buffer that receives the header field.
+     *  @param pName The name of the field.
+     *  @param pDisplayName The display name of the mailbox.
+     *  @param pEmailAddress The email address of the mailbox.
+     */
+    static void appendMailbox(std::string &pOutput,
+            const char *pName,
+            const char *pDisplayName,
+            const char *pEmailAddress);
+};
+}  // namespace jed_utils
+
+#endif
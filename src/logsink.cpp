@@ -0,0 +1,44 @@
+#include "logsink.h"
+#include <cstdio>
+#include <ctime>
+
+using namespace jed_utils;
+
+LogSink::LogSink(CommunicationLogLevel pLevel)
+    : mLevel(pLevel) {
+}
+
+LogSink::~LogSink() = default;
+
+CommunicationLogLevel LogSink::getLevel() const {
+    return mLevel;
+}
+
+std::string LogSink::format(const LogEvent &pEvent) {
+    const auto since_epoch = pEvent.Timestamp.time_since_epoch();
+    const std::time_t seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch).count();
+    const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch).count() % 1000;
+    std::tm utc {};
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    char prefix[64];
+    const int prefix_length = snprintf(prefix, sizeof(prefix), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ [%llu] %c: ",
+            utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec,
+            static_cast<int>(milliseconds), static_cast<unsigned long long>(pEvent.SessionId),
+            pEvent.Direction == LogDirection::Client ? 'c' : (pEvent.Direction == LogDirection::Server ? 's' : 'i'));
+    std::string line(prefix, prefix_length > 0 ? static_cast<size_t>(prefix_length) : 0);
+    line.reserve(line.length() + pEvent.Text.length() + 8);
+    for (char c : pEvent.Text) {
+        if (c == '\r') {
+            line += "\\r";
+        } else if (c == '\n') {
+            line += "\\n";
+        } else {
+            line += c;
+        }
+    }
+    return line;
+}
@@ -0,0 +1,97 @@
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "communicationlog.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define LOGSINK_API __declspec(dllexport)
+    #else
+        #define LOGSINK_API __declspec(dllimport)
+    #endif
+#else
+    #define LOGSINK_API
+#endif
+
+namespace jed_utils {
+/** @brief The origin of a LogEvent. */
+enum class LogDirection {
+    /** A command sent by the client */
+    Client,
+    /** A reply received from the server */
+    Server,
+    /** A step of both sides, such as the TLS negotiation ("c & s" in the
+     *  communication log) */
+    Info
+};
+
+/** @brief A line of the transcript of an SMTP session. */
+struct LogEvent {
+    /** When the event occurred. */
+    std::chrono::system_clock::time_point Timestamp;
+    /** The session that produced the event (see SMTPClientBase::getSessionId). */
+    std::uint64_t SessionId = 0;
+    /** The origin of the event. */
+    LogDirection Direction = LogDirection::Info;
+    /** The reply code of a server reply, 0 for the other events. */
+    int ReplyCode = 0;
+    /** The level of the event: Commands, Headers or Full. */
+    CommunicationLogLevel Level = CommunicationLogLevel::Commands;
+    /** The command, reply or message, line breaks included. */
+    std::string Text;
+};
+
+/** @brief The LogSink class receives the transcript of the SMTP sessions
+ *  of the clients it is attached to (see SMTPClientBase::setLogSink).
+ *
+ *  write is called by the thread that sends the mail, so it must be quick
+ *  and thread safe when the sink is shared by several clients. See
+ *  AsyncLogSink for a sink that writes from a background thread.
+ */
+class LOGSINK_API LogSink {
+ public:
+    /**
+     *  @brief  Construct a new LogSink.
+     *  @param pLevel The level of the events the sink receives.
+     */
+    explicit LogSink(CommunicationLogLevel pLevel = CommunicationLogLevel::Full);
+
+    /** Destructor of the LogSink. */
+    virtual ~LogSink();
+
+    /** LogSink copy constructor (deleted). */
+    LogSink(const LogSink &other) = delete;
+
+    /** LogSink copy assignment operator (deleted). */
+    LogSink& operator=(const LogSink &other) = delete;
+
+    /** Return the level of the events the sink receives. */
+    CommunicationLogLevel getLevel() const;
+
+    /** Return true if the sink receives the events of the level. */
+    bool isEnabled(CommunicationLogLevel pLevel) const {
+        return pLevel != CommunicationLogLevel::Off && pLevel <= mLevel;
+    }
+
+    /**
+     *  @brief  Receive an event.
+     *  @param pEvent The event. The sink can move it.
+     */
+    virtual void write(LogEvent &pEvent) = 0;
+
+    /**
+     *  @brief  Return an event as a single line without line break:
+     *  timestamp (UTC, ISO 8601), session id, origin (c, s or i) and text
+     *  with its line breaks written as \\r\\n.
+     */
+    static std::string format(const LogEvent &pEvent);
+
+ private:
+    const CommunicationLogLevel mLevel;
+};
+}  // namespace jed_utils
+
+#endif
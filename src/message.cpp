@@ -40,7 +40,9 @@ Message::Message(const MessageAddress &pFrom,
       mSubject(nullptr),
       mBody(nullptr),
       mAttachments(nullptr),
-      mAttachmentCount(pAttachmentsSize) {
+      mAttachmentCount(pAttachmentsSize),
+      mBodyTransferEncoding(TransferEncoding::Automatic),
+      mAlternativeBody(nullptr) {
     if (pSubject == nullptr) {
         mSubject = new char('\0');
     } else {
@@ -93,6 +95,8 @@ Message::~Message() {
     mSubject = nullptr;
     delete[] mBody;
     mBody = nullptr;
+    delete[] mAlternativeBody;
+    mAlternativeBody = nullptr;
     // To
     if (mTo != nullptr) {
         for (unsigned int i = 0; i < mToCount; i++) {
@@ -139,7 +143,10 @@ Message::Message(const Message &other)
       mSubject(new char[strlen(other.mSubject) + 1]),
       mBody(new char[strlen(other.mBody) + 1]),
       mAttachments(nullptr),
-      mAttachmentCount(other.mAttachmentCount) {
+      mAttachmentCount(other.mAttachmentCount),
+      mBodyTransferEncoding(other.mBodyTransferEncoding),
+      mAlternativeBody(nullptr) {
+    setAlternativeBody(other.mAlternativeBody);
     size_t body_len = strlen(other.mBody);
     strncpy(mBody, other.mBody, body_len);
     mBody[body_len] = '\0';
@@ -252,6 +259,8 @@ Message& Message::operator=(const Message &other) {
             }
         }
         mAttachmentCount = other.mAttachmentCount;
+        mBodyTransferEncoding = other.mBodyTransferEncoding;
+        setAlternativeBody(other.mAlternativeBody);
     }
     return *this;
 }
@@ -268,7 +277,9 @@ Message::Message(Message &&other) noexcept
       mSubject(other.mSubject),
       mBody(other.mBody),
       mAttachments(other.mAttachments),
-      mAttachmentCount(other.mAttachmentCount) {
+      mAttachmentCount(other.mAttachmentCount),
+      mBodyTransferEncoding(other.mBodyTransferEncoding),
+      mAlternativeBody(other.mAlternativeBody) {
     // Release the data pointer from the source object so that the destructor
     // does not free the memory multiple times.
     other.mTo = nullptr;
@@ -281,6 +292,7 @@ Message::Message(Message &&other) noexcept
     other.mBody = nullptr;
     other.mAttachments = nullptr;
     other.mAttachmentCount = 0;
+    other.mAlternativeBody = nullptr;
 }
 
 // Move assignement
@@ -288,6 +300,7 @@ Message& Message::operator=(Message &&other) noexcept {
     if (this != &other) {
         delete[] mSubject;
         delete[] mBody;
+        delete[] mAlternativeBody;
         // mTo
         if (mTo != nullptr) {
             for (unsigned int i = 0; i < mToCount; i++) {
@@ -329,6 +342,8 @@ Message& Message::operator=(Message &&other) noexcept {
         mBCCCount = other.mBCCCount;
         mAttachments = other.mAttachments;
         mAttachmentCount = other.mAttachmentCount;
+        mBodyTransferEncoding = other.mBodyTransferEncoding;
+        mAlternativeBody = other.mAlternativeBody;
         // Release the data pointer from the source object so that
         // the destructor does not free the memory multiple times.
         other.mSubject = nullptr;
@@ -341,6 +356,7 @@ Message& Message::operator=(Message &&other) noexcept {
         other.mBCCCount = 0;
         other.mAttachments = nullptr;
         other.mAttachmentCount = 0;
+        other.mAlternativeBody = nullptr;
     }
     return *this;
 }
@@ -389,3 +405,28 @@ size_t Message::getAttachmentsCount() const {
     return mAttachmentCount;
 }
 
+
+TransferEncoding Message::getBodyTransferEncoding() const {
+    return mBodyTransferEncoding;
+}
+
+void Message::setBodyTransferEncoding(TransferEncoding pEncoding) {
+    mBodyTransferEncoding = pEncoding;
+}
+
+const char *Message::getAlternativeBody() const {
+    return mAlternativeBody;
+}
+
+void Message::setAlternativeBody(const char *pAlternativeBody) {
+    if (pAlternativeBody == mAlternativeBody) {
+        return;
+    }
+    delete[] mAlternativeBody;
+    mAlternativeBody = nullptr;
+    if (pAlternativeBody != nullptr) {
+        size_t alternative_body_len = strlen(pAlternativeBody);
+        mAlternativeBody = new char[alternative_body_len + 1];
+        memcpy(mAlternativeBody, pAlternativeBody, alternative_body_len + 1);
+    }
+}
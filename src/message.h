@@ -4,6 +4,7 @@
 #include <cstring>
 #include <vector>
 #include "attachment.h"
+#include "contentclassifier.h"
 #include "messageaddress.h"
 
 #ifdef _WIN32
@@ -117,6 +118,28 @@ class MESSAGE_API Message {
     /** Return the number of message attachments in the array. */
     size_t getAttachmentsCount() const;
 
+    /** Return the transfer encoding of the body. Automatic by default. */
+    TransferEncoding getBodyTransferEncoding() const;
+
+    /**
+     *  @brief  Set the transfer encoding of the body. Automatic selects it
+     *  from the content (see MessageRenderer::selectBodyEncoding). 7bit and
+     *  8bit are used only if the body and the server allow them.
+     *  @param pEncoding The transfer encoding.
+     */
+    void setBodyTransferEncoding(TransferEncoding pEncoding);
+
+    /** Return the plain text alternative of the body or null if none is set. */
+    const char *getAlternativeBody() const;
+
+    /**
+     *  @brief  Set a plain text version of the body, usually of an HTML
+     *  body. Both are sent in a multipart/alternative, the mail clients that
+     *  cannot show the body show the plain text instead.
+     *  @param pAlternativeBody The plain text. Null to send the body alone.
+     */
+    void setAlternativeBody(const char *pAlternativeBody);
+
  private:
     MessageAddress mFrom;
     MessageAddress **mTo;
@@ -129,6 +152,8 @@ class MESSAGE_API Message {
     char *mBody;
     Attachment **mAttachments;
     size_t mAttachmentCount;
+    TransferEncoding mBodyTransferEncoding;
+    char *mAlternativeBody;
 };
 }  // namespace jed_utils
 
@@ -1,9 +1,11 @@
 #include "messageaddress.h"
+#include <algorithm>
 #include <cstddef>
 #include <regex>
 #include <stdexcept>
 #include <string>
 #include "stringutils.h"
+#include "utf8validator.h"
 
 using namespace jed_utils;
 
@@ -118,6 +120,15 @@ const char *MessageAddress::getDisplayName() const {
 
 bool MessageAddress::isEmailAddressValid(const std::string &pEmailAddress) const {
     std::regex emailPattern("^[_a-z0-9-]+(.[_a-z0-9-]+)*@[a-z0-9-]+(.[a-z0-9-]+)*(.[a-z]{2,4})$");
-    return regex_match(StringUtils::toLower(pEmailAddress), emailPattern);
+    // The UTF-8 characters of the internationalized addresses (RFC 6531) are
+    // accepted like the ASCII letters
+    if (!UTF8Validator::isValid(pEmailAddress.data(), pEmailAddress.length())) {
+        return false;
+    }
+    std::string address { StringUtils::toLower(pEmailAddress) };
+    std::replace_if(address.begin(), address.end(), [](char c) {
+            return static_cast<unsigned char>(c) > 127;
+            }, 'a');
+    return regex_match(address, emailPattern);
 }
 
@@ -0,0 +1,280 @@
+#include "messagerenderer.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "headerencoder.h"
+#include "messageaddress.h"
+
+using namespace jed_utils;
+
+namespace {
+    // The fixed fields and the folding of the headers
+    const size_t HEADERS_RESERVED_LENGTH = 128;
+    // The "To: " or "Cc: " field of an address
+    const size_t ADDRESS_RESERVED_LENGTH = 48;
+
+    /* pValidUTF8 is false when the classification found 8-bit bytes that
+       are not UTF-8. A requested encoding is used without classifying the
+       text, which is then declared as UTF-8. */
+    TransferEncoding selectTextEncoding(const char *pText, TransferEncoding pRequestedEncoding, bool pEightBitMime,
+            bool &pValidUTF8) {
+        pValidUTF8 = true;
+        if (pRequestedEncoding == TransferEncoding::QuotedPrintable || pRequestedEncoding == TransferEncoding::Base64) {
+            return pRequestedEncoding;
+        }
+        const size_t length = pText != nullptr ? strlen(pText) : 0;
+        const ContentClassification classification { ContentClassifier::classify(pText, length) };
+        pValidUTF8 = !classification.InvalidUTF8;
+        const TransferEncoding encoding = ContentClassifier::selectEncoding(classification, length, pEightBitMime);
+        // 7bit and 8bit carry the text as is, they are only honored when the
+        // content allows it
+        if (pRequestedEncoding == TransferEncoding::EightBit && pEightBitMime && encoding == TransferEncoding::SevenBit) {
+            return TransferEncoding::EightBit;
+        }
+        return encoding;
+    }
+
+    bool hasEightBitText(const MimePart &pPart) {
+        if (pPart.getKind() == MimePartKind::Text) {
+            return pPart.getTransferEncoding() == TransferEncoding::EightBit;
+        }
+        for (const auto &part : pPart.getParts()) {
+            if (hasEightBitText(part)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void appendHeaders(std::string &pOutput, const Message &pMsg, const MimePart &pRoot) {
+        // The fields are written in place, the room for the folds and encoded
+        // words is only needed by long or non-ASCII values
+        const char *subject = pMsg.getSubject();
+        pOutput.reserve(pOutput.length() + HEADERS_RESERVED_LENGTH + strlen(pMsg.getFrom().getDisplayName())
+                + strlen(pMsg.getFrom().getEmailAddress()) + (subject != nullptr ? strlen(subject) : 0)
+                + (pMsg.getToCount() + pMsg.getCcCount()) * ADDRESS_RESERVED_LENGTH);
+        // From
+        HeaderEncoder::appendMailbox(pOutput, "From", pMsg.getFrom().getDisplayName(), pMsg.getFrom().getEmailAddress());
+
+        // To and Cc.
+        // Note : Bcc are not included in the header
+        MessageAddress **to = pMsg.getTo();
+        for (size_t i = 0; to != nullptr && i < pMsg.getToCount(); i++) {
+            pOutput += "To: ";
+            pOutput += to[i]->getEmailAddress();
+            pOutput += "\r\n";
+        }
+        MessageAddress **cc = pMsg.getCc();
+        for (size_t i = 0; cc != nullptr && i < pMsg.getCcCount(); i++) {
+            pOutput += "Cc: ";
+            pOutput += cc[i]->getEmailAddress();
+            pOutput += "\r\n";
+        }
+
+        // Subject
+        HeaderEncoder::appendUnstructured(pOutput, "Subject", subject);
+
+        // Content-Type of the root multipart
+        pOutput += pRoot.renderHeaders();
+    }
+
+    bool isASCII(const char *pText) {
+        for (const char *c = pText; c != nullptr && *c != '\0'; c++) {
+            if (static_cast<unsigned char>(*c) > 127) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The DKIM signing domain is the domain of the sender
+    const char *getSenderDomain(const Message &pMsg) {
+        const char *address = pMsg.getFrom().getEmailAddress();
+        const char *at_sign = address != nullptr ? strrchr(address, '@') : nullptr;
+        return at_sign != nullptr ? at_sign + 1 : nullptr;
+    }
+
+    // The DKIM-Signature field of the headers followed by the body
+    std::string createSignatureField(const Message &pMsg, const DKIMSigner &pSigner,
+            const std::string &pContent, size_t pOffset, size_t pHeadersLength) {
+        // The body is hashed in place, it is not rendered again
+        DKIMBodyHasher hasher(pSigner.getBodyCanonicalization());
+        const size_t body_offset = pOffset + pHeadersLength;
+        hasher.update(pContent.data() + body_offset, pContent.length() - body_offset);
+        return pSigner.createSignatureField(getSenderDomain(pMsg), pContent.data() + pOffset,
+                pHeadersLength, hasher.finish());
+    }
+
+    bool hasNonASCIIAddress(MessageAddress **pAddresses, size_t pCount) {
+        for (size_t i = 0; pAddresses != nullptr && i < pCount; i++) {
+            if (!isASCII(pAddresses[i]->getEmailAddress())) {
+                return true;
+            }
+        }
+        return false;
+    }
+}  // namespace
+
+std::string MessageRenderer::renderHeaders(const Message &pMsg) {
+    std::string headers;
+    appendHeaders(headers, pMsg, buildMimeTree(pMsg));
+    return headers;
+}
+
+MimePart MessageRenderer::buildMimeTree(const Message &pMsg, bool pEightBitMime) {
+    // mixed
+    // +- alternative (when there is a plain text alternative)
+    // |  +- text/plain alternative
+    // |  +- related (when attachments have a Content-ID)
+    // |     +- body
+    // |     +- inline attachments
+    // +- other attachments
+    bool valid_utf8 = true;
+    const TransferEncoding body_encoding { selectTextEncoding(pMsg.getBody(), pMsg.getBodyTransferEncoding(),
+            pEightBitMime, valid_utf8) };
+    MimePart body { MimePart::createText(pMsg.getMimeType(), pMsg.getBody(), body_encoding, valid_utf8) };
+    Attachment **attachments = pMsg.getAttachments();
+    const size_t attachment_count = attachments != nullptr ? pMsg.getAttachmentsCount() : 0;
+    const size_t inline_count = static_cast<size_t>(std::count_if(attachments, attachments + attachment_count,
+                [](const Attachment *pAttachment) { return pAttachment->getContentId() != nullptr; }));
+    if (inline_count > 0) {
+        MimePart related { MimePart::createMultipart("related") };
+        related.addPart(std::move(body));
+        for (size_t index = 0; index < attachment_count; index++) {
+            if (attachments[index]->getContentId() != nullptr) {
+                related.addPart(MimePart::createAttachment(*attachments[index]));
+            }
+        }
+        body = std::move(related);
+    }
+    const char *alternative_body = pMsg.getAlternativeBody();
+    if (alternative_body != nullptr) {
+        MimePart alternative { MimePart::createMultipart("alternative") };
+        // The preferred version comes last
+        const TransferEncoding alternative_encoding { selectTextEncoding(alternative_body,
+                pMsg.getBodyTransferEncoding(), pEightBitMime, valid_utf8) };
+        alternative.addPart(MimePart::createText("text/plain", alternative_body, alternative_encoding, valid_utf8));
+        alternative.addPart(std::move(body));
+        body = std::move(alternative);
+    }
+
+    MimePart root { MimePart::createMultipart("mixed") };
+    root.addPart(std::move(body));
+    for (size_t index = 0; index < attachment_count; index++) {
+        if (attachments[index]->getContentId() == nullptr) {
+            root.addPart(MimePart::createAttachment(*attachments[index]));
+        }
+    }
+    root.assignBoundaries();
+    return root;
+}
+
+std::string MessageRenderer::renderBodyPart(const Message &pMsg, bool pEightBitMime) {
+    const MimePart root { buildMimeTree(pMsg, pEightBitMime) };
+    const MimePart &first_part = root.getParts().front();
+    std::string body_part { "--" + root.getBoundary() + "\r\n" + first_part.renderHeaders() };
+    first_part.serialize(body_part);
+    return body_part;
+}
+
+TransferEncoding MessageRenderer::selectBodyEncoding(const Message &pMsg, bool pEightBitMime) {
+    bool valid_utf8 = true;
+    return selectTextEncoding(pMsg.getBody(), pMsg.getBodyTransferEncoding(), pEightBitMime, valid_utf8);
+}
+
+std::string MessageRenderer::renderMailFromParameters(const Message &pMsg, const ServerAuthOptions *pOptions) {
+    std::string parameters;
+    if (pOptions == nullptr) {
+        return parameters;
+    }
+    if (pOptions->EightBitMime && hasEightBitText(buildMimeTree(pMsg, true))) {
+        parameters += " BODY=8BITMIME";
+    }
+    if (pOptions->SMTPUTF8
+            && (!isASCII(pMsg.getFrom().getEmailAddress())
+                || hasNonASCIIAddress(pMsg.getTo(), pMsg.getToCount())
+                || hasNonASCIIAddress(pMsg.getCc(), pMsg.getCcCount())
+                || hasNonASCIIAddress(pMsg.getBcc(), pMsg.getBccCount()))) {
+        parameters += " SMTPUTF8";
+    }
+    return parameters;
+}
+
+std::string MessageRenderer::renderBody(const Message &pMsg, bool pEightBitMime) {
+    const MimePart root { buildMimeTree(pMsg, pEightBitMime) };
+    std::string body;
+    body.reserve(root.getSize());
+    root.serialize(body);
+    return body;
+}
+
+std::string MessageRenderer::renderAttachments(const std::vector<Attachment*> &pAttachments) {
+    std::string retval;
+    for (const auto &item : pAttachments) {
+        retval += renderAttachmentHeaders(*item);
+        const char *encoded_file = item->getBase64EncodedFile();
+        if (encoded_file != nullptr) {
+            retval += encoded_file;
+            delete[] encoded_file;
+        }
+    }
+    retval += renderEndOfParts();
+    return retval;
+}
+
+std::string MessageRenderer::renderAttachmentHeaders(const Attachment &pAttachment) {
+    return "\r\n--" + std::string(MimePart::DEFAULT_BOUNDARY) + "\r\n" + MimePart::createAttachment(pAttachment).renderHeaders();
+}
+
+std::string MessageRenderer::renderEndOfParts() {
+    return "\r\n--" + std::string(MimePart::DEFAULT_BOUNDARY) + "--";
+}
+
+std::string MessageRenderer::render(const Message &pMsg, bool pEightBitMime, const DKIMSigner *pSigner) {
+    const MimePart root { buildMimeTree(pMsg, pEightBitMime) };
+    std::string content;
+    appendHeaders(content, pMsg, root);
+    const size_t headers_length = content.length();
+    const size_t signature_length = isSigned(pMsg, pSigner)
+        ? pSigner->getSignatureFieldLength(getSenderDomain(pMsg), content.data(), headers_length) : 0;
+    // The room of the signature is made while only the headers are moved
+    content.insert(0, signature_length, ' ');
+    // The tree is serialized straight into the content
+    content.reserve(signature_length + headers_length + root.getSize());
+    root.serialize(content);
+    if (signature_length > 0) {
+        content.replace(0, signature_length,
+                createSignatureField(pMsg, *pSigner, content, signature_length, headers_length));
+    }
+    return content;
+}
+
+std::string MessageRenderer::render(const Message &pMsg, bool pEightBitMime, const DKIMSigner *pSigner,
+        std::string &pSignatureField) {
+    const MimePart root { buildMimeTree(pMsg, pEightBitMime) };
+    std::string content;
+    appendHeaders(content, pMsg, root);
+    const size_t headers_length = content.length();
+    content.reserve(headers_length + root.getSize());
+    root.serialize(content);
+    pSignatureField.clear();
+    if (isSigned(pMsg, pSigner)) {
+        pSignatureField = createSignatureField(pMsg, *pSigner, content, 0, headers_length);
+    }
+    return content;
+}
+
+size_t MessageRenderer::computeSize(const Message &pMsg, bool pEightBitMime, const DKIMSigner *pSigner) {
+    const MimePart root { buildMimeTree(pMsg, pEightBitMime) };
+    std::string headers;
+    appendHeaders(headers, pMsg, root);
+    const size_t signature_length = isSigned(pMsg, pSigner)
+        ? pSigner->getSignatureFieldLength(getSenderDomain(pMsg), headers.data(), headers.length()) : 0;
+    return signature_length + headers.length() + root.getSize();
+}
+
+bool MessageRenderer::isSigned(const Message &pMsg, const DKIMSigner *pSigner) {
+    return pSigner != nullptr && pSigner->hasKey(getSenderDomain(pMsg));
+}
@@ -0,0 +1,151 @@
+#ifndef MESSAGERENDERER_H
+#define MESSAGERENDERER_H
+
+#include <string>
+#include <vector>
+#include "attachment.h"
+#include "contentclassifier.h"
+#include "dkimsigner.h"
+#include "message.h"
+#include "mimepart.h"
+#include "serverauthoptions.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define MESSAGERENDERER_API __declspec(dllexport)
+    #else
+        #define MESSAGERENDERER_API __declspec(dllimport)
+    #endif
+#else
+    #define MESSAGERENDERER_API
+#endif
+
+namespace jed_utils {
+/** @brief The MessageRenderer class produces the content sent during the
+ *  DATA phase of an SMTP transaction (headers, body part and attachments).
+ *  The body is the MIME tree returned by buildMimeTree.
+ *
+ *  It is shared by the blocking clients and the event-driven SMTPSession so
+ *  both put exactly the same bytes on the wire.
+ */
+class MESSAGERENDERER_API MessageRenderer {
+ public:
+    /**
+     *  @brief  Return the header section of the message, including the
+     *  empty line that separates the headers from the body. The subject and
+     *  the display name of the sender are folded or sent as encoded words
+     *  when needed (see HeaderEncoder).
+     *  @param pMsg The message to render.
+     */
+    static std::string renderHeaders(const Message &pMsg);
+
+    /**
+     *  @brief  Return the MIME tree of the message: a multipart/mixed that
+     *  holds the body and the attachments. The body is in a
+     *  multipart/alternative with its plain text alternative, if any, and in
+     *  a multipart/related with the attachments that have a Content-ID.
+     *  @param pMsg The message to render. It must outlive the tree.
+     *  @param pEightBitMime True if the server accepts 8-bit data (8BITMIME).
+     */
+    static MimePart buildMimeTree(const Message &pMsg, bool pEightBitMime = false);
+
+    /**
+     *  @brief  Return the body section of the message (body part and
+     *  attachments) without the end of data marker.
+     *  @param pMsg The message to render.
+     *  @param pEightBitMime True if the server accepts 8-bit data (8BITMIME).
+     */
+    static std::string renderBody(const Message &pMsg, bool pEightBitMime = false);
+
+    /**
+     *  @brief  Return the first part of the multipart body with its
+     *  delimiter, which holds the message text in the encoding returned by
+     *  selectBodyEncoding (and its alternative).
+     *  @param pMsg The message to render.
+     *  @param pEightBitMime True if the server accepts 8-bit data (8BITMIME).
+     */
+    static std::string renderBodyPart(const Message &pMsg, bool pEightBitMime = false);
+
+    /**
+     *  @brief  Return the transfer encoding of the message text: as is when
+     *  it is ASCII (or 8-bit and the server accepts it) with lines of at most
+     *  998 characters, else quoted-printable or base64.
+     *  @param pMsg The message to render.
+     *  @param pEightBitMime True if the server accepts 8-bit data (8BITMIME).
+     */
+    static TransferEncoding selectBodyEncoding(const Message &pMsg, bool pEightBitMime);
+
+    /**
+     *  @brief  Return the parameters of the MAIL FROM command that announce
+     *  an 8-bit body (BODY=8BITMIME) and UTF-8 addresses (SMTPUTF8), each
+     *  preceded by a space. SIZE is not included.
+     *  @param pMsg The message to send.
+     *  @param pOptions The extensions advertised by the server, or nullptr.
+     */
+    static std::string renderMailFromParameters(const Message &pMsg, const ServerAuthOptions *pOptions);
+
+    /**
+     *  @brief  Return the attachments section of a multipart body that uses
+     *  the default boundary.
+     *  @param pAttachments The attachments to render.
+     */
+    static std::string renderAttachments(const std::vector<Attachment*> &pAttachments);
+
+    /**
+     *  @brief  Return the part separator (default boundary) and headers of
+     *  an attachment, which are followed by its base64 content.
+     *  @param pAttachment The attachment to render.
+     */
+    static std::string renderAttachmentHeaders(const Attachment &pAttachment);
+
+    /** Return the closing separator of a multipart body that uses the
+     *  default boundary. */
+    static std::string renderEndOfParts();
+
+    /**
+     *  @brief  Return the complete DATA content of the message (headers and
+     *  body) without the end of data marker.
+     *
+     *  With a signer that has a key for the domain of the sender, the body is
+     *  hashed once serialized and the DKIM-Signature field is written in the
+     *  room left before the headers.
+     *  @param pMsg The message to render.
+     *  @param pEightBitMime True if the server accepts 8-bit data (8BITMIME).
+     *  @param pSigner The DKIM signer or null to send the message unsigned.
+     */
+    static std::string render(const Message &pMsg, bool pEightBitMime = false, const DKIMSigner *pSigner = nullptr);
+
+    /**
+     *  @brief  Same as render, but the DKIM-Signature field is returned
+     *  apart so it can be sent before the content without copying it.
+     *  @param pMsg The message to render.
+     *  @param pEightBitMime True if the server accepts 8-bit data (8BITMIME).
+     *  @param pSigner The DKIM signer or null to send the message unsigned.
+     *  @param pSignatureField Receives the DKIM-Signature field, empty if
+     *  the message is not signed.
+     */
+    static std::string render(const Message &pMsg, bool pEightBitMime, const DKIMSigner *pSigner,
+            std::string &pSignatureField);
+
+    /**
+     *  @brief  Return the exact size of the content returned by render once
+     *  its bare line breaks are sent as CRLF (RFC 1870). The attachments are
+     *  not read nor encoded, their encoded length is computed from the file
+     *  sizes.
+     *  @param pMsg The message to measure.
+     *  @param pEightBitMime True if the server accepts 8-bit data (8BITMIME).
+     *  @param pSigner The DKIM signer or null if the message is unsigned.
+     */
+    static size_t computeSize(const Message &pMsg, bool pEightBitMime = false, const DKIMSigner *pSigner = nullptr);
+
+    /**
+     *  @brief  Return true if the signer has a key for the domain of the
+     *  sender of the message.
+     *  @param pMsg The message to sign.
+     *  @param pSigner The DKIM signer. Can be null.
+     */
+    static bool isSigned(const Message &pMsg, const DKIMSigner *pSigner);
+};
+}  // namespace jed_utils
+
+#endif
@@ -0,0 +1,449 @@
+#include "metricsregistry.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace jed_utils;
+
+const size_t LatencyHistogram::BUCKET_COUNT;
+const size_t MetricsRegistry::MAX_RELAY_COUNT;
+const size_t MetricsRegistry::COMMAND_COUNT;
+const size_t MetricsRegistry::ERROR_CODE_SLOT_COUNT;
+
+namespace {
+    // The buckets of the Prometheus export: 2^7 to 2^26 microseconds
+    const unsigned int FIRST_EXPORTED_EXPONENT = 7;
+    const unsigned int LAST_EXPORTED_EXPONENT = 26;
+    const int LOWEST_CLIENT_ERROR_CODE = -127;
+    const int LOWEST_REPLY_ERROR_CODE = 400;
+    const int HIGHEST_REPLY_ERROR_CODE = 599;
+
+    void appendSeconds(std::string &pOutput, std::uint64_t pMicroseconds) {
+        char buffer[32];
+        const int length = snprintf(buffer, sizeof(buffer), "%llu.%06llu",
+                static_cast<unsigned long long>(pMicroseconds / 1000000),
+                static_cast<unsigned long long>(pMicroseconds % 1000000));
+        pOutput.append(buffer, length > 0 ? static_cast<size_t>(length) : 0);
+    }
+
+    // The label value with its backslashes, quotes and line feeds escaped
+    std::string escapeLabelValue(const std::string &pValue) {
+        std::string escaped;
+        escaped.reserve(pValue.length());
+        for (char c : pValue) {
+            if (c == '\\' || c == '"') {
+                escaped += '\\';
+                escaped += c;
+            } else if (c == '\n') {
+                escaped += "\\n";
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    void appendHeader(std::string &pOutput, const char *pName, const char *pType, const char *pHelp) {
+        pOutput += "# HELP ";
+        pOutput += pName;
+        pOutput += ' ';
+        pOutput += pHelp;
+        pOutput += "\n# TYPE ";
+        pOutput += pName;
+        pOutput += ' ';
+        pOutput += pType;
+        pOutput += '\n';
+    }
+
+    void appendSample(std::string &pOutput, const char *pName, const std::string &pLabels, const std::string &pValue) {
+        pOutput += pName;
+        if (!pLabels.empty()) {
+            pOutput += '{';
+            pOutput += pLabels;
+            pOutput += '}';
+        }
+        pOutput += ' ';
+        pOutput += pValue;
+        pOutput += '\n';
+    }
+
+    // Case insensitive comparison of the start of a line with an upper case keyword
+    bool startsWith(const char *pLine, const char *pKeyword) {
+        for (; *pKeyword != '\0'; pLine++, pKeyword++) {
+            if (toupper(static_cast<unsigned char>(*pLine)) != *pKeyword) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace
+
+LatencyHistogram::LatencyHistogram()
+    : mCount(0),
+      mSum(0) {
+    for (auto &bucket : mBuckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(std::chrono::microseconds pLatency) {
+    const auto microseconds = static_cast<std::uint64_t>(pLatency.count() > 0 ? pLatency.count() : 0);
+    mBuckets[getBucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mSum.fetch_add(microseconds, std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::getCount() const {
+    return mCount.load(std::memory_order_relaxed);
+}
+
+std::chrono::microseconds LatencyHistogram::getSum() const {
+    return std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(mSum.load(std::memory_order_relaxed)));
+}
+
+std::chrono::microseconds LatencyHistogram::getQuantile(double pQuantile) const {
+    std::array<std::uint64_t, BUCKET_COUNT> counts {};
+    std::uint64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        counts[i] = mBuckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return std::chrono::microseconds(0);
+    }
+    const double quantile = pQuantile < 0 ? 0 : (pQuantile > 1 ? 1 : pQuantile);
+    auto rank = static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(total)));
+    if (rank == 0) {
+        rank = 1;
+    }
+    std::uint64_t cumulative = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        cumulative += counts[i];
+        if (cumulative >= rank) {
+            return std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(getBucketUpperBound(i)));
+        }
+    }
+    return std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(getBucketUpperBound(BUCKET_COUNT - 1)));
+}
+
+void LatencyHistogram::writePrometheus(std::string &pOutput, const char *pName, const std::string &pLabels) const {
+    const std::string bucket_name { std::string(pName) + "_bucket" };
+    const std::string label_prefix { pLabels.empty() ? "" : pLabels + "," };
+    std::uint64_t cumulative = 0;
+    size_t index = 0;
+    for (unsigned int exponent = FIRST_EXPORTED_EXPONENT; exponent <= LAST_EXPORTED_EXPONENT; exponent++) {
+        const std::uint64_t bound = std::uint64_t(1) << exponent;
+        for (; index < BUCKET_COUNT && getBucketUpperBound(index) <= bound; index++) {
+            cumulative += mBuckets[index].load(std::memory_order_relaxed);
+        }
+        std::string le;
+        appendSeconds(le, bound);
+        appendSample(pOutput, bucket_name.c_str(), label_prefix + "le=\"" + le + "\"", std::to_string(cumulative));
+    }
+    for (; index < BUCKET_COUNT; index++) {
+        cumulative += mBuckets[index].load(std::memory_order_relaxed);
+    }
+    // The count is the sum of the buckets read, so the samples agree
+    appendSample(pOutput, bucket_name.c_str(), label_prefix + "le=\"+Inf\"", std::to_string(cumulative));
+    std::string sum;
+    appendSeconds(sum, mSum.load(std::memory_order_relaxed));
+    appendSample(pOutput, (std::string(pName) + "_sum").c_str(), pLabels, sum);
+    appendSample(pOutput, (std::string(pName) + "_count").c_str(), pLabels, std::to_string(cumulative));
+}
+
+size_t LatencyHistogram::getBucketIndex(std::uint64_t pMicroseconds) {
+    // A bucket holds the latencies up to its upper bound included
+    const std::uint64_t value = pMicroseconds > 0 ? pMicroseconds - 1 : 0;
+    if (value < 8) {
+        return static_cast<size_t>(value);
+    }
+    unsigned int exponent = 0;
+    for (std::uint64_t remaining = value; remaining > 1; remaining >>= 1) {
+        exponent++;
+    }
+    if (exponent > 36) {
+        return BUCKET_COUNT - 1;
+    }
+    const auto sub_bucket = static_cast<unsigned int>((value >> (exponent - 2)) & 3);
+    return 8 + (exponent - 3) * 4 + sub_bucket;
+}
+
+std::uint64_t LatencyHistogram::getBucketUpperBound(size_t pIndex) {
+    if (pIndex < 8) {
+        return pIndex + 1;
+    }
+    const size_t exponent = 3 + (pIndex - 8) / 4;
+    const size_t sub_bucket = (pIndex - 8) % 4;
+    return (std::uint64_t { 5 } + sub_bucket) << (exponent - 2);
+}
+
+MetricsRegistry::MetricsRegistry()
+    : mSentCount(0),
+      mFailedCount(0),
+      mRecipientCount(0),
+      mBytesWritten(0),
+      mBytesRead(0),
+      mResumedHandshakeCount(0),
+      mFullHandshakeCount(0),
+      mOpenSessionCount(0),
+      mQueueDepth(0),
+      mOtherRelay("other") {
+    for (auto &error_count : mErrorCounts) {
+        error_count.store(0, std::memory_order_relaxed);
+    }
+    for (auto &relay : mRelays) {
+        relay.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+MetricsRegistry::~MetricsRegistry() {
+    for (auto &relay : mRelays) {
+        delete relay.load(std::memory_order_relaxed);
+    }
+}
+
+void MetricsRegistry::recordSend(const char *pServerName, unsigned int pPort, size_t pRecipientCount, const SendReport &pReport) {
+    Relay &relay = getRelay(std::string(pServerName != nullptr ? pServerName : "") + ":" + std::to_string(pPort));
+    if (pReport.ReturnCode == 0) {
+        mSentCount.fetch_add(1, std::memory_order_relaxed);
+        mRecipientCount.fetch_add(pRecipientCount, std::memory_order_relaxed);
+        relay.SentCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        mFailedCount.fetch_add(1, std::memory_order_relaxed);
+        mErrorCounts[getErrorCodeSlot(pReport.ReturnCode)].fetch_add(1, std::memory_order_relaxed);
+        relay.FailedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    mBytesWritten.fetch_add(pReport.BytesWritten, std::memory_order_relaxed);
+    mBytesRead.fetch_add(pReport.BytesRead, std::memory_order_relaxed);
+    relay.Latency.record(pReport.getTotalDuration());
+}
+
+void MetricsRegistry::recordCommand(SMTPCommand pCommand, std::chrono::microseconds pLatency) {
+    mCommandLatencies[static_cast<size_t>(pCommand)].record(pLatency);
+}
+
+void MetricsRegistry::recordTLSHandshake(bool pResumed) {
+    (pResumed ? mResumedHandshakeCount : mFullHandshakeCount).fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::addOpenSession() {
+    mOpenSessionCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::removeOpenSession() {
+    mOpenSessionCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::setQueueDepth(size_t pDepth) {
+    mQueueDepth.store(pDepth, std::memory_order_relaxed);
+}
+
+std::uint64_t MetricsRegistry::getSentCount() const {
+    return mSentCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MetricsRegistry::getFailedCount() const {
+    return mFailedCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MetricsRegistry::getRecipientCount() const {
+    return mRecipientCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MetricsRegistry::getBytesWritten() const {
+    return mBytesWritten.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MetricsRegistry::getBytesRead() const {
+    return mBytesRead.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MetricsRegistry::getErrorCount(int pErrorCode) const {
+    const size_t slot = getErrorCodeSlot(pErrorCode);
+    return slot != 0 ? mErrorCounts[slot].load(std::memory_order_relaxed) : 0;
+}
+
+std::uint64_t MetricsRegistry::getTLSHandshakeCount(bool pResumed) const {
+    return (pResumed ? mResumedHandshakeCount : mFullHandshakeCount).load(std::memory_order_relaxed);
+}
+
+std::int64_t MetricsRegistry::getOpenSessionCount() const {
+    return mOpenSessionCount.load(std::memory_order_relaxed);
+}
+
+std::size_t MetricsRegistry::getQueueDepth() const {
+    return mQueueDepth.load(std::memory_order_relaxed);
+}
+
+const LatencyHistogram &MetricsRegistry::getCommandLatency(SMTPCommand pCommand) const {
+    return mCommandLatencies[static_cast<size_t>(pCommand)];
+}
+
+const LatencyHistogram *MetricsRegistry::findRelayLatency(const char *pRelay) const {
+    if (pRelay == nullptr) {
+        return nullptr;
+    }
+    if (mOtherRelay.Name == pRelay) {
+        return mOtherRelay.Latency.getCount() > 0 ? &mOtherRelay.Latency : nullptr;
+    }
+    for (const auto &slot : mRelays) {
+        const Relay *relay = slot.load(std::memory_order_acquire);
+        if (relay != nullptr && relay->Name == pRelay) {
+            return &relay->Latency;
+        }
+    }
+    return nullptr;
+}
+
+std::string MetricsRegistry::exportPrometheus() const {
+    std::string output;
+    output.reserve(16384);
+    appendHeader(output, "smtpclient_messages_total", "counter", "Messages passed to sendMail by result.");
+    appendSample(output, "smtpclient_messages_total", "result=\"sent\"", std::to_string(getSentCount()));
+    appendSample(output, "smtpclient_messages_total", "result=\"failed\"", std::to_string(getFailedCount()));
+    appendHeader(output, "smtpclient_recipients_total", "counter", "Recipients of the messages sent.");
+    appendSample(output, "smtpclient_recipients_total", "", std::to_string(getRecipientCount()));
+    appendHeader(output, "smtpclient_written_bytes_total", "counter", "Bytes sent to the servers, before TLS encryption.");
+    appendSample(output, "smtpclient_written_bytes_total", "", std::to_string(getBytesWritten()));
+    appendHeader(output, "smtpclient_read_bytes_total", "counter", "Bytes received from the servers, after TLS decryption.");
+    appendSample(output, "smtpclient_read_bytes_total", "", std::to_string(getBytesRead()));
+
+    appendHeader(output, "smtpclient_errors_total", "counter", "Messages that failed by error code.");
+    for (size_t slot = 0; slot < ERROR_CODE_SLOT_COUNT; slot++) {
+        const std::uint64_t count = mErrorCounts[slot].load(std::memory_order_relaxed);
+        if (count > 0) {
+            const std::string code { slot == 0 ? "other" : std::to_string(getSlotErrorCode(slot)) };
+            appendSample(output, "smtpclient_errors_total", "code=\"" + code + "\"", std::to_string(count));
+        }
+    }
+
+    appendHeader(output, "smtpclient_tls_handshakes_total", "counter", "Successful TLS handshakes by session resumption.");
+    appendSample(output, "smtpclient_tls_handshakes_total", "resumed=\"true\"", std::to_string(getTLSHandshakeCount(true)));
+    appendSample(output, "smtpclient_tls_handshakes_total", "resumed=\"false\"", std::to_string(getTLSHandshakeCount(false)));
+    appendHeader(output, "smtpclient_open_sessions", "gauge", "Connections open with the servers.");
+    appendSample(output, "smtpclient_open_sessions", "", std::to_string(getOpenSessionCount()));
+    appendHeader(output, "smtpclient_queue_depth", "gauge", "Messages waiting to be sent.");
+    appendSample(output, "smtpclient_queue_depth", "", std::to_string(getQueueDepth()));
+
+    appendHeader(output, "smtpclient_command_duration_seconds", "histogram", "Time from a command to its reply.");
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (mCommandLatencies[i].getCount() > 0) {
+            mCommandLatencies[i].writePrometheus(output, "smtpclient_command_duration_seconds",
+                    std::string("command=\"") + getCommandName(static_cast<SMTPCommand>(i)) + "\"");
+        }
+    }
+
+    std::vector<const Relay *> relays;
+    for (const auto &slot : mRelays) {
+        const Relay *relay = slot.load(std::memory_order_acquire);
+        if (relay != nullptr) {
+            relays.push_back(relay);
+        }
+    }
+    if (mOtherRelay.Latency.getCount() > 0) {
+        relays.push_back(&mOtherRelay);
+    }
+    appendHeader(output, "smtpclient_relay_messages_total", "counter", "Messages passed to sendMail by relay and result.");
+    for (const Relay *relay : relays) {
+        const std::string label { "relay=\"" + escapeLabelValue(relay->Name) + "\"" };
+        appendSample(output, "smtpclient_relay_messages_total", label + ",result=\"sent\"",
+                std::to_string(relay->SentCount.load(std::memory_order_relaxed)));
+        appendSample(output, "smtpclient_relay_messages_total", label + ",result=\"failed\"",
+                std::to_string(relay->FailedCount.load(std::memory_order_relaxed)));
+    }
+    appendHeader(output, "smtpclient_relay_send_duration_seconds", "histogram", "Duration of sendMail by relay.");
+    for (const Relay *relay : relays) {
+        relay->Latency.writePrometheus(output, "smtpclient_relay_send_duration_seconds",
+                "relay=\"" + escapeLabelValue(relay->Name) + "\"");
+    }
+    return output;
+}
+
+const char *MetricsRegistry::getCommandName(SMTPCommand pCommand) {
+    switch (pCommand) {
+        case SMTPCommand::Greeting: return "greeting";
+        case SMTPCommand::EHLO: return "EHLO";
+        case SMTPCommand::STARTTLS: return "STARTTLS";
+        case SMTPCommand::AUTH: return "AUTH";
+        case SMTPCommand::MAIL: return "MAIL";
+        case SMTPCommand::RCPT: return "RCPT";
+        case SMTPCommand::DATA: return "DATA";
+        case SMTPCommand::EndOfData: return "end_of_data";
+        case SMTPCommand::RSET: return "RSET";
+        case SMTPCommand::Other: return "other";
+    }
+    return "other";
+}
+
+SMTPCommand MetricsRegistry::getCommand(const char *pCommandLine) {
+    if (pCommandLine == nullptr) {
+        return SMTPCommand::Other;
+    }
+    if (strcmp(pCommandLine, "\r\n.\r\n") == 0) {
+        return SMTPCommand::EndOfData;
+    }
+    if (startsWith(pCommandLine, "EHLO") || startsWith(pCommandLine, "HELO")) {
+        return SMTPCommand::EHLO;
+    }
+    if (startsWith(pCommandLine, "STARTTLS")) {
+        return SMTPCommand::STARTTLS;
+    }
+    if (startsWith(pCommandLine, "AUTH")) {
+        return SMTPCommand::AUTH;
+    }
+    if (startsWith(pCommandLine, "MAIL")) {
+        return SMTPCommand::MAIL;
+    }
+    if (startsWith(pCommandLine, "RCPT")) {
+        return SMTPCommand::RCPT;
+    }
+    if (startsWith(pCommandLine, "DATA")) {
+        return SMTPCommand::DATA;
+    }
+    if (startsWith(pCommandLine, "RSET")) {
+        return SMTPCommand::RSET;
+    }
+    return SMTPCommand::Other;
+}
+
+MetricsRegistry::Relay &MetricsRegistry::getRelay(const std::string &pName) {
+    // Open addressing: a free slot is taken with a CAS and never released
+    const size_t hash = std::hash<std::string>()(pName);
+    for (size_t i = 0; i < MAX_RELAY_COUNT; i++) {
+        std::atomic<Relay *> &slot = mRelays[(hash + i) % MAX_RELAY_COUNT];
+        Relay *relay = slot.load(std::memory_order_acquire);
+        if (relay == nullptr) {
+            std::unique_ptr<Relay> created(new Relay(pName));
+            if (slot.compare_exchange_strong(relay, created.get(), std::memory_order_acq_rel)) {
+                return *created.release();
+            }
+            // Another thread took the slot, relay is its entry
+        }
+        if (relay->Name == pName) {
+            return *relay;
+        }
+    }
+    return mOtherRelay;
+}
+
+size_t MetricsRegistry::getErrorCodeSlot(int pErrorCode) {
+    if (pErrorCode < 0 && pErrorCode >= LOWEST_CLIENT_ERROR_CODE) {
+        return static_cast<size_t>(-pErrorCode);
+    }
+    if (pErrorCode >= LOWEST_REPLY_ERROR_CODE && pErrorCode <= HIGHEST_REPLY_ERROR_CODE) {
+        return static_cast<size_t>(-LOWEST_CLIENT_ERROR_CODE + 1 + pErrorCode - LOWEST_REPLY_ERROR_CODE);
+    }
+    return 0;
+}
+
+int MetricsRegistry::getSlotErrorCode(size_t pSlot) {
+    const auto slot = static_cast<int>(pSlot);
+    if (slot <= -LOWEST_CLIENT_ERROR_CODE) {
+        return -slot;
+    }
+    return slot - (-LOWEST_CLIENT_ERROR_CODE + 1) + LOWEST_REPLY_ERROR_CODE;
+}
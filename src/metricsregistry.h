@@ -0,0 +1,233 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include "sendreport.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define METRICSREGISTRY_API __declspec(dllexport)
+    #else
+        #define METRICSREGISTRY_API __declspec(dllimport)
+    #endif
+#else
+    #define METRICSREGISTRY_API
+#endif
+
+namespace jed_utils {
+/** @brief The SMTP commands whose reply latency is measured. */
+enum class SMTPCommand {
+    /** The wait for the greeting of the server */
+    Greeting,
+    EHLO,
+    STARTTLS,
+    AUTH,
+    MAIL,
+    RCPT,
+    DATA,
+    /** The end of the data, answered when the server accepts the message */
+    EndOfData,
+    RSET,
+    /** Any other line, such as the answers to the AUTH LOGIN challenges */
+    Other
+};
+
+/** @brief The LatencyHistogram class counts latencies in log-linear buckets
+ *  (four buckets per power of two of microseconds, like an HDR histogram
+ *  with two significant bits), without locks.
+ */
+class METRICSREGISTRY_API LatencyHistogram {
+ public:
+    /** The number of buckets: 8 one microsecond wide, then 4 per power of
+     *  two up to 2^36 microseconds (about 19 hours). */
+    static const size_t BUCKET_COUNT = 144;
+
+    /** Construct an empty histogram. */
+    LatencyHistogram();
+
+    /** LatencyHistogram copy constructor (deleted). */
+    LatencyHistogram(const LatencyHistogram &other) = delete;
+
+    /** LatencyHistogram copy assignment operator (deleted). */
+    LatencyHistogram& operator=(const LatencyHistogram &other) = delete;
+
+    /** Count a latency. */
+    void record(std::chrono::microseconds pLatency);
+
+    /** Return the number of latencies counted. */
+    std::uint64_t getCount() const;
+
+    /** Return the sum of the latencies counted. */
+    std::chrono::microseconds getSum() const;
+
+    /**
+     *  @brief  Return the latency under which a proportion of the latencies
+     *  are, rounded up to the upper bound of its bucket (at most 25% more).
+     *  @param pQuantile The proportion, from 0 to 1.
+     */
+    std::chrono::microseconds getQuantile(double pQuantile) const;
+
+    /**
+     *  @brief  Append the histogram in the Prometheus text format, in seconds,
+     *  with a bucket per power of two from 128 microseconds to 67 seconds.
+     *  @param pOutput The text to append to.
+     *  @param pName The name of the metric.
+     *  @param pLabels The labels of the samples without braces, can be empty.
+     */
+    void writePrometheus(std::string &pOutput, const char *pName, const std::string &pLabels) const;
+
+ private:
+    static size_t getBucketIndex(std::uint64_t pMicroseconds);
+    static std::uint64_t getBucketUpperBound(size_t pIndex);
+
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> mBuckets;
+    std::atomic<std::uint64_t> mCount;
+    std::atomic<std::uint64_t> mSum;
+};
+
+/** @brief The MetricsRegistry class holds the metrics of the clients that
+ *  share it (see SMTPClientBase::setMetricsRegistry): messages, recipients,
+ *  bytes, errors by code, TLS handshakes, open sessions, queue depth and the
+ *  latency of each command and of each relay.
+ *
+ *  All the updates are lock-free. The relays (server name and port) are kept
+ *  in a table of MAX_RELAY_COUNT entries that are never removed; the relays
+ *  beyond it are counted under the relay "other". exportPrometheus returns
+ *  the metrics in the Prometheus text format, for any HTTP server or file.
+ */
+class METRICSREGISTRY_API MetricsRegistry {
+ public:
+    /** The number of relays followed individually. */
+    static const size_t MAX_RELAY_COUNT = 64;
+
+    /** Construct an empty registry. */
+    MetricsRegistry();
+
+    /** Destructor of the MetricsRegistry. */
+    ~MetricsRegistry();
+
+    /** MetricsRegistry copy constructor (deleted). */
+    MetricsRegistry(const MetricsRegistry &other) = delete;
+
+    /** MetricsRegistry copy assignment operator (deleted). */
+    MetricsRegistry& operator=(const MetricsRegistry &other) = delete;
+
+    /**
+     *  @brief  Count a call of sendMail.
+     *  @param pServerName The name of the relay.
+     *  @param pPort The port of the relay.
+     *  @param pRecipientCount The number of recipients of the message.
+     *  @param pReport The report of the sending.
+     */
+    void recordSend(const char *pServerName, unsigned int pPort, size_t pRecipientCount, const SendReport &pReport);
+
+    /** Count the latency of the reply to a command. */
+    void recordCommand(SMTPCommand pCommand, std::chrono::microseconds pLatency);
+
+    /** Count a successful TLS handshake, resumed or full. */
+    void recordTLSHandshake(bool pResumed);
+
+    /** Count a connection opened. */
+    void addOpenSession();
+
+    /** Count a connection closed. */
+    void removeOpenSession();
+
+    /** Set the number of messages waiting to be sent (see SenderPool). */
+    void setQueueDepth(size_t pDepth);
+
+    /** Return the number of messages sent. */
+    std::uint64_t getSentCount() const;
+
+    /** Return the number of messages that failed. */
+    std::uint64_t getFailedCount() const;
+
+    /** Return the number of recipients of the messages sent. */
+    std::uint64_t getRecipientCount() const;
+
+    /** Return the bytes sent to the servers. */
+    std::uint64_t getBytesWritten() const;
+
+    /** Return the bytes received from the servers. */
+    std::uint64_t getBytesRead() const;
+
+    /**
+     *  @brief  Return the number of failures with an error code.
+     *  @param pErrorCode A code of smtpclienterrors.h, socketerrors.h or
+     *  sslerrors.h, or an SMTP reply code from 400 to 599.
+     */
+    std::uint64_t getErrorCount(int pErrorCode) const;
+
+    /** Return the number of TLS handshakes, resumed or full. */
+    std::uint64_t getTLSHandshakeCount(bool pResumed) const;
+
+    /** Return the number of connections open. */
+    std::int64_t getOpenSessionCount() const;
+
+    /** Return the last queue depth set. */
+    std::size_t getQueueDepth() const;
+
+    /** Return the latency of the replies to a command. */
+    const LatencyHistogram &getCommandLatency(SMTPCommand pCommand) const;
+
+    /**
+     *  @brief  Return the latency of the sendMail calls to a relay.
+     *  @param pRelay The relay as "name:port", or "other".
+     *  @return The histogram or null if no message was sent to the relay.
+     */
+    const LatencyHistogram *findRelayLatency(const char *pRelay) const;
+
+    /** Return the metrics in the Prometheus text exposition format. */
+    std::string exportPrometheus() const;
+
+    /** Return the name of a command in the metrics. */
+    static const char *getCommandName(SMTPCommand pCommand);
+
+    /** Return the command of a line sent to the server. */
+    static SMTPCommand getCommand(const char *pCommandLine);
+
+ private:
+    static const size_t COMMAND_COUNT = 10;
+    // The client codes -1 to -127, then the SMTP reply codes 400 to 599
+    static const size_t ERROR_CODE_SLOT_COUNT = 328;
+
+    struct Relay {
+        explicit Relay(std::string pName)
+            : Name(std::move(pName)),
+              SentCount(0),
+              FailedCount(0) {
+        }
+        const std::string Name;
+        std::atomic<std::uint64_t> SentCount;
+        std::atomic<std::uint64_t> FailedCount;
+        LatencyHistogram Latency;
+    };
+
+    Relay &getRelay(const std::string &pName);
+    static size_t getErrorCodeSlot(int pErrorCode);
+    static int getSlotErrorCode(size_t pSlot);
+
+    std::atomic<std::uint64_t> mSentCount;
+    std::atomic<std::uint64_t> mFailedCount;
+    std::atomic<std::uint64_t> mRecipientCount;
+    std::atomic<std::uint64_t> mBytesWritten;
+    std::atomic<std::uint64_t> mBytesRead;
+    std::atomic<std::uint64_t> mResumedHandshakeCount;
+    std::atomic<std::uint64_t> mFullHandshakeCount;
+    std::atomic<std::int64_t> mOpenSessionCount;
+    std::atomic<std::size_t> mQueueDepth;
+    std::array<std::atomic<std::uint64_t>, ERROR_CODE_SLOT_COUNT> mErrorCounts;
+    std::array<LatencyHistogram, COMMAND_COUNT> mCommandLatencies;
+    std::array<std::atomic<Relay *>, MAX_RELAY_COUNT> mRelays;
+    Relay mOtherRelay;
+};
+}  // namespace jed_utils
+
+#endif
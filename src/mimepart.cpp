@@ -0,0 +1,242 @@
+#include "mimepart.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include "base64.h"
+#include "quotedprintable.h"
+
+using namespace jed_utils;
+
+const char *const MimePart::DEFAULT_BOUNDARY = "sep";
+
+namespace {
+    // The length of "--" + boundary + CRLF, "CRLF--" + boundary + CRLF and
+    // "CRLF--" + boundary + "--", without the boundary
+    const size_t FIRST_DELIMITER_LENGTH = 4;
+    const size_t DELIMITER_LENGTH = 6;
+    const size_t CLOSE_DELIMITER_LENGTH = 6;
+
+    bool contains(const char *pText, size_t pLength, const std::string &pPattern) {
+        return std::search(pText, pText + pLength, pPattern.begin(), pPattern.end()) != pText + pLength;
+    }
+
+    // A boundary made of other characters is quoted in the Content-Type
+    bool isToken(const std::string &pValue) {
+        return std::all_of(pValue.begin(), pValue.end(), [](char c) {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                    || c == '-' || c == '_' || c == '.';
+                });
+    }
+
+    size_t encodedTextLength(const char *pText, size_t pLength, TransferEncoding pEncoding) {
+        switch (pEncoding) {
+            case TransferEncoding::QuotedPrintable:
+                return QuotedPrintable::encodedLength(pText, pLength);
+            case TransferEncoding::Base64:
+                return Base64::EncodedLength(pLength, Base64::MIME_LINE_LENGTH);
+            default:
+                // The bare line breaks are sent as CRLF (see DataStuffer)
+                return pLength + ContentClassifier::classify(pText, pLength).BareLineBreakCount;
+        }
+    }
+
+    void appendEncodedText(std::string &pOutput, const char *pText, size_t pLength, TransferEncoding pEncoding) {
+        switch (pEncoding) {
+            case TransferEncoding::QuotedPrintable:
+                QuotedPrintable::encode(pText, pLength, pOutput);
+                break;
+            case TransferEncoding::Base64:
+                pOutput += Base64::EncodeWithLineBreaks(reinterpret_cast<const unsigned char *>(pText), pLength);
+                break;
+            default:
+                pOutput.append(pText, pLength);
+                break;
+        }
+    }
+}  // namespace
+
+MimePart::MimePart(MimePartKind pKind, std::string pMimeType)
+    : mKind(pKind),
+      mMimeType(std::move(pMimeType)),
+      mText(nullptr),
+      mTextLength(0),
+      mEncoding(TransferEncoding::SevenBit),
+      mValidUTF8(true),
+      mAttachment(nullptr),
+      mSize(0) {
+}
+
+MimePart MimePart::createMultipart(const char *pSubtype) {
+    return MimePart(MimePartKind::Multipart, std::string("multipart/") + pSubtype);
+}
+
+MimePart MimePart::createText(const char *pMimeType, const char *pText, TransferEncoding pEncoding,
+        bool pValidUTF8) {
+    MimePart part(MimePartKind::Text, pMimeType);
+    part.mText = pText != nullptr ? pText : "";
+    part.mTextLength = strlen(part.mText);
+    part.mEncoding = pEncoding == TransferEncoding::Automatic ? TransferEncoding::Base64 : pEncoding;
+    part.mValidUTF8 = pValidUTF8;
+    // The text is followed by a line break
+    part.mSize = encodedTextLength(part.mText, part.mTextLength, part.mEncoding) + 2;
+    return part;
+}
+
+MimePart MimePart::createAttachment(const Attachment &pAttachment) {
+    MimePart part(MimePartKind::Attachment, pAttachment.getMimeType());
+    part.mAttachment = &pAttachment;
+    part.mEncoding = TransferEncoding::Base64;
+    part.mSize = pAttachment.getBase64EncodedSize();
+    return part;
+}
+
+MimePartKind MimePart::getKind() const {
+    return mKind;
+}
+
+const std::string &MimePart::getMimeType() const {
+    return mMimeType;
+}
+
+TransferEncoding MimePart::getTransferEncoding() const {
+    return mEncoding;
+}
+
+void MimePart::addPart(MimePart pPart) {
+    mParts.push_back(std::move(pPart));
+}
+
+const std::vector<MimePart> &MimePart::getParts() const {
+    return mParts;
+}
+
+const std::string &MimePart::getBoundary() const {
+    return mBoundary;
+}
+
+void MimePart::assignBoundaries() {
+    std::vector<const MimePart *> texts;
+    collectTexts(texts);
+    size_t index = 0;
+    assignBoundaries(texts, index);
+}
+
+void MimePart::collectTexts(std::vector<const MimePart *> &pTexts) const {
+    if (mKind == MimePartKind::Text) {
+        pTexts.push_back(this);
+    }
+    for (const auto &part : mParts) {
+        part.collectTexts(pTexts);
+    }
+}
+
+void MimePart::assignBoundaries(const std::vector<const MimePart *> &pTexts, size_t &pIndex) {
+    if (mKind != MimePartKind::Multipart) {
+        return;
+    }
+    // The nested boundaries start differently than the root one, so none is
+    // the prefix of another. The base64 content of the attachments never
+    // contains "--".
+    const std::string base { pIndex == 0
+        ? std::string(DEFAULT_BOUNDARY)
+        : "=_" + std::to_string(pIndex) + "_" + mMimeType.substr(mMimeType.find('/') + 1) };
+    pIndex++;
+    auto found_in_texts = [&pTexts](const std::string &pBoundary) {
+        const std::string delimiter { "--" + pBoundary };
+        return std::any_of(pTexts.begin(), pTexts.end(), [&delimiter](const MimePart *pText) {
+                return contains(pText->mText, pText->mTextLength, delimiter);
+                });
+    };
+    mBoundary = base;
+    for (size_t attempt = 1; found_in_texts(mBoundary); attempt++) {
+        mBoundary = base + "_" + std::to_string(attempt);
+    }
+
+    mSize = 0;
+    for (size_t index = 0; index < mParts.size(); index++) {
+        mParts[index].assignBoundaries(pTexts, pIndex);
+        mSize += (index == 0 ? FIRST_DELIMITER_LENGTH : DELIMITER_LENGTH) + mBoundary.length()
+            + mParts[index].renderHeaders().length() + mParts[index].getSize();
+    }
+    mSize += CLOSE_DELIMITER_LENGTH + mBoundary.length();
+}
+
+std::string MimePart::renderHeaders() const {
+    std::string headers { "Content-Type: " };
+    headers += mMimeType;
+    switch (mKind) {
+        case MimePartKind::Multipart:
+            headers += isToken(mBoundary) ? "; boundary=" + mBoundary : "; boundary=\"" + mBoundary + "\"";
+            headers += "\r\n";
+            break;
+        case MimePartKind::Text:
+            // A text that is not UTF-8 is not declared as such (RFC 1428)
+            headers += mValidUTF8 ? "; charset=UTF-8\r\n" : "; charset=unknown-8bit\r\n";
+            // 7bit is the default and is not declared
+            if (mEncoding != TransferEncoding::SevenBit) {
+                headers += "Content-Transfer-Encoding: ";
+                headers += ContentClassifier::getEncodingName(mEncoding);
+                headers += "\r\n";
+            }
+            break;
+        case MimePartKind::Attachment: {
+            const char *content_id = mAttachment->getContentId();
+            headers += "; name=\"";
+            headers += mAttachment->getName();
+            headers += content_id != nullptr ? "\"\r\nContent-Disposition: inline; filename=\""
+                : "\"\r\nContent-Disposition: attachment; filename=\"";
+            headers += mAttachment->getName();
+            headers += "\"\r\n";
+            if (content_id != nullptr) {
+                headers += "Content-ID: <";
+                headers += content_id;
+                headers += ">\r\n";
+            }
+            headers += "Content-Transfer-Encoding: base64\r\n";
+            break;
+        }
+    }
+    headers += "\r\n";
+    return headers;
+}
+
+size_t MimePart::getSize() const {
+    return mSize;
+}
+
+int MimePart::serialize(std::string &pOutput, const AttachmentWriter &pAttachmentWriter) const {
+    switch (mKind) {
+        case MimePartKind::Text:
+            appendEncodedText(pOutput, mText, mTextLength, mEncoding);
+            pOutput += "\r\n";
+            return 0;
+        case MimePartKind::Attachment: {
+            if (pAttachmentWriter) {
+                return pAttachmentWriter(pOutput, *mAttachment);
+            }
+            const char *encoded_file = mAttachment->getBase64EncodedFile();
+            if (encoded_file != nullptr) {
+                pOutput += encoded_file;
+                delete[] encoded_file;
+            }
+            return 0;
+        }
+        case MimePartKind::Multipart:
+            break;
+    }
+    for (size_t index = 0; index < mParts.size(); index++) {
+        pOutput += index == 0 ? "--" : "\r\n--";
+        pOutput += mBoundary;
+        pOutput += "\r\n";
+        pOutput += mParts[index].renderHeaders();
+        int part_return_code = mParts[index].serialize(pOutput, pAttachmentWriter);
+        if (part_return_code != 0) {
+            return part_return_code;
+        }
+    }
+    pOutput += "\r\n--";
+    pOutput += mBoundary;
+    pOutput += "--";
+    return 0;
+}
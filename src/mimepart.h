@@ -0,0 +1,138 @@
+#ifndef MIMEPART_H
+#define MIMEPART_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "attachment.h"
+#include "contentclassifier.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define MIMEPART_API __declspec(dllexport)
+    #else
+        #define MIMEPART_API __declspec(dllimport)
+    #endif
+#else
+    #define MIMEPART_API
+#endif
+
+namespace jed_utils {
+/** @brief What a MimePart holds. */
+enum class MimePartKind {
+    /** Other parts (multipart/mixed, alternative or related) */
+    Multipart,
+    /** A text, encoded when it is serialized */
+    Text,
+    /** The base64 content of an attachment */
+    Attachment
+};
+
+/** @brief The MimePart class is a node of the MIME tree of a message
+ *  (RFC 2046). The leaves are the texts and the attachments, the multiparts
+ *  group them.
+ *
+ *  The texts and attachments are referenced, not copied: they must outlive
+ *  the tree. Once the tree is complete, assignBoundaries chooses a boundary
+ *  for each multipart that appears in none of the texts and computes the
+ *  exact size of every part, so the tree is serialized in a single pass into
+ *  a buffer reserved beforehand.
+ */
+class MIMEPART_API MimePart {
+ public:
+    /** Appends the content of an attachment to the output, or sends it by
+     *  other means. Returns 0 or an error code that stops the serialization. */
+    using AttachmentWriter = std::function<int(std::string &pOutput, const Attachment &pAttachment)>;
+
+    /** The boundary of the root multipart when the texts do not contain it. */
+    static const char *const DEFAULT_BOUNDARY;
+
+    /**
+     *  @brief  Create an empty multipart.
+     *  @param pSubtype The subtype: "mixed", "alternative" or "related".
+     */
+    static MimePart createMultipart(const char *pSubtype);
+
+    /**
+     *  @brief  Create a text part, sent with charset=UTF-8, or with
+     *  charset=unknown-8bit (RFC 1428) when it is not valid UTF-8.
+     *  @param pMimeType The MIME type of the text ("text/plain").
+     *  @param pText The text.
+     *  @param pEncoding The transfer encoding of the text (not Automatic).
+     *  @param pValidUTF8 False if the text holds bytes that are not UTF-8
+     *  (see ContentClassification::InvalidUTF8).
+     */
+    static MimePart createText(const char *pMimeType, const char *pText, TransferEncoding pEncoding,
+            bool pValidUTF8 = true);
+
+    /**
+     *  @brief  Create an attachment part, base64 encoded. An attachment with
+     *  a Content-ID is declared inline, the others as attachments.
+     *  @param pAttachment The attachment.
+     */
+    static MimePart createAttachment(const Attachment &pAttachment);
+
+    /** Return what the part holds. */
+    MimePartKind getKind() const;
+
+    /** Return the MIME type of the part ("multipart/mixed", "text/html"...). */
+    const std::string &getMimeType() const;
+
+    /** Return the transfer encoding of a text or attachment part. */
+    TransferEncoding getTransferEncoding() const;
+
+    /**
+     *  @brief  Append a part to a multipart.
+     *  @param pPart The part to append.
+     */
+    void addPart(MimePart pPart);
+
+    /** Return the parts of a multipart. */
+    const std::vector<MimePart> &getParts() const;
+
+    /** Return the boundary of a multipart (see assignBoundaries). */
+    const std::string &getBoundary() const;
+
+    /**
+     *  @brief  Choose the boundaries of the multiparts of the tree and
+     *  compute their sizes. A boundary is unique in the tree and is not found
+     *  in the texts. Call it on the root once the tree is complete.
+     */
+    void assignBoundaries();
+
+    /** Return the header fields of the part followed by the empty line. */
+    std::string renderHeaders() const;
+
+    /** Return the exact length of the serialized content of the part, its
+     *  headers excluded. The bare line breaks of the texts count as CRLF. */
+    size_t getSize() const;
+
+    /**
+     *  @brief  Append the content of the part, its headers excluded.
+     *  @param pOutput The buffer that receives the content.
+     *  @param pAttachmentWriter Writes the content of the attachments. If
+     *  empty, their base64 content is appended.
+     *  @return 0 or the error code returned by pAttachmentWriter.
+     */
+    int serialize(std::string &pOutput, const AttachmentWriter &pAttachmentWriter = nullptr) const;
+
+ private:
+    MimePart(MimePartKind pKind, std::string pMimeType);
+    void collectTexts(std::vector<const MimePart *> &pTexts) const;
+    void assignBoundaries(const std::vector<const MimePart *> &pTexts, size_t &pIndex);
+
+    MimePartKind mKind;
+    std::string mMimeType;
+    const char *mText;
+    size_t mTextLength;
+    TransferEncoding mEncoding;
+    bool mValidUTF8;
+    const Attachment *mAttachment;
+    std::string mBoundary;
+    std::vector<MimePart> mParts;
+    size_t mSize;
+};
+}  // namespace jed_utils
+
+#endif
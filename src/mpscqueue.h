@@ -0,0 +1,194 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jed_utils {
+/** @brief The MPSCQueue class is a bounded, lock-free multi-producer ring
+ *  used to submit work (messages or rendered buffers) to a sender worker.
+ *
+ *  Each slot carries a sequence number that tells producers and the consumer
+ *  whether it is free or filled, so enqueue and dequeue only need one atomic
+ *  compare-and-swap on their own position counter. Producers are never
+ *  blocked by a lock: when the ring is full, tryEnqueue() fails immediately
+ *  and enqueue() backs off until the deadline.
+ *
+ *  The queue is meant to be drained by one consumer (the owning worker), but
+ *  dequeue is also safe from other threads so idle workers can steal items.
+ *  T must be default constructible and move assignable.
+ */
+template<typename T>
+class MPSCQueue {
+ public:
+    /**
+     *  @brief  Construct a new MPSCQueue.
+     *  @param pCapacity The maximum number of items. It is rounded up to the
+     *  next power of two (at least 2, the sequence numbers of a single slot
+     *  could not tell a free slot from a filled one).
+     */
+    explicit MPSCQueue(size_t pCapacity)
+        : mEnqueuePosition(0),
+          mDequeuePosition(0) {
+        if (pCapacity == 0) {
+            throw std::invalid_argument("The capacity must be greater than zero");
+        }
+        size_t capacity = 2;
+        while (capacity < pCapacity) {
+            capacity <<= 1;
+        }
+        mMask = capacity - 1;
+        mCells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; i++) {
+            mCells[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /** MPSCQueue copy constructor (deleted). */
+    MPSCQueue(const MPSCQueue &other) = delete;
+
+    /** MPSCQueue copy assignment operator (deleted). */
+    MPSCQueue& operator=(const MPSCQueue &other) = delete;
+
+    /** Return the maximum number of items of the queue. */
+    size_t capacity() const {
+        return mMask + 1;
+    }
+
+    /** Return the approximate number of items in the queue. */
+    size_t size() const {
+        const size_t enqueue_position = mEnqueuePosition.load(std::memory_order_relaxed);
+        const size_t dequeue_position = mDequeuePosition.load(std::memory_order_relaxed);
+        return enqueue_position > dequeue_position ? enqueue_position - dequeue_position : 0;
+    }
+
+    /**
+     *  @brief  Add an item without waiting.
+     *  @return False if the queue is full (the item is left untouched).
+     */
+    bool tryEnqueue(T &&pItem) {
+        return push(pItem);
+    }
+
+    /**
+     *  @brief  Add a copy of an item without waiting.
+     *  @return False if the queue is full.
+     */
+    bool tryEnqueue(const T &pItem) {
+        T item { pItem };
+        return push(item);
+    }
+
+    /**
+     *  @brief  Add an item, waiting for free space until the deadline.
+     *  @return False if the queue was still full at the deadline (the item is
+     *  left untouched).
+     */
+    bool enqueue(T &&pItem, std::chrono::steady_clock::time_point pDeadline) {
+        // Spin briefly, then yield, then sleep with an exponential backoff
+        std::chrono::microseconds sleep_duration(50);
+        const std::chrono::microseconds MAX_SLEEP_DURATION(1000);
+        for (unsigned int attempt = 0; !push(pItem); attempt++) {
+            if (std::chrono::steady_clock::now() >= pDeadline) {
+                return false;
+            }
+            if (attempt < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(sleep_duration);
+                if (sleep_duration < MAX_SLEEP_DURATION) {
+                    sleep_duration *= 2;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     *  @brief  Remove the oldest item.
+     *  @return False if the queue is empty.
+     */
+    bool tryDequeue(T &pItem) {
+        Cell *cell = nullptr;
+        size_t position = mDequeuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &mCells[position & mMask];
+            const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0) {
+                if (mDequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = mDequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        pItem = std::move(cell->Item);
+        cell->Item = T();
+        cell->Sequence.store(position + mMask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     *  @brief  Remove up to pMaxCount items and append them to pItems.
+     *  @return The number of items removed.
+     */
+    size_t dequeueBatch(std::vector<T> &pItems, size_t pMaxCount) {
+        size_t count = 0;
+        T item;
+        while (count < pMaxCount && tryDequeue(item)) {
+            pItems.push_back(std::move(item));
+            count++;
+        }
+        return count;
+    }
+
+ private:
+    struct Cell {
+        std::atomic<size_t> Sequence;
+        T Item;
+    };
+    static const size_t CACHE_LINE_LENGTH = 64;
+
+    bool push(T &pItem) {
+        Cell *cell = nullptr;
+        size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &mCells[position & mMask];
+            const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        cell->Item = std::move(pItem);
+        cell->Sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // The producer and consumer positions live on separate cache lines
+    char mPadding0[CACHE_LINE_LENGTH];
+    std::atomic<size_t> mEnqueuePosition;
+    char mPadding1[CACHE_LINE_LENGTH - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> mDequeuePosition;
+    char mPadding2[CACHE_LINE_LENGTH - sizeof(std::atomic<size_t>)];
+    std::unique_ptr<Cell[]> mCells;
+    size_t mMask;
+};
+}  // namespace jed_utils
+
+#endif
@@ -7,7 +7,6 @@
 #include "smtpserverstatuscodes.h"
 #include "socketerrors.h"
 #include "sslerrors.h"
-#include "stringutils.h"
 
 #ifdef _WIN32
     #include <WinSock2.h>
@@ -67,7 +66,9 @@ int OpportunisticSecureSMTPClient::establishConnectionWithServer() {
         return client_init_return_code;
     }
 
-    if (isStartTLSSupported(getLastServerResponse())) {
+    // The options were parsed from the EHLO response by sendServerIdentification
+    const ServerAuthOptions *options = getAuthenticationOptions();
+    if (options != nullptr && options->StartTLS) {
         addCommunicationLogItem("Info: STARTTLS is available by the server, the communication will be encrypted.");
         int tls_init_return_code = upgradeToSecureConnection();
         if (tls_init_return_code != STATUS_CODE_SERVICE_READY) {
@@ -95,6 +96,7 @@ int OpportunisticSecureSMTPClient::establishConnectionWithServer() {
 }
 
 int OpportunisticSecureSMTPClient::upgradeToSecureConnection() {
+    beginPhase(SendPhase::TLS);
     std::string start_tls_cmd { "STARTTLS\r\n" };
     addCommunicationLogItem(start_tls_cmd.c_str());
     return sendRawCommand(start_tls_cmd.c_str(),
@@ -104,14 +106,6 @@ int OpportunisticSecureSMTPClient::upgradeToSecureConnection() {
 
 
 bool OpportunisticSecureSMTPClient::isStartTLSSupported(const char *pServerResponse) {
-    if (pServerResponse == nullptr) {
-        return false;
-    }
-    std::string serverResponse { pServerResponse };
-    if (serverResponse.length() == 0 || StringUtils::trim(serverResponse).empty()) {
-        return false;
-    }
-
-    const std::string STARTTLS_LINE_PREFIX { "250-STARTTLS" };
-    return serverResponse.find(STARTTLS_LINE_PREFIX) != std::string::npos;
+    ServerAuthOptions options;
+    return parseEhloResponse(pServerResponse, &options) && options.StartTLS;
 }
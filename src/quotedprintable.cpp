@@ -0,0 +1,191 @@
+#include "quotedprintable.h"
+#include <algorithm>
+#include "simdutils.h"
+
+using namespace jed_utils;
+
+const size_t QuotedPrintable::MAX_LINE_LENGTH;
+
+namespace {
+    const char HEX_DIGITS[] = "0123456789ABCDEF";
+    const size_t BLOCK_LENGTH = 16;
+    // A soft line break needs a '=' at the end of the line
+    const size_t SOFT_LINE_LENGTH = QuotedPrintable::MAX_LINE_LENGTH - 1;
+
+    struct StringSink {
+        std::string &Output;
+        void append(const char *pData, size_t pLength) {
+            Output.append(pData, pLength);
+        }
+    };
+
+    struct LengthSink {
+        size_t Length;
+        void append(const char *, size_t pLength) {
+            Length += pLength;
+        }
+    };
+
+    inline bool isSafeByte(unsigned char pByte) {
+        return pByte >= 32 && pByte <= 126 && pByte != '=';
+    }
+
+    // Return true if the block is copied as is: printable ASCII or spaces,
+    // and not a space as last byte since it could end a line
+    inline bool isSafeBlock(const unsigned char *pBlock) {
+        if (pBlock[BLOCK_LENGTH - 1] == ' ') {
+            return false;
+        }
+#ifdef SMTPCLIENT_SSE2
+        // The signed comparisons also reject the bytes above 127
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pBlock));
+        const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(31)),
+                _mm_cmplt_epi8(block, _mm_set1_epi8(127)));
+        const __m128i safe = _mm_andnot_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('=')), printable);
+        return _mm_movemask_epi8(safe) == 0xFFFF;
+#else
+        for (size_t i = 0; i < BLOCK_LENGTH; i++) {
+            if (!isSafeByte(pBlock[i])) {
+                return false;
+            }
+        }
+        return true;
+#endif
+    }
+
+    // Return the length of the line break at pOffset (CRLF or LF), or 0
+    inline size_t lineBreakLength(const unsigned char *pData, size_t pLength, size_t pOffset) {
+        if (pData[pOffset] == '\n') {
+            return 1;
+        }
+        if (pData[pOffset] == '\r' && pOffset + 1 < pLength && pData[pOffset + 1] == '\n') {
+            return 2;
+        }
+        return 0;
+    }
+
+    // Encode pData and return the number of bytes consumed. Unless pFinal is
+    // true, the last bytes whose encoding depends on what follows are left.
+    template <typename Sink>
+    size_t encodeTo(const unsigned char *pData, size_t pLength, bool pFinal, size_t &pColumn, Sink &pSink) {
+        size_t offset = 0;
+        while (offset < pLength) {
+            // A safe block is followed by a byte of the text, so none of its
+            // bytes but the last ends a line and they all fit before the
+            // soft line break
+            if (pColumn < SOFT_LINE_LENGTH && offset + BLOCK_LENGTH <= pLength && isSafeBlock(pData + offset)) {
+                const size_t run_length = std::min(BLOCK_LENGTH, SOFT_LINE_LENGTH - pColumn);
+                pSink.append(reinterpret_cast<const char *>(pData + offset), run_length);
+                pColumn += run_length;
+                offset += run_length;
+                continue;
+            }
+            if (!pFinal && (offset + 1 == pLength || (offset + 2 == pLength && pData[offset + 1] == '\r'))) {
+                break;
+            }
+            const size_t line_break = lineBreakLength(pData, pLength, offset);
+            if (line_break != 0) {
+                pSink.append("\r\n", 2);
+                pColumn = 0;
+                offset += line_break;
+                continue;
+            }
+            const unsigned char byte = pData[offset];
+            const bool line_end = offset + 1 == pLength || lineBreakLength(pData, pLength, offset + 1) != 0;
+            // The spaces and tabs at the end of a line would be removed in transit
+            const bool literal = (isSafeByte(byte) && byte != ' ')
+                || ((byte == ' ' || byte == '\t') && !line_end);
+            const size_t width = literal ? 1 : 3;
+            // Keep room for the '=' of a soft line break, unless the line ends here
+            const size_t limit = line_end ? QuotedPrintable::MAX_LINE_LENGTH : SOFT_LINE_LENGTH;
+            if (pColumn + width > limit) {
+                pSink.append("=\r\n", 3);
+                pColumn = 0;
+            }
+            if (literal) {
+                pSink.append(reinterpret_cast<const char *>(pData + offset), 1);
+            } else {
+                const char escaped[3] = { '=', HEX_DIGITS[byte >> 4], HEX_DIGITS[byte & 0x0F] };
+                pSink.append(escaped, 3);
+            }
+            pColumn += width;
+            offset++;
+        }
+        return offset;
+    }
+}  // namespace
+
+std::string QuotedPrintable::encode(const char *pData, size_t pLength) {
+    std::string encoded;
+    if (pData == nullptr) {
+        return encoded;
+    }
+    encoded.reserve(encodedLength(pData, pLength));
+    encode(pData, pLength, encoded);
+    return encoded;
+}
+
+void QuotedPrintable::encode(const char *pData, size_t pLength, std::string &pOutput) {
+    if (pData == nullptr) {
+        return;
+    }
+    size_t column = 0;
+    StringSink sink { pOutput };
+    encodeTo(reinterpret_cast<const unsigned char *>(pData), pLength, true, column, sink);
+}
+
+size_t QuotedPrintable::encodedLength(const char *pData, size_t pLength) {
+    if (pData == nullptr) {
+        return 0;
+    }
+    size_t column = 0;
+    LengthSink sink { 0 };
+    encodeTo(reinterpret_cast<const unsigned char *>(pData), pLength, true, column, sink);
+    return sink.Length;
+}
+
+QuotedPrintableEncoder::QuotedPrintableEncoder()
+    : mColumn(0),
+      mPending { 0, 0 },
+      mPendingLength(0) {
+}
+
+void QuotedPrintableEncoder::encode(const char *pData, size_t pLength, std::string &pOutput) {
+    if (pData == nullptr || pLength == 0) {
+        return;
+    }
+    StringSink sink { pOutput };
+    const auto *data = reinterpret_cast<const unsigned char *>(pData);
+    size_t offset = 0;
+    if (mPendingLength > 0) {
+        // Join the kept bytes with the start of the chunk, which is enough
+        // to decide their encoding. At most two bytes are ever kept.
+        const size_t pending_length = std::min(mPendingLength, sizeof(mPending));
+        unsigned char joined[sizeof(mPending) + 2];
+        const size_t joined_length = pending_length + std::min(pLength, sizeof(joined) - pending_length);
+        std::copy(mPending, mPending + pending_length, joined);
+        std::copy(data, data + (joined_length - pending_length), joined + pending_length);
+        const size_t consumed = encodeTo(joined, joined_length, false, mColumn, sink);
+        if (consumed < pending_length) {
+            // Only possible when the chunk is too short to decide
+            mPendingLength = 0;
+            for (size_t i = consumed; i < joined_length; i++) {
+                mPending[mPendingLength++] = static_cast<char>(joined[i]);
+            }
+            return;
+        }
+        offset = consumed - pending_length;
+        mPendingLength = 0;
+    }
+    offset += encodeTo(data + offset, pLength - offset, false, mColumn, sink);
+    for (; offset < pLength; offset++) {
+        mPending[mPendingLength++] = pData[offset];
+    }
+}
+
+void QuotedPrintableEncoder::finish(std::string &pOutput) {
+    StringSink sink { pOutput };
+    encodeTo(reinterpret_cast<const unsigned char *>(mPending), mPendingLength, true, mColumn, sink);
+    mPendingLength = 0;
+    mColumn = 0;
+}
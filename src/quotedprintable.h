@@ -0,0 +1,84 @@
+#ifndef QUOTEDPRINTABLE_H
+#define QUOTEDPRINTABLE_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define QUOTEDPRINTABLE_API __declspec(dllexport)
+    #else
+        #define QUOTEDPRINTABLE_API __declspec(dllimport)
+    #endif
+#else
+    #define QUOTEDPRINTABLE_API
+#endif
+
+namespace jed_utils {
+/** @brief The QuotedPrintable class encodes text in the quoted-printable
+ *  transfer encoding (RFC 2045). The line breaks of the text (CRLF or LF)
+ *  become CRLF and the longer lines are split with soft line breaks.
+ *
+ *  The runs of printable ASCII are copied 16 bytes at a time when SSE2 is
+ *  available, so a mostly ASCII text is encoded at close to copy speed.
+ */
+class QUOTEDPRINTABLE_API QuotedPrintable {
+ public:
+    /** The maximum length of an encoded line, CRLF excluded. */
+    static const size_t MAX_LINE_LENGTH = 76;
+
+    /**
+     *  @brief  Return the encoded text.
+     *  @param pData The text to encode.
+     *  @param pLength The length of the text.
+     */
+    static std::string encode(const char *pData, size_t pLength);
+
+    /**
+     *  @brief  Append the encoded text to a buffer.
+     *  @param pData The text to encode.
+     *  @param pLength The length of the text.
+     *  @param pOutput The buffer that receives the encoded text.
+     */
+    static void encode(const char *pData, size_t pLength, std::string &pOutput);
+
+    /**
+     *  @brief  Return the length of the encoded text, without encoding it.
+     *  @param pData The text to encode.
+     *  @param pLength The length of the text.
+     */
+    static size_t encodedLength(const char *pData, size_t pLength);
+};
+
+/** @brief The QuotedPrintableEncoder class encodes a text received in
+ *  several chunks. The output is the same as QuotedPrintable::encode on the
+ *  whole text.
+ */
+class QUOTEDPRINTABLE_API QuotedPrintableEncoder {
+ public:
+    QuotedPrintableEncoder();
+
+    /**
+     *  @brief  Encode the next chunk of the text. Up to 2 bytes whose
+     *  encoding depends on what follows are kept for the next call.
+     *  @param pData The chunk.
+     *  @param pLength The length of the chunk.
+     *  @param pOutput The buffer that receives the encoded text.
+     */
+    void encode(const char *pData, size_t pLength, std::string &pOutput);
+
+    /**
+     *  @brief  Encode the bytes kept from the last chunk and reset the
+     *  encoder for a new text.
+     *  @param pOutput The buffer that receives the encoded text.
+     */
+    void finish(std::string &pOutput);
+
+ private:
+    size_t mColumn;
+    char mPending[2];
+    size_t mPendingLength;
+};
+}  // namespace jed_utils
+
+#endif
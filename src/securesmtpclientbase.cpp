@@ -1,8 +1,12 @@
 #include "securesmtpclientbase.h"
 #include <openssl/err.h>
+#include <cerrno>
+#include <chrono>
 #include <string>
 #include <utility>
 #include "smtpclienterrors.h"
+#include "smtpserverstatuscodes.h"
+#include "smtptrace.h"
 #include "socketerrors.h"
 #include "sslerrors.h"
 
@@ -13,22 +17,49 @@
     typedef SSIZE_T ssize_t;
     #include <windows.h>
     constexpr auto sleep = Sleep;
+    constexpr auto poll = WSAPoll;
 #else
     #include <fcntl.h>
     #include <netdb.h>
     #include <netinet/in.h>
     #include <openssl/bio.h> /* BasicInput/Output streams */
+    #include <poll.h>
+    #include <sys/stat.h>
     #include <unistd.h>
 #endif
 
+#if defined(__linux__) && OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(OPENSSL_NO_KTLS)
+    #define SMTPCLIENT_KTLS_SUPPORTED
+#endif
+
 using namespace std::literals::string_literals;
 using namespace jed_utils;
 
+namespace {
+    bool setSocketBlocking(int pSocket, bool pBlocking) {
+#ifdef _WIN32
+        u_long mode = pBlocking ? 0 : 1;
+        return ioctlsocket(pSocket, FIONBIO, &mode) == 0;
+#else
+        int flags = fcntl(pSocket, F_GETFL, 0);
+        if (flags < 0) {
+            return false;
+        }
+        flags = pBlocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+        return fcntl(pSocket, F_SETFL, flags) == 0;
+#endif
+    }
+}  // namespace
+
 SecureSMTPClientBase::SecureSMTPClientBase(const char *pServerName, unsigned int pPort)
     : SMTPClientBase(pServerName, pPort),
     mBIO(nullptr),
     mCTX(nullptr),
-    mSSL(nullptr) {
+    mSSL(nullptr),
+    mTLSContext(nullptr),
+    mHandshakeTimeout(DEFAULT_HANDSHAKE_TIMEOUT_MS),
+    mLastHandshakeDuration(0),
+    mKernelTLS(false) {
 }
 
 SecureSMTPClientBase::~SecureSMTPClientBase() {
@@ -40,7 +71,11 @@ SecureSMTPClientBase::SecureSMTPClientBase(const SecureSMTPClientBase& other)
     : SMTPClientBase(other),
     mBIO(nullptr),
     mCTX(nullptr),
-    mSSL(nullptr) {
+    mSSL(nullptr),
+    mTLSContext(other.mTLSContext),
+    mHandshakeTimeout(other.mHandshakeTimeout),
+    mLastHandshakeDuration(other.mLastHandshakeDuration),
+    mKernelTLS(other.mKernelTLS) {
 }
 
 // Assignment operator
@@ -50,6 +85,10 @@ SecureSMTPClientBase& SecureSMTPClientBase::operator=(const SecureSMTPClientBase
         mBIO = nullptr;
         mCTX = nullptr;
         mSSL = nullptr;
+        mTLSContext = other.mTLSContext;
+        mHandshakeTimeout = other.mHandshakeTimeout;
+        mLastHandshakeDuration = other.mLastHandshakeDuration;
+        mKernelTLS = other.mKernelTLS;
     }
     return *this;
 }
@@ -59,7 +98,11 @@ SecureSMTPClientBase::SecureSMTPClientBase(SecureSMTPClientBase&& other) noexcep
 : SMTPClientBase(std::move(other)),
     mBIO(other.mBIO),
     mCTX(other.mCTX),
-    mSSL(other.mSSL) {
+    mSSL(other.mSSL),
+    mTLSContext(std::move(other.mTLSContext)),
+    mHandshakeTimeout(other.mHandshakeTimeout),
+    mLastHandshakeDuration(other.mLastHandshakeDuration),
+    mKernelTLS(other.mKernelTLS) {
     // Release the data pointer from the source object so that the destructor
     // does not free the memory multiple times.
     other.mBIO = nullptr;
@@ -74,6 +117,10 @@ SecureSMTPClientBase& SecureSMTPClientBase::operator=(SecureSMTPClientBase&& oth
         mBIO = other.mBIO;
         mCTX = other.mCTX;
         mSSL = other.mSSL;
+        mTLSContext = std::move(other.mTLSContext);
+        mHandshakeTimeout = other.mHandshakeTimeout;
+        mLastHandshakeDuration = other.mLastHandshakeDuration;
+        mKernelTLS = other.mKernelTLS;
         // Release the data pointer from the source object so that
         // the destructor does not free the memory multiple times.
         other.mBIO = nullptr;
@@ -120,88 +167,107 @@ BIO* SecureSMTPClientBase::getBIO() const {
     return mBIO;
 }
 
-void SecureSMTPClientBase::initializeSSLContext() {
-    SSL_library_init();
+std::shared_ptr<TLSContext> SecureSMTPClientBase::getTLSContext() const {
+    return mTLSContext;
+}
 
-    OpenSSL_add_all_algorithms();
-    SSL_load_error_strings();
-    const SSL_METHOD *method = TLS_client_method();
-    mCTX = SSL_CTX_new(method);
+void SecureSMTPClientBase::setTLSContext(std::shared_ptr<TLSContext> pTLSContext) {
+    mTLSContext = std::move(pTLSContext);
+}
 
-    if (mCTX == nullptr) {
+unsigned int SecureSMTPClientBase::getHandshakeTimeout() const {
+    return mHandshakeTimeout;
+}
+
+void SecureSMTPClientBase::setHandshakeTimeout(unsigned int pTimeOutInMilliseconds) {
+    mHandshakeTimeout = pTimeOutInMilliseconds;
+}
+
+std::chrono::microseconds SecureSMTPClientBase::getLastHandshakeDuration() const {
+    return mLastHandshakeDuration;
+}
+
+bool SecureSMTPClientBase::getKernelTLS() const {
+    return mKernelTLS;
+}
+
+void SecureSMTPClientBase::setKernelTLS(bool pValue) {
+    mKernelTLS = pValue;
+}
+
+bool SecureSMTPClientBase::isKernelTLSActive() const {
+#ifdef SMTPCLIENT_KTLS_SUPPORTED
+    return mSSL != nullptr && BIO_get_ktls_send(SSL_get_wbio(mSSL));
+#else
+    return false;
+#endif
+}
+
+void SecureSMTPClientBase::initializeSSLContext() {
+    // The context and its trusted certificates are loaded once and shared,
+    // the connection only takes a reference that cleanup() releases.
+    std::shared_ptr<TLSContext> tls_context { mTLSContext ? mTLSContext : TLSContext::getDefault() };
+    if (!tls_context) {
         setLastSocketErrNo(static_cast<int>(ERR_get_error()));
+        return;
     }
+    mCTX = tls_context->getSSLContext();
+    SSL_CTX_up_ref(mCTX);
 }
 
 int SecureSMTPClientBase::startTLSNegotiation() {
+    beginPhase(SendPhase::TLS);
     addCommunicationLogItem("<Start TLS negotiation>");
     initializeSSLContext();
     if (mCTX == nullptr) {
         return SSL_CLIENT_STARTTLS_INITSSLCTX_ERROR;
     }
 
-    mBIO = BIO_new_ssl_connect(mCTX);
+    mSSL = SSL_new(mCTX);
+    if (mSSL == nullptr) {
+        return SSL_CLIENT_STARTTLS_BIONEWSSLCONNECT_ERROR;
+    }
+    /* The BIO owns the session from now on */
+    mBIO = BIO_new(BIO_f_ssl());
     if (mBIO == nullptr) {
+        SSL_free(mSSL);
+        mSSL = nullptr;
         return SSL_CLIENT_STARTTLS_BIONEWSSLCONNECT_ERROR;
     }
-
-    /* Link bio channel, SSL session, and server endpoint */
-    const int SERVERNAMEANDPORT_LENGTH = 1024;
-    char name[SERVERNAMEANDPORT_LENGTH];
-    sprintf(name, "%s:%u", getServerName(), getServerPort());
-    BIO_get_ssl(mBIO, &mSSL); /* session */
+    BIO_set_ssl(mBIO, mSSL, BIO_CLOSE);
     SSL_set_fd(mSSL, getSocketFileDescriptor());
     SSL_set_mode(mSSL, SSL_MODE_AUTO_RETRY); /* robustness */
-    BIO_set_conn_hostname(mBIO, name); /* prepare to connect */
-
-#ifdef _WIN32
-    /* On Windows, we need to import all the ROOT certificates to
-       the OpenSSL Store */
-    PCCERT_CONTEXT pContext = nullptr;
-    X509_STORE *store = SSL_CTX_get_cert_store(mCTX);
-    HCERTSTORE hStore = CertOpenSystemStore(NULL, "ROOT");
-
-    if (!hStore) {
-        setLastSocketErrNo(static_cast<int>(GetLastError()));
-        return SSL_CLIENT_STARTTLS_WIN_CERTOPENSYSTEMSTORE_ERROR;
-    }
-
-    pContext = CertEnumCertificatesInStore(hStore, pContext);
-    while (pContext) {
-        X509 *x509 = nullptr;
-        x509 = d2i_X509(nullptr, (const unsigned char **)&pContext->pbCertEncoded, pContext->cbCertEncoded);
-        if (x509) {
-            X509_STORE_add_cert(store, x509);
-            X509_free(x509);
-        }
-        pContext = CertEnumCertificatesInStore(hStore, pContext);
-    }
-#else
-    if (SSL_CTX_set_default_verify_paths(mCTX) == 0) {
-        return SSL_CLIENT_STARTTLS_CTX_SET_DEFAULT_VERIFY_PATHS_ERROR;
+#ifdef SMTPCLIENT_KTLS_SUPPORTED
+    if (mKernelTLS) {
+        /* The keys are handed to the kernel at the end of the handshake
+           if the kernel and the negotiated cipher support it */
+        SSL_set_options(mSSL, SSL_OP_ENABLE_KTLS);
     }
 #endif
-    long verify_flag = SSL_get_verify_result(mSSL);
-    if (verify_flag != X509_V_OK) {
-        fprintf(stderr,
-                "##### Certificate verification error (%i) but continuing...\n",
-                static_cast<int>(verify_flag));
-    }
-
-    /* Try to connect */
-    if (BIO_do_connect(mBIO) <= 0) {
-        cleanup();
-        setLastSocketErrNo(static_cast<int>(ERR_get_error()));
-        return SSL_CLIENT_STARTTLS_BIO_CONNECT_ERROR;
+    TLSContext *tls_context = TLSContext::fromSSLContext(mCTX);
+    if (tls_context != nullptr) {
+        /* Offer the session of the previous connection to this server */
+        tls_context->prepareConnection(mSSL, getServerName(), getServerPort());
     }
 
     /* Try to do the handshake */
     addCommunicationLogItem("<Negotiate a TLS session>", "c & s");
-    if (BIO_do_handshake(mBIO) <= 0) {
+    SMTPCLIENT_PROBE1(tls__handshake__start, getSessionId());
+    int handshake_ret_code = doTLSHandshake();
+    if (handshake_ret_code != 0) {
+        SMTPCLIENT_PROBE3(tls__handshake__done, getSessionId(), handshake_ret_code, 0);
         cleanup();
-        setLastSocketErrNo(static_cast<int>(ERR_get_error()));
-        return SSL_CLIENT_STARTTLS_BIO_HANDSHAKE_ERROR;
+        return handshake_ret_code;
+    }
+    if (tls_context != nullptr) {
+        tls_context->recordHandshake(mSSL);
+    }
+    const bool is_resumed = SSL_session_reused(mSSL) == 1;
+    SMTPCLIENT_PROBE3(tls__handshake__done, getSessionId(), 0, is_resumed ? 1 : 0);
+    if (getSendReport() != nullptr) {
+        getSendReport()->TLSResumed = is_resumed;
     }
+    recordTLSHandshake(is_resumed);
 
     addCommunicationLogItem("<Check result of negotiation>", "c & s");
     /* Step 1: Verify a server certificate was presented
@@ -225,32 +291,113 @@ int SecureSMTPClientBase::startTLSNegotiation() {
     }
 
     addCommunicationLogItem("TLS session ready!");
-
-#ifdef _WIN32
-    CertFreeCertificateContext(pContext);
-    CertCloseStore(hStore, 0);
-#endif
     return 0;
 }
 
-int SecureSMTPClientBase::getServerSecureIdentification() {
-    const int EHLO_SUCCESS_CODE = 250;
+int SecureSMTPClientBase::doTLSHandshake() {
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto deadline = start_time + std::chrono::milliseconds(mHandshakeTimeout);
+    int socketFileDescriptor { getSocketFileDescriptor() };
+    int ret_code = 0;
+    /* The socket is non-blocking during the handshake so a stalled server
+       cannot hold the thread past the deadline */
+    setSocketBlocking(socketFileDescriptor, false);
+    for (;;) {
+        int connect_result = SSL_connect(mSSL);
+        if (connect_result == 1) {
+            break;
+        }
+        pollfd poll_descriptor {};
+        poll_descriptor.fd = socketFileDescriptor;
+        int ssl_error = SSL_get_error(mSSL, connect_result);
+        if (ssl_error == SSL_ERROR_WANT_READ) {
+            poll_descriptor.events = POLLIN;
+        } else if (ssl_error == SSL_ERROR_WANT_WRITE) {
+            poll_descriptor.events = POLLOUT;
+        } else {
+            setLastSocketErrNo(static_cast<int>(ERR_get_error()));
+            ret_code = SSL_CLIENT_STARTTLS_BIO_HANDSHAKE_ERROR;
+            break;
+        }
+        // Rounded up, so the poll does not return just before the deadline
+        const auto time_left = deadline - std::chrono::steady_clock::now();
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(time_left);
+        if (remaining < time_left) {
+            ++remaining;
+        }
+        if (remaining.count() <= 0) {
+            ret_code = SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT;
+            break;
+        }
+        int poll_result = poll(&poll_descriptor, 1, static_cast<int>(remaining.count()));
+        if (poll_result == 0) {
+            ret_code = SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT;
+            break;
+        }
+        if (poll_result < 0 && errno != EINTR) {
+            setLastSocketErrNo(errno);
+            ret_code = SSL_CLIENT_STARTTLS_BIO_HANDSHAKE_ERROR;
+            break;
+        }
+    }
+    setSocketBlocking(socketFileDescriptor, true);
+    mLastHandshakeDuration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+    return ret_code;
+}
+
+int SecureSMTPClientBase::checkSecureServerGreetings() {
+    beginPhase(SendPhase::Greeting);
+    const auto start_time = startCommandTimer();
+    char outbuf[SERVERRESPONSE_BUFFER_LENGTH];
+    unsigned int waitTime = 0;
+    ssize_t bytes_received = 0;
+    while ((bytes_received = trackRead(BIO_read(getBIO(), outbuf, SERVERRESPONSE_BUFFER_LENGTH))) <= 0 && waitTime < getCommandTimeout()) {
+        if (!BIO_should_retry(getBIO())) {
+            // The server closed the connection
+            return SOCKET_INIT_SESSION_CONNECT_ERROR;
+        }
+        sleep(1);
+        waitTime += 1;
+    }
+    if (waitTime < getCommandTimeout()) {
+        outbuf[bytes_received-1] = '\0';
+        recordCommandLatency(SMTPCommand::Greeting, start_time);
+        addCommunicationLogItem(outbuf, "s");
+        int status_code = extractReturnCode(outbuf);
+        SMTPCLIENT_PROBE3(reply__parsed, getSessionId(), status_code, outbuf);
+        if (status_code == STATUS_CODE_SERVICE_READY) {
+            addCommunicationLogItem("Connected!");
+        }
+        return status_code;
+    }
+    return SOCKET_INIT_SESSION_CONNECT_TIMEOUT;
+}
+
+int SecureSMTPClientBase::sendSecureServerIdentification() {
+    beginPhase(SendPhase::Hello);
     addCommunicationLogItem("Contacting the server again but via the secure channel...");
     std::string ehlo { "ehlo localhost\r\n"s };
     addCommunicationLogItem(ehlo.c_str());
-    int tls_command_return_code = sendCommandWithFeedback(ehlo.c_str(),
+    return sendCommandWithFeedback(ehlo.c_str(),
             SSL_CLIENT_INITSECURECLIENT_ERROR,
             SSL_CLIENT_INITSECURECLIENT_TIMEOUT);
+}
+
+int SecureSMTPClientBase::getServerSecureIdentification() {
+    const int EHLO_SUCCESS_CODE = 250;
+    int tls_command_return_code = sendSecureServerIdentification();
     if (tls_command_return_code != EHLO_SUCCESS_CODE) {
         return tls_command_return_code;
     }
-    // Inspect the returned values for authentication options
-    setAuthenticationOptions(SMTPClientBase::extractAuthenticationOptions(getLastServerResponse()));
+    // The options offered on the secure channel replace the previous ones
+    auto *options = new ServerAuthOptions();
+    parseEhloResponse(getLastServerResponse(), options);
+    setAuthenticationOptions(options);
     return EHLO_SUCCESS_CODE;
 }
 
 int SecureSMTPClientBase::sendCommand(const char *pCommand, int pErrorCode) {
-    if (BIO_puts(mBIO, pCommand) < 0) {
+    if (trackWrite(BIO_puts(mBIO, pCommand)) < 0) {
         setLastSocketErrNo(static_cast<int>(ERR_get_error()));
         cleanup();
         return pErrorCode;
@@ -258,26 +405,73 @@ int SecureSMTPClientBase::sendCommand(const char *pCommand, int pErrorCode) {
     return 0;
 }
 
+int SecureSMTPClientBase::sendFile(const char *pFilename, int pErrorCode) {
+    if (getKeepUsingBaseSendCommands()) {
+        return SMTPClientBase::sendFile(pFilename, pErrorCode);
+    }
+#ifdef SMTPCLIENT_KTLS_SUPPORTED
+    if (isKernelTLSActive()) {
+        int file_descriptor = open(pFilename, O_RDONLY | O_CLOEXEC);
+        if (file_descriptor < 0) {
+            setLastSocketErrNo(errno);
+            return CLIENT_SENDMAIL_ENCODED_FILE_ERROR;
+        }
+        struct stat file_status {};
+        if (fstat(file_descriptor, &file_status) != 0) {
+            setLastSocketErrNo(errno);
+            close(file_descriptor);
+            return CLIENT_SENDMAIL_ENCODED_FILE_ERROR;
+        }
+        off_t offset = 0;
+        while (offset < file_status.st_size) {
+            ossl_ssize_t bytes_sent = trackWrite(SSL_sendfile(mSSL, file_descriptor, offset,
+                    static_cast<size_t>(file_status.st_size - offset), 0));
+            if (bytes_sent <= 0) {
+                setLastSocketErrNo(static_cast<int>(ERR_get_error()));
+                close(file_descriptor);
+                return pErrorCode;
+            }
+            SMTPCLIENT_PROBE2(data__chunk, getSessionId(), bytes_sent);
+            offset += bytes_sent;
+        }
+        close(file_descriptor);
+        return 0;
+    }
+#endif
+    /* The file goes through the TLS record layer of OpenSSL */
+    return sendFileContent(pFilename, pErrorCode);
+}
+
 int SecureSMTPClientBase::sendCommandWithFeedback(const char *pCommand, int pErrorCode, int pTimeoutCode) {
     unsigned int waitTime {0};
     int bytes_received {0};
     char outbuf[SERVERRESPONSE_BUFFER_LENGTH];
+    const auto start_time = startCommandTimer();
+    SMTPCLIENT_PROBE2(command__sent, getSessionId(), pCommand);
 
-    if (BIO_puts(mBIO, pCommand) < 0) {
+    if (trackWrite(BIO_puts(mBIO, pCommand)) < 0) {
         setLastSocketErrNo(static_cast<int>(ERR_get_error()));
         cleanup();
         return pErrorCode;
     }
 
-    while ((bytes_received = BIO_read(mBIO, outbuf, SERVERRESPONSE_BUFFER_LENGTH)) <= 0 && waitTime < getCommandTimeout()) {
+    while ((bytes_received = trackRead(BIO_read(mBIO, outbuf, SERVERRESPONSE_BUFFER_LENGTH))) <= 0 && waitTime < getCommandTimeout()) {
+        if (!BIO_should_retry(mBIO)) {
+            // The server closed the connection, waiting cannot help
+            cleanup();
+            return pErrorCode;
+        }
         sleep(1);
         waitTime += 1;
     }
     if (waitTime < getCommandTimeout()) {
         outbuf[bytes_received-1] = '\0';
+        recordCommandLatency(MetricsRegistry::getCommand(pCommand), start_time);
         setLastServerResponse(outbuf);
         addCommunicationLogItem(outbuf, "s");
-        return extractReturnCode(outbuf);
+        const int reply_code = extractReturnCode(outbuf);
+        SMTPCLIENT_PROBE3(reply__parsed, getSessionId(), reply_code, outbuf);
+        return reply_code;
     }
 
     cleanup();
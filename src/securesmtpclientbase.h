@@ -2,7 +2,10 @@
 #define SECURESMTPCLIENTBASE_H
 
 #include <openssl/ssl.h>
+#include <chrono>
+#include <memory>
 #include "smtpclientbase.h"
+#include "tlscontext.h"
 
 #ifdef _WIN32
     #ifdef SMTPCLIENT_EXPORTS
@@ -44,23 +47,75 @@ class SECURESMTPCLIENTBASE_API SecureSMTPClientBase : public SMTPClientBase {
     /** SecureSMTPClientBase move assignment operator. */
     SecureSMTPClientBase& operator=(SecureSMTPClientBase&& other) noexcept;
 
+    /** Return the TLS context used by the client. Null means the default
+     *  context of the process (see TLSContext::getDefault). */
+    std::shared_ptr<TLSContext> getTLSContext() const;
+
+    /**
+     *  @brief  Set the TLS context used by the next connections, for example
+     *  to trust a custom set of certificates. The context can be shared by
+     *  several clients.
+     *  @param pTLSContext The TLS context. Null to use the default context of
+     *  the process.
+     */
+    void setTLSContext(std::shared_ptr<TLSContext> pTLSContext);
+
+    /** Return the TLS handshake timeout in milliseconds. */
+    unsigned int getHandshakeTimeout() const;
+
+    /**
+     *  @brief  Set the maximum duration of the TLS handshake.
+     *  @param pTimeOutInMilliseconds The timeout in milliseconds.
+     *  Default: 10000 milliseconds
+     */
+    void setHandshakeTimeout(unsigned int pTimeOutInMilliseconds);
+
+    /** Return the duration of the last TLS handshake (successful or not). */
+    std::chrono::microseconds getLastHandshakeDuration() const;
+
+    /** Return true if the kernel TLS offload is requested. */
+    bool getKernelTLS() const;
+
+    /**
+     *  @brief  Request the kernel TLS offload (Linux with OpenSSL 3) for the
+     *  next connections. The pre-encoded attachment files (see
+     *  Attachment::setEncodedFilename) are then sent with SSL_sendfile,
+     *  without copying them in user space. When the kernel or OpenSSL do not
+     *  support it, the connection silently uses the usual TLS record layer.
+     *  @param pValue True to request the offload, false for the default
+     */
+    void setKernelTLS(bool pValue);
+
+    /** Return true if the kernel encrypts the data sent on the current
+     *  connection. */
+    bool isKernelTLSActive() const;
+
  protected:
     // Methods
     void cleanup() override;
     BIO *getBIO() const;
     // Methods used to establish the connection with server
+    int checkSecureServerGreetings();
+    int sendSecureServerIdentification();
     int getServerSecureIdentification();
     int startTLSNegotiation();
     void initializeSSLContext();
+    int doTLSHandshake();
     // Methods to send commands to the server
     int sendCommand(const char *pCommand, int pErrorCode) override;
     int sendCommandWithFeedback(const char *pCommand, int pErrorCode, int pTimeoutCode) override;
+    int sendFile(const char *pFilename, int pErrorCode) override;
 
  private:
     // Attributes used to communicate with the server
     BIO *mBIO;
     SSL_CTX *mCTX;
     SSL *mSSL;
+    std::shared_ptr<TLSContext> mTLSContext;
+    static const unsigned int DEFAULT_HANDSHAKE_TIMEOUT_MS = 10000;
+    unsigned int mHandshakeTimeout;
+    std::chrono::microseconds mLastHandshakeDuration;
+    bool mKernelTLS;
 };
 }  // namespace jed_utils
 
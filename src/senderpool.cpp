@@ -0,0 +1,182 @@
+#include "senderpool.h"
+#include <stdexcept>
+#include <utility>
+
+using namespace jed_utils;
+
+namespace {
+    // Small, so most of the backlog stays visible to the stealing workers
+    const size_t BATCH_LENGTH = 4;
+    // Bounds the latency of a wakeup missed by a parked worker
+    const std::chrono::milliseconds IDLE_WAIT_DURATION(50);
+}  // namespace
+
+SenderPool::SenderPool(size_t pWorkerCount, ClientFactory pClientFactory, size_t pQueueCapacity)
+    : mNextWorker(0),
+      mStolenCount(0),
+      mStopping(false),
+      mIdleWorkerCount(0) {
+    if (pWorkerCount == 0) {
+        throw std::invalid_argument("The worker count must be greater than zero");
+    }
+    if (!pClientFactory) {
+        throw std::invalid_argument("The client factory cannot be null");
+    }
+    for (size_t i = 0; i < pWorkerCount; i++) {
+        mWorkers.emplace_back(new Worker(pQueueCapacity));
+        mWorkers.back()->Client = pClientFactory();
+        if (!mWorkers.back()->Client) {
+            throw std::invalid_argument("The client factory returned a null client");
+        }
+        mWorkers.back()->Client->setKeepAlive(true);
+    }
+    try {
+        for (size_t i = 0; i < pWorkerCount; i++) {
+            mWorkers[i]->Thread = std::thread(&SenderPool::run, this, i);
+        }
+    } catch (...) {
+        // A joinable thread must not be destroyed
+        stopWorkers();
+        throw;
+    }
+}
+
+SenderPool::~SenderPool() {
+    stopWorkers();
+}
+
+void SenderPool::stopWorkers() {
+    mStopping = true;
+    {
+        std::lock_guard<std::mutex> lock(mIdleMutex);
+        mIdleCondition.notify_all();
+    }
+    for (auto &worker : mWorkers) {
+        if (worker->Thread.joinable()) {
+            worker->Thread.join();
+        }
+    }
+}
+
+bool SenderPool::trySubmit(std::unique_ptr<Message> &pMsg, CompletionHandler pHandler) {
+    if (mStopping || !pMsg) {
+        return false;
+    }
+    Job job { std::move(pMsg), std::move(pHandler) };
+    if (!tryPush(job, mNextWorker++ % mWorkers.size())) {
+        pMsg = std::move(job.Msg);
+        return false;
+    }
+    updateQueueDepth();
+    wakeUpWorker();
+    return true;
+}
+
+bool SenderPool::submit(std::unique_ptr<Message> &pMsg, CompletionHandler pHandler,
+        std::chrono::steady_clock::time_point pDeadline) {
+    if (mStopping || !pMsg) {
+        return false;
+    }
+    Job job { std::move(pMsg), std::move(pHandler) };
+    const size_t first_worker = mNextWorker++ % mWorkers.size();
+    if (!tryPush(job, first_worker) && !mWorkers[first_worker]->Queue.enqueue(std::move(job), pDeadline)) {
+        pMsg = std::move(job.Msg);
+        return false;
+    }
+    updateQueueDepth();
+    wakeUpWorker();
+    return true;
+}
+
+size_t SenderPool::getWorkerCount() const {
+    return mWorkers.size();
+}
+
+size_t SenderPool::getQueuedCount() const {
+    size_t count = 0;
+    for (const auto &worker : mWorkers) {
+        count += worker->Queue.size();
+    }
+    return count;
+}
+
+std::uint64_t SenderPool::getStolenCount() const {
+    return mStolenCount;
+}
+
+void SenderPool::setMetricsRegistry(std::shared_ptr<MetricsRegistry> pRegistry) {
+    mMetrics = std::move(pRegistry);
+}
+
+void SenderPool::updateQueueDepth() {
+    if (mMetrics) {
+        mMetrics->setQueueDepth(getQueuedCount());
+    }
+}
+
+bool SenderPool::tryPush(Job &pJob, size_t pFirstWorker) {
+    // The round robin worker, then any worker that has room
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        if (mWorkers[(pFirstWorker + i) % mWorkers.size()]->Queue.tryEnqueue(std::move(pJob))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SenderPool::wakeUpWorker() {
+    // Pairs with the fence of the parking worker: either the worker sees the
+    // new job or this thread sees the idle worker.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mIdleWorkerCount > 0) {
+        std::lock_guard<std::mutex> lock(mIdleMutex);
+        mIdleCondition.notify_one();
+    }
+}
+
+bool SenderPool::steal(size_t pIndex, Job &pJob) {
+    for (size_t i = 1; i < mWorkers.size(); i++) {
+        if (mWorkers[(pIndex + i) % mWorkers.size()]->Queue.tryDequeue(pJob)) {
+            mStolenCount++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SenderPool::run(size_t pIndex) {
+    MPSCQueue<Job> &queue = mWorkers[pIndex]->Queue;
+    SMTPClientBase &client = *mWorkers[pIndex]->Client;
+    std::vector<Job> batch;
+    batch.reserve(BATCH_LENGTH);
+    for (;;) {
+        batch.clear();
+        if (queue.dequeueBatch(batch, BATCH_LENGTH) == 0) {
+            Job job;
+            if (steal(pIndex, job)) {
+                batch.push_back(std::move(job));
+            }
+        }
+        if (batch.empty()) {
+            if (mStopping && getQueuedCount() == 0) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(mIdleMutex);
+            mIdleWorkerCount++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!mStopping && getQueuedCount() == 0) {
+                mIdleCondition.wait_for(lock, IDLE_WAIT_DURATION);
+            }
+            mIdleWorkerCount--;
+            continue;
+        }
+        updateQueueDepth();
+        for (auto &job : batch) {
+            const int ret_code = client.sendMail(*job.Msg);
+            if (job.Handler) {
+                job.Handler(ret_code);
+            }
+        }
+    }
+    client.disconnect();
+}
@@ -0,0 +1,139 @@
+#ifndef SENDERPOOL_H
+#define SENDERPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "message.h"
+#include "metricsregistry.h"
+#include "mpscqueue.h"
+#include "smtpclientbase.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define SENDERPOOL_API __declspec(dllexport)
+    #else
+        #define SENDERPOOL_API __declspec(dllimport)
+    #endif
+#else
+    #define SENDERPOOL_API
+#endif
+
+namespace jed_utils {
+/** @brief The SenderPool class sends messages from N worker threads.
+ *
+ *  Each worker owns one client created by the factory and keeps its
+ *  connection open between messages (see SMTPClientBase::setKeepAlive).
+ *  Messages are submitted without locks to the MPSCQueue of a worker
+ *  (round robin) and an idle worker steals the queued messages of busy
+ *  workers, so a few very large messages do not hold back the others.
+ *
+ *  The rendering of a message (headers, base64 attachments) is done by the
+ *  worker that sends it, not by the thread that submits it.
+ */
+class SENDERPOOL_API SenderPool {
+ public:
+    /** The function that creates the client of a worker. */
+    using ClientFactory = std::function<std::unique_ptr<SMTPClientBase>()>;
+
+    /**
+     *  @brief  The callback invoked by the worker when a message has been
+     *  sent (0) or failed (error code returned by sendMail).
+     */
+    using CompletionHandler = std::function<void(int)>;
+
+    /**
+     *  @brief  Construct a new SenderPool and start its workers.
+     *  @param pWorkerCount The number of worker threads.
+     *  @param pClientFactory The function that creates the client of each
+     *  worker. It must not return null.
+     *  @param pQueueCapacity The capacity of the queue of each worker.
+     */
+    SenderPool(size_t pWorkerCount, ClientFactory pClientFactory, size_t pQueueCapacity = 1024);
+
+    /**
+     *  @brief  Destructor of the SenderPool. The messages already submitted
+     *  are sent, then the connections are closed.
+     */
+    ~SenderPool();
+
+    /** SenderPool copy constructor (deleted). */
+    SenderPool(const SenderPool &other) = delete;
+
+    /** SenderPool copy assignment operator (deleted). */
+    SenderPool& operator=(const SenderPool &other) = delete;
+
+    /**
+     *  @brief  Submit a message without waiting.
+     *  @param pMsg The message to send.
+     *  @param pHandler The callback invoked by the worker. Can be null.
+     *  @return False if every queue is full or the pool is stopping. The
+     *  message is then left in pMsg.
+     */
+    bool trySubmit(std::unique_ptr<Message> &pMsg, CompletionHandler pHandler = nullptr);
+
+    /**
+     *  @brief  Submit a message, waiting for free space until the deadline.
+     *  @return False if the queues were still full at the deadline or the
+     *  pool is stopping. The message is then left in pMsg.
+     */
+    bool submit(std::unique_ptr<Message> &pMsg, CompletionHandler pHandler,
+            std::chrono::steady_clock::time_point pDeadline);
+
+    /** Return the number of worker threads. */
+    size_t getWorkerCount() const;
+
+    /** Return the number of messages waiting in the queues. */
+    size_t getQueuedCount() const;
+
+    /** Return the number of messages sent by a worker other than the one
+     *  they were submitted to. */
+    std::uint64_t getStolenCount() const;
+
+    /**
+     *  @brief  Set the registry whose queue depth follows the messages
+     *  waiting in the pool. Set it before the first submission.
+     *  @param pRegistry The registry, null to stop updating it.
+     */
+    void setMetricsRegistry(std::shared_ptr<MetricsRegistry> pRegistry);
+
+ private:
+    struct Job {
+        std::unique_ptr<Message> Msg;
+        CompletionHandler Handler;
+    };
+    struct Worker {
+        explicit Worker(size_t pQueueCapacity)
+            : Queue(pQueueCapacity) {
+        }
+        MPSCQueue<Job> Queue;
+        std::unique_ptr<SMTPClientBase> Client;
+        std::thread Thread;
+    };
+
+    bool tryPush(Job &pJob, size_t pFirstWorker);
+    void stopWorkers();
+    void wakeUpWorker();
+    void run(size_t pIndex);
+    bool steal(size_t pIndex, Job &pJob);
+    void updateQueueDepth();
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::atomic<size_t> mNextWorker;
+    std::atomic<std::uint64_t> mStolenCount;
+    std::atomic<bool> mStopping;
+    std::atomic<size_t> mIdleWorkerCount;
+    std::mutex mIdleMutex;
+    std::condition_variable mIdleCondition;
+    std::shared_ptr<MetricsRegistry> mMetrics;
+};
+}  // namespace jed_utils
+
+#endif
@@ -0,0 +1,42 @@
+#include "sendreport.h"
+#include <cstring>
+
+using namespace jed_utils;
+
+const size_t SendReport::PHASE_COUNT;
+
+namespace {
+    // The token that follows the marker in the reply, up to a space or the end of the line
+    std::string extractToken(const char *pReply, const char *pMarker) {
+        const char *found = strstr(pReply, pMarker);
+        if (found == nullptr) {
+            return "";
+        }
+        const char *begin = found + strlen(pMarker);
+        const char *end = begin + strcspn(begin, " \t\r\n;,");
+        return std::string(begin, static_cast<size_t>(end - begin));
+    }
+}  // namespace
+
+const SendPhaseTiming &SendReport::getPhase(SendPhase pPhase) const {
+    return Phases[static_cast<size_t>(pPhase)];
+}
+
+std::chrono::microseconds SendReport::getTotalDuration() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(End - Start);
+}
+
+void SendReport::clear() {
+    *this = SendReport();
+}
+
+std::string SendReport::extractQueueId(const char *pReply) {
+    if (pReply == nullptr) {
+        return "";
+    }
+    std::string queue_id { extractToken(pReply, "queued as ") };
+    if (queue_id.empty()) {
+        queue_id = extractToken(pReply, "id=");
+    }
+    return queue_id;
+}
@@ -0,0 +1,115 @@
+#ifndef SENDREPORT_H
+#define SENDREPORT_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define SENDREPORT_API __declspec(dllexport)
+    #else
+        #define SENDREPORT_API __declspec(dllimport)
+    #endif
+#else
+    #define SENDREPORT_API
+#endif
+
+namespace jed_utils {
+/** @brief The phases of the sending of a message, in the order they occur. */
+enum class SendPhase {
+    /** The resolution of the server name */
+    Resolve,
+    /** The TCP connection */
+    Connect,
+    /** The wait for the greeting of the server */
+    Greeting,
+    /** The EHLO commands, before and after the TLS negotiation */
+    Hello,
+    /** The STARTTLS command, the TLS handshake and the certificate checks */
+    TLS,
+    /** The AUTH commands */
+    Authentication,
+    /** The RSET command that reuses a kept alive connection */
+    Reset,
+    /** The MAIL FROM and RCPT TO commands */
+    Envelope,
+    /** The DATA command and the upload of the content */
+    Data,
+    /** The wait for the reply to the end of the data */
+    FinalReply,
+    /** The QUIT command */
+    Quit
+};
+
+/** @brief The time spent in a phase of the sending. */
+struct SendPhaseTiming {
+    /** When the phase started the first time, the epoch of steady_clock if
+     *  it did not run. */
+    std::chrono::steady_clock::time_point Start;
+    /** When the phase ended the last time. */
+    std::chrono::steady_clock::time_point End;
+    /** The time spent in the phase, summed when it ran several times. */
+    std::chrono::microseconds Duration { 0 };
+};
+
+/** @brief The SendReport struct describes how a message was sent: the time
+ *  spent in each phase and the traffic with the server. It is filled by
+ *  SMTPClientBase::sendMail(const Message &, SendReport *).
+ *
+ *  The timestamps come from the monotonic steady_clock. The bytes are those
+ *  of the SMTP session, before the TLS encryption.
+ */
+struct SENDREPORT_API SendReport {
+    /** The number of SendPhase values. */
+    static const size_t PHASE_COUNT = 11;
+
+    /** When sendMail started. */
+    std::chrono::steady_clock::time_point Start;
+    /** When sendMail returned. */
+    std::chrono::steady_clock::time_point End;
+    /** The timing of each phase, indexed by SendPhase (see getPhase). */
+    std::array<SendPhaseTiming, PHASE_COUNT> Phases;
+    /** The bytes sent to the server. */
+    size_t BytesWritten = 0;
+    /** The bytes received from the server. */
+    size_t BytesRead = 0;
+    /** The number of calls that sent data to the socket. */
+    size_t WriteCallCount = 0;
+    /** The number of calls that read data from the socket, including the
+     *  reads that returned nothing while waiting for a reply. */
+    size_t ReadCallCount = 0;
+    /** True if the connection kept alive by the previous message was used. */
+    bool ConnectionReused = false;
+    /** True if the TLS session of a previous connection was resumed. */
+    bool TLSResumed = false;
+    /** The code returned by sendMail. */
+    int ReturnCode = 0;
+    /** The reply of the server to the end of the data. */
+    std::string FinalReply;
+    /** The identifier given by the server to the message (see
+     *  extractQueueId), empty if unknown. */
+    std::string QueueId;
+
+    /** Return the timing of a phase. */
+    const SendPhaseTiming &getPhase(SendPhase pPhase) const;
+
+    /** Return the time from the start of sendMail to its end. */
+    std::chrono::microseconds getTotalDuration() const;
+
+    /** Reset all the fields. */
+    void clear();
+
+    /**
+     *  @brief  Extract the queue identifier from the reply to the end of the
+     *  data, in the formats "queued as <id>" (Postfix) and
+     *  "id=<id>" (Exim).
+     *  @param pReply The reply of the server.
+     *  @return The identifier, or an empty string if it is not found.
+     */
+    static std::string extractQueueId(const char *pReply);
+};
+}  // namespace jed_utils
+
+#endif
@@ -1,7 +1,12 @@
 #ifndef SERVERAUTHOPTIONS_H
 #define SERVERAUTHOPTIONS_H
 
+#include <cstddef>
+
 namespace jed_utils {
+/** @brief The options advertised by a server in its EHLO response: the AUTH
+ *  methods and the SMTP extensions.
+ */
 struct ServerAuthOptions {
     bool Plain = false;
     bool Login = false;
@@ -9,6 +14,24 @@ struct ServerAuthOptions {
     bool Plain_ClientToken = false;
     bool OAuthBearer = false;
     bool XOAuth = false;
+    /** The server advertises AUTH (RFC 4954) */
+    bool Auth = false;
+    /** The server advertises SIZE (RFC 1870) */
+    bool Size = false;
+    /** The maximum message size declared with SIZE. 0 means no limit. */
+    size_t MaxMessageSize = 0;
+    /** The commands can be pipelined (RFC 2920) */
+    bool Pipelining = false;
+    /** The content can be sent with BDAT (RFC 3030) */
+    bool Chunking = false;
+    /** The body can contain 8-bit characters (RFC 6152) */
+    bool EightBitMime = false;
+    /** The addresses and headers can contain UTF-8 (RFC 6531) */
+    bool SMTPUTF8 = false;
+    /** Delivery status notifications can be requested (RFC 3461) */
+    bool DSN = false;
+    /** The connection can be upgraded with STARTTLS (RFC 3207) */
+    bool StartTLS = false;
 };
 }  // namespace jed_utils
 
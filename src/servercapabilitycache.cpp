@@ -0,0 +1,75 @@
+#include "servercapabilitycache.h"
+
+using namespace jed_utils;
+
+namespace {
+    // Bounds the memory used by the cache
+    const size_t MAX_CACHED_SERVER_COUNT = 1024;
+}  // namespace
+
+ServerCapabilityCache::ServerCapabilityCache(std::chrono::seconds pTimeToLive)
+    : mTimeToLive(pTimeToLive.count()) {
+}
+
+std::shared_ptr<ServerCapabilityCache> ServerCapabilityCache::getDefault() {
+    static std::shared_ptr<ServerCapabilityCache> default_cache = std::make_shared<ServerCapabilityCache>();
+    return default_cache;
+}
+
+std::chrono::seconds ServerCapabilityCache::getTimeToLive() const {
+    return std::chrono::seconds(mTimeToLive.load());
+}
+
+void ServerCapabilityCache::setTimeToLive(std::chrono::seconds pTimeToLive) {
+    mTimeToLive = pTimeToLive.count();
+}
+
+bool ServerCapabilityCache::find(const char *pServerName, unsigned int pPort, ServerCapabilities &pCapabilities) {
+    const std::string key { createKey(pServerName, pPort) };
+    std::lock_guard<std::mutex> lock(mEntriesMutex);
+    auto entry = mEntries.find(key);
+    if (entry == mEntries.end()) {
+        return false;
+    }
+    if (std::chrono::steady_clock::now() >= entry->second.Expiration) {
+        mEntries.erase(entry);
+        return false;
+    }
+    pCapabilities = entry->second.Capabilities;
+    return true;
+}
+
+void ServerCapabilityCache::store(const char *pServerName, unsigned int pPort, const ServerCapabilities &pCapabilities) {
+    const std::int64_t time_to_live = mTimeToLive;
+    if (time_to_live <= 0) {
+        return;
+    }
+    std::string key { createKey(pServerName, pPort) };
+    std::lock_guard<std::mutex> lock(mEntriesMutex);
+    if (mEntries.size() >= MAX_CACHED_SERVER_COUNT && mEntries.find(key) == mEntries.end()) {
+        mEntries.erase(mEntries.begin());
+    }
+    mEntries[key] = Entry { pCapabilities, std::chrono::steady_clock::now() + std::chrono::seconds(time_to_live) };
+}
+
+void ServerCapabilityCache::remove(const char *pServerName, unsigned int pPort) {
+    const std::string key { createKey(pServerName, pPort) };
+    std::lock_guard<std::mutex> lock(mEntriesMutex);
+    mEntries.erase(key);
+}
+
+void ServerCapabilityCache::clear() {
+    std::lock_guard<std::mutex> lock(mEntriesMutex);
+    mEntries.clear();
+}
+
+size_t ServerCapabilityCache::size() const {
+    std::lock_guard<std::mutex> lock(mEntriesMutex);
+    return mEntries.size();
+}
+
+std::string ServerCapabilityCache::createKey(const char *pServerName, unsigned int pPort) {
+    std::string key { pServerName != nullptr ? pServerName : "" };
+    key.append(":").append(std::to_string(pPort));
+    return key;
+}
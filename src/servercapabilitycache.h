@@ -0,0 +1,121 @@
+#ifndef SERVERCAPABILITYCACHE_H
+#define SERVERCAPABILITYCACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "serverauthoptions.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define SERVERCAPABILITYCACHE_API __declspec(dllexport)
+    #else
+        #define SERVERCAPABILITYCACHE_API __declspec(dllimport)
+    #endif
+#else
+    #define SERVERCAPABILITYCACHE_API
+#endif
+
+namespace jed_utils {
+/** @brief How the communication with a server is secured. */
+enum class ServerSecurityMode {
+    /** The server offers neither implicit TLS nor STARTTLS */
+    Unencrypted,
+    /** The connection is upgraded with STARTTLS */
+    StartTLS,
+    /** TLS from the initial connection */
+    Implicit
+};
+
+/** @brief What a server offered the last time a client connected to it. */
+struct ServerCapabilities {
+    ServerSecurityMode SecurityMode = ServerSecurityMode::StartTLS;
+    /** The response of the last EHLO command. */
+    std::string EhloResponse;
+    /** The AUTH methods and extensions parsed from EhloResponse. */
+    ServerAuthOptions Options;
+};
+
+/** @brief The ServerCapabilityCache class remembers the capabilities of the
+ *  servers for a limited time, so the next connections skip the probing of
+ *  the security mode and the parsing of the EHLO response.
+ *
+ *  The cache is thread safe and can be shared by several clients.
+ */
+class SERVERCAPABILITYCACHE_API ServerCapabilityCache {
+ public:
+    /**
+     *  @brief  Construct a new ServerCapabilityCache.
+     *  @param pTimeToLive How long the capabilities of a server are kept.
+     */
+    explicit ServerCapabilityCache(std::chrono::seconds pTimeToLive = std::chrono::seconds(3600));
+
+    /** ServerCapabilityCache copy constructor (deleted). */
+    ServerCapabilityCache(const ServerCapabilityCache &other) = delete;
+
+    /** ServerCapabilityCache copy assignment operator (deleted). */
+    ServerCapabilityCache& operator=(const ServerCapabilityCache &other) = delete;
+
+    /** Return the process-wide cache. It is created on the first call. */
+    static std::shared_ptr<ServerCapabilityCache> getDefault();
+
+    /** Return how long the capabilities of a server are kept. */
+    std::chrono::seconds getTimeToLive() const;
+
+    /**
+     *  @brief  Set how long the capabilities of a server are kept. The
+     *  entries already stored keep their expiration time.
+     *  @param pTimeToLive The time to live. 0 disables the cache.
+     */
+    void setTimeToLive(std::chrono::seconds pTimeToLive);
+
+    /**
+     *  @brief  Find the capabilities of a server.
+     *  @param pServerName The name of the server.
+     *  @param pPort The server port number.
+     *  @param pCapabilities Receives the capabilities if they are found.
+     *  @return False if the server is unknown or its entry has expired.
+     */
+    bool find(const char *pServerName, unsigned int pPort, ServerCapabilities &pCapabilities);
+
+    /**
+     *  @brief  Store the capabilities of a server. They replace the previous
+     *  ones, if any.
+     *  @param pServerName The name of the server.
+     *  @param pPort The server port number.
+     *  @param pCapabilities The capabilities.
+     */
+    void store(const char *pServerName, unsigned int pPort, const ServerCapabilities &pCapabilities);
+
+    /**
+     *  @brief  Remove the capabilities of a server, so they are probed on the
+     *  next connection.
+     *  @param pServerName The name of the server.
+     *  @param pPort The server port number.
+     */
+    void remove(const char *pServerName, unsigned int pPort);
+
+    /** Remove the capabilities of all the servers. */
+    void clear();
+
+    /** Return the number of servers in the cache (expired included). */
+    size_t size() const;
+
+ private:
+    struct Entry {
+        ServerCapabilities Capabilities;
+        std::chrono::steady_clock::time_point Expiration;
+    };
+    static std::string createKey(const char *pServerName, unsigned int pPort);
+
+    std::atomic<std::int64_t> mTimeToLive;
+    mutable std::mutex mEntriesMutex;
+    std::unordered_map<std::string, Entry> mEntries;
+};
+}  // namespace jed_utils
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SIMDUTILS_H
+#define SIMDUTILS_H
+
+// SSE2 is part of x86-64 and is used by the byte scanning loops of the
+// library (content classification, quoted-printable, dot-stuffing). The other
+// architectures use the byte-wise loops.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SMTPCLIENT_SSE2
+    #include <emmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+namespace jed_utils {
+namespace simd {
+/** Return the index of the lowest bit set in a non-zero mask. */
+inline unsigned int countTrailingZeros(unsigned int pMask) {
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward(&index, pMask);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(pMask));
+#endif
+}
+}  // namespace simd
+}  // namespace jed_utils
+
+#endif
@@ -1,20 +1,27 @@
 #include "smtpclientbase.h"
 #include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <cerrno>
 #include <cstddef>
 #include <cstring>
+#include <fstream>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include "base64.h"
+#include "datastuffer.h"
+#include "dkimsigner.h"
 #include "errorresolver.h"
 #include "message.h"
 #include "messageaddress.h"
+#include "messagerenderer.h"
 #include "serverauthoptions.h"
 #include "smtpclienterrors.h"
 #include "smtpserverstatuscodes.h"
+#include "smtptrace.h"
 #include "socketerrors.h"
 #include "stringutils.h"
 #ifdef _WIN32
@@ -25,22 +32,130 @@
     #include <windows.h>
     #include <WinNT.h>
     constexpr auto sleep = Sleep;
+    constexpr auto poll = WSAPoll;
 #else
     #include <fcntl.h>
     #include <netdb.h>
     #include <netinet/in.h>
+    #include <poll.h>
     #include <sys/socket.h>
+    #include <sys/stat.h>
     #include <sys/types.h>
     #include <unistd.h>
+    #ifdef __linux__
+        #include <sys/sendfile.h>
+    #endif
 #endif
 
 using namespace std::literals::string_literals;
 using namespace jed_utils;
 
+namespace {
+    // The identifiers of the connections, unique in the process
+    std::atomic<std::uint64_t> lastSessionId(0);
+
+    /* True if an idle connection cannot be reused: the server closed it or
+       sent an unsolicited reply, usually 421 before closing it */
+    bool isIdleConnectionClosed(int pSocket) {
+        pollfd poll_descriptor {};
+        poll_descriptor.fd = pSocket;
+        poll_descriptor.events = POLLIN;
+        return poll(&poll_descriptor, 1, 0) != 0;
+    }
+
+    // The three digits of a server reply, 0 if it does not start with them
+    int parseReplyCode(const char *pReply) {
+        if (pReply == nullptr) {
+            return 0;
+        }
+        int code = 0;
+        for (int i = 0; i < 3; i++) {
+            if (pReply[i] < '0' || pReply[i] > '9') {
+                return 0;
+            }
+            code = code * 10 + (pReply[i] - '0');
+        }
+        return code;
+    }
+
+    // Case insensitive comparison of [pBegin, pEnd) with an upper case keyword
+    bool tokenEquals(const char *pBegin, const char *pEnd, const char *pKeyword) {
+        for (; pBegin != pEnd; pBegin++, pKeyword++) {
+            if (*pKeyword == '\0' || toupper(static_cast<unsigned char>(*pBegin)) != *pKeyword) {
+                return false;
+            }
+        }
+        return *pKeyword == '\0';
+    }
+
+    void parseAuthMechanism(const char *pBegin, const char *pEnd, ServerAuthOptions &pOptions) {
+        if (tokenEquals(pBegin, pEnd, "PLAIN")) {
+            pOptions.Plain = true;
+        } else if (tokenEquals(pBegin, pEnd, "LOGIN")) {
+            pOptions.Login = true;
+        } else if (tokenEquals(pBegin, pEnd, "XOAUTH2")) {
+            pOptions.XOAuth2 = true;
+        } else if (tokenEquals(pBegin, pEnd, "PLAIN-CLIENTTOKEN")) {
+            pOptions.Plain_ClientToken = true;
+        } else if (tokenEquals(pBegin, pEnd, "OAUTHBEARER")) {
+            pOptions.OAuthBearer = true;
+        } else if (tokenEquals(pBegin, pEnd, "XOAUTH")) {
+            pOptions.XOAuth = true;
+        }
+    }
+
+    size_t parseMaxMessageSize(const char *pBegin, const char *pEnd) {
+        size_t size = 0;
+        for (; pBegin != pEnd && *pBegin >= '0' && *pBegin <= '9'; pBegin++) {
+            const auto digit = static_cast<size_t>(*pBegin - '0');
+            if (size > ((std::numeric_limits<size_t>::max)() - digit) / 10) {
+                return 0;
+            }
+            size = size * 10 + digit;
+        }
+        return size;
+    }
+
+    // Parse the keyword and parameters of one EHLO line (after "250-")
+    void parseEhloLine(const char *pBegin, const char *pEnd, ServerAuthOptions &pOptions) {
+        const char *keyword_end = pBegin;
+        // Some servers still use the obsolete AUTH=LOGIN form
+        while (keyword_end != pEnd && *keyword_end != ' ' && *keyword_end != '=') {
+            keyword_end++;
+        }
+        const char *parameters = keyword_end == pEnd ? pEnd : keyword_end + 1;
+        if (tokenEquals(pBegin, keyword_end, "AUTH")) {
+            pOptions.Auth = true;
+            while (parameters != pEnd) {
+                const char *mechanism_end = parameters;
+                while (mechanism_end != pEnd && *mechanism_end != ' ') {
+                    mechanism_end++;
+                }
+                parseAuthMechanism(parameters, mechanism_end, pOptions);
+                parameters = mechanism_end == pEnd ? pEnd : mechanism_end + 1;
+            }
+        } else if (tokenEquals(pBegin, keyword_end, "SIZE")) {
+            pOptions.Size = true;
+            pOptions.MaxMessageSize = parseMaxMessageSize(parameters, pEnd);
+        } else if (tokenEquals(pBegin, keyword_end, "PIPELINING")) {
+            pOptions.Pipelining = true;
+        } else if (tokenEquals(pBegin, keyword_end, "CHUNKING")) {
+            pOptions.Chunking = true;
+        } else if (tokenEquals(pBegin, keyword_end, "8BITMIME")) {
+            pOptions.EightBitMime = true;
+        } else if (tokenEquals(pBegin, keyword_end, "SMTPUTF8")) {
+            pOptions.SMTPUTF8 = true;
+        } else if (tokenEquals(pBegin, keyword_end, "DSN")) {
+            pOptions.DSN = true;
+        } else if (tokenEquals(pBegin, keyword_end, "STARTTLS")) {
+            pOptions.StartTLS = true;
+        }
+    }
+}  // namespace
+
 SMTPClientBase::SMTPClientBase(const char *pServerName, unsigned int pPort)
     : mServerName(nullptr),
       mPort(pPort),
-      mCommunicationLog(nullptr),
       mLastServerResponse(nullptr),
       mCommandTimeOut(5),
       mLastSocketErrNo(0),
@@ -62,8 +177,6 @@ SMTPClientBase::SMTPClientBase(const char *pServerName, unsigned int pPort)
 SMTPClientBase::~SMTPClientBase() {
     delete[] mServerName;
     mServerName = nullptr;
-    delete[] mCommunicationLog;
-    mCommunicationLog = nullptr;
     delete[] mLastServerResponse;
     mLastServerResponse = nullptr;
     delete mAuthOptions;
@@ -75,25 +188,23 @@ SMTPClientBase::~SMTPClientBase() {
 SMTPClientBase::SMTPClientBase(const SMTPClientBase& other)
     : mServerName(new char[strlen(other.mServerName) + 1]),
       mPort(other.mPort),
-      mCommunicationLog(other.mCommunicationLog != nullptr ? new char[strlen(other.mCommunicationLog) + 1]: nullptr),
-      mCommunicationLogSize(other.mCommunicationLogSize),
+      mCommunicationLog(other.mCommunicationLog),
       mLastServerResponse(other.mLastServerResponse != nullptr ? new char[strlen(other.mLastServerResponse) + 1]: nullptr),
       mCommandTimeOut(other.mCommandTimeOut),
       mLastSocketErrNo(other.mLastSocketErrNo),
       mAuthOptions(other.mAuthOptions != nullptr ? new ServerAuthOptions(*other.mAuthOptions) : nullptr),
       mCredential(other.mCredential != nullptr ? new Credential(*other.mCredential) : nullptr),
       mSock(0),
+      mKeepAlive(other.mKeepAlive),
+      mDKIMSigner(other.mDKIMSigner),
+      mLogSink(other.mLogSink),
+      mMetrics(other.mMetrics),
       mKeepUsingBaseSendCommands(other.mKeepUsingBaseSendCommands),
       sendCommandPtr(&SMTPClientBase::sendCommand),
       sendCommandWithFeedbackPtr(&SMTPClientBase::sendCommandWithFeedback) {
     size_t server_name_len = strlen(other.mServerName);
     strncpy(mServerName, other.mServerName, server_name_len);
     mServerName[server_name_len] = '\0';
-    if (mCommunicationLog != nullptr) {
-        size_t communication_log_len = strlen(other.mCommunicationLog);
-        strncpy(mCommunicationLog, other.mCommunicationLog, communication_log_len);
-        mCommunicationLog[communication_log_len] = '\0';
-    }
 
     if (mLastServerResponse != nullptr) {
         size_t last_server_response_len = strlen(other.mLastServerResponse);
@@ -115,13 +226,7 @@ SMTPClientBase& SMTPClientBase::operator=(const SMTPClientBase& other) {
         // mPort
         mPort = other.mPort;
         // mCommunicationLog
-        mCommunicationLog = other.mCommunicationLog != nullptr ? new char[strlen(other.mCommunicationLog) + 1]: nullptr;
-        if (mCommunicationLog != nullptr) {
-            size_t communication_log_len = strlen(other.mCommunicationLog);
-            strncpy(mCommunicationLog, other.mCommunicationLog, communication_log_len);
-            mCommunicationLog[communication_log_len] = '\0';
-        }
-        mCommunicationLogSize = other.mCommunicationLogSize;
+        mCommunicationLog = other.mCommunicationLog;
         // mLastServerResponse
         mLastServerResponse = other.mLastServerResponse != nullptr ? new char[strlen(other.mLastServerResponse) + 1]: nullptr;
         if (mLastServerResponse != nullptr) {
@@ -137,6 +242,10 @@ SMTPClientBase& SMTPClientBase::operator=(const SMTPClientBase& other) {
         // mCredential
         mCredential = other.mCredential != nullptr ? new Credential(*other.mCredential) : nullptr;
         mSock = 0;
+        mKeepAlive = other.mKeepAlive;
+        mDKIMSigner = other.mDKIMSigner;
+        mLogSink = other.mLogSink;
+        mMetrics = other.mMetrics;
         setKeepUsingBaseSendCommands(other.mKeepUsingBaseSendCommands);
     }
     return *this;
@@ -146,27 +255,32 @@ SMTPClientBase& SMTPClientBase::operator=(const SMTPClientBase& other) {
 SMTPClientBase::SMTPClientBase(SMTPClientBase&& other) noexcept
     : mServerName(other.mServerName),
       mPort(other.mPort),
-      mCommunicationLog(other.mCommunicationLog),
-      mCommunicationLogSize(other.mCommunicationLogSize),
+      mCommunicationLog(std::move(other.mCommunicationLog)),
       mLastServerResponse(other.mLastServerResponse),
       mCommandTimeOut(other.mCommandTimeOut),
       mLastSocketErrNo(other.mLastSocketErrNo),
       mAuthOptions(other.mAuthOptions),
       mCredential(other.mCredential),
       mSock(other.mSock),
+      mKeepAlive(other.mKeepAlive),
+      mDKIMSigner(std::move(other.mDKIMSigner)),
+      mLogSink(std::move(other.mLogSink)),
+      mSessionId(other.mSessionId),
+      mMetrics(std::move(other.mMetrics)),
+      mOpenSessionMetrics(std::move(other.mOpenSessionMetrics)),
       mKeepUsingBaseSendCommands(other.mKeepUsingBaseSendCommands),
       sendCommandPtr(&SMTPClientBase::sendCommand),
       sendCommandWithFeedbackPtr(&SMTPClientBase::sendCommandWithFeedback) {
     other.mServerName = nullptr;
     other.mPort = 0;
-    other.mCommunicationLog = nullptr;
-    other.mCommunicationLogSize = 0;
+    other.mCommunicationLog.clear();
     other.mLastServerResponse = nullptr;
     other.mCommandTimeOut = 0;
     other.mLastSocketErrNo = 0;
     other.mAuthOptions = nullptr;
     other.mCredential = nullptr;
     other.mSock = 0;
+    other.mKeepAlive = false;
     other.mKeepUsingBaseSendCommands = false;
     setKeepUsingBaseSendCommands(mKeepUsingBaseSendCommands);
 }
@@ -175,35 +289,39 @@ SMTPClientBase::SMTPClientBase(SMTPClientBase&& other) noexcept
 SMTPClientBase& SMTPClientBase::operator=(SMTPClientBase&& other) noexcept {
     if (this != &other) {
         delete[] mServerName;
-        delete[] mCommunicationLog;
         delete[] mLastServerResponse;
         delete mAuthOptions;
         delete mCredential;
         // Copy the data pointer and its length from the source object.
         mServerName = other.mServerName;
         mPort = other.mPort;
-        mCommunicationLog = other.mCommunicationLog;
-        mCommunicationLogSize = other.mCommunicationLogSize;
+        mCommunicationLog = std::move(other.mCommunicationLog);
         mLastServerResponse = other.mLastServerResponse;
         mCommandTimeOut = other.mCommandTimeOut;
         mLastSocketErrNo = other.mLastSocketErrNo;
         mAuthOptions = other.mAuthOptions;
         mCredential = other.mCredential;
         mSock = other.mSock;
+        mKeepAlive = other.mKeepAlive;
+        mDKIMSigner = std::move(other.mDKIMSigner);
+        mLogSink = std::move(other.mLogSink);
+        mSessionId = other.mSessionId;
+        mMetrics = std::move(other.mMetrics);
+        mOpenSessionMetrics = std::move(other.mOpenSessionMetrics);
         mKeepUsingBaseSendCommands = other.mKeepUsingBaseSendCommands;
         setKeepUsingBaseSendCommands(mKeepUsingBaseSendCommands);
         // Release the data pointer from the source object so that
         // the destructor does not free the memory multiple times.
         other.mServerName = nullptr;
         other.mPort = 0;
-        other.mCommunicationLog = nullptr;
-        other.mCommunicationLogSize = 0;
+        other.mCommunicationLog.clear();
         other.mLastServerResponse = nullptr;
         other.mCommandTimeOut = 0;
         other.mLastSocketErrNo = 0;
         other.mAuthOptions = nullptr;
         other.mCredential = nullptr;
         other.mSock = 0;
+        other.mKeepAlive = false;
         other.mKeepUsingBaseSendCommands = false;
     }
     return *this;
@@ -222,7 +340,23 @@ unsigned int SMTPClientBase::getCommandTimeout() const {
 }
 
 const char *SMTPClientBase::getCommunicationLog() const {
-    return mCommunicationLog == nullptr ? "" : mCommunicationLog;
+    return mCommunicationLog.getText().c_str();
+}
+
+CommunicationLogLevel SMTPClientBase::getCommunicationLogLevel() const {
+    return mCommunicationLog.getLevel();
+}
+
+void SMTPClientBase::setCommunicationLogLevel(CommunicationLogLevel pLevel) {
+    mCommunicationLog.setLevel(pLevel);
+}
+
+size_t SMTPClientBase::getCommunicationLogMaxSize() const {
+    return mCommunicationLog.getMaxSize();
+}
+
+void SMTPClientBase::setCommunicationLogMaxSize(size_t pMaxSize) {
+    mCommunicationLog.setMaxSize(pMaxSize);
 }
 
 const Credential *SMTPClientBase::getCredentials() const {
@@ -265,12 +399,72 @@ void SMTPClientBase::setKeepUsingBaseSendCommands(bool pValue) {
     }
 }
 
+bool SMTPClientBase::getKeepUsingBaseSendCommands() const {
+    return mKeepUsingBaseSendCommands;
+}
+
+bool SMTPClientBase::getKeepAlive() const {
+    return mKeepAlive;
+}
+
+void SMTPClientBase::setKeepAlive(bool pValue) {
+    mKeepAlive = pValue;
+}
+
+std::shared_ptr<DKIMSigner> SMTPClientBase::getDKIMSigner() const {
+    return mDKIMSigner;
+}
+
+void SMTPClientBase::setDKIMSigner(std::shared_ptr<DKIMSigner> pSigner) {
+    mDKIMSigner = std::move(pSigner);
+}
+
+std::shared_ptr<LogSink> SMTPClientBase::getLogSink() const {
+    return mLogSink;
+}
+
+void SMTPClientBase::setLogSink(std::shared_ptr<LogSink> pSink) {
+    mLogSink = std::move(pSink);
+}
+
+std::uint64_t SMTPClientBase::getSessionId() const {
+    return mSessionId;
+}
+
+std::shared_ptr<MetricsRegistry> SMTPClientBase::getMetricsRegistry() const {
+    return mMetrics;
+}
+
+void SMTPClientBase::setMetricsRegistry(std::shared_ptr<MetricsRegistry> pRegistry) {
+    mMetrics = std::move(pRegistry);
+}
+
+bool SMTPClientBase::isConnected() const {
+    return mSock != 0;
+}
+
+int SMTPClientBase::disconnect() {
+    if (!isConnected()) {
+        return 0;
+    }
+    int quit_ret_code = sendQuitCommand();
+    cleanup();
+    return quit_ret_code;
+}
+
 int SMTPClientBase::getSocketFileDescriptor() const {
     return mSock;
 }
 
 void SMTPClientBase::clearSocketFileDescriptor() {
+    if (mSock != 0) {
+        SMTPCLIENT_PROBE1(session__close, mSessionId);
+    }
     mSock = 0;
+    if (mOpenSessionMetrics) {
+        mOpenSessionMetrics->removeOpenSession();
+        mOpenSessionMetrics.reset();
+    }
 }
 
 const char *SMTPClientBase::getLastServerResponse() const {
@@ -281,6 +475,10 @@ void SMTPClientBase::setLastSocketErrNo(int lastError) {
     mLastSocketErrNo = lastError;
 }
 
+const ServerAuthOptions *SMTPClientBase::getAuthenticationOptions() const {
+    return mAuthOptions;
+}
+
 void SMTPClientBase::setAuthenticationOptions(ServerAuthOptions *authOptions) {
     delete mAuthOptions;
     mAuthOptions = authOptions;
@@ -316,42 +514,95 @@ int SMTPClientBase::getErrorMessage_r(int errorCode,
 }
 
 int SMTPClientBase::sendMail(const Message &pMsg) {
-    int client_connect_ret_code = establishConnectionWithServer();
-    if (client_connect_ret_code != 0) {
-        return client_connect_ret_code;
+    return sendMail(pMsg, nullptr);
+}
+
+int SMTPClientBase::sendMail(const Message &pMsg, SendReport *pReport) {
+    if (pReport == nullptr && !mMetrics) {
+        return transmitMail(pMsg);
+    }
+    // The metrics are taken from a report
+    SendReport metrics_report;
+    SendReport *report = pReport != nullptr ? pReport : &metrics_report;
+    report->clear();
+    report->Start = std::chrono::steady_clock::now();
+    mSendReport = report;
+    const int ret_code = transmitMail(pMsg);
+    endPhase();
+    mSendReport = nullptr;
+    report->ReturnCode = ret_code;
+    report->End = std::chrono::steady_clock::now();
+    if (mMetrics) {
+        mMetrics->recordSend(getServerName(), getServerPort(),
+                pMsg.getToCount() + pMsg.getCcCount() + pMsg.getBccCount(), *report);
+    }
+    return ret_code;
+}
+
+int SMTPClientBase::transmitMail(const Message &pMsg) {
+    /* A kept alive connection is reused if the server did not close it and
+       still accepts RSET, otherwise a new connection is made at once */
+    if (mKeepAlive && isConnected() && !isIdleConnectionClosed(mSock)
+            && resetMailTransaction() == 0) {
+        if (mSendReport != nullptr) {
+            mSendReport->ConnectionReused = true;
+        }
+    } else {
+        if (isConnected()) {
+            cleanup();
+        }
+        int client_connect_ret_code = establishConnectionWithServer();
+        if (client_connect_ret_code != 0) {
+            cleanup();
+            return client_connect_ret_code;
+        }
+        if (mMetrics && !mOpenSessionMetrics) {
+            mOpenSessionMetrics = mMetrics;
+            mOpenSessionMetrics->addOpenSession();
+        }
     }
 
+    beginPhase(SendPhase::Envelope);
     int set_mail_recipients_ret_code = setMailRecipients(pMsg);
     if (set_mail_recipients_ret_code != 0) {
+        cleanup();
         return set_mail_recipients_ret_code;
     }
 
+    beginPhase(SendPhase::Data);
     int set_mail_headers_ret_code = setMailHeaders(pMsg);
     if (set_mail_headers_ret_code != 0) {
+        cleanup();
         return set_mail_headers_ret_code;
     }
 
     int set_mail_body_ret_code = setMailBody(pMsg);
     if (set_mail_body_ret_code != 0) {
+        cleanup();
         return set_mail_body_ret_code;
     }
 
+    if (mKeepAlive) {
+        return 0;
+    }
+    int quit_ret_code = sendQuitCommand();
     cleanup();
-    return 0;
+    return quit_ret_code;
 }
 
-
 int SMTPClientBase::initializeSession() {
-    delete[] mCommunicationLog;
-    mCommunicationLog = new char[INITIAL_COMM_LOG_LENGTH];
-    mCommunicationLogSize = INITIAL_COMM_LOG_LENGTH;
-    mCommunicationLog[0] = '\0';
+    mCommunicationLog.clear();
+    mSessionId = ++lastSessionId;
+    beginPhase(SendPhase::Resolve);
+    SMTPCLIENT_PROBE3(connect__start, mSessionId, getServerName(), getServerPort());
 
 #ifdef _WIN32
-    return initializeSessionWinSock();
+    const int connect_ret_code = initializeSessionWinSock();
 #else
-    return initializeSessionPOSIX();
+    const int connect_ret_code = initializeSessionPOSIX();
 #endif
+    SMTPCLIENT_PROBE2(connect__done, mSessionId, connect_ret_code);
+    return connect_ret_code;
 }
 
 #ifdef _WIN32
@@ -393,6 +644,7 @@ int SMTPClientBase::initializeSessionWinSock() {
     std::stringstream ss;
     ss << "Trying to connect to " << getServerName() << " on port " << getServerPort();
     addCommunicationLogItem(ss.str().c_str());
+    beginPhase(SendPhase::Connect);
     wsa_retVal = connect(mSock, result->ai_addr, static_cast<int>(result->ai_addrlen));
     if (wsa_retVal == SOCKET_ERROR) {
         int wsa_error = WSAGetLastError();
@@ -468,6 +720,7 @@ int SMTPClientBase::initializeSessionPOSIX() {
     std::stringstream ss;
     ss << "Trying to connect to " << getServerName() << " on port " << getServerPort();
     addCommunicationLogItem(ss.str().c_str());
+    beginPhase(SendPhase::Connect);
     int res = connect(mSock, reinterpret_cast<struct sockaddr*>(&saddr_in), sizeof(saddr_in));
     if (res < 0) {
         if (errno == EINPROGRESS) {
@@ -546,26 +799,41 @@ int SMTPClientBase::setSocketToBlockingPOSIX() {
 #endif
 
 int SMTPClientBase::sendServerIdentification() {
+    beginPhase(SendPhase::Hello);
     std::string ehlo { "ehlo localhost\r\n" };
     addCommunicationLogItem(ehlo.c_str());
-    return sendRawCommand(ehlo.c_str(),
+    int ehlo_return_code = sendRawCommand(ehlo.c_str(),
             SOCKET_INIT_CLIENT_SEND_EHLO_ERROR,
             SOCKET_INIT_CLIENT_SEND_EHLO_TIMEOUT);
+    if (ehlo_return_code == STATUS_CODE_REQUESTED_MAIL_ACTION_OK_OR_COMPLETED) {
+        auto *options = new ServerAuthOptions();
+        parseEhloResponse(getLastServerResponse(), options);
+        setAuthenticationOptions(options);
+    }
+    return ehlo_return_code;
 }
 
 int SMTPClientBase::checkServerGreetings() {
+    beginPhase(SendPhase::Greeting);
+    const auto start_time = startCommandTimer();
     char outbuf[SERVERRESPONSE_BUFFER_LENGTH];
     unsigned int waitTime = 0;
     ssize_t bytes_received = 0;
-    while ((bytes_received = recv(mSock, outbuf, SERVERRESPONSE_BUFFER_LENGTH, 0)) <= 0
+    while ((bytes_received = trackRead(recv(mSock, outbuf, SERVERRESPONSE_BUFFER_LENGTH, 0))) <= 0
             && waitTime < mCommandTimeOut) {
+        if (bytes_received == 0) {
+            // The server closed the connection
+            return SOCKET_INIT_SESSION_CONNECT_ERROR;
+        }
         sleep(1);
         waitTime += 1;
     }
     if (waitTime < mCommandTimeOut) {
         outbuf[bytes_received-1] = '\0';
+        recordCommandLatency(SMTPCommand::Greeting, start_time);
         addCommunicationLogItem(outbuf, "s");
         int status_code = extractReturnCode(outbuf);
+        SMTPCLIENT_PROBE3(reply__parsed, mSessionId, status_code, outbuf);
         if (status_code == STATUS_CODE_SERVICE_READY) {
             addCommunicationLogItem("Connected!");
         }
@@ -584,7 +852,7 @@ int SMTPClientBase::sendRawCommand(const char *pCommand, int pErrorCode) {
 #else
     size_t commandSize = strlen(pCommand);
 #endif
-    if (send(mSock, pCommand, commandSize, 0) == -1) {
+    if (trackWrite(send(mSock, pCommand, commandSize, 0)) == -1) {
         setLastSocketErrNo(errno);
         cleanup();
         return pErrorCode;
@@ -596,19 +864,29 @@ int SMTPClientBase::sendRawCommand(const char *pCommand, int pErrorCode, int pTi
     char outbuf[SERVERRESPONSE_BUFFER_LENGTH];
     unsigned int waitTime {0};
     ssize_t bytes_received {0};
+    const auto start_time = startCommandTimer();
+    SMTPCLIENT_PROBE2(command__sent, mSessionId, pCommand);
     if (sendRawCommand(pCommand, pErrorCode) != 0) {
         return pErrorCode;
     }
 
-    while ((bytes_received = recv(mSock, outbuf, SERVERRESPONSE_BUFFER_LENGTH, 0)) <= 0 && waitTime < mCommandTimeOut) {
+    while ((bytes_received = trackRead(recv(mSock, outbuf, SERVERRESPONSE_BUFFER_LENGTH, 0))) <= 0 && waitTime < mCommandTimeOut) {
+        if (bytes_received == 0) {
+            // The server closed the connection, waiting cannot help
+            cleanup();
+            return pErrorCode;
+        }
         sleep(1);
         waitTime += 1;
     }
     if (waitTime < mCommandTimeOut) {
         outbuf[bytes_received-1] = '\0';
+        recordCommandLatency(MetricsRegistry::getCommand(pCommand), start_time);
         setLastServerResponse(outbuf);
         addCommunicationLogItem(outbuf, "s");
-        return extractReturnCode(outbuf);
+        const int reply_code = extractReturnCode(outbuf);
+        SMTPCLIENT_PROBE3(reply__parsed, mSessionId, reply_code, outbuf);
+        return reply_code;
     }
 
     cleanup();
@@ -625,10 +903,11 @@ void SMTPClientBase::setLastServerResponse(const char *pResponse) {
 
 int SMTPClientBase::authenticateClient() {
     if (mCredential != nullptr) {
-        if (mAuthOptions->Plain) {
+        beginPhase(SendPhase::Authentication);
+        if (mAuthOptions != nullptr && mAuthOptions->Plain) {
             return authenticateWithMethodPlain();
         }
-        if (mAuthOptions->Login) {
+        if (mAuthOptions != nullptr && mAuthOptions->Login) {
             return authenticateWithMethodLogin();
         }
         return CLIENT_AUTHENTICATION_METHOD_NOTSUPPORTED;
@@ -680,7 +959,21 @@ int SMTPClientBase::setMailRecipients(const Message &pMsg) {
 
     const int SENDER_OK { 250 };
     const int RECIPIENT_OK { 250 };
-    std::string mailFormat = "MAIL FROM: <"s + pMsg.getFrom().getEmailAddress() + ">\r\n";
+    std::string mailFormat = "MAIL FROM: <"s + pMsg.getFrom().getEmailAddress() + ">";
+    const ServerAuthOptions *options = getAuthenticationOptions();
+    const bool eight_bit_mime = options != nullptr && options->EightBitMime;
+    if (options != nullptr && options->Size) {
+        // Declare the size (RFC 1870) and spare the transfer of a message
+        // the server would refuse anyway
+        const size_t message_size = MessageRenderer::computeSize(pMsg, eight_bit_mime, mDKIMSigner.get());
+        if (options->MaxMessageSize > 0 && message_size > options->MaxMessageSize) {
+            addCommunicationLogItem("Error: The message exceeds the maximum size accepted by the server.");
+            return CLIENT_SENDMAIL_MESSAGE_TOO_LARGE;
+        }
+        mailFormat += " SIZE=" + std::to_string(message_size);
+    }
+    mailFormat += MessageRenderer::renderMailFromParameters(pMsg, options);
+    mailFormat += "\r\n";
 
     addCommunicationLogItem(mailFormat.c_str());
     int mail_from_ret_code = (*this.*sendCommandWithFeedbackPtr)(mailFormat.c_str(), CLIENT_SENDMAIL_MAILFROM_ERROR, CLIENT_SENDMAIL_MAILFROM_TIMEOUT);
@@ -730,102 +1023,206 @@ int SMTPClientBase::setMailHeaders(const Message &pMsg) {
         return data_ret_code;
     }
 
+    // A signed message is sent at once with its headers (see setMailBody)
+    if (MessageRenderer::isSigned(pMsg, mDKIMSigner.get())) {
+        return 0;
+    }
+
     // Mail headers
-    // From
-    std::string from_header =  "\"" + std::string(pMsg.getFrom().getDisplayName()) + "\" <" + pMsg.getFrom().getEmailAddress() + ">";
-    int header_from_ret_code = addMailHeader("From", from_header.c_str() , CLIENT_SENDMAIL_HEADERFROM_ERROR);
-    if (header_from_ret_code != 0) {
-        return header_from_ret_code;
-    }
-
-    // To and Cc.
-    // Note : Bcc are not included in the header
-    std::vector<std::tuple<MessageAddress **, size_t, const char *>> recipients {
-        std::tuple<MessageAddress **, size_t, const char *>(pMsg.getTo(), pMsg.getToCount(), "To"),
-            std::tuple<MessageAddress **, size_t, const char *>(pMsg.getCc(), pMsg.getCcCount(), "Cc")
-    };
-    for (const auto &item : recipients) {
-        MessageAddress **list = std::get<0>(item);
-        size_t count = std::get<1>(item);
-        const char *field = std::get<2>(item);
-        if (list != nullptr) {
-            std::for_each(list, list + count, [this, &field](MessageAddress *address) {
-                    return addMailHeader(field, address->getEmailAddress(), CLIENT_SENDMAIL_HEADERTOANDCC_ERROR);
-                    });
-        }
+    std::string headers { MessageRenderer::renderHeaders(pMsg) };
+    addCommunicationLogItem(headers.c_str(), "c", CommunicationLogLevel::Headers);
+    std::string stuffed_headers;
+    stuffed_headers.reserve(headers.length());
+    DataStuffer().write(headers.data(), headers.length(), stuffed_headers);
+    int headers_ret_code = (*this.*sendCommandPtr)(stuffed_headers.c_str(), CLIENT_SENDMAIL_HEADERS_ERROR);
+    if (headers_ret_code != 0) {
+        return headers_ret_code;
     }
 
-    // Subject
-    std::stringstream ss_header_subject;
-    ss_header_subject << "Subject: " << pMsg.getSubject() << "\r\n";
-    addCommunicationLogItem(ss_header_subject.str().c_str());
-    int header_subject_ret_code = (*this.*sendCommandPtr)(ss_header_subject.str().c_str(), CLIENT_SENDMAIL_HEADERSUBJECT_ERROR);
-    if (header_subject_ret_code != 0) {
-        return header_subject_ret_code;
+    return 0;
+}
+
+int SMTPClientBase::setMailBody(const Message &pMsg) {
+    const ServerAuthOptions *options = getAuthenticationOptions();
+    const bool eight_bit_mime = options != nullptr && options->EightBitMime;
+    std::string body_real;
+    if (MessageRenderer::isSigned(pMsg, mDKIMSigner.get())) {
+        // The signature precedes the headers and covers the body, so the
+        // whole content is rendered before it is sent. The pre-encoded
+        // attachment files are read instead of being sent with sendFile,
+        // which leaves out sendfile and the kernel TLS offload.
+        std::string signature_field;
+        body_real = MessageRenderer::render(pMsg, eight_bit_mime, mDKIMSigner.get(), signature_field);
+        if (isLogEnabled(CommunicationLogLevel::Headers)) {
+            addCommunicationLogItem((signature_field + body_real.substr(0, body_real.find("\r\n\r\n") + 2)).c_str(), "c", CommunicationLogLevel::Headers);
+        }
+        // Sent on its own instead of being inserted before the content
+        int signature_ret_code = sendBodyContent(signature_field);
+        if (signature_ret_code != 0) {
+            return signature_ret_code;
+        }
+    } else {
+        int serialize_ret_code = serializeMailBody(pMsg, eight_bit_mime, body_real);
+        if (serialize_ret_code != 0) {
+            return serialize_ret_code;
+        }
     }
 
-    // Content-Type
-    std::string content_type { "Content-Type: multipart/mixed; boundary=sep\r\n\r\n" };
-    addCommunicationLogItem(content_type.c_str());
-    int header_content_type_ret_code = (*this.*sendCommandPtr)(content_type.c_str(), CLIENT_SENDMAIL_HEADERCONTENTTYPE_ERROR);
-    if (header_content_type_ret_code != 0) {
-        return header_content_type_ret_code;
+    int body_ret_code = sendBodyContent(body_real);
+    if (body_ret_code != 0) {
+        return body_ret_code;
     }
 
+    // End of data
+    beginPhase(SendPhase::FinalReply);
+    std::string end_data_command { "\r\n.\r\n" };
+    addCommunicationLogItem(end_data_command.c_str());
+    int end_data_ret_code = (*this.*sendCommandWithFeedbackPtr)(end_data_command.c_str(), CLIENT_SENDMAIL_END_DATA_ERROR, CLIENT_SENDMAIL_END_DATA_TIMEOUT);
+    if (mSendReport != nullptr && getLastServerResponse() != nullptr) {
+        mSendReport->FinalReply = getLastServerResponse();
+        mSendReport->QueueId = SendReport::extractQueueId(getLastServerResponse());
+    }
+    if (end_data_ret_code != STATUS_CODE_REQUESTED_MAIL_ACTION_OK_OR_COMPLETED) {
+        return end_data_ret_code;
+    }
     return 0;
 }
 
-int SMTPClientBase::addMailHeader(const char *field, const char *value, int pErrorCode) {
-    std::stringstream ss_header_item;
-    ss_header_item << field << ": " << value << "\r\n";
-    addCommunicationLogItem(ss_header_item.str().c_str());
-    return (*this.*sendCommandPtr)(ss_header_item.str().c_str(), pErrorCode);
-}
-
-int SMTPClientBase::setMailBody(const Message &pMsg) {
-    // Body part
-    std::ostringstream body_ss;
-    body_ss << "--sep\r\nContent-Type: " << pMsg.getMimeType() << "; charset=UTF-8\r\n\r\n" << pMsg.getBody() << "\r\n";
-    std::string body_real = body_ss.str();
-    addCommunicationLogItem(body_real.c_str());
+int SMTPClientBase::serializeMailBody(const Message &pMsg, bool pEightBitMime, std::string &pOutput) {
+    const MimePart root { MessageRenderer::buildMimeTree(pMsg, pEightBitMime) };
+    pOutput.reserve(root.getSize());
 
-    // If there's attachments, prepare the attachments text content
-    Attachment** arr_attachment = pMsg.getAttachments();
-
-    std::vector<Attachment*> vect_attachment(arr_attachment, arr_attachment + pMsg.getAttachmentsCount());
-    if (pMsg.getAttachmentsCount() > 0) {
-        std::string attachments_text = createAttachmentsText(vect_attachment);
-        body_real += attachments_text;
+    // The texts are logged, not the content of the attachments
+    bool is_logged = false;
+    auto attachment_writer = [this, &is_logged](std::string &pBuffer, const Attachment &pAttachment) {
+        if (!is_logged) {
+            addCommunicationLogItem(pBuffer.c_str(), "c", CommunicationLogLevel::Full);
+            is_logged = true;
+        }
+        if (pAttachment.getEncodedFilename() != nullptr) {
+            // The pre-encoded content goes straight from the file
+            int content_ret_code = sendBodyContent(pBuffer);
+            if (content_ret_code != 0) {
+                return content_ret_code;
+            }
+            pBuffer.clear();
+            return sendFile(pAttachment.getEncodedFilename(), CLIENT_SENDMAIL_BODYPART_ERROR);
+        }
+        const char *encoded_file = pAttachment.getBase64EncodedFile();
+        if (encoded_file != nullptr) {
+            pBuffer += encoded_file;
+            delete[] encoded_file;
+        }
+        return 0;
+    };
+    int serialize_ret_code = root.serialize(pOutput, attachment_writer);
+    if (serialize_ret_code == 0 && !is_logged) {
+        addCommunicationLogItem(pOutput.c_str(), "c", CommunicationLogLevel::Full);
     }
+    return serialize_ret_code;
+}
 
+int SMTPClientBase::sendBodyContent(const std::string &pContent) {
     const size_t CHUNK_MAXLENGTH = 512;
-    if (body_real.length() > CHUNK_MAXLENGTH) {
+    // Each piece of the body starts a line or with CRLF, so the stuffer
+    // starts anew for each of them
+    std::string stuffed_content;
+    stuffed_content.reserve(pContent.length());
+    DataStuffer().write(pContent.data(), pContent.length(), stuffed_content);
+    if (stuffed_content.length() > CHUNK_MAXLENGTH) {
         // Split into chunk
-        for (size_t index_start = 0; index_start < body_real.length(); index_start += CHUNK_MAXLENGTH) {
+        for (size_t index_start = 0; index_start < stuffed_content.length(); index_start += CHUNK_MAXLENGTH) {
             size_t length = CHUNK_MAXLENGTH;
-            if (index_start + CHUNK_MAXLENGTH > body_real.length() - 1) {
-                length = body_real.length() - index_start;
+            if (index_start + CHUNK_MAXLENGTH > stuffed_content.length() - 1) {
+                length = stuffed_content.length() - index_start;
             }
-            int body_part_ret_code = (*this.*sendCommandPtr)(body_real.substr(index_start, length).c_str(), CLIENT_SENDMAIL_BODYPART_ERROR);
+            int body_part_ret_code = (*this.*sendCommandPtr)(stuffed_content.substr(index_start, length).c_str(), CLIENT_SENDMAIL_BODYPART_ERROR);
             if (body_part_ret_code != 0) {
                 return body_part_ret_code;
             }
+            SMTPCLIENT_PROBE2(data__chunk, mSessionId, length);
         }
-    } else {
-        int body_ret_code = (*this.*sendCommandPtr)(body_real.c_str(), CLIENT_SENDMAIL_BODY_ERROR);
+    } else if (!stuffed_content.empty()) {
+        int body_ret_code = (*this.*sendCommandPtr)(stuffed_content.c_str(), CLIENT_SENDMAIL_BODY_ERROR);
         if (body_ret_code != 0) {
             return body_ret_code;
         }
+        SMTPCLIENT_PROBE2(data__chunk, mSessionId, stuffed_content.length());
     }
+    return 0;
+}
 
-    // End of data
-    std::string end_data_command { "\r\n.\r\n" };
-    addCommunicationLogItem(end_data_command.c_str());
-    int end_data_ret_code = (*this.*sendCommandWithFeedbackPtr)(end_data_command.c_str(), CLIENT_SENDMAIL_END_DATA_ERROR, CLIENT_SENDMAIL_END_DATA_TIMEOUT);
-    if (end_data_ret_code != STATUS_CODE_REQUESTED_MAIL_ACTION_OK_OR_COMPLETED) {
-        return end_data_ret_code;
+int SMTPClientBase::sendFile(const char *pFilename, int pErrorCode) {
+#ifdef __linux__
+    // The plain socket can send the file without copying it in user space
+    int file_descriptor = open(pFilename, O_RDONLY | O_CLOEXEC);
+    if (file_descriptor < 0) {
+        setLastSocketErrNo(errno);
+        return CLIENT_SENDMAIL_ENCODED_FILE_ERROR;
+    }
+    struct stat file_status {};
+    if (fstat(file_descriptor, &file_status) != 0) {
+        setLastSocketErrNo(errno);
+        close(file_descriptor);
+        return CLIENT_SENDMAIL_ENCODED_FILE_ERROR;
     }
+    off_t offset = 0;
+    while (offset < file_status.st_size) {
+        ssize_t bytes_sent = trackWrite(sendfile(mSock, file_descriptor, &offset, static_cast<size_t>(file_status.st_size - offset)));
+        if (bytes_sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_sent <= 0) {
+            setLastSocketErrNo(errno);
+            close(file_descriptor);
+            return pErrorCode;
+        }
+        SMTPCLIENT_PROBE2(data__chunk, mSessionId, bytes_sent);
+    }
+    close(file_descriptor);
+    return 0;
+#else
+    return sendFileContent(pFilename, pErrorCode);
+#endif
+}
+
+int SMTPClientBase::sendFileContent(const char *pFilename, int pErrorCode) {
+    std::ifstream in(pFilename, std::ios::in | std::ios::binary);
+    if (!in) {
+        return CLIENT_SENDMAIL_ENCODED_FILE_ERROR;
+    }
+    const size_t CHUNK_MAXLENGTH = 65536;
+    std::string chunk(CHUNK_MAXLENGTH, '\0');
+    while (in) {
+        in.read(&chunk[0], static_cast<std::streamsize>(CHUNK_MAXLENGTH));
+        const auto length = static_cast<size_t>(in.gcount());
+        if (length == 0) {
+            break;
+        }
+        int chunk_ret_code = (*this.*sendCommandPtr)(chunk.substr(0, length).c_str(), pErrorCode);
+        if (chunk_ret_code != 0) {
+            return chunk_ret_code;
+        }
+        SMTPCLIENT_PROBE2(data__chunk, mSessionId, length);
+    }
+    return 0;
+}
 
+int SMTPClientBase::resetMailTransaction() {
+    // Each message of a kept alive connection gets its own communication log
+    mCommunicationLog.clear();
+    beginPhase(SendPhase::Reset);
+    std::string rset_command { "RSET\r\n" };
+    addCommunicationLogItem(rset_command.c_str());
+    int rset_ret_code = (*this.*sendCommandWithFeedbackPtr)(rset_command.c_str(), CLIENT_SENDMAIL_RSET_ERROR, CLIENT_SENDMAIL_RSET_TIMEOUT);
+    if (rset_ret_code != STATUS_CODE_REQUESTED_MAIL_ACTION_OK_OR_COMPLETED) {
+        return rset_ret_code;
+    }
+    return 0;
+}
+
+int SMTPClientBase::sendQuitCommand() {
+    beginPhase(SendPhase::Quit);
     std::string quit_command { "QUIT\r\n" };
     addCommunicationLogItem(quit_command.c_str());
     int quit_ret_code = (*this.*sendCommandPtr)(quit_command.c_str(), CLIENT_SENDMAIL_QUIT_ERROR);
@@ -835,50 +1232,84 @@ int SMTPClientBase::setMailBody(const Message &pMsg) {
     return 0;
 }
 
-void SMTPClientBase::addCommunicationLogItem(const char *pItem, const char *pPrefix) {
-    std::string item { pItem };
-    if (strcmp(pPrefix, "c") == 0) {
-        /* Replace the \ by \\ */
-        const std::string FROM { "\r\n" };
-        const std::string TO { "\\r\\n" };
-        size_t start_pos = 0;
-        while ((start_pos = item.find(FROM, start_pos)) != std::string::npos) {
-            item.replace(start_pos, FROM.length(), TO);
-            start_pos += TO.length();  // Handles case where 'to' is a substring of 'from'
-        }
-    }
-    const std::string ENDOFLINE { "\n" };
-    const std::string SEPARATOR { ": " };
-    size_t currentLogSize = strlen(mCommunicationLog);
-    size_t appendSize = ENDOFLINE.length() + strlen(pPrefix) + SEPARATOR.length() + item.length() + 1;
-    if (mCommunicationLogSize - currentLogSize <= appendSize) {
-        size_t newSize = currentLogSize + appendSize + INITIAL_COMM_LOG_LENGTH;
-        char *newBuffer = new char[newSize];
-        std::strncpy(newBuffer, mCommunicationLog, currentLogSize);
-        newBuffer[currentLogSize] = '\0';
-        mCommunicationLogSize = newSize;
-        char *tmpBuffer = mCommunicationLog;
-        mCommunicationLog = newBuffer;
-        delete [] tmpBuffer;
-    }
-    strncat(mCommunicationLog, ENDOFLINE.c_str(), mCommunicationLogSize-1);
-    strncat(mCommunicationLog, pPrefix, mCommunicationLogSize-1);
-    strncat(mCommunicationLog, SEPARATOR.c_str(), mCommunicationLogSize-1);
-    strncat(mCommunicationLog, item.c_str(), mCommunicationLogSize-1);
-    mCommunicationLog[mCommunicationLogSize-1] = '\0';
+void SMTPClientBase::addCommunicationLogItem(const char *pItem, const char *pPrefix, CommunicationLogLevel pLevel) {
+    const bool is_client_item = strcmp(pPrefix, "c") == 0;
+    if (mCommunicationLog.isEnabled(pLevel)) {
+        // The line breaks of the client items are written as \r\n
+        mCommunicationLog.add(pItem, pPrefix, is_client_item);
+    }
+    if (mLogSink && mLogSink->isEnabled(pLevel)) {
+        LogEvent event;
+        event.Timestamp = std::chrono::system_clock::now();
+        event.SessionId = mSessionId;
+        event.Level = pLevel;
+        if (is_client_item) {
+            event.Direction = LogDirection::Client;
+        } else if (strcmp(pPrefix, "s") == 0) {
+            event.Direction = LogDirection::Server;
+            event.ReplyCode = parseReplyCode(pItem);
+        }
+        if (pItem != nullptr) {
+            event.Text = pItem;
+        }
+        mLogSink->write(event);
+    }
 }
 
-std::string SMTPClientBase::createAttachmentsText(const std::vector<Attachment*> &pAttachments) {
-    std::string retval;
-    for (const auto &item : pAttachments) {
-        retval += "\r\n--sep\r\n";
-        retval += "Content-Type: " + std::string(item->getMimeType()) + "; file=\"" + std::string(item->getName()) + "\"\r\n";
-        retval += "Content-Disposition: Inline; filename=\"" + std::string(item->getName()) + "\"\r\n";
-        retval += "Content-Transfer-Encoding: base64\r\n\r\n";
-        retval += std::string((item->getBase64EncodedFile() != nullptr ? item->getBase64EncodedFile() : ""));
+bool SMTPClientBase::isLogEnabled(CommunicationLogLevel pLevel) const {
+    return mCommunicationLog.isEnabled(pLevel) || (mLogSink && mLogSink->isEnabled(pLevel));
+}
+
+std::chrono::steady_clock::time_point SMTPClientBase::startCommandTimer() const {
+    return mMetrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+
+void SMTPClientBase::recordCommandLatency(SMTPCommand pCommand, std::chrono::steady_clock::time_point pStartTime) {
+    if (mMetrics) {
+        mMetrics->recordCommand(pCommand,
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - pStartTime));
+    }
+}
+
+void SMTPClientBase::recordTLSHandshake(bool pResumed) {
+    if (mMetrics) {
+        mMetrics->recordTLSHandshake(pResumed);
+    }
+}
+
+SendReport *SMTPClientBase::getSendReport() const {
+    return mSendReport;
+}
+
+void SMTPClientBase::beginPhase(SendPhase pPhase) {
+    if (mSendReport == nullptr || (mPhaseRunning && mRunningPhase == pPhase)) {
+        return;
+    }
+    endPhase();
+    SendPhaseTiming &timing = mSendReport->Phases[static_cast<size_t>(pPhase)];
+    const auto now = std::chrono::steady_clock::now();
+    if (timing.Start == std::chrono::steady_clock::time_point()) {
+        timing.Start = now;
+    }
+    timing.End = now;
+    mRunningPhase = pPhase;
+    mPhaseRunning = true;
+}
+
+void SMTPClientBase::endPhase() {
+    if (mSendReport == nullptr || !mPhaseRunning) {
+        return;
     }
-    retval += "\r\n--sep--";
-    return retval;
+    SendPhaseTiming &timing = mSendReport->Phases[static_cast<size_t>(mRunningPhase)];
+    const auto now = std::chrono::steady_clock::now();
+    // End holds the start of the current run until the phase ends
+    timing.Duration += std::chrono::duration_cast<std::chrono::microseconds>(now - timing.End);
+    timing.End = now;
+    mPhaseRunning = false;
+}
+
+std::string SMTPClientBase::createAttachmentsText(const std::vector<Attachment*> &pAttachments) {
+    return MessageRenderer::renderAttachments(pAttachments);
 }
 
 int SMTPClientBase::extractReturnCode(const char *pOutput) {
@@ -895,47 +1326,33 @@ int SMTPClientBase::extractReturnCode(const char *pOutput) {
 }
 
 ServerAuthOptions *SMTPClientBase::extractAuthenticationOptions(const char *pEhloOutput) {
-    ServerAuthOptions *retVal = nullptr;
-    const std::string AUTH_LINE_PREFIX = "250-AUTH";
-    if (pEhloOutput == nullptr) {
-        return retVal;
-    }
-    const std::string DELIMITER { "\r\n" };
-    std::string ehlo_output { pEhloOutput };
-    size_t ehlo_character_index { 0 };
-    while ((ehlo_character_index = ehlo_output.find(DELIMITER)) != std::string::npos) {
-        std::string line { ehlo_output.substr(0, ehlo_character_index)};
-        // Find the line that begin with 250-AUTH
-        if (line.substr(0, AUTH_LINE_PREFIX.length()) == AUTH_LINE_PREFIX) {
-            retVal = new ServerAuthOptions();
-            // Find each options
-            std::vector<std::string> options;
-            size_t line_character_index { 0 };
-            while ((line_character_index = line.find(' ')) != std::string::npos) {
-                std::string option { line.substr(0, line_character_index)};
-                options.push_back(option);
-                line.erase(0, line_character_index + 1);
-            }
-            options.push_back(line);
-            // Try to match the string options with the ServerAuthOptions struct attributes
-            for_each(options.begin(), options.end(), [&retVal](const std::string &option) {
-                if (option == "PLAIN") {
-                    retVal->Plain = true;
-                } else if (option == "LOGIN") {
-                    retVal->Login = true;
-                } else if (option == "XOAUTH2") {
-                    retVal->XOAuth2 = true;
-                } else if (option == "PLAIN-CLIENTTOKEN") {
-                    retVal->Plain_ClientToken = true;
-                } else if (option == "OAUTHBEARER") {
-                    retVal->OAuthBearer = true;
-                } else if (option == "XOAUTH") {
-                    retVal->XOAuth = true;
-                }
-                });
-            break;
+    ServerAuthOptions options;
+    if (!parseEhloResponse(pEhloOutput, &options) || !options.Auth) {
+        return nullptr;
+    }
+    return new ServerAuthOptions(options);
+}
+
+bool SMTPClientBase::parseEhloResponse(const char *pEhloOutput, ServerAuthOptions *pOptions) {
+    if (pEhloOutput == nullptr || pOptions == nullptr) {
+        return false;
+    }
+    bool has_reply_line = false;
+    const char *line = pEhloOutput;
+    while (*line != '\0') {
+        const char *line_end = line;
+        while (*line_end != '\0' && *line_end != '\r' && *line_end != '\n') {
+            line_end++;
+        }
+        // 250-KEYWORD, or 250 KEYWORD on the last line
+        if (line_end - line >= 4 && strncmp(line, "250", 3) == 0 && (line[3] == '-' || line[3] == ' ')) {
+            has_reply_line = true;
+            parseEhloLine(line + 4, line_end, *pOptions);
+        }
+        line = line_end;
+        while (*line == '\r' || *line == '\n') {
+            line++;
         }
-        ehlo_output.erase(0, ehlo_character_index + DELIMITER.length());
     }
-    return retVal;
+    return has_reply_line;
 }
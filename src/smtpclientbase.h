@@ -1,14 +1,21 @@
 #ifndef SMTPCLIENTBASE_H
 #define SMTPCLIENTBASE_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
 #include "attachment.h"
+#include "communicationlog.h"
 #include "credential.h"
+#include "dkimsigner.h"
 #include "htmlmessage.h"
+#include "logsink.h"
 #include "messageaddress.h"
+#include "metricsregistry.h"
 #include "plaintextmessage.h"
+#include "sendreport.h"
 #include "serverauthoptions.h"
 
 #ifdef _WIN32
@@ -21,9 +28,6 @@
     #define SMTPCLIENTBASE_API
 #endif
 
-/** The max length of the communication log */
-#define INITIAL_COMM_LOG_LENGTH 4096
-
 /** The max length of the server response buffer */
 #define SERVERRESPONSE_BUFFER_LENGTH 1024
 
@@ -66,9 +70,31 @@ class SMTPCLIENTBASE_API SMTPClientBase {
     /** Return the command timeout in seconds. */
     unsigned int getCommandTimeout() const;
 
-    /** Return the communication log produced by the sendMail method. */
+    /** Return the communication log produced by the sendMail method. It
+     *  stays valid until the next call of a method of the client. */
     const char *getCommunicationLog() const;
 
+    /** Return the level of the items kept in the communication log. */
+    CommunicationLogLevel getCommunicationLogLevel() const;
+
+    /**
+     *  @brief  Set the level of the items kept in the communication log.
+     *  @param pLevel The level, Full by default. Off disables the log.
+     */
+    void setCommunicationLogLevel(CommunicationLogLevel pLevel);
+
+    /** Return the maximum size of the communication log in bytes, 0 if
+     *  unbounded. */
+    size_t getCommunicationLogMaxSize() const;
+
+    /**
+     *  @brief  Set the maximum size of the communication log. The oldest
+     *  items are dropped when it is exceeded.
+     *  @param pMaxSize The maximum size in bytes (1 MiB by default), 0 for
+     *  an unbounded log.
+     */
+    void setCommunicationLogMaxSize(size_t pMaxSize);
+
     /** Return the credentials configured. */
     const Credential *getCredentials() const;
 
@@ -110,6 +136,76 @@ class SMTPCLIENTBASE_API SMTPClientBase {
      */
     void setKeepUsingBaseSendCommands(bool pValue);
 
+    /** Return true if the base send commands are used even by a child class
+     *  (see setKeepUsingBaseSendCommands). */
+    bool getKeepUsingBaseSendCommands() const;
+
+    /** Return true if the connection is kept open between sendMail calls. */
+    bool getKeepAlive() const;
+
+    /**
+     *  @brief  Indicate if the connection must be kept open after a message
+     *  is sent.
+     *
+     *  When enabled, sendMail does not send QUIT at the end of a message.
+     *  The next call resets the session with RSET and reuses the connection
+     *  (or reconnects if the server closed it). Call disconnect() to close
+     *  the connection.
+     *  @param pValue True to keep the connection open, false for the default
+     */
+    void setKeepAlive(bool pValue);
+
+    /** Return the DKIM signer of the messages or null. */
+    std::shared_ptr<DKIMSigner> getDKIMSigner() const;
+
+    /**
+     *  @brief  Set the DKIM signer of the messages. A message is signed when
+     *  the signer has a key for the domain of its sender. The content of a
+     *  signed message is rendered in memory before it is sent, so its
+     *  pre-encoded attachment files are not sent with sendfile nor with the
+     *  kernel TLS offload (see Attachment::setEncodedFilename).
+     *  @param pSigner The signer, null to send the messages unsigned.
+     */
+    void setDKIMSigner(std::shared_ptr<DKIMSigner> pSigner);
+
+    /** Return the sink of the log events or null. */
+    std::shared_ptr<LogSink> getLogSink() const;
+
+    /**
+     *  @brief  Set the sink that receives the items of the communication log
+     *  as events, in addition to the communication log. The sink filters the
+     *  events with its own level.
+     *  @param pSink The sink, null to stop sending events. It can be shared
+     *  by several clients.
+     */
+    void setLogSink(std::shared_ptr<LogSink> pSink);
+
+    /** Return the identifier of the current or last connection of the client,
+     *  0 before the first one. It is unique in the process and it is the
+     *  SessionId of the log events. */
+    std::uint64_t getSessionId() const;
+
+    /** Return the registry of the metrics of the client or null. */
+    std::shared_ptr<MetricsRegistry> getMetricsRegistry() const;
+
+    /**
+     *  @brief  Set the registry that counts the messages, the bytes, the
+     *  errors, the connections and the latencies of the client.
+     *  @param pRegistry The registry, null to stop counting. It can be
+     *  shared by several clients.
+     */
+    void setMetricsRegistry(std::shared_ptr<MetricsRegistry> pRegistry);
+
+    /** Return true if a connection with the server is open. */
+    bool isConnected() const;
+
+    /**
+     *  @brief  Send QUIT and close the connection kept open by the keep
+     *  alive mode. Does nothing if no connection is open.
+     *  @return 0 for success, otherwise the error code of the QUIT command.
+     */
+    int disconnect();
+
     /**
      *  @brief  Retreive the error message string that correspond to
      *  the error code provided.
@@ -137,12 +233,37 @@ class SMTPCLIENTBASE_API SMTPClientBase {
 
     int sendMail(const Message &pMsg);
 
+    /**
+     *  @brief  Send a message and describe how it was sent.
+     *  @param pMsg The message.
+     *  @param pReport The report to fill: the time spent in each phase, the
+     *  bytes exchanged, the TLS resumption and the queue identifier given by
+     *  the server. Null to send without report, at no cost.
+     *  @return 0 for success, otherwise the error code.
+     */
+    int sendMail(const Message &pMsg, SendReport *pReport);
+
+    /**
+     *  @brief  Return the code of a server reply, or -1 if it has none.
+     *  @param pOutput The reply of the server.
+     */
+    static int extractReturnCode(const char *pOutput);
+
+    /**
+     *  @brief  Fill the options with the extensions of an EHLO reply.
+     *  @param pEhloOutput The reply of the server to EHLO.
+     *  @param pOptions The options to fill.
+     *  @return False if the reply or the options are null.
+     */
+    static bool parseEhloResponse(const char *pEhloOutput, ServerAuthOptions *pOptions);
+
  protected:
     virtual void cleanup() = 0;
     int getSocketFileDescriptor() const;
     void clearSocketFileDescriptor();
     const char *getLastServerResponse() const;
     void setLastSocketErrNo(int lastError);
+    const ServerAuthOptions *getAuthenticationOptions() const;
     void setAuthenticationOptions(ServerAuthOptions *authOptions);
     // Methods used to establish the connection with server
     int initializeSession();
@@ -174,25 +295,73 @@ class SMTPCLIENTBASE_API SMTPClientBase {
     int setMailRecipients(const Message &pMsg);
     int addMailRecipients(jed_utils::MessageAddress **list, size_t count, const int RECIPIENT_OK);
     int setMailHeaders(const Message &pMsg);
-    int addMailHeader(const char *field, const char *value, int pErrorCode);
     int setMailBody(const Message &pMsg);
+    int serializeMailBody(const Message &pMsg, bool pEightBitMime, std::string &pOutput);
+    int sendBodyContent(const std::string &pContent);
+    virtual int sendFile(const char *pFilename, int pErrorCode);
+    int sendFileContent(const char *pFilename, int pErrorCode);
+    int resetMailTransaction();
+    int sendQuitCommand();
 
-    void addCommunicationLogItem(const char *pItem, const char *pPrefix = "c");
+    void addCommunicationLogItem(const char *pItem,
+            const char *pPrefix = "c",
+            CommunicationLogLevel pLevel = CommunicationLogLevel::Commands);
+    bool isLogEnabled(CommunicationLogLevel pLevel) const;
+    // The send report, null unless sendMail was given one
+    SendReport *getSendReport() const;
+    // Start a phase of the report and end the running one
+    void beginPhase(SendPhase pPhase);
+    void endPhase();
+    // Measure the latency of a reply for the metrics
+    std::chrono::steady_clock::time_point startCommandTimer() const;
+    void recordCommandLatency(SMTPCommand pCommand, std::chrono::steady_clock::time_point pStartTime);
+    void recordTLSHandshake(bool pResumed);
+    // Count an I/O call of the report and return its result
+    template<typename T>
+    T trackRead(T pResult) {
+        if (mSendReport != nullptr) {
+            mSendReport->ReadCallCount++;
+            if (pResult > 0) {
+                mSendReport->BytesRead += static_cast<size_t>(pResult);
+            }
+        }
+        return pResult;
+    }
+    template<typename T>
+    T trackWrite(T pResult) {
+        if (mSendReport != nullptr) {
+            mSendReport->WriteCallCount++;
+            if (pResult > 0) {
+                mSendReport->BytesWritten += static_cast<size_t>(pResult);
+            }
+        }
+        return pResult;
+    }
     static std::string createAttachmentsText(const std::vector<Attachment*> &pAttachments);
-    static int extractReturnCode(const char *pOutput);
     static ServerAuthOptions *extractAuthenticationOptions(const char *pEhloOutput);
 
  private:
+    int transmitMail(const Message &pMsg);
+
     char *mServerName;
     unsigned int mPort;
-    char *mCommunicationLog;
-    size_t mCommunicationLogSize = 0;
+    CommunicationLog mCommunicationLog;
     char *mLastServerResponse;
     unsigned int mCommandTimeOut;
     int mLastSocketErrNo;
     ServerAuthOptions *mAuthOptions;
     Credential *mCredential;
     int mSock = 0;
+    bool mKeepAlive = false;
+    std::shared_ptr<DKIMSigner> mDKIMSigner;
+    std::shared_ptr<LogSink> mLogSink;
+    std::uint64_t mSessionId = 0;
+    SendReport *mSendReport = nullptr;
+    std::shared_ptr<MetricsRegistry> mMetrics;
+    // The registry that counts the open connection, until it is closed
+    std::shared_ptr<MetricsRegistry> mOpenSessionMetrics;
+    bool mPhaseRunning = false;
+    SendPhase mRunningPhase = SendPhase::Resolve;
     #ifdef _WIN32
     bool mWSAStarted = false;
     #endif
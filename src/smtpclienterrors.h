@@ -14,6 +14,8 @@ const int CLIENT_SENDMAIL_RCPTTO_ERROR = -87;
 const int CLIENT_SENDMAIL_RCPTTO_TIMEOUT = -88;
 const int CLIENT_SENDMAIL_DATA_ERROR = -89;
 const int CLIENT_SENDMAIL_DATA_TIMEOUT = -90;
+// The headers are sent at once since 1.1.6, the next four codes are no
+// longer returned (see CLIENT_SENDMAIL_HEADERS_ERROR)
 const int CLIENT_SENDMAIL_HEADERFROM_ERROR = -91;
 const int CLIENT_SENDMAIL_HEADERTOANDCC_ERROR = -92;
 const int CLIENT_SENDMAIL_HEADERSUBJECT_ERROR = -93;
@@ -23,6 +25,12 @@ const int CLIENT_SENDMAIL_BODY_ERROR = -96;
 const int CLIENT_SENDMAIL_END_DATA_ERROR = -97;
 const int CLIENT_SENDMAIL_END_DATA_TIMEOUT = -98;
 const int CLIENT_SENDMAIL_QUIT_ERROR = -99;
+const int CLIENT_SENDMAIL_QUIT_TIMEOUT = -100;
+const int CLIENT_SENDMAIL_RSET_ERROR = -101;
+const int CLIENT_SENDMAIL_RSET_TIMEOUT = -102;
+const int CLIENT_SENDMAIL_ENCODED_FILE_ERROR = -103;
+const int CLIENT_SENDMAIL_MESSAGE_TOO_LARGE = -104;
+const int CLIENT_SENDMAIL_HEADERS_ERROR = -105;
 
 // SMTP standard error code
 const int SMTPSERVER_AUTHENTICATIONREQUIRED_ERROR = 530;
@@ -0,0 +1,390 @@
+#ifdef __linux__
+
+#include "smtpeventloop.h"
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "socketerrors.h"
+
+using namespace jed_utils;
+
+namespace {
+    const std::uint64_t WAKEUP_ID = 0;
+    const int MAX_EVENTS = 256;
+    const size_t READ_BUFFER_LENGTH = 65536;
+    const size_t TIMER_SLOT_COUNT = 1024;
+    const std::uint64_t TIMER_RESOLUTION_MS = 10;
+    const std::uint64_t RESOLVED_ADDRESS_TTL_MS = 60000;
+}  // namespace
+
+SMTPEventLoop::SMTPEventLoop(std::shared_ptr<TLSContext> pTLSContext)
+    : mEpoll(epoll_create1(EPOLL_CLOEXEC)),
+      mWakeup(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      mTLSContext(std::move(pTLSContext)),
+      mNextId(WAKEUP_ID + 1),
+      mReadBuffer(READ_BUFFER_LENGTH),
+      mTimers(TIMER_SLOT_COUNT, TIMER_RESOLUTION_MS, TimerWheel::getSteadyTimeMs()),
+      mStopRequested(false) {
+    if (mEpoll < 0 || mWakeup < 0) {
+        std::string error_message { strerror(errno) };
+        if (mEpoll >= 0) {
+            close(mEpoll);
+        }
+        if (mWakeup >= 0) {
+            close(mWakeup);
+        }
+        throw std::runtime_error("Unable to create the event loop: " + error_message);
+    }
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKEUP_ID;
+    epoll_ctl(mEpoll, EPOLL_CTL_ADD, mWakeup, &event);
+}
+
+SMTPEventLoop::~SMTPEventLoop() {
+    for (auto &item : mConnections) {
+        item.second.Session->onTransportError();
+        if (mSessionClosedHandler) {
+            mSessionClosedHandler(*item.second.Session);
+        }
+        close(item.second.Socket);
+    }
+    mConnections.clear();
+    close(mWakeup);
+    close(mEpoll);
+}
+
+SMTPSession *SMTPEventLoop::createSession(const SMTPSessionOptions &pOptions) {
+    SSL_CTX *ssl_context = pOptions.Security == SMTPSessionSecurity::None ? nullptr : getSSLContext();
+    const std::uint64_t id = mNextId++;
+    Connection &connection = mConnections[id];
+    connection.Session.reset(new SMTPSession(pOptions, ssl_context));
+    SMTPSession *session = connection.Session.get();
+    // The elements of the map keep their address until they are erased,
+    // along with the session and its handler
+    Connection *entry = &connection;
+    session->setActivityHandler([this, id, entry]() {
+            if (!entry->Dirty) {
+                entry->Dirty = true;
+                mDirty.push_back(id);
+            }
+            });
+
+    ResolvedAddress address {};
+    int resolve_ret_code = resolve(pOptions, address);
+    if (resolve_ret_code != 0) {
+        session->onTransportError(resolve_ret_code);
+        update(id);
+        return session;
+    }
+    connection.Socket = socket(address.Address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (connection.Socket < 0) {
+        session->onTransportError(SOCKET_INIT_SESSION_CREATION_ERROR);
+        update(id);
+        return session;
+    }
+    // Commands are small and latency bound
+    int no_delay = 1;
+    setsockopt(connection.Socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+    epoll_event event {};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.u64 = id;
+    if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, connection.Socket, &event) < 0) {
+        session->onTransportError(SOCKET_INIT_SESSION_CREATION_ERROR);
+        update(id);
+        return session;
+    }
+    if (::connect(connection.Socket, reinterpret_cast<const sockaddr *>(&address.Address), address.AddressLength) < 0
+        && errno != EINPROGRESS) {
+        session->onTransportError(SOCKET_INIT_SESSION_CONNECT_ERROR);
+    }
+    update(id);
+    return session;
+}
+
+void SMTPEventLoop::setSessionClosedHandler(SessionClosedHandler pHandler) {
+    mSessionClosedHandler = std::move(pHandler);
+}
+
+void SMTPEventLoop::post(std::function<void()> pTask) {
+    {
+        std::lock_guard<std::mutex> lock(mTasksMutex);
+        mTasks.push_back(std::move(pTask));
+    }
+    std::uint64_t value = 1;
+    if (write(mWakeup, &value, sizeof(value)) < 0) {
+        // The counter is already signaled, the loop will wake up anyway
+    }
+}
+
+int SMTPEventLoop::runOnce(int pTimeoutMs) {
+    int timeout = pTimeoutMs;
+    int next_timer = mTimers.getNextTimeoutMs(TimerWheel::getSteadyTimeMs());
+    if (next_timer >= 0 && (timeout < 0 || next_timer < timeout)) {
+        timeout = next_timer;
+    }
+    if (!mDirty.empty()) {
+        // Sessions were used since the last iteration, flush them now
+        timeout = 0;
+    }
+
+    epoll_event events[MAX_EVENTS];
+    int event_count = epoll_wait(mEpoll, events, MAX_EVENTS, timeout);
+    if (event_count < 0 && errno != EINTR) {
+        return -1;
+    }
+    for (int i = 0; i < event_count; i++) {
+        if (events[i].data.u64 == WAKEUP_ID) {
+            std::uint64_t value = 0;
+            if (read(mWakeup, &value, sizeof(value)) < 0) {
+                // Nothing to do, the counter was already reset
+            }
+            continue;
+        }
+        handleSocketEvent(events[i].data.u64, events[i].events);
+    }
+
+    runPostedTasks();
+
+    mExpired.clear();
+    const std::uint64_t now = TimerWheel::getSteadyTimeMs();
+    mTimers.advance(now, mExpired);
+    for (const auto &entry : mExpired) {
+        auto it = mConnections.find(entry.Key);
+        if (it == mConnections.end()) {
+            continue;
+        }
+        // The timer of the session is gone, update schedules the next one
+        it->second.ScheduledDeadline = 0;
+        const std::uint64_t deadline = it->second.Session->getDeadline();
+        if (deadline != 0 && deadline <= now) {
+            it->second.Session->onTimeout();
+        }
+        update(entry.Key);
+    }
+    // The completion handlers can use other sessions
+    updateDirtySessions();
+
+    std::vector<std::uint64_t> closing;
+    closing.swap(mClosing);
+    for (const auto id : closing) {
+        release(id);
+    }
+    return event_count < 0 ? 0 : event_count;
+}
+
+void SMTPEventLoop::run() {
+    mStopRequested = false;
+    while (!mStopRequested) {
+        if (runOnce(-1) < 0) {
+            break;
+        }
+    }
+}
+
+void SMTPEventLoop::stop() {
+    mStopRequested = true;
+    std::uint64_t value = 1;
+    if (write(mWakeup, &value, sizeof(value)) < 0) {
+        // The counter is already signaled, the loop will wake up anyway
+    }
+}
+
+size_t SMTPEventLoop::getSessionCount() const {
+    return mConnections.size();
+}
+
+int SMTPEventLoop::resolve(const SMTPSessionOptions &pOptions, ResolvedAddress &pResult) {
+    const std::string port { std::to_string(pOptions.Port) };
+    const std::string key { pOptions.ServerName + ":" + port };
+    const std::uint64_t now = TimerWheel::getSteadyTimeMs();
+    auto it = mResolvedAddresses.find(key);
+    if (it != mResolvedAddresses.end() && it->second.Expiry > now) {
+        pResult = it->second;
+        return 0;
+    }
+
+    addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(pOptions.ServerName.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr) {
+        return SOCKET_INIT_SESSION_GETHOSTBYNAME_ERROR;
+    }
+    memcpy(&pResult.Address, result->ai_addr, result->ai_addrlen);
+    pResult.AddressLength = result->ai_addrlen;
+    pResult.Expiry = now + RESOLVED_ADDRESS_TTL_MS;
+    freeaddrinfo(result);
+    mResolvedAddresses[key] = pResult;
+    return 0;
+}
+
+void SMTPEventLoop::handleSocketEvent(std::uint64_t pId, std::uint32_t pEvents) {
+    auto it = mConnections.find(pId);
+    if (it == mConnections.end()) {
+        return;
+    }
+    Connection &connection = it->second;
+    if (!connection.Connected) {
+        if ((pEvents & (EPOLLOUT | EPOLLERR | EPOLLHUP)) == 0) {
+            return;
+        }
+        int socket_error = 0;
+        socklen_t length = sizeof(socket_error);
+        if (getsockopt(connection.Socket, SOL_SOCKET, SO_ERROR, &socket_error, &length) < 0) {
+            connection.Session->onTransportError(SOCKET_INIT_SESSION_GET_SOCKET_OPTIONS_ERROR);
+        } else if (socket_error != 0) {
+            connection.Session->onTransportError(SOCKET_INIT_SESSION_DELAYED_CONNECTION_ERROR);
+        } else {
+            connection.Connected = true;
+            connection.Session->onConnected();
+        }
+        update(pId);
+        return;
+    }
+    if ((pEvents & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0) {
+        receive(connection);
+    }
+    update(pId);
+}
+
+void SMTPEventLoop::receive(Connection &pConnection) {
+    while (!pConnection.Session->isFinished()) {
+        ssize_t bytes_received = recv(pConnection.Socket, mReadBuffer.data(), mReadBuffer.size(), 0);
+        if (bytes_received > 0) {
+            pConnection.Session->onReceive(mReadBuffer.data(), static_cast<size_t>(bytes_received));
+        } else if (bytes_received == 0) {
+            pConnection.Session->onTransportError();
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN) {
+                pConnection.Session->onTransportError();
+            }
+            return;
+        }
+    }
+}
+
+void SMTPEventLoop::flush(Connection &pConnection) {
+    SMTPSession &session = *pConnection.Session;
+    while (session.hasPendingOutput()) {
+        ssize_t bytes_sent = send(pConnection.Socket, session.getPendingOutput(),
+                session.getPendingOutputLength(), MSG_NOSIGNAL);
+        if (bytes_sent > 0) {
+            session.consumeOutput(static_cast<size_t>(bytes_sent));
+        } else if (bytes_sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (bytes_sent == 0 || (errno != EAGAIN)) {
+                session.onTransportError();
+            }
+            return;
+        }
+    }
+}
+
+void SMTPEventLoop::update(std::uint64_t pId) {
+    auto it = mConnections.find(pId);
+    if (it == mConnections.end()) {
+        return;
+    }
+    Connection &connection = it->second;
+    SMTPSession &session = *connection.Session;
+    if (connection.Connected && connection.Socket >= 0) {
+        flush(connection);
+    }
+
+    if (session.isFinished()) {
+        if (!connection.Closing) {
+            connection.Closing = true;
+            mClosing.push_back(pId);
+        }
+        return;
+    }
+
+    const bool want_write = !connection.Connected || session.hasPendingOutput();
+    if (want_write != connection.WantWrite) {
+        epoll_event event {};
+        event.events = EPOLLIN;
+        if (want_write) {
+            event.events |= EPOLLOUT;
+        }
+        event.data.u64 = pId;
+        epoll_ctl(mEpoll, EPOLL_CTL_MOD, connection.Socket, &event);
+        connection.WantWrite = want_write;
+    }
+
+    const std::uint64_t deadline = session.getDeadline();
+    if (deadline != connection.ScheduledDeadline) {
+        // Replaces or cancels the previous timer of the session
+        if (deadline != 0) {
+            mTimers.schedule(pId, deadline);
+        } else {
+            mTimers.cancel(pId);
+        }
+        connection.ScheduledDeadline = deadline;
+    }
+}
+
+void SMTPEventLoop::release(std::uint64_t pId) {
+    auto it = mConnections.find(pId);
+    if (it == mConnections.end()) {
+        return;
+    }
+    if (mSessionClosedHandler) {
+        mSessionClosedHandler(*it->second.Session);
+    }
+    mTimers.cancel(pId);
+    if (it->second.Socket >= 0) {
+        epoll_ctl(mEpoll, EPOLL_CTL_DEL, it->second.Socket, nullptr);
+        close(it->second.Socket);
+    }
+    mConnections.erase(it);
+}
+
+void SMTPEventLoop::runPostedTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mTasksMutex);
+        tasks.swap(mTasks);
+    }
+    for (auto &task : tasks) {
+        task();
+    }
+    // Tasks usually queue commands on sessions
+    updateDirtySessions();
+}
+
+void SMTPEventLoop::updateDirtySessions() {
+    std::vector<std::uint64_t> dirty;
+    dirty.swap(mDirty);
+    for (const auto id : dirty) {
+        auto it = mConnections.find(id);
+        if (it == mConnections.end()) {
+            continue;
+        }
+        it->second.Dirty = false;
+        update(id);
+    }
+}
+
+SSL_CTX *SMTPEventLoop::getSSLContext() {
+    if (!mTLSContext) {
+        mTLSContext = TLSContext::getDefault();
+    }
+    return mTLSContext ? mTLSContext->getSSLContext() : nullptr;
+}
+
+#endif  // __linux__
@@ -0,0 +1,135 @@
+#ifndef SMTPEVENTLOOP_H
+#define SMTPEVENTLOOP_H
+
+#ifdef __linux__
+
+#include <openssl/ssl.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "smtpsession.h"
+#include "timerwheel.h"
+#include "tlscontext.h"
+
+namespace jed_utils {
+/** @brief The SMTPEventLoop class drives a large number of SMTPSession
+ *  objects from a single thread with epoll (Linux only).
+ *
+ *  Sockets are non-blocking, every session command is bound to a deadline
+ *  tracked by a timer wheel and TLS is handled by the sessions through
+ *  memory BIOs, so no call of the loop ever blocks on the network.
+ *
+ *  Except for post() and stop(), the methods of the loop must be called
+ *  from the thread that runs it.
+ */
+class SMTPEventLoop {
+ public:
+    /** The callback invoked right before a finished session is released. */
+    using SessionClosedHandler = std::function<void(SMTPSession &)>;
+
+    /**
+     *  @brief  Construct a new SMTPEventLoop.
+     *  @param pTLSContext The TLS context shared by the secure sessions. When
+     *  null, the default context of the process is used.
+     */
+    explicit SMTPEventLoop(std::shared_ptr<TLSContext> pTLSContext = nullptr);
+
+    /** Destructor of the SMTPEventLoop. The remaining sessions are failed. */
+    ~SMTPEventLoop();
+
+    /** SMTPEventLoop copy constructor (deleted). */
+    SMTPEventLoop(const SMTPEventLoop &other) = delete;
+
+    /** SMTPEventLoop copy assignment operator (deleted). */
+    SMTPEventLoop& operator=(const SMTPEventLoop &other) = delete;
+
+    /**
+     *  @brief  Open a new session. The connection starts immediately.
+     *
+     *  The server name is resolved synchronously and the result is cached
+     *  for a minute. The returned session is owned by the loop and stays
+     *  valid until the closed handler is invoked for it.
+     *  @param pOptions The options of the session.
+     */
+    SMTPSession *createSession(const SMTPSessionOptions &pOptions);
+
+    /** Set the handler invoked right before a finished session is released. */
+    void setSessionClosedHandler(SessionClosedHandler pHandler);
+
+    /** Run a task on the loop thread. This method is thread-safe. */
+    void post(std::function<void()> pTask);
+
+    /**
+     *  @brief  Wait for network events and expired deadlines, then process
+     *  them.
+     *  @param pTimeoutMs The maximum wait time in milliseconds (-1 to wait
+     *  until something happens).
+     *  @return The number of network events processed or -1 on error.
+     */
+    int runOnce(int pTimeoutMs);
+
+    /** Run the loop until stop() is called. */
+    void run();
+
+    /** Ask the loop to return from run(). This method is thread-safe. */
+    void stop();
+
+    /** Return the number of open sessions. */
+    size_t getSessionCount() const;
+
+ private:
+    struct Connection {
+        int Socket = -1;
+        std::unique_ptr<SMTPSession> Session;
+        bool Connected = false;
+        bool WantWrite = true;
+        bool Closing = false;
+        // True while the id is in mDirty
+        bool Dirty = false;
+        std::uint64_t ScheduledDeadline = 0;
+    };
+    struct ResolvedAddress {
+        sockaddr_storage Address;
+        socklen_t AddressLength;
+        std::uint64_t Expiry;
+    };
+
+    int resolve(const SMTPSessionOptions &pOptions, ResolvedAddress &pResult);
+    void handleSocketEvent(std::uint64_t pId, std::uint32_t pEvents);
+    void receive(Connection &pConnection);
+    void flush(Connection &pConnection);
+    void update(std::uint64_t pId);
+    void release(std::uint64_t pId);
+    void runPostedTasks();
+    void updateDirtySessions();
+    SSL_CTX *getSSLContext();
+
+    int mEpoll;
+    int mWakeup;
+    std::shared_ptr<TLSContext> mTLSContext;
+    std::uint64_t mNextId;
+    std::unordered_map<std::uint64_t, Connection> mConnections;
+    std::unordered_map<std::string, ResolvedAddress> mResolvedAddresses;
+    std::vector<std::uint64_t> mClosing;
+    // The sessions that produced output or finished outside of update()
+    std::vector<std::uint64_t> mDirty;
+    std::vector<TimerWheel::Entry> mExpired;
+    std::vector<char> mReadBuffer;
+    TimerWheel mTimers;
+    SessionClosedHandler mSessionClosedHandler;
+    std::mutex mTasksMutex;
+    std::vector<std::function<void()>> mTasks;
+    std::atomic<bool> mStopRequested;
+};
+}  // namespace jed_utils
+
+#endif  // __linux__
+
+#endif
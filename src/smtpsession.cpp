@@ -0,0 +1,750 @@
+#include "smtpsession.h"
+#include <openssl/err.h>
+#include <openssl/x509.h>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include "base64.h"
+#include "datastuffer.h"
+#include "messageaddress.h"
+#include "messagerenderer.h"
+#include "smtpclientbase.h"
+#include "smtpclienterrors.h"
+#include "smtpserverstatuscodes.h"
+#include "socketerrors.h"
+#include "sslerrors.h"
+#include "timerwheel.h"
+#include "tlscontext.h"
+
+using namespace jed_utils;
+
+namespace {
+    const size_t OUTPUT_COMPACT_THRESHOLD = 65536;
+    const size_t TLS_WRITE_CHUNK_LENGTH = 1048576;
+
+    bool isPositiveReply(int pCode) {
+        return pCode >= 200 && pCode < 400;
+    }
+
+    bool isIPAddress(const std::string &pServerName) {
+        return !pServerName.empty() &&
+            (pServerName.find(':') != std::string::npos ||
+             pServerName.find_first_not_of("0123456789.") == std::string::npos);
+    }
+}  // namespace
+
+SMTPSession::SMTPSession(const SMTPSessionOptions &pOptions, SSL_CTX *pSSLContext)
+    : mOptions(pOptions),
+      mState(SMTPSessionState::Connecting),
+      mSSLContext(pSSLContext),
+      mSSL(nullptr),
+      mNetworkRead(nullptr),
+      mNetworkWrite(nullptr),
+      mSecure(false),
+      mAuthOptions(nullptr),
+      mOutputOffset(0),
+      mLastError(0),
+      mDeadline(0),
+      mNextTransactionId(1),
+      mOperationInProgress(false) {
+    setState(SMTPSessionState::Connecting);
+}
+
+SMTPSession::~SMTPSession() {
+    if (mSSL != nullptr) {
+        // The memory BIOs are owned by the SSL object
+        SSL_free(mSSL);
+    }
+    mSSL = nullptr;
+    mNetworkRead = nullptr;
+    mNetworkWrite = nullptr;
+    delete mAuthOptions;
+    mAuthOptions = nullptr;
+}
+
+const SMTPSessionOptions &SMTPSession::getOptions() const {
+    return mOptions;
+}
+
+void SMTPSession::setActivityHandler(ActivityHandler pHandler) {
+    mActivityHandler = std::move(pHandler);
+}
+
+SMTPSessionState SMTPSession::getState() const {
+    return mState;
+}
+
+bool SMTPSession::isSecure() const {
+    return mSecure;
+}
+
+const ServerAuthOptions *SMTPSession::getAuthenticationOptions() const {
+    return mAuthOptions;
+}
+
+const std::string &SMTPSession::getLastServerResponse() const {
+    return mLastServerResponse;
+}
+
+int SMTPSession::getLastError() const {
+    return mLastError;
+}
+
+std::uint64_t SMTPSession::getDeadline() const {
+    return mDeadline;
+}
+
+void SMTPSession::connect(CompletionHandler pHandler) {
+    if (mState == SMTPSessionState::Failed || mState == SMTPSessionState::Closed) {
+        pHandler(mLastError != 0 ? mLastError : SOCKET_INIT_SESSION_CONNECT_ERROR);
+        return;
+    }
+    if (mState == SMTPSessionState::Ready || mOperationInProgress) {
+        pHandler(0);
+        return;
+    }
+    mConnectHandler = std::move(pHandler);
+}
+
+void SMTPSession::mailFrom(const std::string &pAddress, CompletionHandler pHandler) {
+    mOperations.push_back({ OperationType::MailFrom, pAddress, std::move(pHandler), 0, nullptr });
+    runNextOperation();
+}
+
+void SMTPSession::rcptTo(const std::string &pAddress, CompletionHandler pHandler) {
+    mOperations.push_back({ OperationType::RcptTo, pAddress, std::move(pHandler), 0, nullptr });
+    runNextOperation();
+}
+
+void SMTPSession::data(std::string pContent, CompletionHandler pHandler) {
+    mOperations.push_back({ OperationType::Data, std::move(pContent), std::move(pHandler), 0, nullptr });
+    runNextOperation();
+}
+
+void SMTPSession::rset(CompletionHandler pHandler) {
+    mOperations.push_back({ OperationType::Rset, "", std::move(pHandler), 0, nullptr });
+    runNextOperation();
+}
+
+void SMTPSession::quit(CompletionHandler pHandler) {
+    mOperations.push_back({ OperationType::Quit, "", std::move(pHandler), 0, nullptr });
+    runNextOperation();
+}
+
+void SMTPSession::sendMail(const Message &pMsg, CompletionHandler pHandler) {
+    const std::uint64_t transaction_id = mNextTransactionId++;
+    // The handler is shared by every command of the transaction but only the
+    // first failure or the final DATA reply invokes it (once).
+    auto handler = std::make_shared<CompletionHandler>(std::move(pHandler));
+    auto complete = [handler](int pCode) {
+        if (*handler) {
+            CompletionHandler invoked_handler { std::move(*handler) };
+            *handler = nullptr;
+            invoked_handler(pCode);
+        }
+    };
+    auto on_envelope_reply = [complete](int pCode) {
+        if (!isPositiveReply(pCode)) {
+            complete(pCode);
+        }
+    };
+    // The content and the MAIL FROM parameters depend on the extensions of
+    // the server, they are rendered when MAIL FROM is sent (see
+    // runNextOperation)
+    mOperations.push_back({ OperationType::MailFrom, pMsg.getFrom().getEmailAddress(), on_envelope_reply, transaction_id,
+            &pMsg });
+    const std::pair<MessageAddress **, size_t> recipients[] = {
+        { pMsg.getTo(), pMsg.getToCount() },
+        { pMsg.getCc(), pMsg.getCcCount() },
+        { pMsg.getBcc(), pMsg.getBccCount() }
+    };
+    for (const auto &item : recipients) {
+        for (size_t i = 0; item.first != nullptr && i < item.second; i++) {
+            mOperations.push_back({ OperationType::RcptTo, item.first[i]->getEmailAddress(), on_envelope_reply, transaction_id, nullptr });
+        }
+    }
+    mOperations.push_back({ OperationType::Data, "", [complete](int pCode) {
+            complete(pCode == STATUS_CODE_REQUESTED_MAIL_ACTION_OK_OR_COMPLETED ? 0 : pCode);
+            }, transaction_id, nullptr });
+    runNextOperation();
+}
+
+void SMTPSession::onConnected() {
+    if (mState != SMTPSessionState::Connecting) {
+        return;
+    }
+    if (mOptions.Security == SMTPSessionSecurity::Implicit) {
+        startTLSHandshake();
+    } else {
+        setState(SMTPSessionState::Greeting);
+    }
+}
+
+void SMTPSession::onReceive(const char *pData, size_t pLength) {
+    if (isFinished() || pLength == 0) {
+        return;
+    }
+    if (mSSL == nullptr) {
+        mInput.append(pData, pLength);
+        processInput();
+        return;
+    }
+    if (pLength > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        fail(getErrorCode());
+        return;
+    }
+    BIO_write(mNetworkRead, pData, static_cast<int>(pLength));
+    if (mState == SMTPSessionState::TLSHandshake) {
+        continueTLSHandshake();
+    } else {
+        readTLSInput();
+        processInput();
+    }
+}
+
+void SMTPSession::onTimeout() {
+    if (mDeadline != 0 && !isFinished()) {
+        fail(getTimeoutCode());
+    }
+}
+
+void SMTPSession::onTransportError(int pErrorCode) {
+    if (isFinished()) {
+        return;
+    }
+    if (mState == SMTPSessionState::Quit) {
+        // The server is allowed to close the connection right after QUIT
+        setState(SMTPSessionState::Closed, false);
+        completeOperation(STATUS_CODE_SERVICE_CLOSING);
+        return;
+    }
+    fail(pErrorCode != 0 ? pErrorCode : getErrorCode());
+}
+
+bool SMTPSession::hasPendingOutput() const {
+    return mOutputOffset < mOutput.length();
+}
+
+const char *SMTPSession::getPendingOutput() const {
+    return mOutput.data() + mOutputOffset;
+}
+
+size_t SMTPSession::getPendingOutputLength() const {
+    return mOutput.length() - mOutputOffset;
+}
+
+void SMTPSession::consumeOutput(size_t pLength) {
+    mOutputOffset = std::min(mOutputOffset + pLength, mOutput.length());
+    if (mOutputOffset == mOutput.length()) {
+        mOutput.clear();
+        mOutputOffset = 0;
+    } else if (mOutputOffset > OUTPUT_COMPACT_THRESHOLD && mOutputOffset > mOutput.length() / 2) {
+        mOutput.erase(0, mOutputOffset);
+        mOutputOffset = 0;
+    }
+}
+
+bool SMTPSession::isFinished() const {
+    return mState == SMTPSessionState::Closed || mState == SMTPSessionState::Failed;
+}
+
+void SMTPSession::setState(SMTPSessionState pState, bool pArmDeadline) {
+    mState = pState;
+    mDeadline = pArmDeadline ? TimerWheel::getSteadyTimeMs() + mOptions.CommandTimeoutMs : 0;
+}
+
+void SMTPSession::sendLine(const std::string &pLine, SMTPSessionState pNextState) {
+    writeOutput(pLine.data(), pLine.length());
+    // A failed SSL_write already failed the session, it must stay failed
+    if (!isFinished()) {
+        setState(pNextState);
+    }
+}
+
+void SMTPSession::writeOutput(const char *pData, size_t pLength) {
+    if (!mSecure) {
+        mOutput.append(pData, pLength);
+        notifyActivity();
+        return;
+    }
+    // With a memory BIO, SSL_write always accepts the whole record
+    size_t offset = 0;
+    while (offset < pLength) {
+        const size_t length = std::min(pLength - offset, TLS_WRITE_CHUNK_LENGTH);
+        if (SSL_write(mSSL, pData + offset, static_cast<int>(length)) <= 0) {
+            fail(getErrorCode());
+            return;
+        }
+        offset += length;
+    }
+    drainTLSOutput();
+    notifyActivity();
+}
+
+void SMTPSession::startTLSHandshake() {
+    setState(SMTPSessionState::TLSHandshake);
+    // Any plaintext received after the STARTTLS reply must be discarded
+    mInput.clear();
+    if (mSSLContext == nullptr) {
+        fail(SSL_CLIENT_STARTTLS_INITSSLCTX_ERROR);
+        return;
+    }
+    mSSL = SSL_new(mSSLContext);
+    if (mSSL == nullptr) {
+        fail(SSL_CLIENT_STARTTLS_BIONEWSSLCONNECT_ERROR);
+        return;
+    }
+    mNetworkRead = BIO_new(BIO_s_mem());
+    mNetworkWrite = BIO_new(BIO_s_mem());
+    if (mNetworkRead == nullptr || mNetworkWrite == nullptr) {
+        BIO_free(mNetworkRead);
+        BIO_free(mNetworkWrite);
+        mNetworkRead = nullptr;
+        mNetworkWrite = nullptr;
+        fail(SSL_CLIENT_STARTTLS_BIONEWSSLCONNECT_ERROR);
+        return;
+    }
+    SSL_set_bio(mSSL, mNetworkRead, mNetworkWrite);
+    SSL_set_connect_state(mSSL);
+    if (!isIPAddress(mOptions.ServerName)) {
+        // The SSL_set_tlsext_host_name macro hides an old-style cast
+        SSL_ctrl(mSSL, SSL_CTRL_SET_TLSEXT_HOSTNAME, TLSEXT_NAMETYPE_host_name,
+                const_cast<char *>(mOptions.ServerName.c_str()));
+    }
+    TLSContext *tls_context = TLSContext::fromSSLContext(mSSLContext);
+    if (tls_context != nullptr) {
+        tls_context->prepareConnection(mSSL, mOptions.ServerName.c_str(), mOptions.Port);
+    }
+    continueTLSHandshake();
+}
+
+void SMTPSession::continueTLSHandshake() {
+    int handshake_result = SSL_do_handshake(mSSL);
+    drainTLSOutput();
+    if (handshake_result != 1) {
+        int ssl_error = SSL_get_error(mSSL, handshake_result);
+        if (ssl_error != SSL_ERROR_WANT_READ && ssl_error != SSL_ERROR_WANT_WRITE) {
+            ERR_clear_error();
+            fail(SSL_CLIENT_STARTTLS_BIO_HANDSHAKE_ERROR);
+        }
+        return;
+    }
+    TLSContext *tls_context = TLSContext::fromSSLContext(mSSLContext);
+    if (tls_context != nullptr) {
+        tls_context->recordHandshake(mSSL);
+    }
+
+    /* Step 1: Verify a server certificate was presented
+       during the negotiation */
+    X509 *cert = SSL_get_peer_certificate(mSSL);
+    if (cert == nullptr) {
+        fail(SSL_CLIENT_STARTTLS_GET_CERTIFICATE_ERROR);
+        return;
+    }
+    X509_free(cert);
+    /* Step 2: verify the result of chain verification */
+    if (SSL_get_verify_result(mSSL) != X509_V_OK) {
+        fail(SSL_CLIENT_STARTTLS_VERIFY_RESULT_ERROR);
+        return;
+    }
+
+    mSecure = true;
+    if (mOptions.Security == SMTPSessionSecurity::Implicit) {
+        setState(SMTPSessionState::Greeting);
+    } else {
+        sendLine("ehlo localhost\r\n", SMTPSessionState::SecureEhlo);
+        if (isFinished()) {
+            return;
+        }
+    }
+    // The server greeting may have been received with the last handshake record
+    readTLSInput();
+    processInput();
+}
+
+void SMTPSession::drainTLSOutput() {
+    char buffer[16384];
+    int bytes_read = 0;
+    while ((bytes_read = BIO_read(mNetworkWrite, buffer, sizeof(buffer))) > 0) {
+        mOutput.append(buffer, static_cast<size_t>(bytes_read));
+    }
+}
+
+void SMTPSession::readTLSInput() {
+    char buffer[16384];
+    int bytes_read = 0;
+    while ((bytes_read = SSL_read(mSSL, buffer, sizeof(buffer))) > 0) {
+        mInput.append(buffer, static_cast<size_t>(bytes_read));
+    }
+    int ssl_error = SSL_get_error(mSSL, bytes_read);
+    if (ssl_error != SSL_ERROR_WANT_READ && ssl_error != SSL_ERROR_WANT_WRITE && ssl_error != SSL_ERROR_ZERO_RETURN) {
+        ERR_clear_error();
+        fail(getErrorCode());
+        return;
+    }
+    // Reading may produce records to send (e.g. a key update)
+    drainTLSOutput();
+}
+
+void SMTPSession::processInput() {
+    size_t line_start = 0;
+    size_t line_end = 0;
+    while (!isFinished() && (line_end = mInput.find('\n', line_start)) != std::string::npos) {
+        const size_t line_length = line_end - line_start + 1;
+        mReply.append(mInput, line_start, line_length);
+        const bool is_last_line = line_length < 4 || mInput[line_start + 3] != '-';
+        line_start = line_end + 1;
+        if (is_last_line) {
+            // Remove the final end of line
+            size_t reply_length = mReply.length();
+            while (reply_length > 0 && (mReply[reply_length - 1] == '\n' || mReply[reply_length - 1] == '\r')) {
+                reply_length--;
+            }
+            mLastServerResponse.assign(mReply, 0, reply_length);
+            mReply.clear();
+            const SMTPSessionState previous_state = mState;
+            handleReply(SMTPClientBase::extractReturnCode(mLastServerResponse.c_str()));
+            if (previous_state != SMTPSessionState::TLSHandshake && mState == SMTPSessionState::TLSHandshake) {
+                // The rest of the plaintext input has been discarded
+                return;
+            }
+        }
+    }
+    mInput.erase(0, line_start);
+}
+
+void SMTPSession::handleReply(int pCode) {
+    switch (mState) {
+        case SMTPSessionState::Greeting:
+            if (pCode != STATUS_CODE_SERVICE_READY) {
+                fail(pCode);
+                return;
+            }
+            sendLine("ehlo localhost\r\n",
+                    mSecure ? SMTPSessionState::SecureEhlo : SMTPSessionState::Ehlo);
+            break;
+        case SMTPSessionState::Ehlo:
+        case SMTPSessionState::SecureEhlo:
+            handleEhloReply(pCode);
+            break;
+        case SMTPSessionState::StartTLS:
+            if (pCode != STATUS_CODE_SERVICE_READY) {
+                fail(pCode);
+                return;
+            }
+            startTLSHandshake();
+            break;
+        case SMTPSessionState::AuthPlain:
+        case SMTPSessionState::AuthLoginPassword:
+            if (pCode != STATUS_CODE_AUTHENTICATION_SUCCEEDED) {
+                fail(pCode);
+                return;
+            }
+            sessionReady();
+            break;
+        case SMTPSessionState::AuthLogin:
+            if (pCode != STATUS_CODE_SERVER_CHALLENGE) {
+                fail(CLIENT_AUTHENTICATE_ERROR);
+                return;
+            }
+            sendLine(Base64::Encode(reinterpret_cast<const unsigned char*>(mOptions.Username.data()),
+                        mOptions.Username.length()) + "\r\n",
+                    SMTPSessionState::AuthLoginUsername);
+            break;
+        case SMTPSessionState::AuthLoginUsername:
+            if (pCode != STATUS_CODE_SERVER_CHALLENGE) {
+                fail(CLIENT_AUTHENTICATE_ERROR);
+                return;
+            }
+            sendLine(Base64::Encode(reinterpret_cast<const unsigned char*>(mOptions.Password.data()),
+                        mOptions.Password.length()) + "\r\n",
+                    SMTPSessionState::AuthLoginPassword);
+            break;
+        case SMTPSessionState::Data:
+            if (pCode != STATUS_CODE_START_MAIL_INPUT) {
+                completeOperation(pCode);
+                return;
+            }
+            {
+                // The content is stuffed straight into the output buffer, or
+                // into a single buffer handed to SSL_write
+                const std::string &content = mOperations.front().Argument;
+                if (!mSecure) {
+                    mOutput.reserve(mOutput.length() + content.length());
+                    DataStuffer().write(content.data(), content.length(), mOutput);
+                } else {
+                    std::string stuffed_content;
+                    stuffed_content.reserve(content.length());
+                    DataStuffer().write(content.data(), content.length(), stuffed_content);
+                    writeOutput(stuffed_content.data(), stuffed_content.length());
+                    if (isFinished()) {
+                        // The write failed the session and its operations
+                        return;
+                    }
+                }
+                mOperations.front().Argument.clear();
+                mOperations.front().Argument.shrink_to_fit();
+            }
+            sendLine("\r\n.\r\n", SMTPSessionState::EndData);
+            break;
+        case SMTPSessionState::MailFrom:
+        case SMTPSessionState::RcptTo:
+        case SMTPSessionState::EndData:
+        case SMTPSessionState::Rset:
+            completeOperation(pCode);
+            break;
+        case SMTPSessionState::Quit:
+            setState(SMTPSessionState::Closed, false);
+            completeOperation(pCode);
+            break;
+        case SMTPSessionState::Ready:
+            // An unsolicited reply means the server is closing the connection (421)
+            fail(pCode);
+            break;
+        default:
+            break;
+    }
+}
+
+void SMTPSession::handleEhloReply(int pCode) {
+    if (pCode != STATUS_CODE_REQUESTED_MAIL_ACTION_OK_OR_COMPLETED) {
+        fail(pCode);
+        return;
+    }
+    if (mAuthOptions == nullptr) {
+        mAuthOptions = new ServerAuthOptions();
+    }
+    // The options offered on the secure channel replace the previous ones
+    *mAuthOptions = ServerAuthOptions();
+    SMTPClientBase::parseEhloResponse(mLastServerResponse.c_str(), mAuthOptions);
+
+    if (mState == SMTPSessionState::Ehlo &&
+        mOptions.Security == SMTPSessionSecurity::Opportunistic &&
+        mAuthOptions->StartTLS) {
+        sendLine("STARTTLS\r\n", SMTPSessionState::StartTLS);
+        return;
+    }
+    startAuthentication();
+}
+
+void SMTPSession::startAuthentication() {
+    if (mOptions.Username.empty()) {
+        sessionReady();
+        return;
+    }
+    if (mAuthOptions != nullptr && mAuthOptions->Plain) {
+        // Format : \0username\0password
+        std::string credentials;
+        credentials.reserve(mOptions.Username.length() + mOptions.Password.length() + 2);
+        credentials += '\0';
+        credentials += mOptions.Username;
+        credentials += '\0';
+        credentials += mOptions.Password;
+        sendLine("AUTH PLAIN " + Base64::Encode(reinterpret_cast<const unsigned char*>(credentials.data()),
+                    credentials.length()) + "\r\n",
+                SMTPSessionState::AuthPlain);
+    } else if (mAuthOptions != nullptr && mAuthOptions->Login) {
+        sendLine("AUTH LOGIN\r\n", SMTPSessionState::AuthLogin);
+    } else {
+        fail(CLIENT_AUTHENTICATION_METHOD_NOTSUPPORTED);
+    }
+}
+
+void SMTPSession::sessionReady() {
+    setState(SMTPSessionState::Ready, false);
+    if (mConnectHandler) {
+        CompletionHandler handler { std::move(mConnectHandler) };
+        mConnectHandler = nullptr;
+        handler(0);
+    }
+    runNextOperation();
+}
+
+void SMTPSession::runNextOperation() {
+    if (mOperationInProgress || mOperations.empty()) {
+        return;
+    }
+    if (isFinished()) {
+        // Nothing can be sent on a closed session
+        std::deque<Operation> operations;
+        operations.swap(mOperations);
+        for (auto &operation : operations) {
+            if (operation.Handler) {
+                operation.Handler(mLastError != 0 ? mLastError : SOCKET_INIT_SESSION_CONNECT_ERROR);
+            }
+        }
+        return;
+    }
+    if (mState != SMTPSessionState::Ready) {
+        return;
+    }
+    mOperationInProgress = true;
+    const Operation &operation = mOperations.front();
+    switch (operation.Type) {
+        case OperationType::MailFrom: {
+            std::string command { "MAIL FROM: <" + operation.Argument + ">" };
+            if (operation.Msg != nullptr) {
+                // The extensions of the server are known now, the content of
+                // the transaction is rendered for them
+                const Message &msg = *operation.Msg;
+                const bool eight_bit_mime = mAuthOptions != nullptr && mAuthOptions->EightBitMime;
+                const std::uint64_t transaction_id = operation.TransactionId;
+                auto data_operation = std::find_if(mOperations.begin(), mOperations.end(),
+                        [transaction_id](const Operation &pOperation) {
+                        return pOperation.Type == OperationType::Data && pOperation.TransactionId == transaction_id;
+                        });
+                if (mAuthOptions != nullptr && mAuthOptions->Size) {
+                    // The same size as the blocking clients declare (RFC 1870)
+                    const size_t message_size = MessageRenderer::computeSize(msg, eight_bit_mime, mOptions.Signer.get());
+                    if (mAuthOptions->MaxMessageSize > 0 && message_size > mAuthOptions->MaxMessageSize) {
+                        completeOperation(CLIENT_SENDMAIL_MESSAGE_TOO_LARGE);
+                        return;
+                    }
+                    command += " SIZE=" + std::to_string(message_size);
+                }
+                command += MessageRenderer::renderMailFromParameters(msg, mAuthOptions);
+                if (data_operation != mOperations.end()) {
+                    data_operation->Argument = MessageRenderer::render(msg, eight_bit_mime, mOptions.Signer.get());
+                }
+            }
+            sendLine(command + "\r\n", SMTPSessionState::MailFrom);
+            break;
+        }
+        case OperationType::RcptTo:
+            sendLine("RCPT TO: <" + operation.Argument + ">\r\n", SMTPSessionState::RcptTo);
+            break;
+        case OperationType::Data:
+            sendLine("DATA\r\n", SMTPSessionState::Data);
+            break;
+        case OperationType::Rset:
+            sendLine("RSET\r\n", SMTPSessionState::Rset);
+            break;
+        case OperationType::Quit:
+            sendLine("QUIT\r\n", SMTPSessionState::Quit);
+            break;
+    }
+}
+
+void SMTPSession::completeOperation(int pCode) {
+    if (mOperations.empty()) {
+        return;
+    }
+    Operation operation { std::move(mOperations.front()) };
+    mOperations.pop_front();
+    mOperationInProgress = false;
+    if (!isFinished()) {
+        setState(SMTPSessionState::Ready, false);
+    }
+    if (operation.TransactionId != 0 && !isPositiveReply(pCode)) {
+        // Drop the rest of the failed transaction and reset the envelope
+        const std::uint64_t transaction_id = operation.TransactionId;
+        mOperations.erase(std::remove_if(mOperations.begin(), mOperations.end(),
+                    [transaction_id](const Operation &pOperation) {
+                    return pOperation.TransactionId == transaction_id;
+                    }), mOperations.end());
+        if (pCode > 0 && !isFinished()) {
+            mOperations.push_front({ OperationType::Rset, "", nullptr, 0, nullptr });
+        }
+    }
+    if (operation.Handler) {
+        operation.Handler(pCode);
+    }
+    runNextOperation();
+}
+
+void SMTPSession::fail(int pErrorCode) {
+    if (isFinished()) {
+        return;
+    }
+    mLastError = pErrorCode;
+    setState(SMTPSessionState::Failed, false);
+    mOperationInProgress = false;
+    notifyActivity();
+    if (mConnectHandler) {
+        CompletionHandler handler { std::move(mConnectHandler) };
+        mConnectHandler = nullptr;
+        handler(pErrorCode);
+    }
+    std::deque<Operation> operations;
+    operations.swap(mOperations);
+    for (auto &operation : operations) {
+        if (operation.Handler) {
+            operation.Handler(pErrorCode);
+        }
+    }
+}
+
+void SMTPSession::notifyActivity() {
+    if (mActivityHandler) {
+        mActivityHandler();
+    }
+}
+
+int SMTPSession::getTimeoutCode() const {
+    switch (mState) {
+        case SMTPSessionState::Connecting:
+        case SMTPSessionState::Greeting:
+            return SOCKET_INIT_SESSION_CONNECT_TIMEOUT;
+        case SMTPSessionState::TLSHandshake:
+            return SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT;
+        case SMTPSessionState::Ehlo:
+            return SOCKET_INIT_CLIENT_SEND_EHLO_TIMEOUT;
+        case SMTPSessionState::StartTLS:
+            return SOCKET_INIT_CLIENT_SEND_STARTTLS_TIMEOUT;
+        case SMTPSessionState::SecureEhlo:
+            return SSL_CLIENT_INITSECURECLIENT_TIMEOUT;
+        case SMTPSessionState::AuthPlain:
+        case SMTPSessionState::AuthLogin:
+        case SMTPSessionState::AuthLoginUsername:
+        case SMTPSessionState::AuthLoginPassword:
+            return CLIENT_AUTHENTICATE_TIMEOUT;
+        case SMTPSessionState::MailFrom:
+            return CLIENT_SENDMAIL_MAILFROM_TIMEOUT;
+        case SMTPSessionState::RcptTo:
+            return CLIENT_SENDMAIL_RCPTTO_TIMEOUT;
+        case SMTPSessionState::Data:
+            return CLIENT_SENDMAIL_DATA_TIMEOUT;
+        case SMTPSessionState::EndData:
+            return CLIENT_SENDMAIL_END_DATA_TIMEOUT;
+        case SMTPSessionState::Rset:
+            return CLIENT_SENDMAIL_RSET_TIMEOUT;
+        case SMTPSessionState::Quit:
+            return CLIENT_SENDMAIL_QUIT_TIMEOUT;
+        default:
+            return getErrorCode();
+    }
+}
+
+int SMTPSession::getErrorCode() const {
+    switch (mState) {
+        case SMTPSessionState::TLSHandshake:
+            return SSL_CLIENT_STARTTLS_BIO_HANDSHAKE_ERROR;
+        case SMTPSessionState::Ehlo:
+            return SOCKET_INIT_CLIENT_SEND_EHLO_ERROR;
+        case SMTPSessionState::StartTLS:
+            return SOCKET_INIT_CLIENT_SEND_STARTTLS_ERROR;
+        case SMTPSessionState::SecureEhlo:
+            return SSL_CLIENT_INITSECURECLIENT_ERROR;
+        case SMTPSessionState::AuthPlain:
+        case SMTPSessionState::AuthLogin:
+        case SMTPSessionState::AuthLoginUsername:
+        case SMTPSessionState::AuthLoginPassword:
+            return CLIENT_AUTHENTICATE_ERROR;
+        case SMTPSessionState::MailFrom:
+            return CLIENT_SENDMAIL_MAILFROM_ERROR;
+        case SMTPSessionState::RcptTo:
+            return CLIENT_SENDMAIL_RCPTTO_ERROR;
+        case SMTPSessionState::Data:
+            return CLIENT_SENDMAIL_DATA_ERROR;
+        case SMTPSessionState::EndData:
+            return CLIENT_SENDMAIL_END_DATA_ERROR;
+        case SMTPSessionState::Rset:
+            return CLIENT_SENDMAIL_RSET_ERROR;
+        case SMTPSessionState::Quit:
+            return CLIENT_SENDMAIL_QUIT_ERROR;
+        default:
+            return SOCKET_INIT_SESSION_CONNECT_ERROR;
+    }
+}
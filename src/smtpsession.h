@@ -0,0 +1,275 @@
+#ifndef SMTPSESSION_H
+#define SMTPSESSION_H
+
+#include <openssl/ssl.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "dkimsigner.h"
+#include "message.h"
+#include "serverauthoptions.h"
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define SMTPSESSION_API __declspec(dllexport)
+    #else
+        #define SMTPSESSION_API __declspec(dllimport)
+    #endif
+#else
+    #define SMTPSESSION_API
+#endif
+
+namespace jed_utils {
+/** @brief The security mode of an SMTPSession. Each mode matches the
+ *  behavior of one of the blocking client classes.
+ */
+enum class SMTPSessionSecurity {
+    /** No encryption (SmtpClient) */
+    None,
+    /** Upgrade with STARTTLS when the server offers it (OpportunisticSecureSMTPClient) */
+    Opportunistic,
+    /** TLS from the initial connection (ForcedSecureSMTPClient) */
+    Implicit
+};
+
+/** @brief The states of the SMTPSession state machine. */
+enum class SMTPSessionState {
+    Connecting,
+    TLSHandshake,
+    Greeting,
+    Ehlo,
+    StartTLS,
+    SecureEhlo,
+    AuthPlain,
+    AuthLogin,
+    AuthLoginUsername,
+    AuthLoginPassword,
+    Ready,
+    MailFrom,
+    RcptTo,
+    Data,
+    EndData,
+    Rset,
+    Quit,
+    Closed,
+    Failed
+};
+
+/** @brief The options used to open an SMTPSession. */
+struct SMTPSessionOptions {
+    /** The name of the server. Example: smtp.domainexample.com */
+    std::string ServerName;
+    /** The server port number. Example: 25, 465, 587 */
+    unsigned int Port = 25;
+    /** The security mode of the session. */
+    SMTPSessionSecurity Security = SMTPSessionSecurity::Opportunistic;
+    /** The username used for authentication. Leave empty to skip authentication. */
+    std::string Username;
+    /** The password used for authentication. */
+    std::string Password;
+    /** The deadline of every command (including the connection) in milliseconds. */
+    unsigned int CommandTimeoutMs = 5000;
+    /** The DKIM signer of the messages sent with sendMail. Null to send
+     *  them unsigned. */
+    std::shared_ptr<DKIMSigner> Signer;
+};
+
+/** @brief The SMTPSession class models one SMTP session as an explicit,
+ *  non-blocking state machine (greeting, EHLO, STARTTLS, AUTH, envelope,
+ *  DATA and QUIT).
+ *
+ *  The session never touches a socket. The owner (usually SMTPEventLoop)
+ *  feeds it the bytes received from the network, sends the bytes it
+ *  produces and notifies it of connection and timeout events. TLS is done
+ *  with OpenSSL memory BIOs so the handshake never blocks.
+ *
+ *  Operations are queued and run in order once the session is ready. Each
+ *  operation reports its result through a callback: the SMTP reply code on
+ *  success, or the same error codes as the blocking clients on failure.
+ */
+class SMTPSESSION_API SMTPSession {
+ public:
+    /** The callback invoked when an operation completes. */
+    using CompletionHandler = std::function<void(int)>;
+
+    /** The callback invoked when the session has new bytes to send or
+     *  finishes, so that its owner can flush or release it. */
+    using ActivityHandler = std::function<void()>;
+
+    /**
+     *  @brief  Construct a new SMTPSession.
+     *  @param pOptions The options of the session.
+     *  @param pSSLContext The SSL context used to create the TLS connection.
+     *  It must outlive the session. Can be null when Security is None.
+     */
+    SMTPSession(const SMTPSessionOptions &pOptions, SSL_CTX *pSSLContext);
+
+    /** Destructor of the SMTPSession. */
+    virtual ~SMTPSession();
+
+    /** SMTPSession copy constructor (deleted). */
+    SMTPSession(const SMTPSession &other) = delete;
+
+    /** SMTPSession copy assignment operator (deleted). */
+    SMTPSession& operator=(const SMTPSession &other) = delete;
+
+    /** Return the options of the session. */
+    const SMTPSessionOptions &getOptions() const;
+
+    /** Set the handler invoked when the session has new output or finishes. */
+    void setActivityHandler(ActivityHandler pHandler);
+
+    /** Return the current state of the session. */
+    SMTPSessionState getState() const;
+
+    /** Return true if the connection has been encrypted. */
+    bool isSecure() const;
+
+    /** Return the AUTH methods and extensions advertised by the server, or
+     *  null before the EHLO response. */
+    const ServerAuthOptions *getAuthenticationOptions() const;
+
+    /** Return the last reply received from the server. */
+    const std::string &getLastServerResponse() const;
+
+    /** Return the error code that closed the session or 0. */
+    int getLastError() const;
+
+    /**
+     *  @brief  Return the deadline of the pending command in milliseconds
+     *  (steady clock) or 0 when nothing is awaited.
+     */
+    std::uint64_t getDeadline() const;
+
+    /**
+     *  @brief  Register the handler invoked when the session is ready to
+     *  send mails (0) or failed to be established (error code).
+     */
+    void connect(CompletionHandler pHandler);
+
+    /** Queue a MAIL FROM command. The handler receives the reply code. */
+    void mailFrom(const std::string &pAddress, CompletionHandler pHandler);
+
+    /** Queue a RCPT TO command. The handler receives the reply code. */
+    void rcptTo(const std::string &pAddress, CompletionHandler pHandler);
+
+    /**
+     *  @brief  Queue the DATA command followed by the content and the end of
+     *  data marker. The handler receives the reply code of the end of data.
+     *  The line breaks of the content are normalized to CRLF and the lines
+     *  that start with a dot are stuffed while it is written.
+     *  @param pContent The rendered content (see MessageRenderer).
+     */
+    void data(std::string pContent, CompletionHandler pHandler);
+
+    /** Queue a RSET command. The handler receives the reply code. */
+    void rset(CompletionHandler pHandler);
+
+    /** Queue a QUIT command. The handler receives the reply code. */
+    void quit(CompletionHandler pHandler);
+
+    /**
+     *  @brief  Queue the complete transaction of a message (MAIL FROM, RCPT TO
+     *  for each recipient and DATA). The handler receives 0 on success or the
+     *  error code of the first command that failed, in which case the
+     *  transaction is reset so the session can be reused.
+     *
+     *  The message is rendered when its MAIL FROM command is sent, once the
+     *  extensions of the server (8BITMIME, SMTPUTF8, SIZE) are known, so it
+     *  must stay valid until the handler is invoked.
+     */
+    void sendMail(const Message &pMsg, CompletionHandler pHandler);
+
+    // Transport events
+    /** Notify the session that the TCP connection is established. */
+    void onConnected();
+
+    /** Feed the session with bytes received from the network. */
+    void onReceive(const char *pData, size_t pLength);
+
+    /** Notify the session that the pending command deadline has expired. */
+    void onTimeout();
+
+    /**
+     *  @brief  Notify the session that the transport failed or was closed.
+     *  @param pErrorCode The error code to report, or 0 to report the error
+     *  code of the command in progress.
+     */
+    void onTransportError(int pErrorCode = 0);
+
+    /** Return true if the session has bytes to send on the network. */
+    bool hasPendingOutput() const;
+
+    /** Return a pointer to the bytes to send on the network. */
+    const char *getPendingOutput() const;
+
+    /** Return the number of bytes to send on the network. */
+    size_t getPendingOutputLength() const;
+
+    /** Indicate that pLength bytes of the pending output were sent. */
+    void consumeOutput(size_t pLength);
+
+    /** Return true if the session is closed or failed and can be released. */
+    bool isFinished() const;
+
+ protected:
+    enum class OperationType { MailFrom, RcptTo, Data, Rset, Quit };
+    struct Operation {
+        OperationType Type;
+        std::string Argument;
+        CompletionHandler Handler;
+        std::uint64_t TransactionId;
+        // The message of a transaction, on its MAIL FROM operation only
+        const Message *Msg;
+    };
+
+    void setState(SMTPSessionState pState, bool pArmDeadline = true);
+    // Send a command and wait for its reply in pNextState, unless the write
+    // failed the session
+    void sendLine(const std::string &pLine, SMTPSessionState pNextState);
+    void writeOutput(const char *pData, size_t pLength);
+    void handleReply(int pCode);
+    void handleEhloReply(int pCode);
+    void startTLSHandshake();
+    void continueTLSHandshake();
+    void drainTLSOutput();
+    void readTLSInput();
+    void processInput();
+    void startAuthentication();
+    void sessionReady();
+    void runNextOperation();
+    void completeOperation(int pCode);
+    void fail(int pErrorCode);
+    void notifyActivity();
+    int getTimeoutCode() const;
+    int getErrorCode() const;
+
+ private:
+    SMTPSessionOptions mOptions;
+    SMTPSessionState mState;
+    SSL_CTX *mSSLContext;
+    SSL *mSSL;
+    BIO *mNetworkRead;
+    BIO *mNetworkWrite;
+    bool mSecure;
+    ServerAuthOptions *mAuthOptions;
+    std::string mInput;
+    std::string mOutput;
+    size_t mOutputOffset;
+    std::string mReply;
+    std::string mLastServerResponse;
+    int mLastError;
+    std::uint64_t mDeadline;
+    std::uint64_t mNextTransactionId;
+    CompletionHandler mConnectHandler;
+    std::deque<Operation> mOperations;
+    bool mOperationInProgress;
+    ActivityHandler mActivityHandler;
+};
+}  // namespace jed_utils
+
+#endif
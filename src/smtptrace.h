@@ -0,0 +1,48 @@
+#ifndef SMTPTRACE_H
+#define SMTPTRACE_H
+
+/* USDT (SystemTap/bpftrace) static probes of the provider "smtpclient".
+ *
+ * They are compiled only with the CMake option BUILD_WITH_USDT_PROBES and
+ * when sys/sdt.h (package systemtap-sdt-dev) is available. A compiled probe
+ * is a single nop until a tracer attaches to it, and the macros expand to
+ * nothing otherwise. The arguments are evaluated only when the probes are
+ * compiled, so they must stay cheap and free of side effects.
+ *
+ * Probes (the first argument is always the session id, see
+ * SMTPClientBase::getSessionId):
+ *   connect__start(session_id, server_name, port)
+ *   connect__done(session_id, return_code)
+ *   command__sent(session_id, command)
+ *   reply__parsed(session_id, reply_code, reply)
+ *   tls__handshake__start(session_id)
+ *   tls__handshake__done(session_id, return_code, resumed)
+ *   data__chunk(session_id, bytes)
+ *   session__close(session_id)
+ *
+ * Example:
+ *   bpftrace -e 'usdt:./libsmtpclient.so:smtpclient:reply__parsed
+ *       { printf("%d %s\n", arg1, str(arg2)); }'
+ */
+
+#if defined(SMTPCLIENT_USDT_PROBES) && defined(__has_include)
+    #if __has_include(<sys/sdt.h>)
+        #include <sys/sdt.h>
+        #define SMTPCLIENT_HAS_USDT_PROBES
+    #endif
+#endif
+
+#ifdef SMTPCLIENT_HAS_USDT_PROBES
+    #define SMTPCLIENT_PROBE1(name, a1) \
+        DTRACE_PROBE1(smtpclient, name, a1)
+    #define SMTPCLIENT_PROBE2(name, a1, a2) \
+        DTRACE_PROBE2(smtpclient, name, a1, a2)
+    #define SMTPCLIENT_PROBE3(name, a1, a2, a3) \
+        DTRACE_PROBE3(smtpclient, name, a1, a2, a3)
+#else
+    #define SMTPCLIENT_PROBE1(name, a1) do { } while (0)
+    #define SMTPCLIENT_PROBE2(name, a1, a2) do { } while (0)
+    #define SMTPCLIENT_PROBE3(name, a1, a2, a3) do { } while (0)
+#endif
+
+#endif
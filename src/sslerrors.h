@@ -9,6 +9,7 @@ const int SSL_CLIENT_STARTTLS_BIO_CONNECT_ERROR = -55;
 const int SSL_CLIENT_STARTTLS_BIO_HANDSHAKE_ERROR = -56;
 const int SSL_CLIENT_STARTTLS_GET_CERTIFICATE_ERROR = -57;
 const int SSL_CLIENT_STARTTLS_VERIFY_RESULT_ERROR = -58;
+const int SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT = -61;
 
 // Init Session error codes
 const int SSL_CLIENT_INITSECURECLIENT_ERROR = -59;
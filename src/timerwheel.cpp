@@ -0,0 +1,100 @@
+#include "timerwheel.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+using namespace jed_utils;
+
+TimerWheel::TimerWheel(size_t pSlotCount, std::uint64_t pResolutionMs, std::uint64_t pStartMs)
+    : mSlots(pSlotCount),
+      mResolutionMs(pResolutionMs),
+      mCurrentTick(0) {
+    if (pSlotCount == 0) {
+        throw std::invalid_argument("The slot count must be greater than zero");
+    }
+    if (pResolutionMs == 0) {
+        throw std::invalid_argument("The resolution must be greater than zero");
+    }
+    mCurrentTick = pStartMs / mResolutionMs;
+}
+
+std::uint64_t TimerWheel::getSteadyTimeMs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void TimerWheel::schedule(std::uint64_t pKey, std::uint64_t pExpiryMs) {
+    cancel(pKey);
+    std::uint64_t tick = std::max(pExpiryMs / mResolutionMs, mCurrentTick);
+    const size_t slot_index = tick % mSlots.size();
+    mSlots[slot_index].push_back({ pKey, pExpiryMs });
+    mKeySlots[pKey] = slot_index;
+}
+
+bool TimerWheel::cancel(std::uint64_t pKey) {
+    auto it = mKeySlots.find(pKey);
+    if (it == mKeySlots.end()) {
+        return false;
+    }
+    std::vector<Entry> &slot = mSlots[it->second];
+    auto entry = std::find_if(slot.begin(), slot.end(), [pKey](const Entry &pEntry) {
+            return pEntry.Key == pKey;
+            });
+    if (entry != slot.end()) {
+        // The order of a slot does not matter
+        *entry = slot.back();
+        slot.pop_back();
+    }
+    mKeySlots.erase(it);
+    return true;
+}
+
+void TimerWheel::advance(std::uint64_t pNowMs, std::vector<Entry> &pExpired) {
+    std::uint64_t now_tick = pNowMs / mResolutionMs;
+    if (now_tick < mCurrentTick) {
+        return;
+    }
+    // The current slot is visited again on every call because timers can
+    // be scheduled later in the tick that was already processed.
+    std::uint64_t ticks_to_visit = std::min<std::uint64_t>(now_tick - mCurrentTick + 1, mSlots.size());
+    for (std::uint64_t i = 0; i < ticks_to_visit && !mKeySlots.empty(); i++) {
+        std::vector<Entry> &slot = mSlots[(mCurrentTick + i) % mSlots.size()];
+        auto first_kept = std::partition(slot.begin(), slot.end(), [pNowMs](const Entry &entry) {
+                return entry.Expiry > pNowMs;
+                });
+        for (auto it = first_kept; it != slot.end(); ++it) {
+            mKeySlots.erase(it->Key);
+        }
+        pExpired.insert(pExpired.end(), first_kept, slot.end());
+        slot.erase(first_kept, slot.end());
+    }
+    mCurrentTick = now_tick;
+}
+
+int TimerWheel::getNextTimeoutMs(std::uint64_t pNowMs) const {
+    if (mKeySlots.empty()) {
+        return -1;
+    }
+    std::uint64_t next_expiry = std::numeric_limits<std::uint64_t>::max();
+    // Look for the first slot holding a timer of the current rotation.
+    for (size_t i = 0; i < mSlots.size(); i++) {
+        const std::vector<Entry> &slot = mSlots[(mCurrentTick + i) % mSlots.size()];
+        std::uint64_t rotation_end = (mCurrentTick + i + 1) * mResolutionMs;
+        for (const auto &entry : slot) {
+            next_expiry = std::min(next_expiry, entry.Expiry);
+        }
+        if (next_expiry < rotation_end) {
+            break;
+        }
+    }
+    if (next_expiry <= pNowMs) {
+        return 0;
+    }
+    return static_cast<int>(std::min<std::uint64_t>(next_expiry - pNowMs,
+                static_cast<std::uint64_t>(std::numeric_limits<int>::max())));
+}
+
+size_t TimerWheel::size() const {
+    return mKeySlots.size();
+}
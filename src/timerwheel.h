@@ -0,0 +1,86 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define TIMERWHEEL_API __declspec(dllexport)
+    #else
+        #define TIMERWHEEL_API __declspec(dllimport)
+    #endif
+#else
+    #define TIMERWHEEL_API
+#endif
+
+namespace jed_utils {
+/** @brief The TimerWheel class is a hashed timing wheel used to track the
+ *  command deadlines of a large number of sessions.
+ *
+ *  Scheduling is O(1) and advancing the wheel only visits the slots that
+ *  elapsed. A key has at most one timer: scheduling it again replaces the
+ *  previous timer and cancel removes it, so no stale timer is kept.
+ */
+class TIMERWHEEL_API TimerWheel {
+ public:
+    /** An expired timer. */
+    struct Entry {
+        std::uint64_t Key;
+        std::uint64_t Expiry;
+    };
+
+    /**
+     *  @brief  Construct a new TimerWheel.
+     *  @param pSlotCount The number of slots of the wheel.
+     *  @param pResolutionMs The time covered by one slot in milliseconds.
+     *  @param pStartMs The current time in milliseconds.
+     */
+    TimerWheel(size_t pSlotCount, std::uint64_t pResolutionMs, std::uint64_t pStartMs);
+
+    /** Return the current time of the steady clock in milliseconds. */
+    static std::uint64_t getSteadyTimeMs();
+
+    /**
+     *  @brief  Schedule a timer, replacing the timer of the key if any.
+     *  @param pKey The key returned when the timer expires.
+     *  @param pExpiryMs The expiry time in milliseconds.
+     */
+    void schedule(std::uint64_t pKey, std::uint64_t pExpiryMs);
+
+    /**
+     *  @brief  Remove the timer of a key.
+     *  @param pKey The key of the timer.
+     *  @return True if the key had a timer.
+     */
+    bool cancel(std::uint64_t pKey);
+
+    /**
+     *  @brief  Advance the wheel up to the time provided.
+     *  @param pNowMs The current time in milliseconds.
+     *  @param pExpired Receives the timers that expired.
+     */
+    void advance(std::uint64_t pNowMs, std::vector<Entry> &pExpired);
+
+    /**
+     *  @brief  Return the number of milliseconds until the next slot that
+     *  holds a timer must be visited, or -1 if the wheel is empty.
+     *  @param pNowMs The current time in milliseconds.
+     */
+    int getNextTimeoutMs(std::uint64_t pNowMs) const;
+
+    /** Return the number of scheduled timers. */
+    size_t size() const;
+
+ private:
+    std::vector<std::vector<Entry>> mSlots;
+    // The slot that holds the timer of each key
+    std::unordered_map<std::uint64_t, size_t> mKeySlots;
+    std::uint64_t mResolutionMs;
+    std::uint64_t mCurrentTick;
+};
+}  // namespace jed_utils
+
+#endif
@@ -0,0 +1,369 @@
+#include "tlscontext.h"
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <mutex>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <wincrypt.h>
+    #include <intrin.h>
+#elif defined(__linux__) && defined(__aarch64__)
+    #include <asm/hwcap.h>
+    #include <sys/auxv.h>
+#endif
+
+using namespace jed_utils;
+
+namespace {
+    // Bounds the memory used by the sessions and verified chains of a context
+    const size_t MAX_CACHED_SESSION_COUNT = 1024;
+    const long MIN_SEND_FRAGMENT = 512;  // NOLINT(runtime/int)
+    const long MAX_SEND_FRAGMENT = 16384;  // NOLINT(runtime/int)
+    const char *AES_FIRST_CIPHERSUITES = "TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256";
+    const char *CHACHA_FIRST_CIPHERSUITES = "TLS_CHACHA20_POLY1305_SHA256:TLS_AES_128_GCM_SHA256:TLS_AES_256_GCM_SHA384";
+    // TLS 1.2 and older: forward secret AEAD first, then what old servers offer
+    const char *AES_FIRST_CIPHER_LIST = "ECDHE+AESGCM:ECDHE+CHACHA20:HIGH:!aNULL:!MD5:!RC4";
+    const char *CHACHA_FIRST_CIPHER_LIST = "ECDHE+CHACHA20:ECDHE+AESGCM:HIGH:!aNULL:!MD5:!RC4";
+
+    std::once_flag openssl_initialized;
+    std::mutex default_context_mutex;
+    std::shared_ptr<TLSContext> default_context;
+    std::once_flag ex_data_indexes_created;
+    int context_ex_data_index = -1;
+    int session_key_ex_data_index = -1;
+
+    void freeSessionKey(void *, void *pKey, CRYPTO_EX_DATA *, int, long, void *) {  // NOLINT(runtime/int)
+        delete static_cast<std::string *>(pKey);
+    }
+
+    void createExDataIndexes() {
+        std::call_once(ex_data_indexes_created, []() {
+            context_ex_data_index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            session_key_ex_data_index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, freeSessionKey);
+        });
+    }
+
+    bool loadDefaultCA(SSL_CTX *pSSLContext) {
+#ifdef _WIN32
+        /* On Windows, we need to import all the ROOT certificates to
+           the OpenSSL Store */
+        HCERTSTORE hStore = CertOpenSystemStore(NULL, "ROOT");
+        if (!hStore) {
+            return false;
+        }
+        X509_STORE *store = SSL_CTX_get_cert_store(pSSLContext);
+        PCCERT_CONTEXT pContext = CertEnumCertificatesInStore(hStore, nullptr);
+        while (pContext) {
+            const unsigned char *encoded = pContext->pbCertEncoded;
+            X509 *x509 = d2i_X509(nullptr, &encoded, static_cast<long>(pContext->cbCertEncoded));
+            if (x509) {
+                X509_STORE_add_cert(store, x509);
+                X509_free(x509);
+            }
+            pContext = CertEnumCertificatesInStore(hStore, pContext);
+        }
+        CertCloseStore(hStore, 0);
+        return true;
+#else
+        return SSL_CTX_set_default_verify_paths(pSSLContext) != 0;
+#endif
+    }
+}  // namespace
+
+TLSContext::TLSContext(SSL_CTX *pSSLContext)
+    : mSSLContext(pSSLContext),
+      mResumedHandshakeCount(0),
+      mFullHandshakeCount(0),
+      mVerificationCacheDuration(0),
+      mVerificationCacheHitCount(0) {
+    createExDataIndexes();
+    SSL_CTX_set_ex_data(mSSLContext, context_ex_data_index, this);
+    // The sessions are kept by server in mSessions, not in the internal
+    // cache of OpenSSL that a client cannot look up.
+    SSL_CTX_set_session_cache_mode(mSSLContext, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(mSSLContext, &TLSContext::onNewSession);
+    SSL_CTX_set_cert_verify_callback(mSSLContext, &TLSContext::onVerifyChain, this);
+}
+
+TLSContext::~TLSContext() {
+    // Connections still referencing the OpenSSL context must not reach this
+    // object anymore.
+    SSL_CTX_set_ex_data(mSSLContext, context_ex_data_index, nullptr);
+    SSL_CTX_sess_set_new_cb(mSSLContext, nullptr);
+    SSL_CTX_set_cert_verify_callback(mSSLContext, nullptr, nullptr);
+    clearSessions();
+    SSL_CTX_free(mSSLContext);
+    mSSLContext = nullptr;
+}
+
+void TLSContext::initializeOpenSSL() {
+    std::call_once(openssl_initialized, []() {
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+        SSL_library_init();
+        OpenSSL_add_all_algorithms();
+        SSL_load_error_strings();
+#else
+        OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS | OPENSSL_INIT_LOAD_CRYPTO_STRINGS, nullptr);
+#endif
+    });
+}
+
+std::shared_ptr<TLSContext> TLSContext::getDefault() {
+    std::lock_guard<std::mutex> lock(default_context_mutex);
+    if (!default_context) {
+        default_context = createWithDefaultCA();
+    }
+    return default_context;
+}
+
+std::shared_ptr<TLSContext> TLSContext::createWithDefaultCA() {
+    SSL_CTX *ssl_context = createSSLContext();
+    if (ssl_context == nullptr) {
+        return nullptr;
+    }
+    if (!loadDefaultCA(ssl_context)) {
+        SSL_CTX_free(ssl_context);
+        return nullptr;
+    }
+    return std::shared_ptr<TLSContext>(new TLSContext(ssl_context));
+}
+
+std::shared_ptr<TLSContext> TLSContext::createWithCA(const char *pCAFile, const char *pCAPath) {
+    if (pCAFile == nullptr && pCAPath == nullptr) {
+        return nullptr;
+    }
+    SSL_CTX *ssl_context = createSSLContext();
+    if (ssl_context == nullptr) {
+        return nullptr;
+    }
+    if (SSL_CTX_load_verify_locations(ssl_context, pCAFile, pCAPath) != 1) {
+        SSL_CTX_free(ssl_context);
+        return nullptr;
+    }
+    return std::shared_ptr<TLSContext>(new TLSContext(ssl_context));
+}
+
+std::shared_ptr<TLSContext> TLSContext::createWithStore(X509_STORE *pStore) {
+    if (pStore == nullptr) {
+        return nullptr;
+    }
+    SSL_CTX *ssl_context = createSSLContext();
+    if (ssl_context == nullptr) {
+        return nullptr;
+    }
+    SSL_CTX_set1_cert_store(ssl_context, pStore);
+    return std::shared_ptr<TLSContext>(new TLSContext(ssl_context));
+}
+
+TLSContext *TLSContext::fromSSLContext(const SSL_CTX *pSSLContext) {
+    if (pSSLContext == nullptr) {
+        return nullptr;
+    }
+    createExDataIndexes();
+    return static_cast<TLSContext *>(SSL_CTX_get_ex_data(pSSLContext, context_ex_data_index));
+}
+
+bool TLSContext::hasHardwareAES() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul");
+#elif defined(_WIN32) && (defined(_M_X64) || defined(_M_IX86))
+    int cpu_info[4] = { 0 };
+    __cpuid(cpu_info, 1);
+    // ECX bit 25 is AES-NI, bit 1 is PCLMULQDQ (used by GCM)
+    return (cpu_info[2] & (1 << 25)) != 0 && (cpu_info[2] & (1 << 1)) != 0;
+#elif defined(__linux__) && defined(__aarch64__)
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#elif defined(__APPLE__) && defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+SSL_CTX *TLSContext::getSSLContext() const {
+    return mSSLContext;
+}
+
+bool TLSContext::applyProfile(const TLSProfile &pProfile) {
+    if (pProfile.TLS13Only
+            && SSL_CTX_ctrl(mSSLContext, SSL_CTRL_SET_MIN_PROTO_VERSION, TLS1_3_VERSION, nullptr) != 1) {
+        return false;
+    }
+    if (!pProfile.Groups.empty()
+            && SSL_CTX_ctrl(mSSLContext, SSL_CTRL_SET_GROUPS_LIST, 0, const_cast<char *>(pProfile.Groups.c_str())) != 1) {
+        return false;
+    }
+    if (pProfile.CipherOrderByCPU) {
+        const bool hardware_aes = hasHardwareAES();
+        if (SSL_CTX_set_ciphersuites(mSSLContext, hardware_aes ? AES_FIRST_CIPHERSUITES : CHACHA_FIRST_CIPHERSUITES) != 1
+                || SSL_CTX_set_cipher_list(mSSLContext, hardware_aes ? AES_FIRST_CIPHER_LIST : CHACHA_FIRST_CIPHER_LIST) != 1) {
+            return false;
+        }
+    }
+    if (pProfile.MaxSendFragment != 0) {
+        const long max_send_fragment = static_cast<long>(pProfile.MaxSendFragment);  // NOLINT(runtime/int)
+        if (max_send_fragment < MIN_SEND_FRAGMENT || max_send_fragment > MAX_SEND_FRAGMENT
+                || SSL_CTX_ctrl(mSSLContext, SSL_CTRL_SET_MAX_SEND_FRAGMENT, max_send_fragment, nullptr) != 1) {
+            return false;
+        }
+    }
+    if (pProfile.ReadAhead) {
+        SSL_CTX_ctrl(mSSLContext, SSL_CTRL_SET_READ_AHEAD, 1, nullptr);
+        if (pProfile.ReadBufferLength != 0) {
+            SSL_CTX_set_default_read_buffer_len(mSSLContext, pProfile.ReadBufferLength);
+        }
+    }
+    return true;
+}
+
+void TLSContext::prepareConnection(SSL *pSSL, const char *pServerName, unsigned int pPort) {
+    if (pSSL == nullptr || pServerName == nullptr) {
+        return;
+    }
+    std::string *key = new std::string(pServerName);
+    key->append(":").append(std::to_string(pPort));
+    std::lock_guard<std::mutex> lock(mSessionsMutex);
+    auto cached_session = mSessions.find(*key);
+    if (cached_session != mSessions.end()) {
+        SSL_set_session(pSSL, cached_session->second);
+    }
+    delete static_cast<std::string *>(SSL_get_ex_data(pSSL, session_key_ex_data_index));
+    SSL_set_ex_data(pSSL, session_key_ex_data_index, key);
+}
+
+void TLSContext::recordHandshake(const SSL *pSSL) {
+    if (SSL_session_reused(pSSL) == 1) {
+        mResumedHandshakeCount++;
+    } else {
+        mFullHandshakeCount++;
+    }
+}
+
+void TLSContext::clearSessions() {
+    std::lock_guard<std::mutex> lock(mSessionsMutex);
+    for (auto &item : mSessions) {
+        SSL_SESSION_free(item.second);
+    }
+    mSessions.clear();
+}
+
+size_t TLSContext::getCachedSessionCount() const {
+    std::lock_guard<std::mutex> lock(mSessionsMutex);
+    return mSessions.size();
+}
+
+std::uint64_t TLSContext::getResumedHandshakeCount() const {
+    return mResumedHandshakeCount;
+}
+
+std::uint64_t TLSContext::getFullHandshakeCount() const {
+    return mFullHandshakeCount;
+}
+
+std::chrono::seconds TLSContext::getVerificationCacheDuration() const {
+    return std::chrono::seconds(mVerificationCacheDuration.load());
+}
+
+void TLSContext::setVerificationCacheDuration(std::chrono::seconds pDuration) {
+    mVerificationCacheDuration = pDuration.count();
+    if (pDuration.count() <= 0) {
+        clearVerifiedChains();
+    }
+}
+
+void TLSContext::clearVerifiedChains() {
+    std::lock_guard<std::mutex> lock(mVerifiedChainsMutex);
+    mVerifiedChains.clear();
+}
+
+size_t TLSContext::getVerifiedChainCount() const {
+    std::lock_guard<std::mutex> lock(mVerifiedChainsMutex);
+    return mVerifiedChains.size();
+}
+
+std::uint64_t TLSContext::getVerificationCacheHitCount() const {
+    return mVerificationCacheHitCount;
+}
+
+int TLSContext::onNewSession(SSL *pSSL, SSL_SESSION *pSession) {
+    TLSContext *tls_context = fromSSLContext(SSL_get_SSL_CTX(pSSL));
+    auto *key = static_cast<std::string *>(SSL_get_ex_data(pSSL, session_key_ex_data_index));
+    if (tls_context == nullptr || key == nullptr || SSL_SESSION_is_resumable(pSession) != 1) {
+        return 0;
+    }
+    // OpenSSL marks the session of a connection freed without a shutdown
+    // as not resumable, so the cache keeps its own copy.
+    SSL_SESSION *session = SSL_SESSION_dup(pSession);
+    if (session != nullptr) {
+        tls_context->storeSession(*key, session);
+    }
+    return 0;
+}
+
+int TLSContext::onVerifyChain(X509_STORE_CTX *pStoreContext, void *pTLSContext) {
+    return static_cast<TLSContext *>(pTLSContext)->verifyChain(pStoreContext);
+}
+
+int TLSContext::verifyChain(X509_STORE_CTX *pStoreContext) {
+    const std::int64_t cache_duration = mVerificationCacheDuration;
+    X509 *leaf = X509_STORE_CTX_get0_cert(pStoreContext);
+    auto *ssl = static_cast<SSL *>(X509_STORE_CTX_get_ex_data(pStoreContext, SSL_get_ex_data_X509_STORE_CTX_idx()));
+    auto *server_key = ssl == nullptr ? nullptr
+        : static_cast<std::string *>(SSL_get_ex_data(ssl, session_key_ex_data_index));
+    unsigned char fingerprint[EVP_MAX_MD_SIZE];
+    unsigned int fingerprint_length = 0;
+    if (cache_duration <= 0 || leaf == nullptr || server_key == nullptr
+            || X509_digest(leaf, EVP_sha256(), fingerprint, &fingerprint_length) != 1) {
+        return X509_verify_cert(pStoreContext);
+    }
+
+    // The same certificate presented by another server is verified again
+    std::string key { *server_key };
+    key.append("|").append(reinterpret_cast<const char *>(fingerprint), fingerprint_length);
+    const auto now = std::chrono::steady_clock::now();
+    const bool leaf_valid = X509_cmp_current_time(X509_get0_notBefore(leaf)) < 0
+        && X509_cmp_current_time(X509_get0_notAfter(leaf)) > 0;
+    {
+        std::lock_guard<std::mutex> lock(mVerifiedChainsMutex);
+        auto verified_chain = mVerifiedChains.find(key);
+        if (verified_chain != mVerifiedChains.end()) {
+            if (leaf_valid && now < verified_chain->second) {
+                mVerificationCacheHitCount++;
+                X509_STORE_CTX_set_error(pStoreContext, X509_V_OK);
+                return 1;
+            }
+            mVerifiedChains.erase(verified_chain);
+        }
+    }
+
+    int verify_result = X509_verify_cert(pStoreContext);
+    if (verify_result == 1 && X509_STORE_CTX_get_error(pStoreContext) == X509_V_OK && leaf_valid) {
+        std::lock_guard<std::mutex> lock(mVerifiedChainsMutex);
+        if (mVerifiedChains.size() >= MAX_CACHED_SESSION_COUNT) {
+            mVerifiedChains.erase(mVerifiedChains.begin());
+        }
+        mVerifiedChains[key] = now + std::chrono::seconds(cache_duration);
+    }
+    return verify_result;
+}
+
+void TLSContext::storeSession(const std::string &pKey, SSL_SESSION *pSession) {
+    std::lock_guard<std::mutex> lock(mSessionsMutex);
+    auto cached_session = mSessions.find(pKey);
+    if (cached_session != mSessions.end()) {
+        SSL_SESSION_free(cached_session->second);
+        cached_session->second = pSession;
+        return;
+    }
+    if (mSessions.size() >= MAX_CACHED_SESSION_COUNT) {
+        SSL_SESSION_free(mSessions.begin()->second);
+        mSessions.erase(mSessions.begin());
+    }
+    mSessions.emplace(pKey, pSession);
+}
+
+SSL_CTX *TLSContext::createSSLContext() {
+    initializeOpenSSL();
+    return SSL_CTX_new(TLS_client_method());
+}
@@ -0,0 +1,209 @@
+#ifndef TLSCONTEXT_H
+#define TLSCONTEXT_H
+
+#include <openssl/ssl.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define TLSCONTEXT_API __declspec(dllexport)
+    #else
+        #define TLSCONTEXT_API __declspec(dllimport)
+    #endif
+#else
+    #define TLSCONTEXT_API
+#endif
+
+namespace jed_utils {
+/** @brief The performance settings applied to a TLSContext. */
+struct TLSProfile {
+    /** Refuse the protocol versions older than TLS 1.3. */
+    bool TLS13Only = false;
+    /** The key exchange groups in order of preference (OpenSSL syntax).
+     *  X25519 is the fastest. Leave empty for the defaults of OpenSSL. */
+    std::string Groups = "X25519:P-256:P-384";
+    /** Offer AES-GCM first when the CPU has AES instructions and
+     *  ChaCha20-Poly1305 first otherwise (see TLSContext::hasHardwareAES). */
+    bool CipherOrderByCPU = true;
+    /** The maximum plaintext length of the records sent, from 512 to 16384
+     *  bytes. 0 keeps the default (16384). */
+    unsigned int MaxSendFragment = 0;
+    /** Read as many bytes as available from the socket instead of one
+     *  record at a time, which saves system calls during bulk transfers. */
+    bool ReadAhead = false;
+    /** The length of the read buffer used with ReadAhead. 0 keeps the
+     *  default of OpenSSL. */
+    size_t ReadBufferLength = 0;
+};
+
+/** @brief The TLSContext class holds an OpenSSL client context (SSL_CTX)
+ *  whose trusted certificates are loaded once.
+ *
+ *  Loading the CA bundle of the system takes milliseconds, so the secure
+ *  clients, sender pools and event loops share one context instead of
+ *  creating a new one for every connection. A context is immutable once
+ *  created and OpenSSL allows its concurrent use by several connections,
+ *  so it can be shared between threads.
+ *
+ *  The context also caches the last TLS session (or TLS 1.3 ticket) of each
+ *  server so the next connection to the same server and port resumes it
+ *  with an abbreviated handshake.
+ *
+ *  Optionally, the context also remembers the leaf certificates whose chain
+ *  it has verified for each server, so a full handshake with a known
+ *  certificate skips the chain building until the entry or the certificate
+ *  expires.
+ */
+class TLSCONTEXT_API TLSContext {
+ public:
+    /**
+     *  @brief  Initialize the OpenSSL library. Only the first call does the
+     *  initialization and it is safe to call from several threads.
+     */
+    static void initializeOpenSSL();
+
+    /**
+     *  @brief  Return the process-wide context that trusts the default CA
+     *  locations of the system. It is created on the first call.
+     *  @return The shared context or null if it could not be created (the
+     *  creation is attempted again on the next call).
+     */
+    static std::shared_ptr<TLSContext> getDefault();
+
+    /**
+     *  @brief  Create a new context that trusts the default CA locations of
+     *  the system (the ROOT store on Windows).
+     *  @return The new context or null if it could not be created.
+     */
+    static std::shared_ptr<TLSContext> createWithDefaultCA();
+
+    /**
+     *  @brief  Create a new context that trusts only the given certificates.
+     *  @param pCAFile The PEM file containing the trusted certificates. Can be
+     *  null if pCAPath is set.
+     *  @param pCAPath The directory containing the trusted certificates
+     *  (hashed names, see openssl rehash). Can be null if pCAFile is set.
+     *  @return The new context or null if the certificates could not be
+     *  loaded.
+     */
+    static std::shared_ptr<TLSContext> createWithCA(const char *pCAFile, const char *pCAPath = nullptr);
+
+    /**
+     *  @brief  Create a new context that uses an existing certificate store.
+     *  @param pStore The trusted certificates. The context takes its own
+     *  reference, the caller keeps ownership of pStore.
+     *  @return The new context or null if pStore is null or the context could
+     *  not be created.
+     */
+    static std::shared_ptr<TLSContext> createWithStore(X509_STORE *pStore);
+
+    /** Destructor of the TLSContext. */
+    ~TLSContext();
+
+    /** TLSContext copy constructor (deleted). */
+    TLSContext(const TLSContext &other) = delete;
+
+    /** TLSContext copy assignment operator (deleted). */
+    TLSContext& operator=(const TLSContext &other) = delete;
+
+    /**
+     *  @brief  Return the TLSContext that owns an OpenSSL context.
+     *  @return The TLSContext or null if the OpenSSL context was not created
+     *  by a TLSContext.
+     */
+    static TLSContext *fromSSLContext(const SSL_CTX *pSSLContext);
+
+    /** Return true if the CPU has AES instructions (AES-NI on x86, the
+     *  cryptography extension on ARMv8). */
+    static bool hasHardwareAES();
+
+    /** Return the OpenSSL context. It stays owned by the TLSContext. */
+    SSL_CTX *getSSLContext() const;
+
+    /**
+     *  @brief  Apply the settings of a TLS profile. Call it before the
+     *  context is used by a connection.
+     *  @param pProfile The settings to apply.
+     *  @return False if OpenSSL rejected a setting (for example an unknown
+     *  group). The settings before it have been applied.
+     */
+    bool applyProfile(const TLSProfile &pProfile);
+
+    /**
+     *  @brief  Prepare a connection created from this context before its
+     *  handshake: the cached session of the server, if any, is offered and
+     *  the session negotiated will be cached for the next connection.
+     *  @param pSSL The connection.
+     *  @param pServerName The name of the server.
+     *  @param pPort The server port number.
+     */
+    void prepareConnection(SSL *pSSL, const char *pServerName, unsigned int pPort);
+
+    /**
+     *  @brief  Count a completed handshake as resumed or full.
+     *  @param pSSL The connection whose handshake has completed.
+     */
+    void recordHandshake(const SSL *pSSL);
+
+    /** Remove all the cached sessions. */
+    void clearSessions();
+
+    /** Return the number of servers that have a cached session. */
+    size_t getCachedSessionCount() const;
+
+    /** Return the number of handshakes that resumed a cached session. */
+    std::uint64_t getResumedHandshakeCount() const;
+
+    /** Return the number of handshakes that negotiated a new session. */
+    std::uint64_t getFullHandshakeCount() const;
+
+    /** Return how long a verified chain is remembered. 0 means the
+     *  verified chain cache is disabled. */
+    std::chrono::seconds getVerificationCacheDuration() const;
+
+    /**
+     *  @brief  Enable the verified chain cache. A chain is verified again
+     *  when the leaf certificate of the server changes, when the entry is
+     *  older than pDuration or when the leaf certificate is not valid
+     *  anymore.
+     *  @param pDuration How long a verified chain is remembered. 0 to
+     *  disable the cache (the default).
+     */
+    void setVerificationCacheDuration(std::chrono::seconds pDuration);
+
+    /** Remove all the verified chains. */
+    void clearVerifiedChains();
+
+    /** Return the number of verified chains remembered. */
+    size_t getVerifiedChainCount() const;
+
+    /** Return the number of chain verifications skipped thanks to the cache. */
+    std::uint64_t getVerificationCacheHitCount() const;
+
+ private:
+    explicit TLSContext(SSL_CTX *pSSLContext);
+    static SSL_CTX *createSSLContext();
+    static int onNewSession(SSL *pSSL, SSL_SESSION *pSession);
+    static int onVerifyChain(X509_STORE_CTX *pStoreContext, void *pTLSContext);
+    void storeSession(const std::string &pKey, SSL_SESSION *pSession);
+    int verifyChain(X509_STORE_CTX *pStoreContext);
+
+    SSL_CTX *mSSLContext;
+    mutable std::mutex mSessionsMutex;
+    std::unordered_map<std::string, SSL_SESSION *> mSessions;
+    std::atomic<std::uint64_t> mResumedHandshakeCount;
+    std::atomic<std::uint64_t> mFullHandshakeCount;
+    std::atomic<std::int64_t> mVerificationCacheDuration;
+    mutable std::mutex mVerifiedChainsMutex;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> mVerifiedChains;
+    std::atomic<std::uint64_t> mVerificationCacheHitCount;
+};
+}  // namespace jed_utils
+
+#endif
@@ -0,0 +1,86 @@
+#include "utf8validator.h"
+#include "simdutils.h"
+
+using namespace jed_utils;
+
+namespace {
+    inline bool isContinuation(unsigned char pByte) {
+        return (pByte & 0xC0) == 0x80;
+    }
+
+    // Return the length of the valid sequence that starts with a non-ASCII
+    // byte, or 0 if it is invalid (Unicode, table 3-7)
+    inline size_t validSequenceLength(const unsigned char *pData, size_t pRemaining) {
+        const unsigned char lead = pData[0];
+        size_t length = 0;
+        unsigned char second_min = 0x80;
+        unsigned char second_max = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            if (lead == 0xE0) {
+                // Overlong forms
+                second_min = 0xA0;
+            } else if (lead == 0xED) {
+                // Surrogates
+                second_max = 0x9F;
+            }
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            if (lead == 0xF0) {
+                second_min = 0x90;
+            } else if (lead == 0xF4) {
+                // Above U+10FFFF
+                second_max = 0x8F;
+            }
+        } else {
+            return 0;
+        }
+        if (pRemaining < length || pData[1] < second_min || pData[1] > second_max) {
+            return 0;
+        }
+        for (size_t index = 2; index < length; index++) {
+            if (!isContinuation(pData[index])) {
+                return 0;
+            }
+        }
+        return length;
+    }
+}  // namespace
+
+size_t UTF8Validator::findFirstInvalid(const char *pData, size_t pLength) {
+    if (pData == nullptr) {
+        return 0;
+    }
+    const auto *data = reinterpret_cast<const unsigned char *>(pData);
+    size_t offset = 0;
+    while (offset < pLength) {
+#ifdef SMTPCLIENT_SSE2
+        if (offset + 16 <= pLength) {
+            // The bytes above 127 have their high bit set
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + offset));
+            const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(block));
+            if (mask == 0) {
+                offset += 16;
+                continue;
+            }
+            offset += simd::countTrailingZeros(mask);
+        }
+#endif
+        if (data[offset] < 0x80) {
+            offset++;
+            continue;
+        }
+        const size_t sequence_length = validSequenceLength(data + offset, pLength - offset);
+        if (sequence_length == 0) {
+            return offset;
+        }
+        offset += sequence_length;
+    }
+    return pLength;
+}
+
+bool UTF8Validator::isValid(const char *pData, size_t pLength) {
+    return findFirstInvalid(pData, pLength) == pLength;
+}
@@ -0,0 +1,43 @@
+#ifndef UTF8VALIDATOR_H
+#define UTF8VALIDATOR_H
+
+#include <cstddef>
+
+#ifdef _WIN32
+    #ifdef SMTPCLIENT_EXPORTS
+        #define UTF8VALIDATOR_API __declspec(dllexport)
+    #else
+        #define UTF8VALIDATOR_API __declspec(dllimport)
+    #endif
+#else
+    #define UTF8VALIDATOR_API
+#endif
+
+namespace jed_utils {
+/** @brief The UTF8Validator class checks that a text is well-formed UTF-8
+ *  (RFC 3629): no overlong form, no surrogate, nothing above U+10FFFF and no
+ *  truncated sequence.
+ *
+ *  The runs of ASCII are skipped 16 bytes at a time with SSE2 when it is
+ *  available, the multi-byte sequences are checked one by one.
+ */
+class UTF8VALIDATOR_API UTF8Validator {
+ public:
+    /**
+     *  @brief  Return the offset of the first byte that does not start a
+     *  valid UTF-8 sequence, or pLength if the whole text is valid.
+     *  @param pData The text to check.
+     *  @param pLength The length of the text.
+     */
+    static size_t findFirstInvalid(const char *pData, size_t pLength);
+
+    /**
+     *  @brief  Return true if the text is valid UTF-8.
+     *  @param pData The text to check.
+     *  @param pLength The length of the text.
+     */
+    static bool isValid(const char *pData, size_t pLength);
+};
+}  // namespace jed_utils
+
+#endif
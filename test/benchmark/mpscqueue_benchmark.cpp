@@ -0,0 +1,121 @@
+// Contention benchmark of the MPSCQueue submission ring against a bounded
+// mutex + condition variable queue. Each run pushes the same number of items
+// through the queue with 1 to 64 producers and a single batch consumer.
+//
+// Usage : mpscqueue_benchmark [items per run]
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../../src/mpscqueue.h"
+
+using jed_utils::MPSCQueue;
+
+namespace {
+const size_t QUEUE_CAPACITY = 4096;
+const size_t BATCH_LENGTH = 64;
+
+// Baseline : bounded queue protected by a mutex with two condition variables
+class MutexQueue {
+ public:
+    explicit MutexQueue(size_t pCapacity)
+        : mCapacity(pCapacity) {
+    }
+
+    void enqueue(size_t pItem) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mNotFull.wait(lock, [this]() { return mItems.size() < mCapacity; });
+        mItems.push_back(pItem);
+        lock.unlock();
+        mNotEmpty.notify_one();
+    }
+
+    size_t dequeueBatch(std::vector<size_t> &pItems, size_t pMaxCount) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mNotEmpty.wait(lock, [this]() { return !mItems.empty(); });
+        size_t count = 0;
+        while (count < pMaxCount && !mItems.empty()) {
+            pItems.push_back(mItems.front());
+            mItems.pop_front();
+            count++;
+        }
+        lock.unlock();
+        mNotFull.notify_all();
+        return count;
+    }
+
+ private:
+    size_t mCapacity;
+    std::mutex mMutex;
+    std::condition_variable mNotFull;
+    std::condition_variable mNotEmpty;
+    std::deque<size_t> mItems;
+};
+
+template<typename Produce, typename Consume>
+double run(unsigned int pProducerCount, size_t pItemCount, Produce pProduce, Consume pConsume) {
+    const size_t items_per_producer = pItemCount / pProducerCount;
+    const size_t total = items_per_producer * pProducerCount;
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (unsigned int p = 0; p < pProducerCount; p++) {
+        producers.emplace_back([&pProduce, items_per_producer]() {
+                for (size_t i = 0; i < items_per_producer; i++) {
+                    pProduce(i);
+                }
+                });
+    }
+    std::vector<size_t> batch;
+    batch.reserve(BATCH_LENGTH);
+    size_t received = 0;
+    while (received < total) {
+        batch.clear();
+        received += pConsume(batch);
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(total) / elapsed.count();
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    const size_t item_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    const unsigned int producer_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    std::printf("%10s %20s %20s\n", "producers", "mpsc (items/s)", "mutex (items/s)");
+    for (const auto producer_count : producer_counts) {
+        MPSCQueue<size_t> ring(QUEUE_CAPACITY);
+        const double ring_rate = run(producer_count, item_count,
+                [&ring](size_t pItem) {
+                    while (!ring.tryEnqueue(pItem)) {
+                        std::this_thread::yield();
+                    }
+                },
+                [&ring](std::vector<size_t> &pBatch) {
+                    size_t count = ring.dequeueBatch(pBatch, BATCH_LENGTH);
+                    if (count == 0) {
+                        std::this_thread::yield();
+                    }
+                    return count;
+                });
+
+        MutexQueue baseline(QUEUE_CAPACITY);
+        const double mutex_rate = run(producer_count, item_count,
+                [&baseline](size_t pItem) {
+                    baseline.enqueue(pItem);
+                },
+                [&baseline](std::vector<size_t> &pBatch) {
+                    return baseline.dequeueBatch(pBatch, BATCH_LENGTH);
+                });
+
+        std::printf("%10u %20.0f %20.0f\n", producer_count, ring_rate, mutex_rate);
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Benchmark of the TLS profile settings (see TLSProfile) against a local,
+// in-memory TLS server. For each profile, it measures the full and resumed
+// handshakes per second and the bulk throughput of a DATA-like transfer
+// from the client to the server.
+//
+// Usage : tls_benchmark [handshakes per run] [megabytes per run]
+
+#include <openssl/ssl.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../../src/tlscontext.h"
+#include "../smtpclient_unittest/tlstestpeer.h"
+
+using jed_utils::TLSContext;
+using jed_utils::TLSProfile;
+
+namespace {
+const size_t WRITE_LENGTH = 16384;
+const size_t PAIR_BUFFER_LENGTH = 262144;
+
+struct Connection {
+    SSL *Client = nullptr;
+    SSL *Server = nullptr;
+};
+
+// Connect a client of pContext to a new server connection of pPeer
+bool connect(TLSContext &pContext, TLSTestPeer &pPeer, Connection &pConnection) {
+    pConnection.Client = SSL_new(pContext.getSSLContext());
+    pConnection.Server = SSL_new(pPeer.getServerContext());
+    BIO *client_bio = nullptr;
+    BIO *server_bio = nullptr;
+    BIO_new_bio_pair(&client_bio, PAIR_BUFFER_LENGTH, &server_bio, PAIR_BUFFER_LENGTH);
+    SSL_set_bio(pConnection.Client, client_bio, client_bio);
+    SSL_set_bio(pConnection.Server, server_bio, server_bio);
+    SSL_set_connect_state(pConnection.Client);
+    SSL_set_accept_state(pConnection.Server);
+    pContext.prepareConnection(pConnection.Client, "localhost", 465);
+    bool client_done = false;
+    bool server_done = false;
+    for (int round = 0; round < 20 && !(client_done && server_done); round++) {
+        client_done = client_done || SSL_do_handshake(pConnection.Client) == 1;
+        server_done = server_done || SSL_do_handshake(pConnection.Server) == 1;
+    }
+    if (client_done && server_done) {
+        // Deliver the TLS 1.3 tickets to the client
+        char byte = 'x';
+        SSL_write(pConnection.Server, &byte, 1);
+        SSL_read(pConnection.Client, &byte, 1);
+        pContext.recordHandshake(pConnection.Client);
+    }
+    return client_done && server_done;
+}
+
+void release(Connection &pConnection) {
+    SSL_free(pConnection.Client);
+    SSL_free(pConnection.Server);
+    pConnection = Connection();
+}
+
+double measureHandshakes(TLSContext &pContext, TLSTestPeer &pPeer, size_t pCount, bool pResume) {
+    pContext.clearSessions();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pCount; i++) {
+        if (!pResume) {
+            pContext.clearSessions();
+        }
+        Connection connection;
+        if (!connect(pContext, pPeer, connection)) {
+            std::fprintf(stderr, "Handshake failed\n");
+            std::exit(1);
+        }
+        release(connection);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(pCount) / elapsed.count();
+}
+
+double measureBulk(TLSContext &pContext, TLSTestPeer &pPeer, size_t pMegabytes) {
+    Connection connection;
+    if (!connect(pContext, pPeer, connection)) {
+        std::fprintf(stderr, "Handshake failed\n");
+        std::exit(1);
+    }
+    const size_t total = pMegabytes * 1024 * 1024;
+    std::vector<char> payload(WRITE_LENGTH, 'A');
+    std::vector<char> sink(PAIR_BUFFER_LENGTH);
+    size_t sent = 0;
+    size_t received = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (received < total) {
+        while (sent < total) {
+            int written = SSL_write(connection.Client, payload.data(), static_cast<int>(WRITE_LENGTH));
+            if (written <= 0) {
+                break;
+            }
+            sent += static_cast<size_t>(written);
+        }
+        int read = 0;
+        while ((read = SSL_read(connection.Server, sink.data(), static_cast<int>(sink.size()))) > 0) {
+            received += static_cast<size_t>(read);
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    release(connection);
+    return static_cast<double>(total) / (1024.0 * 1024.0) / elapsed.count();
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    const size_t handshake_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    const size_t megabytes = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+
+    struct NamedProfile {
+        const char *Name;
+        TLSProfile Profile;
+        bool UseProfile;
+    };
+    std::vector<NamedProfile> profiles;
+    profiles.push_back({ "OpenSSL defaults", TLSProfile(), false });
+    profiles.push_back({ "Default profile", TLSProfile(), true });
+    TLSProfile tls13;
+    tls13.TLS13Only = true;
+    profiles.push_back({ "TLS 1.3 only", tls13, true });
+    TLSProfile p256;
+    p256.Groups = "P-256:X25519";
+    profiles.push_back({ "P-256 first", p256, true });
+    TLSProfile fragment;
+    fragment.MaxSendFragment = 4096;
+    profiles.push_back({ "4 KiB records", fragment, true });
+    TLSProfile read_ahead;
+    read_ahead.ReadAhead = true;
+    read_ahead.ReadBufferLength = 65536;
+    profiles.push_back({ "Read ahead 64 KiB", read_ahead, true });
+
+    std::printf("Hardware AES: %s\n", TLSContext::hasHardwareAES() ? "yes" : "no");
+    std::printf("%-20s %16s %16s %12s %-28s\n", "profile", "full (hs/s)", "resumed (hs/s)", "bulk (MB/s)", "cipher");
+    TLSTestPeer peer;
+    for (auto &item : profiles) {
+        auto context = TLSContext::createWithDefaultCA();
+        if (!context || (item.UseProfile && !context->applyProfile(item.Profile))) {
+            std::fprintf(stderr, "Unable to create the context of %s\n", item.Name);
+            return 1;
+        }
+        const double full_rate = measureHandshakes(*context, peer, handshake_count, false);
+        const double resumed_rate = measureHandshakes(*context, peer, handshake_count, true);
+        Connection connection;
+        connect(*context, peer, connection);
+        const std::string cipher { SSL_CIPHER_get_name(SSL_get_current_cipher(connection.Client)) };
+        release(connection);
+        const double bulk_rate = measureBulk(*context, peer, megabytes);
+        std::printf("%-20s %16.0f %16.0f %12.1f %-28s\n", item.Name, full_rate, resumed_rate, bulk_rate, cipher.c_str());
+    }
+    return 0;
+}
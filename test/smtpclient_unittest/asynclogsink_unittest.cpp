@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../../src/asynclogsink.h"
+
+using namespace jed_utils;
+
+namespace {
+    LogEvent createEvent(LogDirection pDirection, const char *pText, int pReplyCode = 0) {
+        LogEvent event;
+        event.Timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(1700000000123));
+        event.SessionId = 7;
+        event.Direction = pDirection;
+        event.ReplyCode = pReplyCode;
+        event.Text = pText;
+        return event;
+    }
+
+    std::vector<std::string> readLines(const char *pFilename) {
+        std::ifstream file(pFilename);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+}  // namespace
+
+TEST(LogSink_format, WithServerEvent_ReturnSingleLine) {
+    ASSERT_EQ("2023-11-14T22:13:20.123Z [7] s: 250 OK\\r\\n",
+            LogSink::format(createEvent(LogDirection::Server, "250 OK\r\n", 250)));
+}
+
+TEST(LogSink_format, WithClientAndInfoEvents_ReturnTheirOrigin) {
+    ASSERT_EQ("2023-11-14T22:13:20.123Z [7] c: QUIT\\r\\n",
+            LogSink::format(createEvent(LogDirection::Client, "QUIT\r\n")));
+    ASSERT_EQ("2023-11-14T22:13:20.123Z [7] i: TLS session resumed",
+            LogSink::format(createEvent(LogDirection::Info, "TLS session resumed")));
+}
+
+TEST(AsyncLogSink_createFileSink, WithInvalidFilename_ReturnNull) {
+    ASSERT_EQ(nullptr, AsyncLogSink::createFileSink("/nonexistent/dir/log.txt"));
+    ASSERT_EQ(nullptr, AsyncLogSink::createFileSink(nullptr));
+}
+
+TEST(AsyncLogSink_write, WithEventsThenFlush_WriteOneLineEach) {
+    const char *filename = "asynclogsink_unittest.log";
+    std::remove(filename);
+    auto sink = AsyncLogSink::createFileSink(filename);
+    ASSERT_NE(nullptr, sink);
+    for (int i = 0; i < 1000; i++) {
+        LogEvent event = createEvent(LogDirection::Client, ("NOOP " + std::to_string(i) + "\r\n").c_str());
+        sink->write(event);
+    }
+    sink->flush();
+    std::vector<std::string> lines = readLines(filename);
+    ASSERT_EQ(1000U, lines.size());
+    ASSERT_EQ("2023-11-14T22:13:20.123Z [7] c: NOOP 0\\r\\n", lines.front());
+    ASSERT_EQ("2023-11-14T22:13:20.123Z [7] c: NOOP 999\\r\\n", lines.back());
+    ASSERT_EQ(0U, sink->getDroppedCount());
+    sink.reset();
+    std::remove(filename);
+}
+
+TEST(AsyncLogSink_write, WithLevelCommands_FilterHeadersAndFull) {
+    const char *filename = "asynclogsink_unittest_level.log";
+    auto sink = AsyncLogSink::createFileSink(filename, CommunicationLogLevel::Commands);
+    ASSERT_NE(nullptr, sink);
+    ASSERT_TRUE(sink->isEnabled(CommunicationLogLevel::Commands));
+    ASSERT_FALSE(sink->isEnabled(CommunicationLogLevel::Headers));
+    ASSERT_FALSE(sink->isEnabled(CommunicationLogLevel::Off));
+    sink.reset();
+    std::remove(filename);
+}
+
+TEST(AsyncLogSink_destructor, WithQueuedEvents_WriteThemAll) {
+    const char *filename = "asynclogsink_unittest_destructor.log";
+    std::remove(filename);
+    {
+        auto sink = AsyncLogSink::createFileSink(filename, CommunicationLogLevel::Full, 4096);
+        for (int i = 0; i < 100; i++) {
+            LogEvent event = createEvent(LogDirection::Server, "250 OK\r\n", 250);
+            sink->write(event);
+        }
+        ASSERT_EQ(0U, sink->getDroppedCount());
+    }
+    ASSERT_EQ(100U, readLines(filename).size());
+    std::remove(filename);
+}
+
+TEST(AsyncLogSink_write, WithFullQueue_DropAndCountEvents) {
+    const char *filename = "asynclogsink_unittest_dropped.log";
+    std::remove(filename);
+    auto sink = AsyncLogSink::createFileSink(filename, CommunicationLogLevel::Full, 2);
+    ASSERT_NE(nullptr, sink);
+    for (int i = 0; i < 10000; i++) {
+        LogEvent event = createEvent(LogDirection::Client, "NOOP\r\n");
+        sink->write(event);
+    }
+    sink->flush();
+    ASSERT_EQ(10000U, readLines(filename).size() + sink->getDroppedCount());
+    sink.reset();
+    std::remove(filename);
+}
@@ -0,0 +1,96 @@
+#include "../../src/asyncsmtpsession.h"
+
+#ifdef SMTPCLIENT_HAS_COROUTINES
+
+#include <gtest/gtest.h>
+#include <coroutine>
+#include <exception>
+#include <string>
+#include <vector>
+#include "../../src/cpp/plaintextmessage.hpp"
+#include "../../src/smtpclienterrors.h"
+
+using namespace jed_utils;
+
+namespace {
+// Minimal coroutine type that starts eagerly and is never awaited
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+SMTPSessionOptions createOptions() {
+    SMTPSessionOptions options;
+    options.ServerName = "localhost";
+    options.Security = SMTPSessionSecurity::None;
+    return options;
+}
+
+void reply(SMTPSession &pSession, const std::string &pReply) {
+    pSession.consumeOutput(pSession.getPendingOutputLength());
+    pSession.onReceive(pReply.data(), pReply.length());
+}
+
+DetachedTask sendOneMail(AsyncSMTPSession &pClient, std::vector<int> &pResults) {
+    pResults.push_back(co_await pClient.connect());
+    cpp::PlaintextMessage msg(cpp::MessageAddress("from@test.com"),
+            { cpp::MessageAddress("to@domain.com") },
+            "Subject",
+            "Hello");
+    pResults.push_back(co_await pClient.send(msg));
+    pResults.push_back(co_await pClient.quit());
+}
+
+DetachedTask sendEnvelope(AsyncSMTPSession &pClient, std::vector<int> &pResults) {
+    pResults.push_back(co_await pClient.mailFrom("from@test.com"));
+    pResults.push_back(co_await pClient.rcpt("to@domain.com"));
+}
+}  // namespace
+
+TEST(AsyncSMTPSession_send, WithValidReplies_ResumeAfterEachOperation) {
+    SMTPSession session(createOptions(), nullptr);
+    AsyncSMTPSession client(session);
+    std::vector<int> results;
+    sendOneMail(client, results);
+    session.onConnected();
+    reply(session, "220 localhost\r\n");
+    reply(session, "250 localhost\r\n");
+    ASSERT_EQ(std::vector<int>({ 0 }), results);
+    reply(session, "250 OK\r\n");
+    reply(session, "250 OK\r\n");
+    reply(session, "354 Go ahead\r\n");
+    reply(session, "250 Queued\r\n");
+    ASSERT_EQ(std::vector<int>({ 0, 0 }), results);
+    reply(session, "221 Bye\r\n");
+    ASSERT_EQ(std::vector<int>({ 0, 0, 221 }), results);
+}
+
+TEST(AsyncSMTPSession_rcpt, WithRejectedRecipient_ReturnReplyCode) {
+    SMTPSession session(createOptions(), nullptr);
+    AsyncSMTPSession client(session);
+    session.onConnected();
+    reply(session, "220 localhost\r\n");
+    reply(session, "250 localhost\r\n");
+    std::vector<int> results;
+    sendEnvelope(client, results);
+    reply(session, "250 OK\r\n");
+    reply(session, "550 No such user\r\n");
+    ASSERT_EQ(std::vector<int>({ 250, 550 }), results);
+}
+
+TEST(AsyncSMTPSession_connect, WithFailedSession_CompleteWithoutSuspending) {
+    SMTPSession session(createOptions(), nullptr);
+    session.onTransportError(CLIENT_SENDMAIL_MAILFROM_ERROR);
+    AsyncSMTPSession client(session);
+    std::vector<int> results;
+    sendOneMail(client, results);
+    ASSERT_EQ(3, results.size());
+    ASSERT_EQ(CLIENT_SENDMAIL_MAILFROM_ERROR, results[0]);
+}
+
+#endif  // SMTPCLIENT_HAS_COROUTINES
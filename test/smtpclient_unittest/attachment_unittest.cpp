@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 #include "../../src/attachment.h"
+#include "../../src/base64.h"
 #include "../../src/cpp/attachment.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
 
 using namespace jed_utils;
 
@@ -453,3 +458,109 @@ TEST(CPPAttachement, getBase64EncodedFile_NonExsitantFile_ReturnNullPTR) {
     ASSERT_EQ(att1.getBase64EncodedFile(), "");
 }
 
+
+TEST(Attachment, getEncodedFilename_Default_ReturnNullPTR) {
+    Attachment att1("test.png", "");
+    ASSERT_EQ(att1.getEncodedFilename(), nullptr);
+}
+
+TEST(Attachment, setEncodedFilename_ReturnEncodedFilename) {
+    Attachment att1("test.png", "");
+    att1.setEncodedFilename("test.png.b64");
+    ASSERT_EQ("test.png.b64", std::string(att1.getEncodedFilename()));
+    att1.setEncodedFilename(nullptr);
+    ASSERT_EQ(att1.getEncodedFilename(), nullptr);
+}
+
+TEST(Attachment, CopyConstructor_CopyEncodedFilename) {
+    Attachment att1("test.png", "");
+    att1.setEncodedFilename("test.png.b64");
+    Attachment att2(att1);
+    ASSERT_EQ("test.png.b64", std::string(att1.getEncodedFilename()));
+    ASSERT_EQ("test.png.b64", std::string(att2.getEncodedFilename()));
+}
+
+TEST(Attachment, CopyAssignment_CopyEncodedFilename) {
+    Attachment att1("test.png", "");
+    att1.setEncodedFilename("test.png.b64");
+    Attachment att2("aaa.png", "");
+    att2 = att1;
+    ASSERT_EQ("test.png.b64", std::string(att2.getEncodedFilename()));
+}
+
+TEST(Attachment, MoveConstructor_MoveEncodedFilename) {
+    Attachment att1("test.png", "");
+    att1.setEncodedFilename("test.png.b64");
+    Attachment att2(std::move(att1));
+    ASSERT_EQ("test.png.b64", std::string(att2.getEncodedFilename()));
+}
+
+TEST(Attachment, setContentId_CopyAndMove_KeepTheContentId) {
+    Attachment att1("test.png", "");
+    ASSERT_EQ(att1.getContentId(), nullptr);
+    att1.setContentId("logo@domain.com");
+    Attachment att2(att1);
+    ASSERT_EQ("logo@domain.com", std::string(att2.getContentId()));
+    Attachment att3("aaa.png", "");
+    att3 = att1;
+    ASSERT_EQ("logo@domain.com", std::string(att3.getContentId()));
+    Attachment att4(std::move(att1));
+    ASSERT_EQ("logo@domain.com", std::string(att4.getContentId()));
+}
+
+TEST(Attachment, getBase64EncodedFile_WithEncodedFile_ReturnFileContent) {
+    const char *encoded_filename = "attachment_unittest_encoded.b64";
+    std::ofstream(encoded_filename, std::ios::binary) << "SGVsbG8=";
+    Attachment att1("C:\\NonExistantfile.txt", "");
+    att1.setEncodedFilename(encoded_filename);
+    const char *encoded_file = att1.getBase64EncodedFile();
+    ASSERT_NE(encoded_file, nullptr);
+    ASSERT_EQ("SGVsbG8=", std::string(encoded_file));
+    delete[] encoded_file;
+    std::remove(encoded_filename);
+}
+
+TEST(Attachment, getBase64EncodedFile_WithLongFile_BreakLinesAt76Characters) {
+    const char *filename = "attachment_unittest_long.txt";
+    const std::string content(200, 'x');
+    std::ofstream(filename, std::ios::binary) << content;
+    Attachment att1(filename, "");
+    const char *encoded_file = att1.getBase64EncodedFile();
+    const size_t encoded_size = att1.getBase64EncodedSize();
+    std::remove(filename);
+    ASSERT_NE(encoded_file, nullptr);
+    const std::string encoded { encoded_file };
+    delete[] encoded_file;
+    ASSERT_EQ(76, encoded.find("\r\n"));
+    ASSERT_EQ(encoded.length(), encoded_size);
+    ASSERT_EQ(content, Base64::Decode(encoded));
+}
+
+TEST(Attachment, getBase64EncodedSize_WithEncodedFile_ReturnFileSize) {
+    const char *encoded_filename = "attachment_unittest_encoded_size.b64";
+    std::ofstream(encoded_filename, std::ios::binary) << "SGVsbG8=";
+    Attachment att1("C:\\NonExistantfile.txt", "");
+    att1.setEncodedFilename(encoded_filename);
+    ASSERT_EQ(8, att1.getBase64EncodedSize());
+    std::remove(encoded_filename);
+}
+
+TEST(Attachment, getBase64EncodedSize_NonExsitantFile_ReturnZero) {
+    Attachment att1("C:\\NonExistantfile.txt", "");
+    ASSERT_EQ(0, att1.getBase64EncodedSize());
+}
+
+TEST(CPPAttachement, setEncodedFilename_ReturnEncodedFilename) {
+    cpp::Attachment att1("test.png", "");
+    ASSERT_EQ("", att1.getEncodedFilename());
+    att1.setEncodedFilename("test.png.b64");
+    ASSERT_EQ("test.png.b64", att1.getEncodedFilename());
+    ASSERT_EQ("test.png.b64", std::string(att1.toStdAttachment().getEncodedFilename()));
+}
+
+TEST(CPPAttachement, setContentId_ReturnContentId) {
+    cpp::Attachment att1("test.png", "");
+    ASSERT_EQ("", att1.getContentId());
+    att1.setContentId("logo@domain.com");
+    ASSERT_EQ("logo@domain.com", std::string(att1.toStdAttachment().getContentId()));
+}
@@ -0,0 +1,143 @@
+#include "../../src/autosecuresmtpclient.h"
+#include "../../src/plaintextmessage.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <utility>
+#include "loopbackserver.h"
+#include "tlstestpeer.h"
+
+using namespace jed_utils;
+
+TEST(AutoSecureSMTPClient_Constructor, ValidArguments_ReturnDefaults) {
+    AutoSecureSMTPClient client("test", 587);
+    ASSERT_STREQ("test", client.getServerName());
+    ASSERT_EQ(587, client.getServerPort());
+    ASSERT_EQ(nullptr, client.getCapabilityCache());
+    ASSERT_FALSE(client.isCapabilityCacheHit());
+}
+
+TEST(AutoSecureSMTPClient_CapabilityCache, SetCapabilityCache_ReturnCache) {
+    AutoSecureSMTPClient client("test", 587);
+    auto cache = std::make_shared<ServerCapabilityCache>();
+    client.setCapabilityCache(cache);
+    ASSERT_EQ(cache, client.getCapabilityCache());
+}
+
+TEST(AutoSecureSMTPClient_CapabilityCache, CopyConstructor_ShareCache) {
+    AutoSecureSMTPClient client("test", 587);
+    auto cache = std::make_shared<ServerCapabilityCache>();
+    client.setCapabilityCache(cache);
+    AutoSecureSMTPClient copy(client);
+    ASSERT_EQ(cache, copy.getCapabilityCache());
+    ASSERT_EQ(cache, client.getCapabilityCache());
+}
+
+TEST(AutoSecureSMTPClient_CapabilityCache, MoveConstructor_MoveCache) {
+    AutoSecureSMTPClient client("test", 587);
+    auto cache = std::make_shared<ServerCapabilityCache>();
+    client.setCapabilityCache(cache);
+    AutoSecureSMTPClient moved(std::move(client));
+    ASSERT_EQ(cache, moved.getCapabilityCache());
+}
+
+#ifdef __linux__
+class AutoSecureSMTPClientFixture : public ::testing::Test {
+ public:
+    AutoSecureSMTPClientFixture()
+        : cache(std::make_shared<ServerCapabilityCache>()),
+          msg(MessageAddress("from@test.com"),
+              MessageAddress("to@domain.com"),
+              "Subject",
+              "Hello") {
+        X509_STORE *store = X509_STORE_new();
+        X509_STORE_add_cert(store, peer.getCertificate());
+        tls_context = TLSContext::createWithStore(store);
+        X509_STORE_free(store);
+    }
+
+    std::unique_ptr<AutoSecureSMTPClient> createClient() {
+        std::unique_ptr<AutoSecureSMTPClient> client(new AutoSecureSMTPClient("127.0.0.1", server.getPort()));
+        client->setCapabilityCache(cache);
+        client->setTLSContext(tls_context);
+        return client;
+    }
+
+    LoopbackServer server;
+    TLSTestPeer peer;
+    std::shared_ptr<TLSContext> tls_context;
+    std::shared_ptr<ServerCapabilityCache> cache;
+    PlaintextMessage msg;
+};
+
+TEST_F(AutoSecureSMTPClientFixture, PlainServer_FallBackToUnencryptedAndCache) {
+    server.serve();
+    auto client = createClient();
+    ASSERT_EQ(0, client->sendMail(msg));
+    ASSERT_EQ(ServerSecurityMode::Unencrypted, client->getSecurityMode());
+    ASSERT_FALSE(client->isCapabilityCacheHit());
+    // The TLS attempt, then the connection in clear text
+    ASSERT_EQ(2, server.getConnectionCount());
+    ServerCapabilities capabilities;
+    ASSERT_TRUE(cache->find("127.0.0.1", server.getPort(), capabilities));
+    ASSERT_EQ(ServerSecurityMode::Unencrypted, capabilities.SecurityMode);
+    ASSERT_NE(std::string::npos, capabilities.EhloResponse.find("SIZE 1000000"));
+}
+
+TEST_F(AutoSecureSMTPClientFixture, PlainServerCached_SkipTheProbe) {
+    server.serve();
+    ASSERT_EQ(0, createClient()->sendMail(msg));
+    auto client = createClient();
+    ASSERT_EQ(0, client->sendMail(msg));
+    ASSERT_TRUE(client->isCapabilityCacheHit());
+    ASSERT_EQ(ServerSecurityMode::Unencrypted, client->getSecurityMode());
+    ASSERT_EQ(3, server.getConnectionCount());
+}
+
+TEST_F(AutoSecureSMTPClientFixture, ImplicitTLSServer_UseImplicitTLSAndCache) {
+    server.serveTLS(peer.getServerContext());
+    auto client = createClient();
+    ASSERT_EQ(0, client->sendMail(msg));
+    ASSERT_EQ(ServerSecurityMode::Implicit, client->getSecurityMode());
+    ASSERT_EQ(1, server.getConnectionCount());
+    ServerCapabilities capabilities;
+    ASSERT_TRUE(cache->find("127.0.0.1", server.getPort(), capabilities));
+    ASSERT_EQ(ServerSecurityMode::Implicit, capabilities.SecurityMode);
+    ASSERT_TRUE(capabilities.Options.Auth);
+    ASSERT_TRUE(capabilities.Options.Plain);
+    ASSERT_TRUE(capabilities.Options.Login);
+    ASSERT_EQ(1000000, capabilities.Options.MaxMessageSize);
+}
+
+TEST_F(AutoSecureSMTPClientFixture, ImplicitTLSServerCached_UseCachedCapabilities) {
+    server.serveTLS(peer.getServerContext());
+    ASSERT_EQ(0, createClient()->sendMail(msg));
+    auto client = createClient();
+    ASSERT_EQ(0, client->sendMail(msg));
+    ASSERT_TRUE(client->isCapabilityCacheHit());
+    ASSERT_EQ(ServerSecurityMode::Implicit, client->getSecurityMode());
+    ASSERT_EQ(2, server.getConnectionCount());
+}
+
+TEST_F(AutoSecureSMTPClientFixture, ImplicitTLSServerWithReport_ReportTheResumption) {
+    server.serveTLS(peer.getServerContext());
+    SendReport first_report;
+    ASSERT_EQ(0, createClient()->sendMail(msg, &first_report));
+    ASSERT_FALSE(first_report.TLSResumed);
+    ASSERT_LT(0, first_report.getPhase(SendPhase::TLS).Duration.count());
+    SendReport report;
+    ASSERT_EQ(0, createClient()->sendMail(msg, &report));
+    ASSERT_TRUE(report.TLSResumed);
+}
+
+TEST_F(AutoSecureSMTPClientFixture, CachedModeRefused_RemoveFromCacheThenProbe) {
+    server.serve();
+    ServerCapabilities stale;
+    stale.SecurityMode = ServerSecurityMode::Implicit;
+    cache->store("127.0.0.1", server.getPort(), stale);
+    auto client = createClient();
+    ASSERT_NE(0, client->sendMail(msg));
+    ASSERT_EQ(0, cache->size());
+    ASSERT_EQ(0, client->sendMail(msg));
+    ASSERT_EQ(ServerSecurityMode::Unencrypted, client->getSecurityMode());
+}
+#endif
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "../../src/communicationlog.h"
+
+using namespace jed_utils;
+
+TEST(CommunicationLog_add, WithClientItem_ReturnEscapedLineBreaks) {
+    CommunicationLog log;
+    log.add("EHLO localhost\r\n", "c", true);
+    log.add("250 OK\r\n", "s", false);
+    ASSERT_EQ("\nc: EHLO localhost\\r\\n\ns: 250 OK\r\n", log.getText());
+    ASSERT_EQ(log.getText().length(), log.getSize());
+}
+
+TEST(CommunicationLog_add, WithLevelOff_KeepNothing) {
+    CommunicationLog log;
+    log.setLevel(CommunicationLogLevel::Off);
+    ASSERT_FALSE(log.isEnabled(CommunicationLogLevel::Commands));
+    log.add("QUIT\r\n", "c", true);
+    ASSERT_EQ("", log.getText());
+}
+
+TEST(CommunicationLog_isEnabled, WithHeadersLevel_ReturnTrueForCommandsAndHeaders) {
+    CommunicationLog log;
+    ASSERT_TRUE(log.isEnabled(CommunicationLogLevel::Full));
+    log.setLevel(CommunicationLogLevel::Headers);
+    ASSERT_TRUE(log.isEnabled(CommunicationLogLevel::Commands));
+    ASSERT_TRUE(log.isEnabled(CommunicationLogLevel::Headers));
+    ASSERT_FALSE(log.isEnabled(CommunicationLogLevel::Full));
+    ASSERT_FALSE(log.isEnabled(CommunicationLogLevel::Off));
+}
+
+TEST(CommunicationLog_add, WithItemsOverMaxSize_DropTheOldestItems) {
+    CommunicationLog log;
+    log.setMaxSize(CommunicationLog::CHUNK_SIZE * 2);
+    for (int index = 0; index < 1000; index++) {
+        log.add(("RCPT TO: <user" + std::to_string(index) + "@domain.com>").c_str(), "c", true);
+    }
+    ASSERT_GE(CommunicationLog::CHUNK_SIZE * 3, log.getSize());
+    const std::string &text = log.getText();
+    ASSERT_EQ(0, text.find("\nc: RCPT TO: <user"));
+    ASSERT_EQ(text.length() - 33, text.find("\nc: RCPT TO: <user999@domain.com>"));
+    ASSERT_EQ(std::string::npos, text.find("<user0@"));
+}
+
+TEST(CommunicationLog_add, WithItemLongerThanAChunk_KeepItWhole) {
+    CommunicationLog log;
+    log.setMaxSize(0);
+    const std::string item(CommunicationLog::CHUNK_SIZE * 3 + 10, 'a');
+    log.add(item.c_str(), "c", true);
+    log.add("b", "s", false);
+    ASSERT_EQ("\nc: " + item + "\ns: b", log.getText());
+    log.clear();
+    ASSERT_EQ(0, log.getSize());
+    ASSERT_EQ("", log.getText());
+}
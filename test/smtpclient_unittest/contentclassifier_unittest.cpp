@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "../../src/contentclassifier.h"
+
+using namespace jed_utils;
+
+TEST(ContentClassifier_classify, WithEmptyContent_ReturnSevenBit) {
+    ContentClassification result = ContentClassifier::classify("", 0);
+    ASSERT_EQ(0, result.EightBitCount);
+    ASSERT_FALSE(result.Binary);
+    ASSERT_EQ(0, result.LongestLine);
+    ASSERT_EQ(TransferEncoding::SevenBit, ContentClassifier::selectEncoding(result, 0, false));
+}
+
+TEST(ContentClassifier_classify, WithASCIILines_ReturnLongestLineWithoutCRLF) {
+    const std::string content { "Hello\r\nThis is a longer line of text\r\nBye" };
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_EQ(0, result.EightBitCount);
+    ASSERT_FALSE(result.Binary);
+    ASSERT_EQ(29, result.LongestLine);
+}
+
+TEST(ContentClassifier_classify, WithEightBitBytesInSeveralBlocks_CountThem) {
+    std::string content(100, 'a');
+    content[3] = '\xC3';
+    content[4] = '\xA9';
+    content[40] = '\xE2';
+    content[99] = '\xFF';
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_EQ(4, result.EightBitCount);
+    ASSERT_EQ(100, result.LongestLine);
+}
+
+TEST(ContentClassifier_classify, WithNulByte_ReturnBinary) {
+    const std::string content("abc\0def", 7);
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_TRUE(result.Binary);
+    ASSERT_EQ(TransferEncoding::Base64, ContentClassifier::selectEncoding(result, content.length(), true));
+}
+
+TEST(ContentClassifier_classify, WithLineBreakAtBlockBoundaries_ReturnLongestLine) {
+    std::string content;
+    content += std::string(15, 'a') + "\r\n";
+    content += std::string(1000, 'b') + "\n";
+    content += std::string(31, 'c');
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_EQ(1000, result.LongestLine);
+}
+
+TEST(ContentClassifier_classify, WithBareLineBreaks_CountThem) {
+    std::string content { "\nline\r\nline\rline\r\r\n" };
+    content += std::string(14, 'a') + "\r\n" + std::string(15, 'b') + "\r";
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_EQ(4, result.BareLineBreakCount);
+}
+
+TEST(ContentClassifier_classify, WithInvalidUTF8_ReturnBase64) {
+    const std::string content { "Bonjour, \xE7" "a va?" };
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_TRUE(result.InvalidUTF8);
+    ASSERT_EQ(TransferEncoding::Base64, ContentClassifier::selectEncoding(result, content.length(), true));
+    const std::string valid_content { "Bonjour, \xC3\xA7" "a va?" };
+    ASSERT_FALSE(ContentClassifier::classify(valid_content.data(), valid_content.length()).InvalidUTF8);
+}
+
+TEST(ContentClassifier_selectEncoding, WithEightBitAndEightBitMime_ReturnEightBit) {
+    const std::string content { "Bonjour, \xC3\xA7" "a va?" };
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_EQ(TransferEncoding::EightBit, ContentClassifier::selectEncoding(result, content.length(), true));
+}
+
+TEST(ContentClassifier_selectEncoding, WithMostlyASCIIAndNoEightBitMime_ReturnQuotedPrintable) {
+    const std::string content { "Bonjour, \xC3\xA7" "a va?" };
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_EQ(TransferEncoding::QuotedPrintable, ContentClassifier::selectEncoding(result, content.length(), false));
+}
+
+TEST(ContentClassifier_selectEncoding, WithMostlyEightBitAndNoEightBitMime_ReturnBase64) {
+    const std::string content { "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E" };
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_EQ(TransferEncoding::Base64, ContentClassifier::selectEncoding(result, content.length(), false));
+}
+
+TEST(ContentClassifier_selectEncoding, WithLongASCIILine_ReturnQuotedPrintable) {
+    const std::string content(999, 'a');
+    ContentClassification result = ContentClassifier::classify(content.data(), content.length());
+    ASSERT_EQ(TransferEncoding::QuotedPrintable, ContentClassifier::selectEncoding(result, content.length(), true));
+}
+
+TEST(ContentClassifier_getEncodingName, ReturnHeaderValues) {
+    ASSERT_EQ("7bit", std::string(ContentClassifier::getEncodingName(TransferEncoding::SevenBit)));
+    ASSERT_EQ("8bit", std::string(ContentClassifier::getEncodingName(TransferEncoding::EightBit)));
+    ASSERT_EQ("quoted-printable", std::string(ContentClassifier::getEncodingName(TransferEncoding::QuotedPrintable)));
+    ASSERT_EQ("base64", std::string(ContentClassifier::getEncodingName(TransferEncoding::Base64)));
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include "../../src/datastuffer.h"
+
+using namespace jed_utils;
+
+namespace {
+    std::string stuff(const std::string &pContent) {
+        std::string output;
+        DataStuffer().write(pContent.data(), pContent.length(), output);
+        return output;
+    }
+}  // namespace
+
+TEST(DataStuffer_write, WithPlainLines_ReturnSameContent) {
+    ASSERT_EQ("Hello\r\nWorld. Bye.\r\n", stuff("Hello\r\nWorld. Bye.\r\n"));
+}
+
+TEST(DataStuffer_write, WithLeadingDot_ReturnDoubledDot) {
+    ASSERT_EQ("..Hello", stuff(".Hello"));
+}
+
+TEST(DataStuffer_write, WithDotAtStartOfLines_ReturnDoubledDots) {
+    ASSERT_EQ("a\r\n..b\r\n..\r\n...c", stuff("a\r\n.b\r\n.\r\n..c"));
+}
+
+TEST(DataStuffer_write, WithBareLineBreaks_ReturnCRLF) {
+    ASSERT_EQ("a\r\nb\r\nc\r\n\r\nd", stuff("a\nb\rc\r\rd"));
+}
+
+TEST(DataStuffer_write, WithDotAfterBareLineBreaks_ReturnDoubledDots) {
+    ASSERT_EQ("a\r\n..b\r\n..c", stuff("a\n.b\r.c"));
+}
+
+TEST(DataStuffer_write, WithLongContent_ReturnSameAsByteWise) {
+    std::string content;
+    std::string expected;
+    for (int index = 0; index < 50; index++) {
+        content += std::string(static_cast<size_t>(index), 'x') + "\n." + std::string(17, 'y') + ".";
+        expected += std::string(static_cast<size_t>(index), 'x') + "\r\n.." + std::string(17, 'y') + ".";
+    }
+    ASSERT_EQ(expected, stuff(content));
+}
+
+TEST(DataStuffer_write, WithContentInChunks_ReturnSameAsWhole) {
+    const std::string content { ".a\r\n.b\rc\n\n.d\r\n" + std::string(40, 'e') + "\r\n." };
+    for (size_t chunk_length = 1; chunk_length < content.length(); chunk_length++) {
+        DataStuffer stuffer;
+        std::string output;
+        for (size_t offset = 0; offset < content.length(); offset += chunk_length) {
+            const size_t length = std::min(chunk_length, content.length() - offset);
+            stuffer.write(content.data() + offset, length, output);
+        }
+        ASSERT_EQ(stuff(content), output) << "chunk length " << chunk_length;
+    }
+}
+
+TEST(DataStuffer_reset, AfterContent_StartANewLine) {
+    DataStuffer stuffer;
+    std::string output;
+    stuffer.write("a\r", 2, output);
+    stuffer.reset();
+    stuffer.write("\n.", 2, output);
+    ASSERT_EQ("a\r\n\r\n..", output);
+}
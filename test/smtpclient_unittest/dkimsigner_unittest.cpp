@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <string>
+#include <vector>
+#include "../../src/base64.h"
+#include "../../src/dkimsigner.h"
+
+using namespace jed_utils;
+
+namespace {
+    std::string generateKeyPEM(int pType) {
+        EVP_PKEY *key = nullptr;
+        EVP_PKEY_CTX *context = EVP_PKEY_CTX_new_id(pType, nullptr);
+        EVP_PKEY_keygen_init(context);
+        if (pType == EVP_PKEY_RSA) {
+            EVP_PKEY_CTX_set_rsa_keygen_bits(context, 1024);
+        }
+        EVP_PKEY_keygen(context, &key);
+        EVP_PKEY_CTX_free(context);
+        BIO *bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+        char *data = nullptr;
+        const long length = BIO_get_mem_data(bio, &data);
+        std::string pem(data, static_cast<size_t>(length));
+        BIO_free(bio);
+        EVP_PKEY_free(key);
+        return pem;
+    }
+
+    std::string bodyHash(DKIMCanonicalization pCanonicalization, const std::string &pBody) {
+        DKIMBodyHasher hasher(pCanonicalization);
+        hasher.update(pBody.data(), pBody.length());
+        return hasher.finish();
+    }
+
+    std::string sha256(const std::string &pData) {
+        unsigned char hash[EVP_MAX_MD_SIZE];
+        unsigned int hash_length = 0;
+        EVP_Digest(pData.data(), pData.length(), hash, &hash_length, EVP_sha256(), nullptr);
+        return Base64::Encode(hash, hash_length);
+    }
+
+    std::string removeFolding(std::string pValue) {
+        for (size_t position = pValue.find("\r\n "); position != std::string::npos; position = pValue.find("\r\n ")) {
+            pValue.erase(position, 3);
+        }
+        return pValue;
+    }
+
+    // Verify a signature made with the simple header canonicalization
+    bool verify(const std::string &pPEM, const std::string &pHeaders, const std::string &pField) {
+        const size_t signature_start = pField.find("\r\n b=") + 5;
+        const std::string signature { Base64::Decode(removeFolding(pField.substr(signature_start, pField.length() - signature_start - 2))) };
+        std::string data { pHeaders + pField.substr(0, signature_start) };
+        BIO *bio = BIO_new_mem_buf(pPEM.c_str(), -1);
+        EVP_PKEY *key = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+        BIO_free(bio);
+        const bool is_ed25519 = EVP_PKEY_base_id(key) == EVP_PKEY_ED25519;
+        if (is_ed25519) {
+            data = Base64::Decode(sha256(data));
+        }
+        EVP_MD_CTX *context = EVP_MD_CTX_new();
+        const bool valid = EVP_DigestVerifyInit(context, nullptr, is_ed25519 ? nullptr : EVP_sha256(), nullptr, key) == 1
+            && EVP_DigestVerify(context, reinterpret_cast<const unsigned char *>(signature.data()), signature.length(),
+                    reinterpret_cast<const unsigned char *>(data.data()), data.length()) == 1;
+        EVP_MD_CTX_free(context);
+        EVP_PKEY_free(key);
+        return valid;
+    }
+}  // namespace
+
+TEST(DKIMBodyHasher_finish, WithEmptyBody_ReturnHashesOfRFC6376) {
+    ASSERT_EQ("frcCV1k9oG9oKj3dpUqdJg1PxRT2RSN/XKdLCPjaYaY=", bodyHash(DKIMCanonicalization::Simple, ""));
+    ASSERT_EQ("47DEQpj8HBSa+/TImW+5JCeuQeRkm5NMpJWZG3hSuFU=", bodyHash(DKIMCanonicalization::Relaxed, ""));
+}
+
+TEST(DKIMBodyHasher_update, WithSimple_ReduceTheTrailingEmptyLines) {
+    ASSERT_EQ(sha256("Hello \r\n\r\nWorld\r\n"), bodyHash(DKIMCanonicalization::Simple, "Hello \r\n\r\nWorld\r\n\r\n\r\n"));
+    ASSERT_EQ(sha256("Hello\r\n"), bodyHash(DKIMCanonicalization::Simple, "Hello"));
+}
+
+TEST(DKIMBodyHasher_update, WithRelaxed_ReduceTheWhitespaces) {
+    ASSERT_EQ(sha256(" Hello World\r\n\r\nBye\r\n"), bodyHash(DKIMCanonicalization::Relaxed, " \tHello  \t World \r\n \r\nBye\t\r\n\r\n"));
+}
+
+TEST(DKIMBodyHasher_update, WithBareLineBreaks_HashThemAsCRLF) {
+    ASSERT_EQ(sha256("a\r\nb\r\nc\r\n"), bodyHash(DKIMCanonicalization::Simple, "a\nb\rc"));
+}
+
+TEST(DKIMBodyHasher_update, WithChunks_ReturnTheHashOfTheWholeBody) {
+    const std::string body { std::string(5000, 'a') + " \r\n\r\n b  c\r\n" + std::string(100, 'd') + "\r\n\r\n" };
+    for (auto canonicalization : { DKIMCanonicalization::Simple, DKIMCanonicalization::Relaxed }) {
+        DKIMBodyHasher hasher(canonicalization);
+        for (size_t offset = 0; offset < body.length(); offset += 7) {
+            hasher.update(body.data() + offset, std::min<size_t>(7, body.length() - offset));
+        }
+        ASSERT_EQ(bodyHash(canonicalization, body), hasher.finish());
+    }
+}
+
+TEST(DKIMSigner_addKey, WithInvalidKey_ReturnFalse) {
+    DKIMSigner signer;
+    ASSERT_FALSE(signer.addKey("test.com", "sel", "not a key"));
+    ASSERT_FALSE(signer.hasKey("test.com"));
+}
+
+TEST(DKIMSigner_createSignatureField, WithEd25519Key_ReturnValidSignature) {
+    const std::string pem { generateKeyPEM(EVP_PKEY_ED25519) };
+    DKIMSigner signer;
+    ASSERT_TRUE(signer.addKey("Test.com", "sel", pem.c_str()));
+    ASSERT_TRUE(signer.hasKey("test.COM"));
+    signer.setCanonicalization(DKIMCanonicalization::Simple, DKIMCanonicalization::Simple);
+    const std::string headers { "From: a@test.com\r\nSubject: Hi\r\n" };
+    const std::string body_hash { bodyHash(DKIMCanonicalization::Simple, "Hello") };
+    const std::string field { signer.createSignatureField("test.com", headers.data(), headers.length(), body_hash) };
+    ASSERT_EQ(0, field.find("DKIM-Signature: v=1; a=ed25519-sha256; c=simple/simple; d=test.com; s=sel;\r\n"
+                " h=from:subject;\r\n bh=" + body_hash + ";\r\n b="));
+    ASSERT_EQ(signer.getSignatureFieldLength("test.com", headers.data(), headers.length()), field.length());
+    ASSERT_TRUE(verify(pem, headers, field));
+}
+
+TEST(DKIMSigner_createSignatureField, WithRSAKey_ReturnValidFoldedSignature) {
+    const std::string pem { generateKeyPEM(EVP_PKEY_RSA) };
+    DKIMSigner signer;
+    ASSERT_TRUE(signer.addKey("test.com", "sel", pem.c_str()));
+    signer.setCanonicalization(DKIMCanonicalization::Simple, DKIMCanonicalization::Relaxed);
+    const std::string headers { "From: a@test.com\r\nSubject: Hi\r\n\r\nIgnored: field\r\n" };
+    const std::string field { signer.createSignatureField("test.com", headers.data(), headers.length(), bodyHash(DKIMCanonicalization::Relaxed, "")) };
+    ASSERT_EQ(0, field.find("DKIM-Signature: v=1; a=rsa-sha256; c=simple/relaxed;"));
+    ASSERT_EQ(signer.getSignatureFieldLength("test.com", headers.data(), headers.length()), field.length());
+    size_t line_start = 0;
+    for (size_t line_end = field.find("\r\n"); line_end != std::string::npos; line_end = field.find("\r\n", line_start)) {
+        ASSERT_GE(78, line_end - line_start);
+        line_start = line_end + 2;
+    }
+    ASSERT_TRUE(verify(pem, headers.substr(0, headers.find("\r\n\r\n") + 2), field));
+}
+
+TEST(DKIMSigner_createSignatureField, WithUnknownDomain_ReturnEmpty) {
+    DKIMSigner signer;
+    ASSERT_TRUE(signer.addKey("test.com", "sel", generateKeyPEM(EVP_PKEY_ED25519).c_str()));
+    const std::string headers { "From: a@other.com\r\n" };
+    ASSERT_EQ("", signer.createSignatureField("other.com", headers.data(), headers.length(), bodyHash(DKIMCanonicalization::Simple, "")));
+    ASSERT_EQ(0, signer.getSignatureFieldLength("other.com", headers.data(), headers.length()));
+}
@@ -167,6 +167,11 @@ TEST(ErrorResolver_getErrorMessage, WithSSL_CLIENT_STARTTLS_VERIFY_RESULT_ERROR_
     ASSERT_EQ("Unable to verify the result of chain verification"s, errorResolver.getErrorMessage());
 }
 
+TEST(ErrorResolver_getErrorMessage, WithSSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT_ReturnValidMessage) {
+    ErrorResolver errorResolver(SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT);
+    ASSERT_EQ("The TLS handshake timed out"s, errorResolver.getErrorMessage());
+}
+
 TEST(ErrorResolver_getErrorMessage, WithSSL_CLIENT_INITSECURECLIENT_ERROR_ReturnValidMessage) {
     ErrorResolver errorResolver(SSL_CLIENT_INITSECURECLIENT_ERROR);
     ASSERT_EQ("Unable to EHLO the server via the secure channel"s, errorResolver.getErrorMessage());
@@ -272,6 +277,36 @@ TEST(ErrorResolver_getErrorMessage, WithCLIENT_SENDMAIL_QUIT_ERROR_ReturnValidMe
     ASSERT_EQ("The QUIT command return an error"s, errorResolver.getErrorMessage());
 }
 
+TEST(ErrorResolver_getErrorMessage, WithCLIENT_SENDMAIL_QUIT_TIMEOUT_ReturnValidMessage) {
+    ErrorResolver errorResolver(CLIENT_SENDMAIL_QUIT_TIMEOUT);
+    ASSERT_EQ("The QUIT command timed out"s, errorResolver.getErrorMessage());
+}
+
+TEST(ErrorResolver_getErrorMessage, WithCLIENT_SENDMAIL_RSET_ERROR_ReturnValidMessage) {
+    ErrorResolver errorResolver(CLIENT_SENDMAIL_RSET_ERROR);
+    ASSERT_EQ("The RSET command return an error"s, errorResolver.getErrorMessage());
+}
+
+TEST(ErrorResolver_getErrorMessage, WithCLIENT_SENDMAIL_RSET_TIMEOUT_ReturnValidMessage) {
+    ErrorResolver errorResolver(CLIENT_SENDMAIL_RSET_TIMEOUT);
+    ASSERT_EQ("The RSET command timed out"s, errorResolver.getErrorMessage());
+}
+
+TEST(ErrorResolver_getErrorMessage, WithCLIENT_SENDMAIL_ENCODED_FILE_ERROR_ReturnValidMessage) {
+    ErrorResolver errorResolver(CLIENT_SENDMAIL_ENCODED_FILE_ERROR);
+    ASSERT_EQ("Unable to open the encoded attachment file"s, errorResolver.getErrorMessage());
+}
+
+TEST(ErrorResolver_getErrorMessage, WithCLIENT_SENDMAIL_MESSAGE_TOO_LARGE_ReturnValidMessage) {
+    ErrorResolver errorResolver(CLIENT_SENDMAIL_MESSAGE_TOO_LARGE);
+    ASSERT_EQ("The message exceeds the maximum size accepted by the server"s, errorResolver.getErrorMessage());
+}
+
+TEST(ErrorResolver_getErrorMessage, WithCLIENT_SENDMAIL_HEADERS_ERROR_ReturnValidMessage) {
+    ErrorResolver errorResolver(CLIENT_SENDMAIL_HEADERS_ERROR);
+    ASSERT_EQ("The headers of the message return an error"s, errorResolver.getErrorMessage());
+}
+
 TEST(ErrorResolver_getErrorMessage, WithSMTPSERVER_AUTHENTICATIONREQUIRED_ERROR_ReturnValidMessage) {
     ErrorResolver errorResolver(SMTPSERVER_AUTHENTICATIONREQUIRED_ERROR);
     ASSERT_EQ("Authentication required"s, errorResolver.getErrorMessage());
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "../../src/base64.h"
+#include "../../src/headerencoder.h"
+
+using namespace jed_utils;
+
+namespace {
+    std::string subject(const std::string &pValue) {
+        std::string output;
+        HeaderEncoder::appendUnstructured(output, "Subject", pValue.c_str());
+        return output;
+    }
+
+    std::vector<std::string> splitLines(const std::string &pHeader) {
+        std::vector<std::string> lines;
+        size_t start = 0;
+        size_t end = 0;
+        while ((end = pHeader.find("\r\n", start)) != std::string::npos) {
+            lines.push_back(pHeader.substr(start, end - start));
+            start = end + 2;
+        }
+        return lines;
+    }
+}  // namespace
+
+TEST(HeaderEncoder_needsEncoding, WithPrintableASCIIAndTabs_ReturnFalse) {
+    const std::string value { std::string(40, 'a') + "\t" + std::string(40, 'b') };
+    ASSERT_FALSE(HeaderEncoder::needsEncoding(value.data(), value.length()));
+}
+
+TEST(HeaderEncoder_needsEncoding, WithEightBitOrControlInAnyBlock_ReturnTrue) {
+    std::string value(50, 'a');
+    value[37] = '\xC3';
+    ASSERT_TRUE(HeaderEncoder::needsEncoding(value.data(), value.length()));
+    value[37] = 'a';
+    value[49] = '\n';
+    ASSERT_TRUE(HeaderEncoder::needsEncoding(value.data(), value.length()));
+}
+
+TEST(HeaderEncoder_appendUnstructured, WithShortASCII_ReturnValueAsIs) {
+    ASSERT_EQ("Subject: Hello World!\r\n", subject("Hello World!"));
+}
+
+TEST(HeaderEncoder_appendUnstructured, WithMostlyASCII_ReturnQEncodedWord) {
+    ASSERT_EQ("Subject: =?UTF-8?Q?Bonjour=2C_=C3=A7a_va=3F?=\r\n", subject("Bonjour, \xC3\xA7" "a va?"));
+}
+
+TEST(HeaderEncoder_appendUnstructured, WithMostlyNonASCII_ReturnBEncodedWord) {
+    ASSERT_EQ("Subject: =?UTF-8?B?5pel5pys6Kqe?=\r\n", subject("\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E"));
+}
+
+TEST(HeaderEncoder_appendUnstructured, WithLineBreaks_ReturnEncodedWordWithoutLineBreak) {
+    const std::string header { subject("Hello\r\nBcc: someone@domain.com") };
+    ASSERT_EQ(1, splitLines(header).size());
+    ASSERT_EQ(0, header.find("Subject: =?UTF-8?Q?Hello=0D=0ABcc"));
+}
+
+TEST(HeaderEncoder_appendUnstructured, WithLongASCII_ReturnFoldedLines) {
+    std::string value;
+    for (int index = 0; index < 40; index++) {
+        value += "word" + std::to_string(index) + " ";
+    }
+    value += "end";
+    const std::string header { subject(value) };
+    const std::vector<std::string> lines { splitLines(header) };
+    ASSERT_LT(1, lines.size());
+    for (size_t index = 0; index < lines.size(); index++) {
+        ASSERT_GE(HeaderEncoder::MAX_LINE_LENGTH, lines[index].length());
+        if (index > 0) {
+            ASSERT_EQ(' ', lines[index][0]);
+        }
+    }
+    // Unfolding gives the value back
+    std::string unfolded;
+    for (const auto &line : lines) {
+        unfolded += line;
+    }
+    ASSERT_EQ("Subject: " + value, unfolded);
+}
+
+TEST(HeaderEncoder_appendUnstructured, WithLongWordWithoutWhitespace_ReturnItWhole) {
+    const std::string value { std::string(100, 'a') + " b" };
+    ASSERT_EQ("Subject: " + std::string(100, 'a') + "\r\n b\r\n", subject(value));
+}
+
+TEST(HeaderEncoder_appendUnstructured, WithLongNonASCII_ReturnWordsOfWholeCharacters) {
+    std::string value;
+    for (int index = 0; index < 60; index++) {
+        value += "\xC3\xA9";
+    }
+    const std::vector<std::string> lines { splitLines(subject(value)) };
+    ASSERT_LT(1, lines.size());
+    std::string decoded;
+    for (size_t index = 0; index < lines.size(); index++) {
+        const std::string &line = lines[index];
+        ASSERT_GE(HeaderEncoder::MAX_LINE_LENGTH, line.length());
+        const size_t word_start = line.find("=?UTF-8?B?");
+        ASSERT_NE(std::string::npos, word_start);
+        ASSERT_GE(HeaderEncoder::MAX_ENCODED_WORD_LENGTH, line.length() - word_start);
+        const std::string word { Base64::Decode(line.substr(word_start + 10, line.length() - word_start - 12)) };
+        ASSERT_EQ(0, word.length() % 2);
+        decoded += word;
+    }
+    ASSERT_EQ(value, decoded);
+}
+
+TEST(HeaderEncoder_appendUnstructured, WithInvalidUTF8_ReturnReplacementCharacter) {
+    ASSERT_EQ("Subject: =?UTF-8?Q?Hello_World_and_=EF=BF=BD?=\r\n", subject("Hello World and \xE7"));
+}
+
+TEST(HeaderEncoder_appendMailbox, WithASCIIDisplayName_ReturnQuotedName) {
+    std::string output;
+    HeaderEncoder::appendMailbox(output, "From", "John \"JD\" Doe", "john@domain.com");
+    ASSERT_EQ("From: \"John \\\"JD\\\" Doe\" <john@domain.com>\r\n", output);
+}
+
+TEST(HeaderEncoder_appendMailbox, WithEmptyDisplayName_ReturnEmptyQuotes) {
+    std::string output;
+    HeaderEncoder::appendMailbox(output, "From", "", "john@domain.com");
+    ASSERT_EQ("From: \"\" <john@domain.com>\r\n", output);
+}
+
+TEST(HeaderEncoder_appendMailbox, WithNonASCIIDisplayName_ReturnEncodedWord) {
+    std::string output;
+    HeaderEncoder::appendMailbox(output, "From", "J\xC3\xA9r\xC3\xB4me", "jerome@domain.com");
+    ASSERT_EQ("From: =?UTF-8?B?SsOpcsO0bWU=?= <jerome@domain.com>\r\n", output);
+}
@@ -72,5 +72,15 @@ TEST(HTMLMessage_ConversionToStdHtmlMessage, WithExtendedArgs_ReturnSuccess) {
     ASSERT_EQ(2, stdMsg.getAttachmentsCount());
 }
 
+TEST(HTMLMessage_ConversionToStdHtmlMessage, WithAlternativeBody_ReturnAlternativeBody) {
+    HTMLMessage msg(MessageAddress("from@from.com"),
+                   { MessageAddress("to@to.com") },
+                   "Subject",
+                   "<p>Body</p>");
+    msg.setAlternativeBody("Body");
+    auto stdMsg = static_cast<jed_utils::HTMLMessage>(msg);
+    ASSERT_STREQ("Body", stdMsg.getAlternativeBody());
+}
+
 }  // namespace cpp_htmlmessage
 }  // namespace jed_utils_unittest
@@ -0,0 +1,215 @@
+#ifndef LOOPBACKSERVER_H
+#define LOOPBACKSERVER_H
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <openssl/ssl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal scripted SMTP server listening on 127.0.0.1 used by the tests that
+// need a real connection. Each connection is served by its own thread.
+// With serveTLS, the server expects TLS from the initial connection.
+class LoopbackServer {
+ public:
+    LoopbackServer()
+        : mListenSocket(socket(AF_INET, SOCK_STREAM, 0)),
+          mPort(0),
+          mConnectionCount(0),
+          mAnswerQuit(true),
+          mCloseAfterMessage(false),
+          mRejectReset(false),
+          mServerContext(nullptr) {
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(mListenSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        listen(mListenSocket, 16);
+        socklen_t length = sizeof(address);
+        getsockname(mListenSocket, reinterpret_cast<sockaddr *>(&address), &length);
+        mPort = ntohs(address.sin_port);
+    }
+
+    ~LoopbackServer() {
+        // Wakes up the accept call
+        shutdown(mListenSocket, SHUT_RDWR);
+        if (mAcceptThread.joinable()) {
+            mAcceptThread.join();
+        }
+        for (auto &thread : mConnectionThreads) {
+            thread.join();
+        }
+        close(mListenSocket);
+    }
+
+    unsigned int getPort() const {
+        return mPort;
+    }
+
+    int getConnectionCount() const {
+        return mConnectionCount;
+    }
+
+    std::vector<std::string> getCommands() {
+        std::lock_guard<std::mutex> lock(mCommandsMutex);
+        return mCommands;
+    }
+
+    // Wait until a command is received, since the client does not wait for
+    // the reply to QUIT. Return false after pTimeoutMs milliseconds.
+    bool waitForCommand(const std::string &pCommand, int pTimeoutMs = 2000) {
+        for (int elapsed = 0; elapsed < pTimeoutMs; elapsed += 10) {
+            std::vector<std::string> commands = getCommands();
+            if (std::find(commands.begin(), commands.end(), pCommand) != commands.end()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    // The DATA content received (lines separated by CRLF)
+    std::string getData() {
+        std::lock_guard<std::mutex> lock(mCommandsMutex);
+        return mData;
+    }
+
+    // Close each connection once a message is queued, as an idle timeout would
+    void setCloseAfterMessage(bool pValue) {
+        mCloseAfterMessage = pValue;
+    }
+
+    // Answer RSET with 421 and close the connection
+    void setRejectReset(bool pValue) {
+        mRejectReset = pValue;
+    }
+
+    // Same as serve, over TLS from the initial connection
+    void serveTLS(SSL_CTX *pServerContext) {
+        mServerContext = pServerContext;
+        serve();
+    }
+
+    // Accept clients and answer each command with a positive reply
+    void serve(bool pAnswerQuit = true) {
+        mAnswerQuit = pAnswerQuit;
+        mAcceptThread = std::thread([this]() {
+            int client = -1;
+            while ((client = accept(mListenSocket, nullptr, nullptr)) >= 0) {
+                mConnectionCount++;
+                mConnectionThreads.emplace_back(&LoopbackServer::handleConnection, this, client);
+            }
+        });
+    }
+
+ private:
+    static void sendReply(int pSocket, SSL *pSSL, const std::string &pReply) {
+        if (pSSL != nullptr) {
+            SSL_write(pSSL, pReply.data(), static_cast<int>(pReply.length()));
+        } else {
+            send(pSocket, pReply.data(), pReply.length(), MSG_NOSIGNAL);
+        }
+    }
+
+    static ssize_t receive(int pSocket, SSL *pSSL, char *pBuffer, size_t pLength) {
+        if (pSSL != nullptr) {
+            return SSL_read(pSSL, pBuffer, static_cast<int>(pLength));
+        }
+        return recv(pSocket, pBuffer, pLength, 0);
+    }
+
+    void handleConnection(int pClient) {
+        SSL *ssl = nullptr;
+        if (mServerContext != nullptr) {
+            ssl = SSL_new(mServerContext);
+            SSL_set_fd(ssl, pClient);
+            if (SSL_accept(ssl) != 1) {
+                SSL_free(ssl);
+                close(pClient);
+                return;
+            }
+        }
+        handleCommands(pClient, ssl);
+        SSL_free(ssl);
+        close(pClient);
+    }
+
+    void handleCommands(int pClient, SSL *pSSL) {
+        sendReply(pClient, pSSL, "220 localhost ESMTP\r\n");
+        std::string buffer;
+        char chunk[4096];
+        ssize_t length = 0;
+        bool in_data = false;
+        while ((length = receive(pClient, pSSL, chunk, sizeof(chunk))) > 0) {
+            buffer.append(chunk, static_cast<size_t>(length));
+            size_t line_end = 0;
+            while ((line_end = buffer.find("\r\n")) != std::string::npos) {
+                std::string line = buffer.substr(0, line_end);
+                buffer.erase(0, line_end + 2);
+                if (in_data) {
+                    if (line == ".") {
+                        in_data = false;
+                        sendReply(pClient, pSSL, "250 2.0.0 Ok: queued as 4F2A1B3C\r\n");
+                        if (mCloseAfterMessage) {
+                            return;
+                        }
+                    } else {
+                        // Remove the dot added by the client (RFC 5321, section 4.5.2)
+                        if (!line.empty() && line[0] == '.') {
+                            line.erase(0, 1);
+                        }
+                        std::lock_guard<std::mutex> lock(mCommandsMutex);
+                        mData += line + "\r\n";
+                    }
+                    continue;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mCommandsMutex);
+                    mCommands.push_back(line);
+                }
+                if (line.compare(0, 4, "ehlo") == 0) {
+                    sendReply(pClient, pSSL, "250-localhost\r\n250-AUTH PLAIN LOGIN\r\n250 SIZE 1000000\r\n");
+                } else if (line == "DATA") {
+                    in_data = true;
+                    sendReply(pClient, pSSL, "354 Go ahead\r\n");
+                } else if (line == "RSET" && mRejectReset) {
+                    sendReply(pClient, pSSL, "421 4.4.2 Service not available\r\n");
+                    return;
+                } else if (line == "QUIT") {
+                    if (mAnswerQuit) {
+                        sendReply(pClient, pSSL, "221 Bye\r\n");
+                    }
+                    return;
+                } else {
+                    sendReply(pClient, pSSL, "250 OK\r\n");
+                }
+            }
+        }
+    }
+
+    int mListenSocket;
+    unsigned int mPort;
+    std::atomic<int> mConnectionCount;
+    bool mAnswerQuit;
+    bool mCloseAfterMessage;
+    bool mRejectReset;
+    SSL_CTX *mServerContext;
+    std::thread mAcceptThread;
+    std::vector<std::thread> mConnectionThreads;
+    std::mutex mCommandsMutex;
+    std::vector<std::string> mCommands;
+    std::string mData;
+};
+
+#endif  // __linux__
+
+#endif
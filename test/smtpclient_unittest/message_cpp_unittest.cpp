@@ -137,5 +137,12 @@ TEST(Message_MoveAssignment, MessageMoveAssignmentValid) {
     validateFakeMessageSample2(msg2);
 }
 
+TEST(Message_setBodyTransferEncoding, ReturnTheEncoding) {
+    auto msg = getFakeMessageSample1();
+    ASSERT_EQ(jed_utils::TransferEncoding::Automatic, msg.getBodyTransferEncoding());
+    msg.setBodyTransferEncoding(jed_utils::TransferEncoding::Base64);
+    ASSERT_EQ(jed_utils::TransferEncoding::Base64, msg.getBodyTransferEncoding());
+}
+
 }  // namespace cpp_message
 }  // namespace jed_utils_unittest
@@ -161,3 +161,35 @@ TEST(Message_MoveAssignment, MessageMoveAssignmentValid) {
     msg2 = std::move(msg1);
     validateFakeMessageSample2(msg2);
 }
+
+TEST(Message_getBodyTransferEncoding, Default_ReturnAutomatic) {
+    auto msg = getFakeMessageSample1();
+    ASSERT_EQ(TransferEncoding::Automatic, msg.getBodyTransferEncoding());
+}
+
+TEST(Message_setBodyTransferEncoding, CopyAndMove_KeepTheEncoding) {
+    auto msg1 = getFakeMessageSample2();
+    msg1.setBodyTransferEncoding(TransferEncoding::QuotedPrintable);
+    FakeMessage msg2(msg1);
+    ASSERT_EQ(TransferEncoding::QuotedPrintable, msg2.getBodyTransferEncoding());
+    auto msg3 = getFakeMessageSample1();
+    msg3 = msg1;
+    ASSERT_EQ(TransferEncoding::QuotedPrintable, msg3.getBodyTransferEncoding());
+    FakeMessage msg4(std::move(msg1));
+    ASSERT_EQ(TransferEncoding::QuotedPrintable, msg4.getBodyTransferEncoding());
+}
+
+TEST(Message_setAlternativeBody, CopyAndMove_KeepTheAlternativeBody) {
+    auto msg1 = getFakeMessageSample2();
+    ASSERT_EQ(nullptr, msg1.getAlternativeBody());
+    msg1.setAlternativeBody("Hello");
+    FakeMessage msg2(msg1);
+    ASSERT_STREQ("Hello", msg2.getAlternativeBody());
+    auto msg3 = getFakeMessageSample1();
+    msg3 = msg1;
+    ASSERT_STREQ("Hello", msg3.getAlternativeBody());
+    FakeMessage msg4(std::move(msg1));
+    ASSERT_STREQ("Hello", msg4.getAlternativeBody());
+    msg4.setAlternativeBody(nullptr);
+    ASSERT_EQ(nullptr, msg4.getAlternativeBody());
+}
@@ -94,6 +94,20 @@ TYPED_TEST(MultiMessageAddressFixture, constructor_ValidParamWithUpperCaseCharEm
     ASSERT_EQ("Test Address", std::string(msg_add.getDisplayName()));
 }
 
+TYPED_TEST(MultiMessageAddressFixture, constructor_ValidParamWithUTF8EmailAddress) {
+    TypeParam msg_add("j\xC3\xA9r\xC3\xB4me@domaine.fr", "Test Address");
+    ASSERT_EQ("j\xC3\xA9r\xC3\xB4me@domaine.fr", std::string(msg_add.getEmailAddress()));
+}
+
+TYPED_TEST(MultiMessageAddressFixture, constructor_InvalidUTF8EmailAddress_ThrowInvalidArgument) {
+    try {
+        TypeParam msg_add("j\xC3r\xC3\xB4me@domaine.fr", "Test Address");
+        FAIL();
+    }
+    catch (std::invalid_argument) {
+    }
+}
+
 TYPED_TEST(MultiMessageAddressFixture, CopyConstructor_MessageAddressCopyConstructorValid) {
     TypeParam msg_add1("myaddress@gmail.com", "Test Address");
     TypeParam msg_add2(msg_add1);
@@ -0,0 +1,322 @@
+#include <gtest/gtest.h>
+#include <openssl/pem.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../../src/htmlmessage.h"
+#include "../../src/messagerenderer.h"
+#include "../../src/plaintextmessage.h"
+
+using namespace jed_utils;
+
+TEST(MessageRenderer_renderHeaders, WithOneRecipient_ReturnValidHeaders) {
+    PlaintextMessage msg(MessageAddress("from@test.com", "Test Address Display"),
+            MessageAddress("to@domain.com"),
+            "This is a test (Subject)",
+            "Hello");
+    ASSERT_EQ("From: \"Test Address Display\" <from@test.com>\r\n"
+            "To: to@domain.com\r\n"
+            "Subject: This is a test (Subject)\r\n"
+            "Content-Type: multipart/mixed; boundary=sep\r\n\r\n",
+            MessageRenderer::renderHeaders(msg));
+}
+
+TEST(MessageRenderer_renderHeaders, WithCcAndBcc_ReturnHeadersWithoutBcc) {
+    MessageAddress to[2] { MessageAddress("to1@domain.com"), MessageAddress("to2@domain.com") };
+    MessageAddress cc[1] { MessageAddress("cc@domain.com") };
+    MessageAddress bcc[1] { MessageAddress("bcc@domain.com") };
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            to, 2,
+            "Subject",
+            "Hello",
+            cc, 1,
+            bcc, 1);
+    ASSERT_EQ("From: \"\" <from@test.com>\r\n"
+            "To: to1@domain.com\r\n"
+            "To: to2@domain.com\r\n"
+            "Cc: cc@domain.com\r\n"
+            "Subject: Subject\r\n"
+            "Content-Type: multipart/mixed; boundary=sep\r\n\r\n",
+            MessageRenderer::renderHeaders(msg));
+}
+
+TEST(MessageRenderer_renderBody, WithPlaintextMessage_ReturnValidBody) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello\r\nHow are you?");
+    ASSERT_EQ("--sep\r\nContent-Type: text/plain; charset=UTF-8\r\n\r\nHello\r\nHow are you?\r\n\r\n--sep--",
+            MessageRenderer::renderBody(msg));
+}
+
+TEST(MessageRenderer_renderBody, WithHTMLMessage_ReturnValidBody) {
+    HTMLMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "<html><body>Hello</body></html>");
+    ASSERT_EQ("--sep\r\nContent-Type: text/html; charset=UTF-8\r\n\r\n<html><body>Hello</body></html>\r\n\r\n--sep--",
+            MessageRenderer::renderBody(msg));
+}
+
+TEST(MessageRenderer_renderAttachments, WithNoAttachment_ReturnClosingBoundary) {
+    ASSERT_EQ("\r\n--sep--", MessageRenderer::renderAttachments(std::vector<Attachment*>()));
+}
+
+TEST(MessageRenderer_renderAttachmentHeaders, WithPNGAttachment_ReturnPartHeaders) {
+    Attachment att("test.png", "picture.png");
+    ASSERT_EQ("\r\n--sep\r\nContent-Type: image/png; name=\"picture.png\"\r\n"
+            "Content-Disposition: attachment; filename=\"picture.png\"\r\n"
+            "Content-Transfer-Encoding: base64\r\n\r\n",
+            MessageRenderer::renderAttachmentHeaders(att));
+}
+
+TEST(MessageRenderer_render, WithPlaintextMessage_ReturnHeadersAndBody) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ASSERT_EQ(MessageRenderer::renderHeaders(msg) + MessageRenderer::renderBody(msg),
+            MessageRenderer::render(msg));
+}
+
+TEST(MessageRenderer_renderHeaders, WithNonASCIISubjectAndDisplayName_ReturnEncodedWords) {
+    PlaintextMessage msg(MessageAddress("from@test.com", "J\xC3\xA9r\xC3\xB4me"),
+            MessageAddress("to@domain.com"),
+            "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E",
+            "Hello");
+    const std::string headers { MessageRenderer::renderHeaders(msg) };
+    ASSERT_EQ(0, headers.find("From: =?UTF-8?B?SsOpcsO0bWU=?= <from@test.com>\r\n"));
+    ASSERT_NE(std::string::npos, headers.find("\r\nSubject: =?UTF-8?B?5pel5pys6Kqe?=\r\n"));
+}
+
+TEST(MessageRenderer_computeSize, WithPlaintextMessage_ReturnRenderedLength) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello\r\nHow are you?");
+    ASSERT_EQ(MessageRenderer::render(msg).length(), MessageRenderer::computeSize(msg));
+}
+
+TEST(MessageRenderer_computeSize, WithBareLineBreaks_CountThemAsCRLF) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello\nHow are you?\rFine\r\n");
+    ASSERT_EQ(MessageRenderer::render(msg).length() + 2, MessageRenderer::computeSize(msg));
+}
+
+TEST(MessageRenderer_computeSize, WithAttachments_ReturnRenderedLength) {
+    const char *filename = "messagerenderer_unittest_attachment.txt";
+    std::ofstream(filename, std::ios::binary) << std::string(500, 'x');
+    const char *encoded_filename = "messagerenderer_unittest_encoded.b64";
+    std::ofstream(encoded_filename, std::ios::binary) << "SGVsbG8gV29ybGQh\r\nSGVsbG8=";
+    Attachment attachments[2] { Attachment(filename, "file.txt"), Attachment("hello.txt", "hello.txt") };
+    attachments[1].setEncodedFilename(encoded_filename);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello",
+            nullptr,
+            nullptr,
+            attachments,
+            2);
+    std::string rendered { MessageRenderer::render(msg) };
+    const size_t size = MessageRenderer::computeSize(msg);
+    std::remove(filename);
+    std::remove(encoded_filename);
+    ASSERT_EQ(rendered.length(), size);
+}
+
+TEST(MessageRenderer_renderBodyPart, WithEightBitBodyWithoutEightBitMime_ReturnQuotedPrintable) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Bonjour, \xC3\xA7" "a va?");
+    ASSERT_EQ("--sep\r\nContent-Type: text/plain; charset=UTF-8\r\n"
+            "Content-Transfer-Encoding: quoted-printable\r\n\r\n"
+            "Bonjour, =C3=A7a va?\r\n",
+            MessageRenderer::renderBodyPart(msg));
+}
+
+TEST(MessageRenderer_renderBodyPart, WithEightBitBodyAndEightBitMime_ReturnBodyAsIs) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Bonjour, \xC3\xA7" "a va?");
+    ASSERT_EQ("--sep\r\nContent-Type: text/plain; charset=UTF-8\r\n"
+            "Content-Transfer-Encoding: 8bit\r\n\r\n"
+            "Bonjour, \xC3\xA7" "a va?\r\n",
+            MessageRenderer::renderBodyPart(msg, true));
+}
+
+TEST(MessageRenderer_renderBodyPart, WithMostlyEightBitBody_ReturnBase64) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "\xE6\x97\xA5\xE6\x9C\xAC");
+    ASSERT_EQ("--sep\r\nContent-Type: text/plain; charset=UTF-8\r\n"
+            "Content-Transfer-Encoding: base64\r\n\r\n"
+            "5pel5pys\r\n",
+            MessageRenderer::renderBodyPart(msg));
+}
+
+TEST(MessageRenderer_renderBodyPart, WithInvalidUTF8Body_ReturnBase64WithUnknownCharset) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "\xFF\xFE\xFD");
+    ASSERT_EQ("--sep\r\nContent-Type: text/plain; charset=unknown-8bit\r\n"
+            "Content-Transfer-Encoding: base64\r\n\r\n"
+            "//79\r\n",
+            MessageRenderer::renderBodyPart(msg, true));
+    ASSERT_EQ(MessageRenderer::render(msg).length(), MessageRenderer::computeSize(msg));
+}
+
+TEST(MessageRenderer_computeSize, WithEncodedBody_ReturnRenderedLength) {
+    const std::string body { std::string(2000, 'a') + "\xC3\xA7\r\nend " };
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            body.c_str());
+    ASSERT_EQ(TransferEncoding::QuotedPrintable, MessageRenderer::selectBodyEncoding(msg, true));
+    ASSERT_EQ(MessageRenderer::render(msg, true).length(), MessageRenderer::computeSize(msg, true));
+    PlaintextMessage msg_base64(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E");
+    ASSERT_EQ(MessageRenderer::render(msg_base64).length(), MessageRenderer::computeSize(msg_base64));
+}
+
+TEST(MessageRenderer_renderMailFromParameters, WithoutOptions_ReturnEmpty) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "\xC3\xA7");
+    ASSERT_EQ("", MessageRenderer::renderMailFromParameters(msg, nullptr));
+}
+
+TEST(MessageRenderer_renderMailFromParameters, WithEightBitBodyAndUTF8Address_ReturnBodyAndSMTPUTF8) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("j\xC3\xA9r\xC3\xB4me@domain.com"),
+            "Subject",
+            "\xC3\xA7" "a");
+    ServerAuthOptions options;
+    options.EightBitMime = true;
+    options.SMTPUTF8 = true;
+    ASSERT_EQ(" BODY=8BITMIME SMTPUTF8", MessageRenderer::renderMailFromParameters(msg, &options));
+}
+
+TEST(MessageRenderer_renderMailFromParameters, WithASCIIMessage_ReturnEmpty) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ServerAuthOptions options;
+    options.EightBitMime = true;
+    options.SMTPUTF8 = true;
+    ASSERT_EQ("", MessageRenderer::renderMailFromParameters(msg, &options));
+}
+
+TEST(MessageRenderer_renderBodyPart, WithQuotedPrintableRequested_ReturnQuotedPrintable) {
+    HTMLMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "<p style=\"margin:0\">Hello</p>");
+    msg.setBodyTransferEncoding(TransferEncoding::QuotedPrintable);
+    ASSERT_EQ("--sep\r\nContent-Type: text/html; charset=UTF-8\r\n"
+            "Content-Transfer-Encoding: quoted-printable\r\n\r\n"
+            "<p style=3D\"margin:0\">Hello</p>\r\n",
+            MessageRenderer::renderBodyPart(msg));
+    ASSERT_EQ(MessageRenderer::render(msg).length(), MessageRenderer::computeSize(msg));
+}
+
+TEST(MessageRenderer_selectBodyEncoding, WithEightBitRequestedWithoutEightBitMime_ReturnAutomaticEncoding) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Bonjour, \xC3\xA7" "a va?");
+    msg.setBodyTransferEncoding(TransferEncoding::EightBit);
+    ASSERT_EQ(TransferEncoding::QuotedPrintable, MessageRenderer::selectBodyEncoding(msg, false));
+    ASSERT_EQ(TransferEncoding::EightBit, MessageRenderer::selectBodyEncoding(msg, true));
+}
+
+TEST(MessageRenderer_renderBody, WithAlternativeBody_ReturnAlternativeParts) {
+    HTMLMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "<p>Hello</p>");
+    msg.setAlternativeBody("Hello");
+    ASSERT_EQ("--sep\r\nContent-Type: multipart/alternative; boundary=\"=_1_alternative\"\r\n\r\n"
+            "--=_1_alternative\r\nContent-Type: text/plain; charset=UTF-8\r\n\r\nHello\r\n"
+            "\r\n--=_1_alternative\r\nContent-Type: text/html; charset=UTF-8\r\n\r\n<p>Hello</p>\r\n"
+            "\r\n--=_1_alternative--"
+            "\r\n--sep--",
+            MessageRenderer::renderBody(msg));
+    ASSERT_EQ(MessageRenderer::render(msg).length(), MessageRenderer::computeSize(msg));
+}
+
+TEST(MessageRenderer_buildMimeTree, WithInlineAndOtherAttachments_ReturnRelatedAndMixedParts) {
+    Attachment attachments[2] { Attachment("logo.png", "logo.png"), Attachment("report.pdf", "report.pdf") };
+    attachments[0].setContentId("logo@domain.com");
+    HTMLMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "<img src=\"cid:logo@domain.com\">",
+            nullptr,
+            nullptr,
+            attachments,
+            2);
+    msg.setAlternativeBody("Hello");
+    const MimePart root { MessageRenderer::buildMimeTree(msg) };
+    ASSERT_EQ(2, root.getParts().size());
+    const MimePart &alternative = root.getParts()[0];
+    ASSERT_EQ("multipart/alternative", alternative.getMimeType());
+    ASSERT_EQ("text/plain", alternative.getParts()[0].getMimeType());
+    const MimePart &related = alternative.getParts()[1];
+    ASSERT_EQ("multipart/related", related.getMimeType());
+    ASSERT_EQ("text/html", related.getParts()[0].getMimeType());
+    ASSERT_EQ("image/png", related.getParts()[1].getMimeType());
+    ASSERT_EQ("application/pdf", root.getParts()[1].getMimeType());
+}
+
+TEST(MessageRenderer_render, WithDKIMSigner_ReturnSignatureBeforeHeaders) {
+    EVP_PKEY *key = nullptr;
+    EVP_PKEY_CTX *context = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+    EVP_PKEY_keygen_init(context);
+    EVP_PKEY_keygen(context, &key);
+    EVP_PKEY_CTX_free(context);
+    BIO *bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+    char *pem = nullptr;
+    const long pem_length = BIO_get_mem_data(bio, &pem);
+    DKIMSigner signer;
+    ASSERT_TRUE(signer.addKey("test.com", "sel", std::string(pem, static_cast<size_t>(pem_length)).c_str()));
+    BIO_free(bio);
+    EVP_PKEY_free(key);
+
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello\nHow are you?");
+    const std::string unsigned_content { MessageRenderer::render(msg) };
+    const std::string content { MessageRenderer::render(msg, false, &signer) };
+    ASSERT_EQ(0, content.find("DKIM-Signature: v=1; a=ed25519-sha256; c=relaxed/simple; d=test.com; s=sel;\r\n"
+                " h=from:to:subject:content-type;\r\n"));
+    ASSERT_EQ(unsigned_content, content.substr(content.find("\r\nFrom: ") + 2));
+    // The bare line break is sent as CRLF
+    ASSERT_EQ(content.length() + 1, MessageRenderer::computeSize(msg, false, &signer));
+    // The field returned apart is the same as the one before the headers
+    std::string signature_field;
+    ASSERT_EQ(unsigned_content, MessageRenderer::render(msg, false, &signer, signature_field));
+    ASSERT_EQ(content, signature_field + unsigned_content);
+
+    PlaintextMessage other_domain_msg(MessageAddress("from@domain.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ASSERT_FALSE(MessageRenderer::isSigned(other_domain_msg, &signer));
+    ASSERT_EQ(MessageRenderer::render(other_domain_msg), MessageRenderer::render(other_domain_msg, false, &signer));
+    ASSERT_EQ(MessageRenderer::render(other_domain_msg), MessageRenderer::render(other_domain_msg, false, &signer, signature_field));
+    ASSERT_TRUE(signature_field.empty());
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/metricsregistry.h"
+#include "../../src/smtpclienterrors.h"
+
+using namespace jed_utils;
+
+namespace {
+    SendReport createReport(int pReturnCode, std::chrono::microseconds pDuration) {
+        SendReport report;
+        report.ReturnCode = pReturnCode;
+        report.Start = std::chrono::steady_clock::now();
+        report.End = report.Start + pDuration;
+        report.BytesWritten = 100;
+        report.BytesRead = 40;
+        return report;
+    }
+}  // namespace
+
+TEST(LatencyHistogram_record, WithLatencies_ReturnCountAndSum) {
+    LatencyHistogram histogram;
+    histogram.record(std::chrono::microseconds(10));
+    histogram.record(std::chrono::microseconds(1000));
+    ASSERT_EQ(2U, histogram.getCount());
+    ASSERT_EQ(1010, histogram.getSum().count());
+}
+
+TEST(LatencyHistogram_getQuantile, WithLatencies_ReturnUpperBoundOfTheBucket) {
+    LatencyHistogram histogram;
+    ASSERT_EQ(0, histogram.getQuantile(0.5).count());
+    for (int i = 1; i <= 100; i++) {
+        histogram.record(std::chrono::microseconds(i * 100));
+    }
+    // Within the 25% of the bucket width
+    const auto median = histogram.getQuantile(0.5).count();
+    ASSERT_LE(5000, median);
+    ASSERT_GE(6250, median);
+    const auto maximum = histogram.getQuantile(1).count();
+    ASSERT_LE(10000, maximum);
+    ASSERT_GE(12500, maximum);
+}
+
+TEST(LatencyHistogram_getQuantile, WithSmallLatencies_ReturnExactValues) {
+    LatencyHistogram histogram;
+    histogram.record(std::chrono::microseconds(0));
+    histogram.record(std::chrono::microseconds(3));
+    histogram.record(std::chrono::microseconds(8));
+    ASSERT_EQ(1, histogram.getQuantile(0.1).count());
+    ASSERT_EQ(3, histogram.getQuantile(0.5).count());
+    ASSERT_EQ(8, histogram.getQuantile(1).count());
+}
+
+TEST(LatencyHistogram_writePrometheus, WithLatencies_WriteCumulativeBuckets) {
+    LatencyHistogram histogram;
+    histogram.record(std::chrono::microseconds(128));
+    histogram.record(std::chrono::microseconds(129));
+    histogram.record(std::chrono::seconds(100));
+    std::string output;
+    histogram.writePrometheus(output, "latency", "command=\"MAIL\"");
+    ASSERT_NE(std::string::npos, output.find("latency_bucket{command=\"MAIL\",le=\"0.000128\"} 1\n"));
+    ASSERT_NE(std::string::npos, output.find("latency_bucket{command=\"MAIL\",le=\"0.000256\"} 2\n"));
+    ASSERT_NE(std::string::npos, output.find("latency_bucket{command=\"MAIL\",le=\"67.108864\"} 2\n"));
+    ASSERT_NE(std::string::npos, output.find("latency_bucket{command=\"MAIL\",le=\"+Inf\"} 3\n"));
+    ASSERT_NE(std::string::npos, output.find("latency_sum{command=\"MAIL\"} 100.000257\n"));
+    ASSERT_NE(std::string::npos, output.find("latency_count{command=\"MAIL\"} 3\n"));
+}
+
+TEST(MetricsRegistry_recordSend, WithSentAndFailedMessages_CountThem) {
+    MetricsRegistry registry;
+    registry.recordSend("smtp.test.com", 587, 3, createReport(0, std::chrono::milliseconds(20)));
+    registry.recordSend("smtp.test.com", 587, 1, createReport(CLIENT_SENDMAIL_MESSAGE_TOO_LARGE, std::chrono::milliseconds(5)));
+    registry.recordSend("smtp.test.com", 587, 1, createReport(550, std::chrono::milliseconds(5)));
+    ASSERT_EQ(1U, registry.getSentCount());
+    ASSERT_EQ(2U, registry.getFailedCount());
+    ASSERT_EQ(3U, registry.getRecipientCount());
+    ASSERT_EQ(300U, registry.getBytesWritten());
+    ASSERT_EQ(120U, registry.getBytesRead());
+    ASSERT_EQ(1U, registry.getErrorCount(CLIENT_SENDMAIL_MESSAGE_TOO_LARGE));
+    ASSERT_EQ(1U, registry.getErrorCount(550));
+    ASSERT_EQ(0U, registry.getErrorCount(CLIENT_SENDMAIL_QUIT_ERROR));
+    const LatencyHistogram *relay_latency = registry.findRelayLatency("smtp.test.com:587");
+    ASSERT_NE(nullptr, relay_latency);
+    ASSERT_EQ(3U, relay_latency->getCount());
+    ASSERT_EQ(nullptr, registry.findRelayLatency("smtp.test.com:25"));
+}
+
+TEST(MetricsRegistry_recordSend, WithMoreRelaysThanTheTable_CountTheRestAsOther) {
+    MetricsRegistry registry;
+    for (size_t i = 0; i < MetricsRegistry::MAX_RELAY_COUNT + 5; i++) {
+        registry.recordSend(("relay" + std::to_string(i)).c_str(), 25, 1, createReport(0, std::chrono::milliseconds(1)));
+    }
+    const LatencyHistogram *other_latency = registry.findRelayLatency("other");
+    ASSERT_NE(nullptr, other_latency);
+    ASSERT_EQ(5U, other_latency->getCount());
+    ASSERT_NE(nullptr, registry.findRelayLatency("relay0:25"));
+}
+
+TEST(MetricsRegistry_recordSend, FromSeveralThreads_CountEveryMessage) {
+    MetricsRegistry registry;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&registry, t]() {
+            for (int i = 0; i < 1000; i++) {
+                registry.recordSend(("relay" + std::to_string((t + i) % 8)).c_str(), 25, 1,
+                        createReport(0, std::chrono::milliseconds(1)));
+                registry.recordCommand(SMTPCommand::RCPT, std::chrono::microseconds(i));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(4000U, registry.getSentCount());
+    ASSERT_EQ(4000U, registry.getCommandLatency(SMTPCommand::RCPT).getCount());
+    std::uint64_t relay_count = 0;
+    for (int i = 0; i < 8; i++) {
+        const LatencyHistogram *latency = registry.findRelayLatency(("relay" + std::to_string(i) + ":25").c_str());
+        ASSERT_NE(nullptr, latency);
+        relay_count += latency->getCount();
+    }
+    ASSERT_EQ(4000U, relay_count);
+}
+
+TEST(MetricsRegistry_getCommand, WithCommandLines_ReturnTheirCommand) {
+    ASSERT_EQ(SMTPCommand::EHLO, MetricsRegistry::getCommand("ehlo localhost\r\n"));
+    ASSERT_EQ(SMTPCommand::STARTTLS, MetricsRegistry::getCommand("STARTTLS\r\n"));
+    ASSERT_EQ(SMTPCommand::AUTH, MetricsRegistry::getCommand("AUTH PLAIN AGFAAGI=\r\n"));
+    ASSERT_EQ(SMTPCommand::MAIL, MetricsRegistry::getCommand("MAIL FROM: <a@b.c>\r\n"));
+    ASSERT_EQ(SMTPCommand::RCPT, MetricsRegistry::getCommand("RCPT TO: <a@b.c>\r\n"));
+    ASSERT_EQ(SMTPCommand::DATA, MetricsRegistry::getCommand("DATA\r\n"));
+    ASSERT_EQ(SMTPCommand::EndOfData, MetricsRegistry::getCommand("\r\n.\r\n"));
+    ASSERT_EQ(SMTPCommand::RSET, MetricsRegistry::getCommand("RSET\r\n"));
+    ASSERT_EQ(SMTPCommand::Other, MetricsRegistry::getCommand("dXNlcg==\r\n"));
+    ASSERT_EQ(SMTPCommand::Other, MetricsRegistry::getCommand(nullptr));
+}
+
+TEST(MetricsRegistry_exportPrometheus, WithMetrics_ReturnTextFormat) {
+    MetricsRegistry registry;
+    registry.recordSend("smtp.test.com", 587, 2, createReport(0, std::chrono::milliseconds(20)));
+    registry.recordSend("smtp.test.com", 587, 1, createReport(CLIENT_SENDMAIL_MESSAGE_TOO_LARGE, std::chrono::milliseconds(5)));
+    registry.recordCommand(SMTPCommand::MAIL, std::chrono::microseconds(300));
+    registry.recordTLSHandshake(true);
+    registry.addOpenSession();
+    registry.addOpenSession();
+    registry.removeOpenSession();
+    registry.setQueueDepth(7);
+    const std::string output = registry.exportPrometheus();
+    ASSERT_NE(std::string::npos, output.find("# TYPE smtpclient_messages_total counter\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_messages_total{result=\"sent\"} 1\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_messages_total{result=\"failed\"} 1\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_recipients_total 2\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_written_bytes_total 200\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_errors_total{code=\"-104\"} 1\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_tls_handshakes_total{resumed=\"true\"} 1\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_tls_handshakes_total{resumed=\"false\"} 0\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_open_sessions 1\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_queue_depth 7\n"));
+    ASSERT_NE(std::string::npos, output.find("# TYPE smtpclient_command_duration_seconds histogram\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_command_duration_seconds_count{command=\"MAIL\"} 1\n"));
+    ASSERT_EQ(std::string::npos, output.find("command=\"RCPT\""));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_relay_messages_total{relay=\"smtp.test.com:587\",result=\"sent\"} 1\n"));
+    ASSERT_NE(std::string::npos, output.find("smtpclient_relay_send_duration_seconds_count{relay=\"smtp.test.com:587\"} 2\n"));
+}
+
+TEST(MetricsRegistry_exportPrometheus, WithQuoteInRelayName_EscapeTheLabel) {
+    MetricsRegistry registry;
+    registry.recordSend("bad\"name", 25, 1, createReport(0, std::chrono::milliseconds(1)));
+    ASSERT_NE(std::string::npos, registry.exportPrometheus().find("relay=\"bad\\\"name:25\""));
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "../../src/mimepart.h"
+
+using namespace jed_utils;
+
+namespace {
+    MimePart nestedTree(const char *pText) {
+        MimePart related { MimePart::createMultipart("related") };
+        related.addPart(MimePart::createText("text/html", pText, TransferEncoding::SevenBit));
+        MimePart alternative { MimePart::createMultipart("alternative") };
+        alternative.addPart(MimePart::createText("text/plain", "Hello", TransferEncoding::SevenBit));
+        alternative.addPart(std::move(related));
+        MimePart root { MimePart::createMultipart("mixed") };
+        root.addPart(std::move(alternative));
+        root.assignBoundaries();
+        return root;
+    }
+}  // namespace
+
+TEST(MimePart_assignBoundaries, WithOneText_ReturnDefaultBoundary) {
+    MimePart root { MimePart::createMultipart("mixed") };
+    root.addPart(MimePart::createText("text/plain", "Hello", TransferEncoding::SevenBit));
+    root.assignBoundaries();
+    ASSERT_EQ(MimePart::DEFAULT_BOUNDARY, root.getBoundary());
+    std::string output;
+    ASSERT_EQ(0, root.serialize(output));
+    ASSERT_EQ("--sep\r\nContent-Type: text/plain; charset=UTF-8\r\n\r\nHello\r\n\r\n--sep--", output);
+}
+
+TEST(MimePart_assignBoundaries, WithBoundaryInText_ReturnOtherBoundary) {
+    MimePart root { MimePart::createMultipart("mixed") };
+    root.addPart(MimePart::createText("text/plain", "--sep\r\n--sep_1", TransferEncoding::SevenBit));
+    root.assignBoundaries();
+    ASSERT_EQ("sep_2", root.getBoundary());
+}
+
+TEST(MimePart_assignBoundaries, WithNestedMultiparts_ReturnUniqueQuotedBoundaries) {
+    const MimePart root { nestedTree("<p>Hello</p>") };
+    const MimePart &alternative = root.getParts()[0];
+    const MimePart &related = alternative.getParts()[1];
+    ASSERT_EQ("=_1_alternative", alternative.getBoundary());
+    ASSERT_EQ("=_2_related", related.getBoundary());
+    ASSERT_EQ("Content-Type: multipart/alternative; boundary=\"=_1_alternative\"\r\n\r\n", alternative.renderHeaders());
+}
+
+TEST(MimePart_getSize, WithNestedMultiparts_ReturnSerializedLength) {
+    const MimePart root { nestedTree("<p>Hello\nWorld</p>") };
+    std::string output;
+    ASSERT_EQ(0, root.serialize(output));
+    // The bare line break is sent as CRLF
+    ASSERT_EQ(output.length() + 1, root.getSize());
+    ASSERT_NE(std::string::npos, output.find("\r\n--=_2_related--\r\n--=_1_alternative--\r\n--sep--"));
+}
+
+TEST(MimePart_renderHeaders, WithInvalidUTF8Text_ReturnUnknownCharset) {
+    ASSERT_EQ("Content-Type: text/plain; charset=unknown-8bit\r\n"
+            "Content-Transfer-Encoding: base64\r\n\r\n",
+            MimePart::createText("text/plain", "\xFF", TransferEncoding::Base64, false).renderHeaders());
+}
+
+TEST(MimePart_renderHeaders, WithInlineAttachment_ReturnContentId) {
+    Attachment att("test.png", "picture.png");
+    att.setContentId("logo@domain.com");
+    ASSERT_EQ("Content-Type: image/png; name=\"picture.png\"\r\n"
+            "Content-Disposition: inline; filename=\"picture.png\"\r\n"
+            "Content-ID: <logo@domain.com>\r\n"
+            "Content-Transfer-Encoding: base64\r\n\r\n",
+            MimePart::createAttachment(att).renderHeaders());
+}
+
+TEST(MimePart_serialize, WithAttachmentWriterError_StopAndReturnError) {
+    Attachment attachments[2] { Attachment("first.txt", "first.txt"), Attachment("second.txt", "second.txt") };
+    MimePart root { MimePart::createMultipart("mixed") };
+    root.addPart(MimePart::createText("text/plain", "Hello", TransferEncoding::SevenBit));
+    root.addPart(MimePart::createAttachment(attachments[0]));
+    root.addPart(MimePart::createAttachment(attachments[1]));
+    root.assignBoundaries();
+    int call_count = 0;
+    std::string output;
+    ASSERT_EQ(-1, root.serialize(output, [&call_count](std::string &pOutput, const Attachment &) {
+                pOutput += "content";
+                call_count++;
+                return -1;
+                }));
+    ASSERT_EQ(1, call_count);
+    ASSERT_EQ(std::string::npos, output.find("second.txt"));
+}
+
+TEST(MimePart_getSize, WithAttachment_ReturnSerializedLength) {
+    const char *filename = "mimepart_unittest_attachment.txt";
+    std::ofstream(filename, std::ios::binary) << std::string(100, 'x');
+    Attachment att(filename, "file.txt");
+    MimePart root { MimePart::createMultipart("mixed") };
+    root.addPart(MimePart::createText("text/plain", "Hello", TransferEncoding::QuotedPrintable));
+    root.addPart(MimePart::createAttachment(att));
+    root.assignBoundaries();
+    std::string output;
+    root.serialize(output);
+    std::remove(filename);
+    ASSERT_EQ(output.length(), root.getSize());
+}
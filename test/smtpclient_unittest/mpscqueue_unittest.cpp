@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../src/mpscqueue.h"
+
+using namespace jed_utils;
+
+TEST(MPSCQueue_Constructor, WithZeroCapacity_ThrowInvalidArgument) {
+    try {
+        MPSCQueue<int> queue(0);
+        FAIL();
+    }
+    catch(std::invalid_argument &err) {
+        ASSERT_STREQ("The capacity must be greater than zero", err.what());
+    }
+}
+
+TEST(MPSCQueue_Constructor, WithCapacityNotPowerOfTwo_RoundUp) {
+    MPSCQueue<int> queue(5);
+    ASSERT_EQ(8, queue.capacity());
+}
+
+TEST(MPSCQueue_Constructor, WithCapacityOne_RoundUpToTwo) {
+    MPSCQueue<int> queue(1);
+    ASSERT_EQ(2, queue.capacity());
+}
+
+TEST(MPSCQueue_tryDequeue, WithEmptyQueue_ReturnFalse) {
+    MPSCQueue<int> queue(4);
+    int item = 0;
+    ASSERT_FALSE(queue.tryDequeue(item));
+}
+
+TEST(MPSCQueue_tryEnqueue, WithItems_DequeueInOrder) {
+    MPSCQueue<std::string> queue(4);
+    ASSERT_TRUE(queue.tryEnqueue(std::string("first")));
+    ASSERT_TRUE(queue.tryEnqueue(std::string("second")));
+    ASSERT_EQ(2, queue.size());
+    std::string item;
+    ASSERT_TRUE(queue.tryDequeue(item));
+    ASSERT_EQ("first", item);
+    ASSERT_TRUE(queue.tryDequeue(item));
+    ASSERT_EQ("second", item);
+    ASSERT_EQ(0, queue.size());
+}
+
+TEST(MPSCQueue_tryEnqueue, WithFullQueue_ReturnFalseAndKeepTheItem) {
+    MPSCQueue<std::unique_ptr<int>> queue(2);
+    ASSERT_TRUE(queue.tryEnqueue(std::unique_ptr<int>(new int(1))));
+    ASSERT_TRUE(queue.tryEnqueue(std::unique_ptr<int>(new int(2))));
+    std::unique_ptr<int> item(new int(3));
+    ASSERT_FALSE(queue.tryEnqueue(std::move(item)));
+    ASSERT_NE(nullptr, item);
+    ASSERT_EQ(3, *item);
+}
+
+TEST(MPSCQueue_enqueue, WithFullQueue_ReturnFalseAtDeadline) {
+    MPSCQueue<int> queue(2);
+    ASSERT_TRUE(queue.tryEnqueue(1));
+    ASSERT_TRUE(queue.tryEnqueue(2));
+    ASSERT_FALSE(queue.enqueue(3, std::chrono::steady_clock::now() + std::chrono::milliseconds(10)));
+}
+
+TEST(MPSCQueue_enqueue, WithSpaceFreedBeforeDeadline_ReturnTrue) {
+    MPSCQueue<int> queue(2);
+    ASSERT_TRUE(queue.tryEnqueue(1));
+    ASSERT_TRUE(queue.tryEnqueue(2));
+    std::thread consumer([&queue]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            int item = 0;
+            queue.tryDequeue(item);
+            });
+    ASSERT_TRUE(queue.enqueue(3, std::chrono::steady_clock::now() + std::chrono::seconds(5)));
+    consumer.join();
+}
+
+TEST(MPSCQueue_dequeueBatch, WithMoreItemsThanMaxCount_ReturnMaxCount) {
+    MPSCQueue<int> queue(8);
+    for (int i = 0; i < 5; i++) {
+        queue.tryEnqueue(i);
+    }
+    std::vector<int> items;
+    ASSERT_EQ(3, queue.dequeueBatch(items, 3));
+    ASSERT_EQ(std::vector<int>({ 0, 1, 2 }), items);
+    ASSERT_EQ(2, queue.dequeueBatch(items, 3));
+    ASSERT_EQ(5, items.size());
+}
+
+TEST(MPSCQueue_tryEnqueue, WithSeveralProducers_DeliverEveryItemOnce) {
+    const int PRODUCER_COUNT = 4;
+    const int ITEMS_PER_PRODUCER = 10000;
+    MPSCQueue<int> queue(64);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCER_COUNT; p++) {
+        producers.emplace_back([&queue, p]() {
+                for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                    while (!queue.tryEnqueue(p * ITEMS_PER_PRODUCER + i)) {
+                        std::this_thread::yield();
+                    }
+                }
+                });
+    }
+    std::vector<int> received(PRODUCER_COUNT * ITEMS_PER_PRODUCER, 0);
+    std::vector<int> last_per_producer(PRODUCER_COUNT, -1);
+    std::vector<int> batch;
+    size_t total = 0;
+    bool in_order = true;
+    while (total < received.size()) {
+        batch.clear();
+        total += queue.dequeueBatch(batch, 16);
+        for (const auto item : batch) {
+            received[static_cast<size_t>(item)]++;
+            const int producer = item / ITEMS_PER_PRODUCER;
+            in_order = in_order && item > last_per_producer[static_cast<size_t>(producer)];
+            last_per_producer[static_cast<size_t>(producer)] = item;
+        }
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    ASSERT_TRUE(in_order);
+    ASSERT_EQ(std::vector<int>(received.size(), 1), received);
+}
@@ -141,3 +141,14 @@ TEST_F(FakeOpportunisticSecureSMTPClient, isStartTLSSupported_WithoutServerRepon
                 "250-CHUNKING\r\n"
                 "250 SMTPUTF8"));
 }
+
+TEST_F(FakeOpportunisticSecureSMTPClient, isStartTLSSupported_WithSTARTTLSOnLastLine_ReturnTrue) {
+    ASSERT_TRUE(isStartTLSSupported("250-smtp.test.com\r\n"
+                "250-PIPELINING\r\n"
+                "250 STARTTLS"));
+}
+
+TEST_F(FakeOpportunisticSecureSMTPClient, isStartTLSSupported_WithSTARTTLSInAnotherKeyword_ReturnFalse) {
+    ASSERT_FALSE(isStartTLSSupported("250-smtp.test.com\r\n"
+                "250 XSTARTTLSX"));
+}
@@ -28,6 +28,16 @@ TEST(PlaintextMessage_Constructor, WithValidArgs_ReturnSuccess) {
     ASSERT_EQ(2, msg.getAttachmentsCount());
 }
 
+TEST(PlaintextMessage_Conversion, KeepTheBodyTransferEncoding) {
+    PlaintextMessage msg(MessageAddress("from@from.com"),
+                   { MessageAddress("to1@to.com") },
+                   "Subject",
+                   "Body");
+    msg.setBodyTransferEncoding(jed_utils::TransferEncoding::QuotedPrintable);
+    jed_utils::PlaintextMessage std_msg = msg;
+    ASSERT_EQ(jed_utils::TransferEncoding::QuotedPrintable, std_msg.getBodyTransferEncoding());
+}
+
 TEST(PlaintextMessage_GetMimeType, ReturnTextPlaintext) {
     PlaintextMessage msg(MessageAddress("from@from.com"),
                     { MessageAddress("to@to.com") },
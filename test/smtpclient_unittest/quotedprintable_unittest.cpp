@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include "../../src/quotedprintable.h"
+
+using namespace jed_utils;
+
+namespace {
+    std::string encode(const std::string &pText) {
+        return QuotedPrintable::encode(pText.data(), pText.length());
+    }
+}  // namespace
+
+TEST(QuotedPrintable_encode, WithASCIIText_ReturnSameText) {
+    ASSERT_EQ("Hello World!", encode("Hello World!"));
+}
+
+TEST(QuotedPrintable_encode, WithEqualAndEightBit_ReturnEscapedBytes) {
+    ASSERT_EQ("a=3Db =C3=A7a", encode("a=b \xC3\xA7" "a"));
+}
+
+TEST(QuotedPrintable_encode, WithSpaceAtEndOfLine_ReturnEscapedSpace) {
+    ASSERT_EQ("Hello=20\r\nWorld=09", encode("Hello \nWorld\t"));
+}
+
+TEST(QuotedPrintable_encode, WithLineBreaks_ReturnCRLF) {
+    ASSERT_EQ("a\r\nb\r\nc=0Dd", encode("a\r\nb\nc\rd"));
+}
+
+TEST(QuotedPrintable_encode, WithLongLine_ReturnSoftLineBreaks) {
+    const std::string encoded { encode(std::string(100, 'a')) };
+    ASSERT_EQ(std::string(75, 'a') + "=\r\n" + std::string(25, 'a'), encoded);
+}
+
+TEST(QuotedPrintable_encode, WithLineOf76Characters_ReturnNoSoftLineBreak) {
+    ASSERT_EQ(std::string(76, 'a'), encode(std::string(76, 'a')));
+}
+
+TEST(QuotedPrintable_encode, WithEscapeAtSoftLineBreak_KeepTheEscapeWhole) {
+    const std::string encoded { encode(std::string(74, 'a') + "\xC3\xA7") };
+    ASSERT_EQ(std::string(74, 'a') + "=\r\n=C3=A7", encoded);
+}
+
+TEST(QuotedPrintable_encodedLength, ReturnLengthOfEncodedText) {
+    const std::string text { std::string(200, 'x') + " \xC3\xA7\r\n=end \n" };
+    ASSERT_EQ(encode(text).length(), QuotedPrintable::encodedLength(text.data(), text.length()));
+}
+
+TEST(QuotedPrintable_encode, WithLongTextOfBlocks_ReturnSoftLineBreaksAt76Characters) {
+    std::string text;
+    for (int i = 0; i < 40; i++) {
+        text += "The quick brown fox jumps over the lazy dog. ";
+    }
+    text += "\r\nEnd";
+    const std::string encoded { encode(text) };
+    size_t line_start = 0;
+    size_t line_end = 0;
+    while ((line_end = encoded.find("\r\n", line_start)) != std::string::npos) {
+        ASSERT_LE(line_end - line_start, QuotedPrintable::MAX_LINE_LENGTH);
+        line_start = line_end + 2;
+    }
+    std::string decoded { encoded };
+    size_t soft_break = 0;
+    while ((soft_break = decoded.find("=\r\n")) != std::string::npos) {
+        decoded.erase(soft_break, 3);
+    }
+    // The space before the line break is escaped
+    ASSERT_EQ(text.substr(0, text.length() - 6) + "=20\r\nEnd", decoded);
+}
+
+TEST(QuotedPrintable_encode, WithBuffer_AppendToTheBuffer) {
+    std::string output { "header:" };
+    const std::string text { "caf\xC3\xA9" };
+    QuotedPrintable::encode(text.data(), text.length(), output);
+    ASSERT_EQ("header:caf=C3=A9", output);
+}
+
+TEST(QuotedPrintableEncoder_encode, WithChunksOfAnySize_ReturnSameAsWholeText) {
+    std::string text;
+    for (int i = 0; i < 20; i++) {
+        text += "Line with a trailing space \r\n\tcaf\xC3\xA9 = 3\t\n" + std::string(static_cast<size_t>(i * 7), 'x') + " \r";
+    }
+    const std::string expected { encode(text) };
+    for (size_t chunk_length = 1; chunk_length <= 40; chunk_length++) {
+        QuotedPrintableEncoder encoder;
+        std::string output;
+        for (size_t offset = 0; offset < text.length(); offset += chunk_length) {
+            encoder.encode(text.data() + offset, std::min(chunk_length, text.length() - offset), output);
+        }
+        encoder.finish(output);
+        ASSERT_EQ(expected, output) << "chunk length " << chunk_length;
+    }
+}
+
+TEST(QuotedPrintableEncoder_finish, ResetTheEncoder) {
+    QuotedPrintableEncoder encoder;
+    std::string output;
+    encoder.encode("a ", 2, output);
+    encoder.finish(output);
+    encoder.encode("b", 1, output);
+    encoder.finish(output);
+    ASSERT_EQ("a=20b", output);
+}
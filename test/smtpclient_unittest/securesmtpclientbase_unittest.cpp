@@ -0,0 +1,129 @@
+#include "../../src/forcedsecuresmtpclient.h"
+#include "../../src/opportunisticsecuresmtpclient.h"
+#include "../../src/plaintextmessage.h"
+#include "../../src/sslerrors.h"
+#include <gtest/gtest.h>
+#include <utility>
+
+#ifdef __linux__
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+using namespace jed_utils;
+
+TEST(SecureSMTPClientBase_TLSContext, Default_ReturnNull) {
+    ForcedSecureSMTPClient client("localhost", 465);
+    ASSERT_EQ(nullptr, client.getTLSContext());
+}
+
+TEST(SecureSMTPClientBase_TLSContext, SetTLSContext_ReturnContext) {
+    auto context = TLSContext::createWithDefaultCA();
+    OpportunisticSecureSMTPClient client("localhost", 587);
+    client.setTLSContext(context);
+    ASSERT_EQ(context, client.getTLSContext());
+}
+
+TEST(SecureSMTPClientBase_TLSContext, CopyConstructor_ShareContext) {
+    auto context = TLSContext::createWithDefaultCA();
+    ForcedSecureSMTPClient client("localhost", 465);
+    client.setTLSContext(context);
+    ForcedSecureSMTPClient copy(client);
+    ASSERT_EQ(context, copy.getTLSContext());
+    ASSERT_EQ(context, client.getTLSContext());
+}
+
+TEST(SecureSMTPClientBase_TLSContext, MoveConstructor_MoveContext) {
+    auto context = TLSContext::createWithDefaultCA();
+    ForcedSecureSMTPClient client("localhost", 465);
+    client.setTLSContext(context);
+    ForcedSecureSMTPClient moved(std::move(client));
+    ASSERT_EQ(context, moved.getTLSContext());
+}
+
+TEST(SecureSMTPClientBase_HandshakeTimeout, Default_Return10000) {
+    ForcedSecureSMTPClient client("localhost", 465);
+    ASSERT_EQ(10000, client.getHandshakeTimeout());
+    ASSERT_EQ(0, client.getLastHandshakeDuration().count());
+}
+
+TEST(SecureSMTPClientBase_HandshakeTimeout, SetHandshakeTimeout_ReturnTimeout) {
+    ForcedSecureSMTPClient client("localhost", 465);
+    client.setHandshakeTimeout(250);
+    ASSERT_EQ(250, client.getHandshakeTimeout());
+}
+
+TEST(SecureSMTPClientBase_HandshakeTimeout, CopyConstructor_CopyTimeout) {
+    OpportunisticSecureSMTPClient client("localhost", 587);
+    client.setHandshakeTimeout(250);
+    OpportunisticSecureSMTPClient copy(client);
+    ASSERT_EQ(250, copy.getHandshakeTimeout());
+}
+
+TEST(SecureSMTPClientBase_KernelTLS, Default_ReturnFalse) {
+    ForcedSecureSMTPClient client("localhost", 465);
+    ASSERT_FALSE(client.getKernelTLS());
+    ASSERT_FALSE(client.isKernelTLSActive());
+}
+
+TEST(SecureSMTPClientBase_KernelTLS, SetKernelTLS_ReturnTrue) {
+    ForcedSecureSMTPClient client("localhost", 465);
+    client.setKernelTLS(true);
+    ASSERT_TRUE(client.getKernelTLS());
+    ASSERT_FALSE(client.isKernelTLSActive());
+}
+
+TEST(SecureSMTPClientBase_KernelTLS, CopyConstructor_CopyKernelTLS) {
+    OpportunisticSecureSMTPClient client("localhost", 587);
+    client.setKernelTLS(true);
+    OpportunisticSecureSMTPClient copy(client);
+    ASSERT_TRUE(copy.getKernelTLS());
+}
+
+#ifdef __linux__
+// The kernel accepts the connections in the backlog of the socket, but
+// nothing ever answers the TLS client hello.
+class SilentServer {
+ public:
+    SilentServer()
+        : mSocket(socket(AF_INET, SOCK_STREAM, 0)),
+          mPort(0) {
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(mSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        listen(mSocket, 4);
+        socklen_t length = sizeof(address);
+        getsockname(mSocket, reinterpret_cast<sockaddr *>(&address), &length);
+        mPort = ntohs(address.sin_port);
+    }
+
+    ~SilentServer() {
+        close(mSocket);
+    }
+
+    unsigned int getPort() const {
+        return mPort;
+    }
+
+ private:
+    int mSocket;
+    unsigned int mPort;
+};
+
+TEST(SecureSMTPClientBase_sendMail, WithSilentServer_ReturnHandshakeTimeout) {
+    SilentServer server;
+    ForcedSecureSMTPClient client("127.0.0.1", server.getPort());
+    client.setHandshakeTimeout(200);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ASSERT_EQ(SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT, client.sendMail(msg));
+    ASSERT_GE(client.getLastHandshakeDuration().count(), 190000);
+    ASSERT_LT(client.getLastHandshakeDuration().count(), 5000000);
+    ASSERT_FALSE(client.isConnected());
+}
+#endif
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include "../../src/plaintextmessage.h"
+#include "../../src/senderpool.h"
+#include "../../src/smtpclient.h"
+#include "loopbackserver.h"
+
+using namespace jed_utils;
+
+namespace {
+std::unique_ptr<Message> createMessage() {
+    return std::unique_ptr<Message>(new PlaintextMessage(MessageAddress("from@test.com"),
+                MessageAddress("to@domain.com"),
+                "Subject",
+                "Hello"));
+}
+}  // namespace
+
+TEST(SenderPool_Constructor, WithZeroWorker_ThrowInvalidArgument) {
+    try {
+        SenderPool pool(0, []() { return std::unique_ptr<SMTPClientBase>(new SmtpClient("test", 25)); });
+        FAIL();
+    }
+    catch(std::invalid_argument &err) {
+        ASSERT_STREQ("The worker count must be greater than zero", err.what());
+    }
+}
+
+TEST(SenderPool_Constructor, WithNullFactory_ThrowInvalidArgument) {
+    try {
+        SenderPool pool(1, nullptr);
+        FAIL();
+    }
+    catch(std::invalid_argument &err) {
+        ASSERT_STREQ("The client factory cannot be null", err.what());
+    }
+}
+
+TEST(SenderPool_Constructor, WithFactoryReturningNull_ThrowInvalidArgument) {
+    try {
+        SenderPool pool(1, []() { return std::unique_ptr<SMTPClientBase>(); });
+        FAIL();
+    }
+    catch(std::invalid_argument &err) {
+        ASSERT_STREQ("The client factory returned a null client", err.what());
+    }
+}
+
+TEST(SenderPool_trySubmit, WithNullMessage_ReturnFalse) {
+    SenderPool pool(1, []() { return std::unique_ptr<SMTPClientBase>(new SmtpClient("test", 25)); });
+    std::unique_ptr<Message> msg;
+    ASSERT_FALSE(pool.trySubmit(msg));
+}
+
+#ifdef __linux__
+TEST(SenderPool_trySubmit, WithSeveralMessages_SendEveryMessageOnWarmConnections) {
+    LoopbackServer server;
+    server.serve();
+    const unsigned int port = server.getPort();
+    std::atomic<int> sent { 0 };
+    std::atomic<int> failed { 0 };
+    {
+        SenderPool pool(2, [port]() { return std::unique_ptr<SMTPClientBase>(new SmtpClient("127.0.0.1", port)); });
+        ASSERT_EQ(2, pool.getWorkerCount());
+        for (int i = 0; i < 20; i++) {
+            std::unique_ptr<Message> msg { createMessage() };
+            ASSERT_TRUE(pool.submit(msg, [&sent, &failed](int pCode) {
+                        if (pCode == 0) {
+                            sent++;
+                        } else {
+                            failed++;
+                        }
+                        }, std::chrono::steady_clock::now() + std::chrono::seconds(5)));
+            ASSERT_EQ(nullptr, msg);
+        }
+    }
+    ASSERT_EQ(20, sent);
+    ASSERT_EQ(0, failed);
+    // One connection per worker at most
+    ASSERT_GE(2, server.getConnectionCount());
+}
+#endif
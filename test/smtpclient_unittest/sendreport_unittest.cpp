@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include "../../src/sendreport.h"
+
+using namespace jed_utils;
+
+TEST(SendReport_extractQueueId, WithPostfixReply_ReturnTheId) {
+    ASSERT_EQ("4F2A1B3C", SendReport::extractQueueId("250 2.0.0 Ok: queued as 4F2A1B3C"));
+}
+
+TEST(SendReport_extractQueueId, WithEximReply_ReturnTheId) {
+    ASSERT_EQ("1qZx4T-0003Ab-9K", SendReport::extractQueueId("250 OK id=1qZx4T-0003Ab-9K\r\n"));
+}
+
+TEST(SendReport_extractQueueId, WithoutId_ReturnEmpty) {
+    ASSERT_EQ("", SendReport::extractQueueId("250 OK"));
+    ASSERT_EQ("", SendReport::extractQueueId(nullptr));
+}
+
+TEST(SendReport_getPhase, WithPhase_ReturnItsTiming) {
+    SendReport report;
+    report.Phases[static_cast<size_t>(SendPhase::Data)].Duration = std::chrono::microseconds(42);
+    ASSERT_EQ(42, report.getPhase(SendPhase::Data).Duration.count());
+    ASSERT_EQ(0, report.getPhase(SendPhase::Quit).Duration.count());
+}
+
+TEST(SendReport_clear, WithFilledReport_ResetAllFields) {
+    SendReport report;
+    report.BytesWritten = 10;
+    report.TLSResumed = true;
+    report.QueueId = "ABC";
+    report.Phases[0].Duration = std::chrono::microseconds(5);
+    report.clear();
+    ASSERT_EQ(0U, report.BytesWritten);
+    ASSERT_FALSE(report.TLSResumed);
+    ASSERT_EQ("", report.QueueId);
+    ASSERT_EQ(0, report.Phases[0].Duration.count());
+}
@@ -0,0 +1,101 @@
+#include "../../src/servercapabilitycache.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+using namespace jed_utils;
+
+TEST(ServerCapabilityCache_getDefault, CalledTwice_ReturnSameCache) {
+    auto first = ServerCapabilityCache::getDefault();
+    ASSERT_NE(nullptr, first);
+    ASSERT_EQ(first, ServerCapabilityCache::getDefault());
+}
+
+TEST(ServerCapabilityCache_Constructor, Default_OneHourAndEmpty) {
+    ServerCapabilityCache cache;
+    ASSERT_EQ(3600, cache.getTimeToLive().count());
+    ASSERT_EQ(0, cache.size());
+}
+
+TEST(ServerCapabilityCache_find, UnknownServer_ReturnFalse) {
+    ServerCapabilityCache cache;
+    ServerCapabilities capabilities;
+    ASSERT_FALSE(cache.find("smtp.test.com", 587, capabilities));
+}
+
+TEST(ServerCapabilityCache_find, StoredServer_ReturnCapabilities) {
+    ServerCapabilityCache cache;
+    ServerCapabilities stored;
+    stored.SecurityMode = ServerSecurityMode::Implicit;
+    stored.EhloResponse = "250-smtp.test.com\r\n250 SIZE 1000";
+    stored.Options.Auth = true;
+    stored.Options.Login = true;
+    cache.store("smtp.test.com", 465, stored);
+
+    ServerCapabilities capabilities;
+    ASSERT_TRUE(cache.find("smtp.test.com", 465, capabilities));
+    ASSERT_EQ(ServerSecurityMode::Implicit, capabilities.SecurityMode);
+    ASSERT_EQ(stored.EhloResponse, capabilities.EhloResponse);
+    ASSERT_TRUE(capabilities.Options.Auth);
+    ASSERT_TRUE(capabilities.Options.Login);
+    ASSERT_FALSE(capabilities.Options.Plain);
+}
+
+TEST(ServerCapabilityCache_find, OtherPort_ReturnFalse) {
+    ServerCapabilityCache cache;
+    cache.store("smtp.test.com", 465, ServerCapabilities());
+    ServerCapabilities capabilities;
+    ASSERT_FALSE(cache.find("smtp.test.com", 587, capabilities));
+}
+
+TEST(ServerCapabilityCache_find, ExpiredEntry_ReturnFalseAndRemoveEntry) {
+    ServerCapabilityCache cache(std::chrono::seconds(1));
+    cache.store("smtp.test.com", 587, ServerCapabilities());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    ServerCapabilities capabilities;
+    ASSERT_FALSE(cache.find("smtp.test.com", 587, capabilities));
+    ASSERT_EQ(0, cache.size());
+}
+
+TEST(ServerCapabilityCache_store, ZeroTimeToLive_NothingStored) {
+    ServerCapabilityCache cache(std::chrono::seconds(0));
+    cache.store("smtp.test.com", 587, ServerCapabilities());
+    ASSERT_EQ(0, cache.size());
+}
+
+TEST(ServerCapabilityCache_store, SameServerTwice_ReplaceEntry) {
+    ServerCapabilityCache cache;
+    ServerCapabilities stored;
+    stored.SecurityMode = ServerSecurityMode::Unencrypted;
+    cache.store("smtp.test.com", 587, stored);
+    stored.SecurityMode = ServerSecurityMode::StartTLS;
+    cache.store("smtp.test.com", 587, stored);
+    ServerCapabilities capabilities;
+    ASSERT_TRUE(cache.find("smtp.test.com", 587, capabilities));
+    ASSERT_EQ(ServerSecurityMode::StartTLS, capabilities.SecurityMode);
+    ASSERT_EQ(1, cache.size());
+}
+
+TEST(ServerCapabilityCache_store, MoreThanMaxServers_SizeBounded) {
+    ServerCapabilityCache cache;
+    for (unsigned int port = 1; port <= 1100; port++) {
+        cache.store("smtp.test.com", port, ServerCapabilities());
+    }
+    ASSERT_EQ(1024, cache.size());
+}
+
+TEST(ServerCapabilityCache_remove, StoredServer_ReturnFalseOnFind) {
+    ServerCapabilityCache cache;
+    cache.store("smtp.test.com", 587, ServerCapabilities());
+    cache.remove("smtp.test.com", 587);
+    ServerCapabilities capabilities;
+    ASSERT_FALSE(cache.find("smtp.test.com", 587, capabilities));
+}
+
+TEST(ServerCapabilityCache_clear, TwoServers_ReturnEmpty) {
+    ServerCapabilityCache cache;
+    cache.store("smtp.test.com", 587, ServerCapabilities());
+    cache.store("smtp.test.com", 465, ServerCapabilities());
+    cache.clear();
+    ASSERT_EQ(0, cache.size());
+}
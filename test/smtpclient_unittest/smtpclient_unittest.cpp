@@ -1,6 +1,17 @@
 #include "../../src/smtpclient.h"
 #include "../../src/cpp/smtpclient.hpp"
+#include "../../src/messagerenderer.h"
+#include "../../src/smtpclienterrors.h"
 #include <gtest/gtest.h>
+#include <openssl/pem.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "loopbackserver.h"
 
 using namespace jed_utils;
 
@@ -98,3 +109,393 @@ TEST(SmtpClient_MoveAssignment, SmtpClientMoveAssignmentValid) {
     ASSERT_STREQ("user1", client2.getCredentials()->getUsername());
     ASSERT_STREQ("pass1", client2.getCredentials()->getPassword());
 }
+
+TEST(SmtpClient_setKeepAlive, DefaultValue_ReturnFalse) {
+    SmtpClient client("test", 587);
+    ASSERT_FALSE(client.getKeepAlive());
+    ASSERT_FALSE(client.isConnected());
+}
+
+TEST(SmtpClient_CopyConstructor, WithKeepAlive_CopyKeepAlive) {
+    SmtpClient client1("test", 587);
+    client1.setKeepAlive(true);
+    SmtpClient client2(client1);
+    ASSERT_TRUE(client2.getKeepAlive());
+}
+
+#ifdef __linux__
+TEST(SmtpClient_sendMail, WithKeepAlive_ReuseTheConnection) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    client.setKeepAlive(true);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_TRUE(client.isConnected());
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_EQ(0, client.disconnect());
+    ASSERT_FALSE(client.isConnected());
+    ASSERT_EQ(1, server.getConnectionCount());
+    ASSERT_TRUE(server.waitForCommand("QUIT"));
+    std::vector<std::string> commands = server.getCommands();
+    ASSERT_EQ(1, std::count(commands.begin(), commands.end(), "RSET"));
+    ASSERT_EQ(1, std::count(commands.begin(), commands.end(), "QUIT"));
+}
+
+TEST(SmtpClient_sendMail, WithKeepAliveAndConnectionClosedByServer_ReconnectAtOnce) {
+    LoopbackServer server;
+    server.setCloseAfterMessage(true);
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    client.setKeepAlive(true);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ASSERT_EQ(0, client.sendMail(msg));
+    const auto start_time = std::chrono::steady_clock::now();
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_LT(std::chrono::steady_clock::now() - start_time, std::chrono::seconds(1));
+    ASSERT_EQ(2, server.getConnectionCount());
+    client.disconnect();
+}
+
+TEST(SmtpClient_sendMail, WithKeepAliveAndRejectedRset_Reconnect) {
+    LoopbackServer server;
+    server.setRejectReset(true);
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    client.setKeepAlive(true);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_EQ(2, server.getConnectionCount());
+    ASSERT_EQ(0, client.disconnect());
+    ASSERT_TRUE(server.waitForCommand("QUIT"));
+    std::vector<std::string> commands = server.getCommands();
+    ASSERT_EQ(1, std::count(commands.begin(), commands.end(), "RSET"));
+    ASSERT_EQ(2, std::count_if(commands.begin(), commands.end(), [](const std::string &command) {
+                return command.compare(0, 10, "MAIL FROM:") == 0;
+                }));
+}
+
+TEST(SmtpClient_sendMail, WithoutKeepAlive_CloseTheConnection) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_FALSE(client.isConnected());
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_EQ(2, server.getConnectionCount());
+}
+
+TEST(SmtpClient_sendMail, WithEncodedAttachmentFile_SendTheFile) {
+    const char *encoded_filename = "smtpclient_unittest_encoded.b64";
+    const std::string encoded_content { "SGVsbG8gV29ybGQh\r\nSGVsbG8gV29ybGQh" };
+    std::ofstream(encoded_filename, std::ios::binary) << encoded_content;
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    Attachment attachment("hello.txt", "hello.txt");
+    attachment.setEncodedFilename(encoded_filename);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello",
+            nullptr,
+            nullptr,
+            &attachment,
+            1);
+    ASSERT_EQ(0, client.sendMail(msg));
+    std::remove(encoded_filename);
+    const std::string data { server.getData() };
+    ASSERT_NE(std::string::npos, data.find("Content-Transfer-Encoding: base64\r\n\r\n" + encoded_content + "\r\n--sep--"));
+}
+
+TEST(SmtpClient_sendMail, WithMissingEncodedAttachmentFile_ReturnEncodedFileError) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    Attachment attachment("hello.txt", "hello.txt");
+    attachment.setEncodedFilename("/nonexistent/hello.txt.b64");
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello",
+            nullptr,
+            nullptr,
+            &attachment,
+            1);
+    ASSERT_EQ(CLIENT_SENDMAIL_ENCODED_FILE_ERROR, client.sendMail(msg));
+    ASSERT_FALSE(client.isConnected());
+}
+
+TEST(SmtpClient_sendMail, WithServerSize_DeclareTheExactMessageSize) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    ASSERT_EQ(0, client.sendMail(msg));
+    const size_t size = MessageRenderer::computeSize(msg);
+    std::vector<std::string> commands = server.getCommands();
+    ASSERT_EQ(1, std::count(commands.begin(), commands.end(), "MAIL FROM: <from@test.com> SIZE=" + std::to_string(size)));
+    // The DATA terminator adds a CRLF to the content
+    ASSERT_EQ(size + 2, server.getData().length());
+}
+
+TEST(SmtpClient_sendMail, WithDotLinesAndBareLineBreaks_ServerReceiveTheBodyUnaltered) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello\n.\n.hidden line\r\nBye");
+    ASSERT_EQ(0, client.sendMail(msg));
+    const size_t size = MessageRenderer::computeSize(msg);
+    std::vector<std::string> commands = server.getCommands();
+    ASSERT_EQ(1, std::count(commands.begin(), commands.end(), "MAIL FROM: <from@test.com> SIZE=" + std::to_string(size)));
+    const std::string data { server.getData() };
+    ASSERT_NE(std::string::npos, data.find("\r\n\r\nHello\r\n.\r\n.hidden line\r\nBye\r\n"));
+    ASSERT_EQ(size + 2, data.length());
+}
+
+TEST(SmtpClient_sendMail, WithDKIMSigner_SendTheSignatureFirstWithTheExactSize) {
+    EVP_PKEY *key = nullptr;
+    EVP_PKEY_CTX *context = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+    EVP_PKEY_keygen_init(context);
+    EVP_PKEY_keygen(context, &key);
+    EVP_PKEY_CTX_free(context);
+    BIO *bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+    char *pem = nullptr;
+    const long pem_length = BIO_get_mem_data(bio, &pem);
+    auto signer = std::make_shared<DKIMSigner>();
+    ASSERT_TRUE(signer->addKey("test.com", "sel", std::string(pem, static_cast<size_t>(pem_length)).c_str()));
+    BIO_free(bio);
+    EVP_PKEY_free(key);
+
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    client.setDKIMSigner(signer);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello\n.\nBye");
+    ASSERT_EQ(0, client.sendMail(msg));
+    const size_t size = MessageRenderer::computeSize(msg, false, signer.get());
+    std::vector<std::string> commands = server.getCommands();
+    ASSERT_EQ(1, std::count(commands.begin(), commands.end(), "MAIL FROM: <from@test.com> SIZE=" + std::to_string(size)));
+    const std::string data { server.getData() };
+    ASSERT_EQ(0, data.find("DKIM-Signature: v=1; a=ed25519-sha256;"));
+    ASSERT_EQ(std::string::npos, data.find("DKIM-Signature:", 1));
+    ASSERT_NE(std::string::npos, data.find("\r\nFrom: \"\" <from@test.com>\r\n"));
+    ASSERT_EQ(size + 2, data.length());
+}
+
+TEST(SmtpClient_sendMail, WithHeadersLogLevel_LogTheHeadersWithoutTheBody) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    client.setCommunicationLogLevel(CommunicationLogLevel::Headers);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "The subject",
+            "The body");
+    ASSERT_EQ(0, client.sendMail(msg));
+    std::string log { client.getCommunicationLog() };
+    ASSERT_NE(std::string::npos, log.find("c: RCPT TO: <to@domain.com>"));
+    ASSERT_NE(std::string::npos, log.find("Subject: The subject"));
+    ASSERT_EQ(std::string::npos, log.find("The body"));
+
+    client.setCommunicationLogLevel(CommunicationLogLevel::Off);
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_EQ("", std::string(client.getCommunicationLog()));
+}
+
+namespace {
+    class CollectingLogSink : public LogSink {
+     public:
+        explicit CollectingLogSink(CommunicationLogLevel pLevel)
+            : LogSink(pLevel) {
+        }
+        void write(LogEvent &pEvent) override {
+            Events.push_back(std::move(pEvent));
+        }
+        std::vector<LogEvent> Events;
+    };
+}  // namespace
+
+TEST(SmtpClient_sendMail, WithLogSink_SendTheEventsOfItsLevel) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    auto sink = std::make_shared<CollectingLogSink>(CommunicationLogLevel::Commands);
+    client.setLogSink(sink);
+    client.setCommunicationLogLevel(CommunicationLogLevel::Off);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "The subject",
+            "The body");
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_EQ("", std::string(client.getCommunicationLog()));
+    ASSERT_NE(0U, client.getSessionId());
+    ASSERT_FALSE(sink->Events.empty());
+    bool has_rcpt = false;
+    bool has_ok_reply = false;
+    for (const auto &event : sink->Events) {
+        ASSERT_EQ(client.getSessionId(), event.SessionId);
+        ASSERT_EQ(CommunicationLogLevel::Commands, event.Level);
+        ASSERT_EQ(std::string::npos, event.Text.find("Subject: The subject"));
+        if (event.Direction == LogDirection::Client && event.Text == "RCPT TO: <to@domain.com>\r\n") {
+            has_rcpt = true;
+        }
+        if (event.Direction == LogDirection::Server && event.ReplyCode == 250) {
+            has_ok_reply = true;
+        }
+    }
+    ASSERT_TRUE(has_rcpt);
+    ASSERT_TRUE(has_ok_reply);
+
+    const std::uint64_t first_session_id = client.getSessionId();
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_LT(first_session_id, client.getSessionId());
+}
+
+TEST(SmtpClient_sendMail, WithReport_FillThePhasesAndTheTraffic) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "The subject",
+            "The body");
+    SendReport report;
+    ASSERT_EQ(0, client.sendMail(msg, &report));
+    ASSERT_EQ(0, report.ReturnCode);
+    ASSERT_FALSE(report.ConnectionReused);
+    ASSERT_FALSE(report.TLSResumed);
+    ASSERT_EQ("4F2A1B3C", report.QueueId);
+    ASSERT_EQ(0U, report.FinalReply.find("250 2.0.0 Ok: queued as 4F2A1B3C"));
+    ASSERT_LE(report.Start, report.End);
+    const SendPhase ran[] { SendPhase::Resolve, SendPhase::Connect, SendPhase::Greeting, SendPhase::Hello,
+        SendPhase::Envelope, SendPhase::Data, SendPhase::FinalReply, SendPhase::Quit };
+    auto previous_start = report.Start;
+    for (SendPhase phase : ran) {
+        const SendPhaseTiming &timing = report.getPhase(phase);
+        ASSERT_LE(previous_start, timing.Start);
+        ASSERT_LE(timing.Start, timing.End);
+        ASSERT_LE(timing.End, report.End);
+        previous_start = timing.Start;
+    }
+    ASSERT_EQ(std::chrono::steady_clock::time_point(), report.getPhase(SendPhase::TLS).Start);
+    ASSERT_EQ(std::chrono::steady_clock::time_point(), report.getPhase(SendPhase::Authentication).Start);
+    ASSERT_EQ(0, report.getPhase(SendPhase::Reset).Duration.count());
+    // Greeting, EHLO, MAIL FROM, RCPT TO, DATA and end of data replies
+    ASSERT_LE(6U, report.ReadCallCount);
+    ASSERT_LT(server.getData().length(), report.BytesWritten);
+    ASSERT_LT(0U, report.BytesRead);
+    ASSERT_LE(7U, report.WriteCallCount);
+}
+
+TEST(SmtpClient_sendMail, WithReportAndKeepAlive_ReportTheReuse) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    client.setKeepAlive(true);
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "The subject",
+            "The body");
+    ASSERT_EQ(0, client.sendMail(msg));
+    SendReport report;
+    ASSERT_EQ(0, client.sendMail(msg, &report));
+    ASSERT_TRUE(report.ConnectionReused);
+    ASSERT_EQ(std::chrono::steady_clock::time_point(), report.getPhase(SendPhase::Connect).Start);
+    ASSERT_LE(report.Start, report.getPhase(SendPhase::Reset).Start);
+    ASSERT_EQ(std::chrono::steady_clock::time_point(), report.getPhase(SendPhase::Quit).Start);
+    ASSERT_EQ("4F2A1B3C", report.QueueId);
+    client.disconnect();
+}
+
+TEST(SmtpClient_sendMail, WithMetricsRegistry_CountTheMessagesAndTheCommands) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    auto registry = std::make_shared<MetricsRegistry>();
+    client.setMetricsRegistry(registry);
+    const MessageAddress to[] = { MessageAddress("to@domain.com"), MessageAddress("to2@domain.com") };
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            to,
+            2,
+            "The subject",
+            "The body");
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_EQ(1U, registry->getSentCount());
+    ASSERT_EQ(2U, registry->getRecipientCount());
+    ASSERT_LT(0U, registry->getBytesWritten());
+    ASSERT_LT(0U, registry->getBytesRead());
+    ASSERT_EQ(0, registry->getOpenSessionCount());
+    ASSERT_EQ(1U, registry->getCommandLatency(SMTPCommand::Greeting).getCount());
+    ASSERT_EQ(1U, registry->getCommandLatency(SMTPCommand::EHLO).getCount());
+    ASSERT_EQ(1U, registry->getCommandLatency(SMTPCommand::MAIL).getCount());
+    ASSERT_EQ(2U, registry->getCommandLatency(SMTPCommand::RCPT).getCount());
+    ASSERT_EQ(1U, registry->getCommandLatency(SMTPCommand::DATA).getCount());
+    ASSERT_EQ(1U, registry->getCommandLatency(SMTPCommand::EndOfData).getCount());
+    const std::string relay { "127.0.0.1:" + std::to_string(server.getPort()) };
+    ASSERT_NE(nullptr, registry->findRelayLatency(relay.c_str()));
+
+    client.setKeepAlive(true);
+    ASSERT_EQ(0, client.sendMail(msg));
+    ASSERT_EQ(1, registry->getOpenSessionCount());
+    client.disconnect();
+    ASSERT_EQ(0, registry->getOpenSessionCount());
+}
+
+TEST(SmtpClient_sendMail, WithMetricsRegistryAndFailure_CountTheErrorCode) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    auto registry = std::make_shared<MetricsRegistry>();
+    client.setMetricsRegistry(registry);
+    const std::string body(1000001, 'a');
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            body.c_str());
+    ASSERT_EQ(CLIENT_SENDMAIL_MESSAGE_TOO_LARGE, client.sendMail(msg));
+    ASSERT_EQ(1U, registry->getFailedCount());
+    ASSERT_EQ(1U, registry->getErrorCount(CLIENT_SENDMAIL_MESSAGE_TOO_LARGE));
+    ASSERT_EQ(0, registry->getOpenSessionCount());
+}
+
+TEST(SmtpClient_sendMail, LargerThanServerSize_ReturnMessageTooLargeWithoutData) {
+    LoopbackServer server;
+    server.serve();
+    SmtpClient client("127.0.0.1", server.getPort());
+    const std::string body(1000001, 'a');
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            body.c_str());
+    ASSERT_EQ(CLIENT_SENDMAIL_MESSAGE_TOO_LARGE, client.sendMail(msg));
+    std::vector<std::string> commands = server.getCommands();
+    ASSERT_EQ(0, std::count_if(commands.begin(), commands.end(), [](const std::string &pCommand) {
+                return pCommand.compare(0, 4, "MAIL") == 0 || pCommand == "DATA";
+                }));
+}
+#endif
@@ -38,6 +38,10 @@ class FakeSMTPClientBase : public SMTPClientBase {
     static ServerAuthOptions *extractAuthenticationOptions(const char *pEhloOutput) {
         return SMTPClientBase::extractAuthenticationOptions(pEhloOutput);
     }
+
+    static bool parseEhloResponse(const char *pEhloOutput, ServerAuthOptions *pOptions) {
+        return SMTPClientBase::parseEhloResponse(pEhloOutput, pOptions);
+    }
 };
 
 template<typename T>
@@ -215,6 +219,15 @@ TYPED_TEST(MultiSmtpClientBaseFixture, getCommunicationLog_WithNewClient_ReturnE
     ASSERT_EQ("", std::string(this->client.getCommunicationLog()));
 }
 
+TYPED_TEST(MultiSmtpClientBaseFixture, getCommunicationLogLevel_WithNewClient_ReturnFull) {
+    ASSERT_EQ(CommunicationLogLevel::Full, this->client.getCommunicationLogLevel());
+    ASSERT_EQ(CommunicationLog::DEFAULT_MAX_SIZE, this->client.getCommunicationLogMaxSize());
+    this->client.setCommunicationLogLevel(CommunicationLogLevel::Off);
+    this->client.setCommunicationLogMaxSize(0);
+    ASSERT_EQ(CommunicationLogLevel::Off, this->client.getCommunicationLogLevel());
+    ASSERT_EQ(0, this->client.getCommunicationLogMaxSize());
+}
+
 TYPED_TEST(MultiSmtpClientBaseFixture, getCredentials_WithNewClient_ReturnNullPtr) {
     ASSERT_EQ(nullptr, this->client.getCredentials());
 }
@@ -335,6 +348,96 @@ TYPED_TEST(MultiSmtpClientBaseFixture, extractAuthenticationOptions_WithAuthMult
     ASSERT_TRUE(options->XOAuth);
 }
 
+TYPED_TEST(MultiSmtpClientBaseFixture, extractAuthenticationOptions_WithAuthOnLastLine_ReturnOptions) {
+    ServerAuthOptions *options = TypeParam::extractAuthenticationOptions("250-smtp.test.com\r\n250 AUTH LOGIN");
+    ASSERT_NE(nullptr, options);
+    ASSERT_TRUE(options->Login);
+    delete options;
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithNull_ReturnFalse) {
+    ServerAuthOptions options;
+    ASSERT_FALSE(FakeSMTPClientBase::parseEhloResponse(nullptr, &options));
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithoutReplyLine_ReturnFalse) {
+    ServerAuthOptions options;
+    ASSERT_FALSE(FakeSMTPClientBase::parseEhloResponse("  ", &options));
+    ASSERT_FALSE(FakeSMTPClientBase::parseEhloResponse("500 Unknown command\r\n", &options));
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithAllExtensions_ReturnAllOptions) {
+    ServerAuthOptions options;
+    ASSERT_TRUE(FakeSMTPClientBase::parseEhloResponse("250-smtp.test.com at your service\r\n"
+                "250-SIZE 35882577\r\n"
+                "250-8BITMIME\r\n"
+                "250-AUTH LOGIN PLAIN XOAUTH2\r\n"
+                "250-ENHANCEDSTATUSCODES\r\n"
+                "250-PIPELINING\r\n"
+                "250-CHUNKING\r\n"
+                "250-DSN\r\n"
+                "250-SMTPUTF8\r\n"
+                "250 STARTTLS\r\n", &options));
+    ASSERT_TRUE(options.Size);
+    ASSERT_EQ(35882577, options.MaxMessageSize);
+    ASSERT_TRUE(options.EightBitMime);
+    ASSERT_TRUE(options.Auth);
+    ASSERT_TRUE(options.Login);
+    ASSERT_TRUE(options.Plain);
+    ASSERT_TRUE(options.XOAuth2);
+    ASSERT_FALSE(options.OAuthBearer);
+    ASSERT_TRUE(options.Pipelining);
+    ASSERT_TRUE(options.Chunking);
+    ASSERT_TRUE(options.DSN);
+    ASSERT_TRUE(options.SMTPUTF8);
+    ASSERT_TRUE(options.StartTLS);
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithNoExtension_ReturnNoOption) {
+    ServerAuthOptions options;
+    ASSERT_TRUE(FakeSMTPClientBase::parseEhloResponse("250 smtp.test.com", &options));
+    ASSERT_FALSE(options.Auth);
+    ASSERT_FALSE(options.Size);
+    ASSERT_FALSE(options.Pipelining);
+    ASSERT_FALSE(options.StartTLS);
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithLowerCaseKeywords_ReturnOptions) {
+    ServerAuthOptions options;
+    ASSERT_TRUE(FakeSMTPClientBase::parseEhloResponse("250-smtp.test.com\r\n250-auth plain\r\n250 pipelining", &options));
+    ASSERT_TRUE(options.Plain);
+    ASSERT_TRUE(options.Pipelining);
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithObsoleteAuthSyntax_ReturnMechanisms) {
+    ServerAuthOptions options;
+    ASSERT_TRUE(FakeSMTPClientBase::parseEhloResponse("250-smtp.test.com\r\n250 AUTH=LOGIN PLAIN", &options));
+    ASSERT_TRUE(options.Auth);
+    ASSERT_TRUE(options.Login);
+    ASSERT_TRUE(options.Plain);
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithSizeWithoutLimit_ReturnZero) {
+    ServerAuthOptions options;
+    ASSERT_TRUE(FakeSMTPClientBase::parseEhloResponse("250-smtp.test.com\r\n250 SIZE", &options));
+    ASSERT_TRUE(options.Size);
+    ASSERT_EQ(0, options.MaxMessageSize);
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithOverflowingSize_ReturnZero) {
+    ServerAuthOptions options;
+    ASSERT_TRUE(FakeSMTPClientBase::parseEhloResponse("250 SIZE 999999999999999999999999", &options));
+    ASSERT_TRUE(options.Size);
+    ASSERT_EQ(0, options.MaxMessageSize);
+}
+
+TEST(SMTPClientBase_parseEhloResponse, WithLFOnly_ReturnOptions) {
+    ServerAuthOptions options;
+    ASSERT_TRUE(FakeSMTPClientBase::parseEhloResponse("250-smtp.test.com\n250-PIPELINING\n250 CHUNKING\n", &options));
+    ASSERT_TRUE(options.Pipelining);
+    ASSERT_TRUE(options.Chunking);
+}
+
 TYPED_TEST(MultiSmtpClientBaseFixture, getErrorMessage_WithZero_ReturnNoMessage) {
     ASSERT_EQ("No message correspond to this error code",
               std::string(TypeParam::getErrorMessage(0)));
@@ -0,0 +1,90 @@
+#ifdef __linux__
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "../../src/smtpeventloop.h"
+#include "../../src/socketerrors.h"
+#include "loopbackserver.h"
+
+using namespace jed_utils;
+
+TEST(SMTPEventLoop_createSession, WithLoopbackServer_SessionReadyThenClosed) {
+    LoopbackServer server;
+    server.serve(true);
+    SMTPEventLoop loop;
+    int connect_result = -1;
+    int quit_result = 0;
+    bool closed = false;
+    loop.setSessionClosedHandler([&closed](SMTPSession &) { closed = true; });
+    SMTPSessionOptions options;
+    options.ServerName = "127.0.0.1";
+    options.Port = server.getPort();
+    options.Security = SMTPSessionSecurity::None;
+    SMTPSession *session = loop.createSession(options);
+    session->connect([&connect_result, &quit_result, session](int pCode) {
+            connect_result = pCode;
+            session->quit([&quit_result](int pQuitCode) { quit_result = pQuitCode; });
+            });
+    for (int i = 0; i < 100 && !closed; i++) {
+        loop.runOnce(100);
+    }
+    ASSERT_EQ(0, connect_result);
+    ASSERT_EQ(221, quit_result);
+    ASSERT_TRUE(closed);
+    ASSERT_EQ(0, loop.getSessionCount());
+}
+
+TEST(SMTPEventLoop_createSession, WithConnectionRefused_FailTheSession) {
+    int port = 0;
+    {
+        LoopbackServer server;
+        port = static_cast<int>(server.getPort());
+    }
+    SMTPEventLoop loop;
+    int connect_result = 0;
+    SMTPSessionOptions options;
+    options.ServerName = "127.0.0.1";
+    options.Port = static_cast<unsigned int>(port);
+    options.Security = SMTPSessionSecurity::None;
+    SMTPSession *session = loop.createSession(options);
+    session->connect([&connect_result](int pCode) { connect_result = pCode; });
+    for (int i = 0; i < 100 && loop.getSessionCount() > 0; i++) {
+        loop.runOnce(100);
+    }
+    ASSERT_EQ(SOCKET_INIT_SESSION_DELAYED_CONNECTION_ERROR, connect_result);
+    ASSERT_EQ(0, loop.getSessionCount());
+}
+
+TEST(SMTPEventLoop_createSession, WithSilentServer_FailWithTimeout) {
+    LoopbackServer server;
+    SMTPEventLoop loop;
+    int connect_result = 0;
+    SMTPSessionOptions options;
+    options.ServerName = "127.0.0.1";
+    options.Port = server.getPort();
+    options.Security = SMTPSessionSecurity::None;
+    options.CommandTimeoutMs = 50;
+    SMTPSession *session = loop.createSession(options);
+    session->connect([&connect_result](int pCode) { connect_result = pCode; });
+    for (int i = 0; i < 100 && loop.getSessionCount() > 0; i++) {
+        loop.runOnce(100);
+    }
+    ASSERT_EQ(SOCKET_INIT_SESSION_CONNECT_TIMEOUT, connect_result);
+}
+
+TEST(SMTPEventLoop_post, FromAnotherThread_RunTheTask) {
+    SMTPEventLoop loop;
+    std::atomic<bool> executed { false };
+    std::thread poster([&loop, &executed]() {
+            loop.post([&loop, &executed]() {
+                executed = true;
+                loop.stop();
+                });
+            });
+    loop.run();
+    poster.join();
+    ASSERT_TRUE(executed);
+}
+
+#endif  // __linux__
@@ -0,0 +1,405 @@
+#include <gtest/gtest.h>
+#include <openssl/ssl.h>
+#include <string>
+#include <vector>
+#include "../../src/messagerenderer.h"
+#include "../../src/plaintextmessage.h"
+#include "../../src/smtpclienterrors.h"
+#include "../../src/smtpsession.h"
+#include "../../src/socketerrors.h"
+#include "../../src/sslerrors.h"
+#include "tlstestpeer.h"
+
+using namespace jed_utils;
+using namespace std::literals::string_literals;
+
+class FakeServerSession : public ::testing::Test {
+ public:
+    FakeServerSession()
+        : session(createOptions(), nullptr) {
+    }
+
+    static SMTPSessionOptions createOptions() {
+        SMTPSessionOptions options;
+        options.ServerName = "localhost";
+        options.Security = SMTPSessionSecurity::None;
+        return options;
+    }
+
+    void reply(const std::string &pReply) {
+        session.onReceive(pReply.data(), pReply.length());
+    }
+
+    std::string takeOutput() {
+        std::string output(session.getPendingOutput(), session.getPendingOutputLength());
+        session.consumeOutput(output.length());
+        return output;
+    }
+
+    void establish() {
+        session.onConnected();
+        reply("220 localhost ESMTP\r\n");
+        takeOutput();
+        reply("250-localhost\r\n250-AUTH PLAIN LOGIN\r\n250 SIZE 1000\r\n");
+    }
+
+    SMTPSession session;
+};
+
+TEST_F(FakeServerSession, onConnected_WaitForGreeting) {
+    session.onConnected();
+    ASSERT_EQ(SMTPSessionState::Greeting, session.getState());
+    ASSERT_FALSE(session.hasPendingOutput());
+    ASSERT_NE(0, session.getDeadline());
+}
+
+TEST_F(FakeServerSession, Greeting_SendEhlo) {
+    session.onConnected();
+    reply("220 localhost ESMTP\r\n");
+    ASSERT_EQ(SMTPSessionState::Ehlo, session.getState());
+    ASSERT_EQ("ehlo localhost\r\n", takeOutput());
+}
+
+TEST_F(FakeServerSession, GreetingInSeveralPackets_SendEhlo) {
+    session.onConnected();
+    reply("220 local");
+    ASSERT_EQ(SMTPSessionState::Greeting, session.getState());
+    reply("host ESMTP\r\n");
+    ASSERT_EQ(SMTPSessionState::Ehlo, session.getState());
+}
+
+TEST_F(FakeServerSession, MultilineEhlo_SessionReady) {
+    int result = -1;
+    session.connect([&result](int pCode) { result = pCode; });
+    establish();
+    ASSERT_EQ(0, result);
+    ASSERT_EQ(SMTPSessionState::Ready, session.getState());
+    ASSERT_EQ(0, session.getDeadline());
+    ASSERT_NE(nullptr, session.getAuthenticationOptions());
+    ASSERT_TRUE(session.getAuthenticationOptions()->Plain);
+}
+
+TEST_F(FakeServerSession, InvalidGreeting_FailWithServerCode) {
+    int result = 0;
+    session.connect([&result](int pCode) { result = pCode; });
+    session.onConnected();
+    reply("554 No service\r\n");
+    ASSERT_EQ(554, result);
+    ASSERT_EQ(SMTPSessionState::Failed, session.getState());
+    ASSERT_TRUE(session.isFinished());
+}
+
+TEST_F(FakeServerSession, TimeoutDuringGreeting_FailWithConnectTimeout) {
+    int result = 0;
+    session.connect([&result](int pCode) { result = pCode; });
+    session.onConnected();
+    session.onTimeout();
+    ASSERT_EQ(SOCKET_INIT_SESSION_CONNECT_TIMEOUT, result);
+    ASSERT_EQ(SOCKET_INIT_SESSION_CONNECT_TIMEOUT, session.getLastError());
+}
+
+TEST_F(FakeServerSession, TimeoutDuringMailFrom_FailWithMailFromTimeout) {
+    establish();
+    int result = 0;
+    session.mailFrom("from@test.com", [&result](int pCode) { result = pCode; });
+    session.onTimeout();
+    ASSERT_EQ(CLIENT_SENDMAIL_MAILFROM_TIMEOUT, result);
+}
+
+TEST_F(FakeServerSession, OperationsQueuedBeforeReady_RunOnceReady) {
+    int result = 0;
+    session.mailFrom("from@test.com", [&result](int pCode) { result = pCode; });
+    establish();
+    ASSERT_EQ("MAIL FROM: <from@test.com>\r\n", takeOutput());
+    reply("250 OK\r\n");
+    ASSERT_EQ(250, result);
+    ASSERT_EQ(SMTPSessionState::Ready, session.getState());
+}
+
+TEST_F(FakeServerSession, sendMail_RunTheCompleteTransaction) {
+    establish();
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    int result = -1;
+    session.sendMail(msg, [&result](int pCode) { result = pCode; });
+    ASSERT_EQ("MAIL FROM: <from@test.com> SIZE="s + std::to_string(MessageRenderer::computeSize(msg)) + "\r\n", takeOutput());
+    reply("250 OK\r\n");
+    ASSERT_EQ("RCPT TO: <to@domain.com>\r\n", takeOutput());
+    reply("250 OK\r\n");
+    ASSERT_EQ("DATA\r\n", takeOutput());
+    reply("354 Go ahead\r\n");
+    std::string content = takeOutput();
+    ASSERT_EQ(0, content.find("From: \"\" <from@test.com>\r\n"));
+    ASSERT_EQ(content.length() - 5, content.rfind("\r\n.\r\n"));
+    ASSERT_EQ(-1, result);
+    reply("250 Queued\r\n");
+    ASSERT_EQ(0, result);
+    ASSERT_EQ(SMTPSessionState::Ready, session.getState());
+}
+
+TEST_F(FakeServerSession, sendMailWithRejectedRecipient_ResetTheTransaction) {
+    establish();
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    std::vector<int> results;
+    session.sendMail(msg, [&results](int pCode) { results.push_back(pCode); });
+    takeOutput();
+    reply("250 OK\r\n");
+    takeOutput();
+    reply("550 No such user\r\n");
+    ASSERT_EQ(std::vector<int>({ 550 }), results);
+    ASSERT_EQ("RSET\r\n", takeOutput());
+    reply("250 OK\r\n");
+    ASSERT_EQ(SMTPSessionState::Ready, session.getState());
+    ASSERT_FALSE(session.hasPendingOutput());
+}
+
+TEST_F(FakeServerSession, sendMailLargerThanServerSize_FailWithoutSendingTheTransaction) {
+    establish();
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            std::string(1000, 'a').c_str());
+    std::vector<int> results;
+    session.sendMail(msg, [&results](int pCode) { results.push_back(pCode); });
+    ASSERT_EQ(std::vector<int>({ CLIENT_SENDMAIL_MESSAGE_TOO_LARGE }), results);
+    ASSERT_FALSE(session.hasPendingOutput());
+    ASSERT_EQ(SMTPSessionState::Ready, session.getState());
+}
+
+TEST_F(FakeServerSession, sendMailWithEightBitMime_SendTheBodyAsIs) {
+    session.onConnected();
+    reply("220 localhost ESMTP\r\n");
+    takeOutput();
+    reply("250-localhost\r\n250 8BITMIME\r\n");
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Bonjour, \xC3\xA7" "a va?");
+    session.sendMail(msg, [](int) {});
+    ASSERT_EQ("MAIL FROM: <from@test.com> BODY=8BITMIME\r\n", takeOutput());
+    reply("250 OK\r\n");
+    takeOutput();
+    reply("250 OK\r\n");
+    takeOutput();
+    reply("354 Go ahead\r\n");
+    ASSERT_NE(std::string::npos, takeOutput().find("Content-Transfer-Encoding: 8bit\r\n\r\nBonjour, \xC3\xA7" "a va?\r\n"));
+}
+
+TEST_F(FakeServerSession, sendMailQueuedBeforeEhlo_UseTheExtensionsOfTheServer) {
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Bonjour, \xC3\xA7" "a va?\n.line");
+    session.sendMail(msg, [](int) {});
+    session.onConnected();
+    reply("220 localhost ESMTP\r\n");
+    takeOutput();
+    reply("250-localhost\r\n250-SIZE 100000\r\n250 8BITMIME\r\n");
+    ASSERT_EQ("MAIL FROM: <from@test.com> SIZE="s + std::to_string(MessageRenderer::computeSize(msg, true))
+            + " BODY=8BITMIME\r\n", takeOutput());
+    reply("250 OK\r\n");
+    takeOutput();
+    reply("250 OK\r\n");
+    takeOutput();
+    reply("354 Go ahead\r\n");
+    ASSERT_NE(std::string::npos, takeOutput().find("Content-Transfer-Encoding: 8bit\r\n\r\nBonjour, \xC3\xA7" "a va?\r\n..line"));
+}
+
+TEST_F(FakeServerSession, dataWithDotsAndBareLineBreaks_SendStuffedContent) {
+    establish();
+    int result = -1;
+    session.data(".first\nsecond\n.\n..third", [&result](int pCode) { result = pCode; });
+    ASSERT_EQ("DATA\r\n", takeOutput());
+    reply("354 Go ahead\r\n");
+    ASSERT_EQ("..first\r\nsecond\r\n..\r\n...third\r\n.\r\n", takeOutput());
+    reply("250 Queued\r\n");
+    ASSERT_EQ(250, result);
+}
+
+TEST_F(FakeServerSession, quit_CloseTheSession) {
+    establish();
+    int result = 0;
+    session.quit([&result](int pCode) { result = pCode; });
+    ASSERT_EQ("QUIT\r\n", takeOutput());
+    reply("221 Bye\r\n");
+    ASSERT_EQ(221, result);
+    ASSERT_EQ(SMTPSessionState::Closed, session.getState());
+}
+
+TEST_F(FakeServerSession, quitThenConnectionClosed_CloseTheSession) {
+    establish();
+    int result = 0;
+    session.quit([&result](int pCode) { result = pCode; });
+    session.onTransportError();
+    ASSERT_EQ(221, result);
+    ASSERT_EQ(SMTPSessionState::Closed, session.getState());
+}
+
+TEST_F(FakeServerSession, TransportErrorWithPendingOperations_FailEveryOperation) {
+    establish();
+    std::vector<int> results;
+    session.mailFrom("from@test.com", [&results](int pCode) { results.push_back(pCode); });
+    session.rcptTo("to@domain.com", [&results](int pCode) { results.push_back(pCode); });
+    session.onTransportError();
+    ASSERT_EQ(std::vector<int>({ CLIENT_SENDMAIL_MAILFROM_ERROR, CLIENT_SENDMAIL_MAILFROM_ERROR }), results);
+}
+
+TEST_F(FakeServerSession, OperationOnFinishedSession_FailImmediately) {
+    session.onTransportError(SOCKET_INIT_SESSION_CONNECT_ERROR);
+    int result = 0;
+    session.rset([&result](int pCode) { result = pCode; });
+    ASSERT_EQ(SOCKET_INIT_SESSION_CONNECT_ERROR, result);
+}
+
+TEST(SMTPSession_Authentication, WithAuthPlain_SendCredentials) {
+    SMTPSessionOptions options;
+    options.ServerName = "localhost";
+    options.Security = SMTPSessionSecurity::None;
+    options.Username = "user";
+    options.Password = "pass";
+    SMTPSession session(options, nullptr);
+    int result = -1;
+    session.connect([&result](int pCode) { result = pCode; });
+    session.onConnected();
+    const std::string greeting { "220 localhost\r\n" };
+    session.onReceive(greeting.data(), greeting.length());
+    session.consumeOutput(session.getPendingOutputLength());
+    const std::string ehlo { "250-localhost\r\n250-AUTH PLAIN\r\n250 SIZE 1000\r\n" };
+    session.onReceive(ehlo.data(), ehlo.length());
+    ASSERT_EQ(SMTPSessionState::AuthPlain, session.getState());
+    ASSERT_EQ("AUTH PLAIN AHVzZXIAcGFzcw==\r\n",
+            std::string(session.getPendingOutput(), session.getPendingOutputLength()));
+    const std::string accepted { "235 Accepted\r\n" };
+    session.onReceive(accepted.data(), accepted.length());
+    ASSERT_EQ(0, result);
+}
+
+TEST(SMTPSession_Authentication, WithoutSupportedMethod_FailWithMethodNotSupported) {
+    SMTPSessionOptions options;
+    options.ServerName = "localhost";
+    options.Security = SMTPSessionSecurity::None;
+    options.Username = "user";
+    SMTPSession session(options, nullptr);
+    int result = 0;
+    session.connect([&result](int pCode) { result = pCode; });
+    session.onConnected();
+    const std::string replies { "220 localhost\r\n250 localhost\r\n" };
+    session.onReceive(replies.data(), replies.length());
+    ASSERT_EQ(CLIENT_AUTHENTICATION_METHOD_NOTSUPPORTED, result);
+}
+
+TEST(SMTPSession_Opportunistic, WithoutSSLContext_FailOnStartTLS) {
+    SMTPSessionOptions options;
+    options.ServerName = "localhost";
+    SMTPSession session(options, nullptr);
+    int result = 0;
+    session.connect([&result](int pCode) { result = pCode; });
+    session.onConnected();
+    const std::string replies { "220 localhost\r\n250-localhost\r\n250 STARTTLS\r\n" };
+    session.onReceive(replies.data(), replies.length());
+    ASSERT_EQ(SMTPSessionState::StartTLS, session.getState());
+    const std::string ready { "220 Ready\r\n" };
+    session.onReceive(ready.data(), ready.length());
+    ASSERT_NE(0, result);
+    ASSERT_TRUE(session.isFinished());
+}
+
+TEST(SMTPSession_Opportunistic, TimeoutDuringTLSHandshake_FailWithHandshakeTimeout) {
+    SMTPSessionOptions options;
+    options.ServerName = "localhost";
+    SSL_CTX *ssl_context = SSL_CTX_new(TLS_client_method());
+    ASSERT_NE(nullptr, ssl_context);
+    {
+        SMTPSession session(options, ssl_context);
+        int result = 0;
+        session.connect([&result](int pCode) { result = pCode; });
+        session.onConnected();
+        const std::string replies { "220 localhost\r\n250-localhost\r\n250 STARTTLS\r\n220 Ready\r\n" };
+        session.onReceive(replies.data(), replies.length());
+        ASSERT_EQ(SMTPSessionState::TLSHandshake, session.getState());
+        session.onTimeout();
+        ASSERT_EQ(SSL_CLIENT_STARTTLS_HANDSHAKE_TIMEOUT, result);
+    }
+    SSL_CTX_free(ssl_context);
+}
+
+namespace {
+    // The SSL object of the last session, kept by an info callback
+    SSL *lastSessionSSL = nullptr;
+
+    void keepSessionSSL(const SSL *pSSL, int pWhere, int) {
+        if ((pWhere & SSL_CB_HANDSHAKE_START) != 0) {
+            lastSessionSSL = const_cast<SSL *>(pSSL);
+        }
+    }
+
+    // Deliver the records of the session to the server and back
+    void exchangeRecords(SMTPSession &pSession, SSL *pServer, BIO *pServerInput, BIO *pServerOutput) {
+        const std::string records(pSession.getPendingOutput(), pSession.getPendingOutputLength());
+        pSession.consumeOutput(records.length());
+        BIO_write(pServerInput, records.data(), static_cast<int>(records.length()));
+        SSL_do_handshake(pServer);
+        char buffer[16384];
+        int length = 0;
+        while ((length = BIO_read(pServerOutput, buffer, sizeof(buffer))) > 0) {
+            pSession.onReceive(buffer, static_cast<size_t>(length));
+        }
+    }
+}  // namespace
+
+TEST(SMTPSession_Implicit, SSLWriteFailure_StayFailed) {
+    TLSTestPeer peer;
+    SSL_CTX *ssl_context = SSL_CTX_new(TLS_client_method());
+    ASSERT_NE(nullptr, ssl_context);
+    X509_STORE_add_cert(SSL_CTX_get_cert_store(ssl_context), peer.getCertificate());
+    SSL_CTX_set_info_callback(ssl_context, keepSessionSSL);
+    SSL *server = SSL_new(peer.getServerContext());
+    BIO *server_input = BIO_new(BIO_s_mem());
+    BIO *server_output = BIO_new(BIO_s_mem());
+    SSL_set_bio(server, server_input, server_output);
+    SSL_set_accept_state(server);
+    {
+        SMTPSessionOptions options;
+        options.ServerName = "localhost";
+        options.Security = SMTPSessionSecurity::Implicit;
+        SMTPSession session(options, ssl_context);
+        int result = 0;
+        session.connect([&result](int pCode) { result = pCode; });
+        session.onConnected();
+        for (int round = 0; round < 10 && session.getState() == SMTPSessionState::TLSHandshake; round++) {
+            exchangeRecords(session, server, server_input, server_output);
+        }
+        ASSERT_EQ(SMTPSessionState::Greeting, session.getState());
+        // The server completes its handshake with the last client records
+        exchangeRecords(session, server, server_input, server_output);
+
+        // The EHLO sent after the greeting cannot be written
+        BIO_set_flags(SSL_get_wbio(lastSessionSSL), BIO_FLAGS_MEM_RDONLY);
+        const std::string greeting { "220 localhost ESMTP\r\n" };
+        SSL_write(server, greeting.data(), static_cast<int>(greeting.length()));
+        exchangeRecords(session, server, server_input, server_output);
+        ASSERT_EQ(SMTPSessionState::Failed, session.getState());
+        ASSERT_TRUE(session.isFinished());
+        ASSERT_EQ(0, session.getDeadline());
+        ASSERT_NE(0, result);
+    }
+    SSL_free(server);
+    SSL_CTX_free(ssl_context);
+}
+
+TEST_F(FakeServerSession, sendMailThenTransportError_InvokeTheHandlerOnce) {
+    establish();
+    PlaintextMessage msg(MessageAddress("from@test.com"),
+            MessageAddress("to@domain.com"),
+            "Subject",
+            "Hello");
+    std::vector<int> results;
+    session.sendMail(msg, [&results](int pCode) { results.push_back(pCode); });
+    session.onTransportError();
+    ASSERT_EQ(std::vector<int>({ CLIENT_SENDMAIL_MAILFROM_ERROR }), results);
+}
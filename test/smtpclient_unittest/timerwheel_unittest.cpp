@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+#include "../../src/timerwheel.h"
+
+using namespace jed_utils;
+
+TEST(TimerWheel_Constructor, WithZeroSlot_ThrowInvalidArgument) {
+    try {
+        TimerWheel wheel(0, 10, 0);
+        FAIL();
+    }
+    catch(std::invalid_argument &err) {
+        ASSERT_STREQ("The slot count must be greater than zero", err.what());
+    }
+}
+
+TEST(TimerWheel_Constructor, WithZeroResolution_ThrowInvalidArgument) {
+    try {
+        TimerWheel wheel(8, 0, 0);
+        FAIL();
+    }
+    catch(std::invalid_argument &err) {
+        ASSERT_STREQ("The resolution must be greater than zero", err.what());
+    }
+}
+
+TEST(TimerWheel_getNextTimeoutMs, WithEmptyWheel_ReturnMinusOne) {
+    TimerWheel wheel(8, 10, 1000);
+    ASSERT_EQ(-1, wheel.getNextTimeoutMs(1000));
+}
+
+TEST(TimerWheel_getNextTimeoutMs, WithOneTimer_ReturnRemainingTime) {
+    TimerWheel wheel(8, 10, 1000);
+    wheel.schedule(1, 1035);
+    ASSERT_EQ(35, wheel.getNextTimeoutMs(1000));
+}
+
+TEST(TimerWheel_getNextTimeoutMs, WithTimerInNextRotation_ReturnRemainingTime) {
+    TimerWheel wheel(8, 10, 1000);
+    wheel.schedule(1, 1500);
+    ASSERT_EQ(500, wheel.getNextTimeoutMs(1000));
+}
+
+TEST(TimerWheel_advance, BeforeExpiry_ReturnNothing) {
+    TimerWheel wheel(8, 10, 1000);
+    wheel.schedule(1, 1035);
+    std::vector<TimerWheel::Entry> expired;
+    wheel.advance(1030, expired);
+    ASSERT_TRUE(expired.empty());
+    ASSERT_EQ(1, wheel.size());
+}
+
+TEST(TimerWheel_advance, AfterExpiry_ReturnTheTimer) {
+    TimerWheel wheel(8, 10, 1000);
+    wheel.schedule(7, 1035);
+    std::vector<TimerWheel::Entry> expired;
+    wheel.advance(1040, expired);
+    ASSERT_EQ(1, expired.size());
+    ASSERT_EQ(7, expired[0].Key);
+    ASSERT_EQ(1035, expired[0].Expiry);
+    ASSERT_EQ(0, wheel.size());
+}
+
+TEST(TimerWheel_advance, WithTimerInNextRotation_KeepTheTimerUntilItsRotation) {
+    TimerWheel wheel(8, 10, 1000);
+    wheel.schedule(1, 1100);
+    std::vector<TimerWheel::Entry> expired;
+    wheel.advance(1025, expired);
+    ASSERT_TRUE(expired.empty());
+    wheel.advance(1100, expired);
+    ASSERT_EQ(1, expired.size());
+}
+
+TEST(TimerWheel_advance, WithTimerInThePast_ExpireOnNextAdvance) {
+    TimerWheel wheel(8, 10, 1000);
+    std::vector<TimerWheel::Entry> expired;
+    wheel.advance(1050, expired);
+    wheel.schedule(1, 1020);
+    ASSERT_EQ(0, wheel.getNextTimeoutMs(1050));
+    wheel.advance(1050, expired);
+    ASSERT_EQ(1, expired.size());
+}
+
+TEST(TimerWheel_advance, WithLongJump_ExpireEveryTimer) {
+    TimerWheel wheel(8, 10, 1000);
+    wheel.schedule(1, 1010);
+    wheel.schedule(2, 1045);
+    wheel.schedule(3, 1200);
+    std::vector<TimerWheel::Entry> expired;
+    wheel.advance(5000, expired);
+    ASSERT_EQ(3, expired.size());
+    ASSERT_EQ(0, wheel.size());
+}
+
+TEST(TimerWheel_schedule, WithKeyAlreadyScheduled_ReplaceItsTimer) {
+    TimerWheel wheel(8, 10, 1000);
+    wheel.schedule(1, 1020);
+    wheel.schedule(1, 1200);
+    ASSERT_EQ(1, wheel.size());
+    ASSERT_EQ(200, wheel.getNextTimeoutMs(1000));
+    std::vector<TimerWheel::Entry> expired;
+    wheel.advance(1100, expired);
+    ASSERT_TRUE(expired.empty());
+    wheel.advance(1200, expired);
+    ASSERT_EQ(1, expired.size());
+    ASSERT_EQ(1200, expired[0].Expiry);
+}
+
+TEST(TimerWheel_cancel, WithScheduledKey_RemoveItsTimer) {
+    TimerWheel wheel(8, 10, 1000);
+    wheel.schedule(1, 1020);
+    wheel.schedule(2, 1030);
+    ASSERT_TRUE(wheel.cancel(1));
+    ASSERT_FALSE(wheel.cancel(1));
+    ASSERT_EQ(1, wheel.size());
+    ASSERT_EQ(30, wheel.getNextTimeoutMs(1000));
+    std::vector<TimerWheel::Entry> expired;
+    wheel.advance(1050, expired);
+    ASSERT_EQ(1, expired.size());
+    ASSERT_EQ(2, expired[0].Key);
+    ASSERT_EQ(-1, wheel.getNextTimeoutMs(1050));
+}
@@ -0,0 +1,275 @@
+#include "../../src/tlscontext.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "tlstestpeer.h"
+
+using namespace jed_utils;
+
+TEST(TLSContext_getDefault, CalledTwice_ReturnSameContext) {
+    auto first = TLSContext::getDefault();
+    auto second = TLSContext::getDefault();
+    ASSERT_NE(nullptr, first);
+    ASSERT_EQ(first, second);
+    ASSERT_NE(nullptr, first->getSSLContext());
+}
+
+TEST(TLSContext_createWithDefaultCA, ReturnNewContext) {
+    auto context = TLSContext::createWithDefaultCA();
+    ASSERT_NE(nullptr, context);
+    ASSERT_NE(TLSContext::getDefault(), context);
+    ASSERT_NE(nullptr, context->getSSLContext());
+}
+
+TEST(TLSContext_createWithCA, WithoutFileAndPath_ReturnNull) {
+    ASSERT_EQ(nullptr, TLSContext::createWithCA(nullptr, nullptr));
+}
+
+TEST(TLSContext_createWithCA, WithUnknownFile_ReturnNull) {
+    ASSERT_EQ(nullptr, TLSContext::createWithCA("/nonexistent/ca.pem"));
+}
+
+TEST(TLSContext_createWithStore, WithNullStore_ReturnNull) {
+    ASSERT_EQ(nullptr, TLSContext::createWithStore(nullptr));
+}
+
+TEST(TLSContext_createWithStore, WithStore_UseTheStore) {
+    X509_STORE *store = X509_STORE_new();
+    auto context = TLSContext::createWithStore(store);
+    ASSERT_NE(nullptr, context);
+    ASSERT_EQ(store, SSL_CTX_get_cert_store(context->getSSLContext()));
+    X509_STORE_free(store);
+}
+
+TEST(TLSContext_fromSSLContext, WithContextOfTLSContext_ReturnTLSContext) {
+    auto context = TLSContext::createWithDefaultCA();
+    ASSERT_EQ(context.get(), TLSContext::fromSSLContext(context->getSSLContext()));
+}
+
+TEST(TLSContext_fromSSLContext, WithOtherContext_ReturnNull) {
+    SSL_CTX *ssl_context = SSL_CTX_new(TLS_client_method());
+    ASSERT_EQ(nullptr, TLSContext::fromSSLContext(ssl_context));
+    ASSERT_EQ(nullptr, TLSContext::fromSSLContext(nullptr));
+    SSL_CTX_free(ssl_context);
+}
+
+class TLSContextSessionFixture : public ::testing::Test {
+ public:
+    TLSContextSessionFixture()
+        : context(TLSContext::createWithDefaultCA()) {
+    }
+
+    bool connect(const char *pServerName, unsigned int pPort) {
+        SSL *ssl = SSL_new(context->getSSLContext());
+        context->prepareConnection(ssl, pServerName, pPort);
+        bool result = peer.handshake(ssl);
+        if (result) {
+            context->recordHandshake(ssl);
+        }
+        SSL_free(ssl);
+        return result;
+    }
+
+    TLSTestPeer peer;
+    std::shared_ptr<TLSContext> context;
+};
+
+TEST_F(TLSContextSessionFixture, NewContext_NoSessionAndNoHandshake) {
+    ASSERT_EQ(0, context->getCachedSessionCount());
+    ASSERT_EQ(0, context->getFullHandshakeCount());
+    ASSERT_EQ(0, context->getResumedHandshakeCount());
+}
+
+TEST_F(TLSContextSessionFixture, FirstConnection_FullHandshakeAndSessionCached) {
+    ASSERT_TRUE(connect("localhost", 465));
+    ASSERT_EQ(1, context->getFullHandshakeCount());
+    ASSERT_EQ(0, context->getResumedHandshakeCount());
+    ASSERT_EQ(1, context->getCachedSessionCount());
+}
+
+TEST_F(TLSContextSessionFixture, SecondConnectionToSameServer_ResumeSession) {
+    ASSERT_TRUE(connect("localhost", 465));
+    ASSERT_TRUE(connect("localhost", 465));
+    ASSERT_EQ(1, context->getFullHandshakeCount());
+    ASSERT_EQ(1, context->getResumedHandshakeCount());
+    ASSERT_EQ(1, context->getCachedSessionCount());
+}
+
+TEST_F(TLSContextSessionFixture, ConnectionToOtherPort_FullHandshake) {
+    ASSERT_TRUE(connect("localhost", 465));
+    ASSERT_TRUE(connect("localhost", 587));
+    ASSERT_EQ(2, context->getFullHandshakeCount());
+    ASSERT_EQ(0, context->getResumedHandshakeCount());
+    ASSERT_EQ(2, context->getCachedSessionCount());
+}
+
+TEST_F(TLSContextSessionFixture, ClearSessions_FullHandshake) {
+    ASSERT_TRUE(connect("localhost", 465));
+    context->clearSessions();
+    ASSERT_EQ(0, context->getCachedSessionCount());
+    ASSERT_TRUE(connect("localhost", 465));
+    ASSERT_EQ(2, context->getFullHandshakeCount());
+    ASSERT_EQ(0, context->getResumedHandshakeCount());
+}
+
+class TLSContextVerificationFixture : public ::testing::Test {
+ public:
+    TLSContextVerificationFixture()
+        : context(createTrustingPeer()) {
+        context->setVerificationCacheDuration(std::chrono::seconds(60));
+    }
+
+    std::shared_ptr<TLSContext> createTrustingPeer() {
+        X509_STORE *store = X509_STORE_new();
+        X509_STORE_add_cert(store, peer.getCertificate());
+        auto trusting_context = TLSContext::createWithStore(store);
+        X509_STORE_free(store);
+        return trusting_context;
+    }
+
+    // Full handshake (the sessions are cleared) and return the verify result
+    long connect(const char *pServerName, unsigned int pPort) {
+        context->clearSessions();
+        SSL *ssl = SSL_new(context->getSSLContext());
+        context->prepareConnection(ssl, pServerName, pPort);
+        long verify_result = peer.handshake(ssl) ? SSL_get_verify_result(ssl) : -1;
+        SSL_free(ssl);
+        return verify_result;
+    }
+
+    TLSTestPeer peer;
+    std::shared_ptr<TLSContext> context;
+};
+
+TEST(TLSContext_VerificationCache, NewContext_CacheDisabled) {
+    auto context = TLSContext::createWithDefaultCA();
+    ASSERT_EQ(0, context->getVerificationCacheDuration().count());
+    ASSERT_EQ(0, context->getVerifiedChainCount());
+    ASSERT_EQ(0, context->getVerificationCacheHitCount());
+}
+
+TEST_F(TLSContextVerificationFixture, CacheDisabled_NothingCached) {
+    context->setVerificationCacheDuration(std::chrono::seconds(0));
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(0, context->getVerifiedChainCount());
+    ASSERT_EQ(0, context->getVerificationCacheHitCount());
+}
+
+TEST_F(TLSContextVerificationFixture, FirstConnection_ChainCached) {
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(1, context->getVerifiedChainCount());
+    ASSERT_EQ(0, context->getVerificationCacheHitCount());
+}
+
+TEST_F(TLSContextVerificationFixture, SecondConnection_VerificationSkipped) {
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(1, context->getVerifiedChainCount());
+    ASSERT_EQ(1, context->getVerificationCacheHitCount());
+}
+
+TEST_F(TLSContextVerificationFixture, ConnectionToOtherServer_ChainVerified) {
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(X509_V_OK, connect("localhost", 587));
+    ASSERT_EQ(2, context->getVerifiedChainCount());
+    ASSERT_EQ(0, context->getVerificationCacheHitCount());
+}
+
+TEST_F(TLSContextVerificationFixture, ExpiredEntry_ChainVerifiedAgain) {
+    context->setVerificationCacheDuration(std::chrono::seconds(1));
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(1, context->getVerifiedChainCount());
+    ASSERT_EQ(0, context->getVerificationCacheHitCount());
+}
+
+TEST_F(TLSContextVerificationFixture, ClearVerifiedChains_ChainVerifiedAgain) {
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    context->clearVerifiedChains();
+    ASSERT_EQ(0, context->getVerifiedChainCount());
+    ASSERT_EQ(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(0, context->getVerificationCacheHitCount());
+}
+
+TEST_F(TLSContextVerificationFixture, UntrustedCertificate_NotCached) {
+    context = TLSContext::createWithDefaultCA();
+    context->setVerificationCacheDuration(std::chrono::seconds(60));
+    ASSERT_NE(X509_V_OK, connect("localhost", 465));
+    ASSERT_NE(X509_V_OK, connect("localhost", 465));
+    ASSERT_EQ(0, context->getVerifiedChainCount());
+    ASSERT_EQ(0, context->getVerificationCacheHitCount());
+}
+
+TEST(TLSContext_applyProfile, WithDefaultProfile_ReturnTrue) {
+    auto context = TLSContext::createWithDefaultCA();
+    ASSERT_TRUE(context->applyProfile(TLSProfile()));
+}
+
+TEST(TLSContext_applyProfile, WithUnknownGroup_ReturnFalse) {
+    auto context = TLSContext::createWithDefaultCA();
+    TLSProfile profile;
+    profile.Groups = "NOTAGROUP";
+    ASSERT_FALSE(context->applyProfile(profile));
+}
+
+TEST(TLSContext_applyProfile, WithTooSmallMaxSendFragment_ReturnFalse) {
+    auto context = TLSContext::createWithDefaultCA();
+    TLSProfile profile;
+    profile.MaxSendFragment = 100;
+    ASSERT_FALSE(context->applyProfile(profile));
+}
+
+TEST(TLSContext_applyProfile, WithTooLargeMaxSendFragment_ReturnFalse) {
+    auto context = TLSContext::createWithDefaultCA();
+    TLSProfile profile;
+    profile.MaxSendFragment = 32768;
+    ASSERT_FALSE(context->applyProfile(profile));
+}
+
+TEST(TLSContext_applyProfile, WithValidMaxSendFragmentAndReadAhead_ReturnTrue) {
+    auto context = TLSContext::createWithDefaultCA();
+    TLSProfile profile;
+    profile.MaxSendFragment = 4096;
+    profile.ReadAhead = true;
+    profile.ReadBufferLength = 65536;
+    ASSERT_TRUE(context->applyProfile(profile));
+    ASSERT_EQ(1, SSL_CTX_get_read_ahead(context->getSSLContext()));
+}
+
+TEST(TLSContext_applyProfile, WithTLS13Only_NegotiateTLS13) {
+    TLSTestPeer peer;
+    auto context = TLSContext::createWithDefaultCA();
+    TLSProfile profile;
+    profile.TLS13Only = true;
+    ASSERT_TRUE(context->applyProfile(profile));
+    SSL *ssl = SSL_new(context->getSSLContext());
+    ASSERT_TRUE(peer.handshake(ssl));
+    ASSERT_EQ(TLS1_3_VERSION, SSL_version(ssl));
+    SSL_free(ssl);
+}
+
+TEST(TLSContext_applyProfile, WithCipherOrderByCPU_NegotiateFastestCipher) {
+    TLSTestPeer peer;
+    auto context = TLSContext::createWithDefaultCA();
+    ASSERT_TRUE(context->applyProfile(TLSProfile()));
+    SSL *ssl = SSL_new(context->getSSLContext());
+    ASSERT_TRUE(peer.handshake(ssl));
+    const std::string cipher { SSL_CIPHER_get_name(SSL_get_current_cipher(ssl)) };
+    ASSERT_EQ(TLSContext::hasHardwareAES() ? "TLS_AES_128_GCM_SHA256" : "TLS_CHACHA20_POLY1305_SHA256", cipher);
+    SSL_free(ssl);
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+TEST(TLSContext_applyProfile, WithX25519First_NegotiateX25519) {
+    TLSTestPeer peer;
+    auto context = TLSContext::createWithDefaultCA();
+    ASSERT_TRUE(context->applyProfile(TLSProfile()));
+    SSL *ssl = SSL_new(context->getSSLContext());
+    ASSERT_TRUE(peer.handshake(ssl));
+    ASSERT_EQ(NID_X25519, SSL_get_negotiated_group(ssl));
+    SSL_free(ssl);
+}
+#endif
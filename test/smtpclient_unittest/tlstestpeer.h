@@ -0,0 +1,92 @@
+#ifndef TLSTESTPEER_H
+#define TLSTESTPEER_H
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+// In-memory TLS server used by the tests that need a real handshake. The
+// server uses a self-signed Ed25519 certificate for "localhost", so the
+// verification of the chain fails unless the certificate is trusted.
+class TLSTestPeer {
+ public:
+    TLSTestPeer()
+        : mKey(nullptr),
+          mCertificate(nullptr),
+          mServerContext(nullptr) {
+        EVP_PKEY_CTX *key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+        EVP_PKEY_keygen_init(key_context);
+        EVP_PKEY_keygen(key_context, &mKey);
+        EVP_PKEY_CTX_free(key_context);
+
+        mCertificate = X509_new();
+        X509_set_version(mCertificate, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(mCertificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(mCertificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(mCertificate), 3600);
+        X509_set_pubkey(mCertificate, mKey);
+        X509_NAME *name = X509_get_subject_name(mCertificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(mCertificate, name);
+        X509_sign(mCertificate, mKey, nullptr);
+
+        mServerContext = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_use_certificate(mServerContext, mCertificate);
+        SSL_CTX_use_PrivateKey(mServerContext, mKey);
+        SSL_CTX_set_session_id_context(mServerContext,
+                reinterpret_cast<const unsigned char *>("tlstestpeer"), 11);
+    }
+
+    ~TLSTestPeer() {
+        SSL_CTX_free(mServerContext);
+        X509_free(mCertificate);
+        EVP_PKEY_free(mKey);
+    }
+
+    TLSTestPeer(const TLSTestPeer &other) = delete;
+    TLSTestPeer& operator=(const TLSTestPeer &other) = delete;
+
+    X509 *getCertificate() const {
+        return mCertificate;
+    }
+
+    SSL_CTX *getServerContext() const {
+        return mServerContext;
+    }
+
+    // Run the handshake of pClient (already prepared by the test) against a
+    // new server connection, then let the client read the session tickets.
+    // Return true if the handshake completed on both sides.
+    bool handshake(SSL *pClient) {
+        SSL *server = SSL_new(mServerContext);
+        BIO *client_bio = nullptr;
+        BIO *server_bio = nullptr;
+        BIO_new_bio_pair(&client_bio, 0, &server_bio, 0);
+        SSL_set_bio(pClient, client_bio, client_bio);
+        SSL_set_bio(server, server_bio, server_bio);
+        SSL_set_connect_state(pClient);
+        SSL_set_accept_state(server);
+        bool client_done = false;
+        bool server_done = false;
+        for (int round = 0; round < 20 && !(client_done && server_done); round++) {
+            client_done = client_done || SSL_do_handshake(pClient) == 1;
+            server_done = server_done || SSL_do_handshake(server) == 1;
+        }
+        if (client_done && server_done) {
+            // TLS 1.3 tickets are sent after the handshake
+            char byte = 'x';
+            SSL_write(server, &byte, 1);
+            SSL_read(pClient, &byte, 1);
+        }
+        SSL_free(server);
+        return client_done && server_done;
+    }
+
+ private:
+    EVP_PKEY *mKey;
+    X509 *mCertificate;
+    SSL_CTX *mServerContext;
+};
+
+#endif
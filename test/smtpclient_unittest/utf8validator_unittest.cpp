@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "../../src/utf8validator.h"
+
+using namespace jed_utils;
+
+namespace {
+    size_t findFirstInvalid(const std::string &pText) {
+        return UTF8Validator::findFirstInvalid(pText.data(), pText.length());
+    }
+}  // namespace
+
+TEST(UTF8Validator_findFirstInvalid, WithEmptyText_ReturnZero) {
+    ASSERT_EQ(0, findFirstInvalid(""));
+}
+
+TEST(UTF8Validator_findFirstInvalid, WithASCIIText_ReturnLength) {
+    const std::string text(100, 'a');
+    ASSERT_EQ(100, findFirstInvalid(text));
+}
+
+TEST(UTF8Validator_findFirstInvalid, WithMultiByteCharacters_ReturnLength) {
+    // 2, 3 and 4 bytes, at the start, in the middle and across block boundaries
+    std::string text { "\xC3\xA9" + std::string(13, 'a') + "\xE6\x97\xA5" + std::string(20, 'b') + "\xF0\x9F\x98\x80" };
+    text += "\xF4\x8F\xBF\xBF\xED\x9F\xBF\xEE\x80\x80";
+    ASSERT_EQ(text.length(), findFirstInvalid(text));
+    ASSERT_TRUE(UTF8Validator::isValid(text.data(), text.length()));
+}
+
+TEST(UTF8Validator_findFirstInvalid, WithInvalidSequence_ReturnItsOffset) {
+    const std::string prefix(37, 'a');
+    // Lone continuation, invalid lead bytes, overlong forms, surrogate, above U+10FFFF
+    const std::string invalid_sequences[] { "\x80", "\xC0\xAF", "\xC1\xBF", "\xF5\x80\x80\x80", "\xFF",
+        "\xE0\x80\xAF", "\xF0\x8F\xBF\xBF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xC3" "a", "\xE6\x97" "a" };
+    for (const auto &sequence : invalid_sequences) {
+        ASSERT_EQ(prefix.length(), findFirstInvalid(prefix + sequence + "end")) << sequence;
+    }
+}
+
+TEST(UTF8Validator_findFirstInvalid, WithTruncatedSequenceAtTheEnd_ReturnItsOffset) {
+    ASSERT_EQ(3, findFirstInvalid("abc\xF0\x9F\x98"));
+    ASSERT_FALSE(UTF8Validator::isValid("abc\xF0\x9F\x98", 6));
+}